@@ -0,0 +1,877 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Headless benchmark for the Cycles standalone.
+ *
+ * Renders a corpus of procedurally generated XML scenes, each stressing a different part of the
+ * renderer, and reports timings and memory usage as JSON. Results can be compared against a
+ * baseline written by an earlier run, to catch performance regressions.
+ *
+ * The corpus is generated on first use and reused afterwards, so that runs against the same
+ * corpus directory are comparable. */
+
+#include <stdio.h>
+
+#include "device/device.h"
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/geometry.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_args.h"
+#include "util/util_foreach.h"
+#include "util/util_hash.h"
+#include "util/util_image.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
+#include "util/util_path.h"
+#include "util/util_string.h"
+#include "util/util_time.h"
+#include "util/util_unique_ptr.h"
+#include "util/util_vector.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct Options {
+  string corpus_path;
+  string output_path;
+  string baseline_path;
+  float tolerance;
+  int width, height;
+  bool quiet;
+  vector<string> scenes;
+  string device_name;
+  SceneParams scene_params;
+  SessionParams session_params;
+} options;
+
+/* Results */
+
+struct BenchmarkResult {
+  double sync_time;
+  double scene_update_time;
+  double bvh_build_time;
+  double render_time;
+  double samples_per_second;
+  double peak_memory;
+
+  BenchmarkResult()
+      : sync_time(0.0),
+        scene_update_time(0.0),
+        bvh_build_time(0.0),
+        render_time(0.0),
+        samples_per_second(0.0),
+        peak_memory(0.0)
+  {
+  }
+};
+
+/* Metrics written to and compared against the baseline. Values below the minimum are too small
+ * to compare reliably, timings in particular. */
+static const struct {
+  const char *name;
+  double BenchmarkResult::*value;
+  bool higher_is_better;
+  double min_value;
+} benchmark_metrics[] = {
+    {"sync_time", &BenchmarkResult::sync_time, false, 0.05},
+    {"scene_update_time", &BenchmarkResult::scene_update_time, false, 0.05},
+    {"bvh_build_time", &BenchmarkResult::bvh_build_time, false, 0.05},
+    {"render_time", &BenchmarkResult::render_time, false, 0.05},
+    {"samples_per_second", &BenchmarkResult::samples_per_second, true, 0.0},
+    {"peak_memory", &BenchmarkResult::peak_memory, false, 1024.0 * 1024.0},
+};
+
+typedef map<string, BenchmarkResult> BenchmarkResults;
+
+/* Corpus
+ *
+ * All scenes share the same camera and world, and are built around the origin. */
+
+static float corpus_random(uint seed, uint i)
+{
+  return hash_uint2_to_float(seed, i);
+}
+
+static void corpus_append_floats(string &xml, const float *values, size_t num)
+{
+  for (size_t i = 0; i < num; i++) {
+    xml += string_printf((i == 0) ? "%g" : " %g", (double)values[i]);
+  }
+}
+
+static void corpus_append_float3s(string &xml, const vector<float3> &values)
+{
+  for (size_t i = 0; i < values.size(); i++) {
+    const float3 &v = values[i];
+    xml += string_printf(
+        (i == 0) ? "%g %g %g" : "  %g %g %g", (double)v.x, (double)v.y, (double)v.z);
+  }
+}
+
+static void corpus_append_ints(string &xml, const vector<int> &values)
+{
+  for (size_t i = 0; i < values.size(); i++) {
+    xml += string_printf((i == 0) ? "%d" : " %d", values[i]);
+  }
+}
+
+static string corpus_mesh(const char *name,
+                          const vector<float3> &P,
+                          const vector<int> &verts,
+                          const vector<int> &nverts)
+{
+  string xml = "<mesh";
+  if (name) {
+    xml += string_printf(" name=\"%s\"", name);
+  }
+  xml += " P=\"";
+  corpus_append_float3s(xml, P);
+  xml += "\" nverts=\"";
+  corpus_append_ints(xml, nverts);
+  xml += "\" verts=\"";
+  corpus_append_ints(xml, verts);
+  xml += "\" />\n";
+  return xml;
+}
+
+static string corpus_plane(float size)
+{
+  vector<float3> P = {make_float3(-size, -1.0f, -size),
+                      make_float3(size, -1.0f, -size),
+                      make_float3(size, -1.0f, size),
+                      make_float3(-size, -1.0f, size)};
+  vector<int> verts = {0, 1, 2, 3};
+  vector<int> nverts = {4};
+  return corpus_mesh(NULL, P, verts, nverts);
+}
+
+static string corpus_cube(float size)
+{
+  vector<float3> P;
+  for (int i = 0; i < 8; i++) {
+    P.push_back(make_float3(
+        (i & 1) ? size : -size, (i & 2) ? size : -size, (i & 4) ? size : -size));
+  }
+  vector<int> verts = {0, 2, 3, 1, 4, 5, 7, 6, 0, 1, 5, 4, 2, 6, 7, 3, 0, 4, 6, 2, 1, 3, 7, 5};
+  vector<int> nverts = {4, 4, 4, 4, 4, 4};
+  return corpus_mesh(NULL, P, verts, nverts);
+}
+
+static string corpus_sphere(const char *name, int segments, int rings, float radius)
+{
+  vector<float3> P;
+  vector<int> verts, nverts;
+
+  for (int j = 0; j <= rings; j++) {
+    float theta = M_PI_F * j / rings;
+    for (int i = 0; i < segments; i++) {
+      float phi = M_2PI_F * i / segments;
+      P.push_back(make_float3(radius * sinf(theta) * cosf(phi),
+                              radius * cosf(theta),
+                              radius * sinf(theta) * sinf(phi)));
+    }
+  }
+
+  for (int j = 0; j < rings; j++) {
+    for (int i = 0; i < segments; i++) {
+      int i_next = (i + 1) % segments;
+      verts.push_back(j * segments + i);
+      verts.push_back(j * segments + i_next);
+      verts.push_back((j + 1) * segments + i_next);
+      verts.push_back((j + 1) * segments + i);
+      nverts.push_back(4);
+    }
+  }
+
+  return corpus_mesh(name, P, verts, nverts);
+}
+
+static string corpus_scene(const string &body)
+{
+  return "<cycles>\n"
+         "<background>\n"
+         "  <background name=\"bg\" color=\"0.3 0.35 0.4\" strength=\"1.0\" />\n"
+         "  <connect from=\"bg background\" to=\"output surface\" />\n"
+         "</background>\n"
+         "<transform rotate=\"180 0 1 0\">\n"
+         "  <transform translate=\"0 0 -10\">\n"
+         "    <camera type=\"perspective\" />\n"
+         "  </transform>\n"
+         "</transform>\n"
+         "<shader name=\"diffuse\">\n"
+         "  <diffuse_bsdf name=\"diff\" color=\"0.8 0.8 0.8\" />\n"
+         "  <connect from=\"diff bsdf\" to=\"output surface\" />\n"
+         "</shader>\n"
+         "<shader name=\"lamp\">\n"
+         "  <emission name=\"emit\" color=\"1 1 1\" strength=\"1\" />\n"
+         "  <connect from=\"emit emission\" to=\"output surface\" />\n"
+         "</shader>\n" +
+         body + "</cycles>\n";
+}
+
+/* Many instances of a single mesh. */
+static string corpus_scene_instances()
+{
+  const int grid = 48;
+  string body = "<state shader=\"diffuse\">\n";
+  body += corpus_plane(20.0f);
+
+  for (int y = 0; y < grid; y++) {
+    for (int x = 0; x < grid; x++) {
+      uint i = y * grid + x;
+      float scale = 0.05f + 0.1f * corpus_random(1, i);
+      body += string_printf(
+          "<transform translate=\"%g %g %g\" scale=\"%g %g %g\">",
+          (double)((x - grid * 0.5f) * 0.25f),
+          (double)(-1.0f + scale),
+          (double)((y - grid * 0.5f) * 0.25f),
+          (double)scale,
+          (double)scale,
+          (double)scale);
+      body += (i == 0) ? corpus_sphere("sphere", 64, 32, 1.0f) :
+                         string("<instance geometry=\"sphere\" />");
+      body += "</transform>\n";
+    }
+  }
+
+  body += "</state>\n";
+  body += "<state shader=\"lamp\">\n";
+  body += "<light type=\"point\" co=\"2 4 -3\" size=\"0.5\" strength=\"800 800 800\" />\n";
+  body += "</state>\n";
+  return corpus_scene(body);
+}
+
+/* Dense field of short curves. */
+static string corpus_scene_hair()
+{
+  const int num_curves = 50000;
+  const int num_keys = 5;
+
+  vector<float3> P;
+  vector<int> nkeys;
+
+  for (int i = 0; i < num_curves; i++) {
+    float r = 3.0f * sqrtf(corpus_random(2, i));
+    float phi = M_2PI_F * corpus_random(3, i);
+    float3 root = make_float3(r * cosf(phi), -1.0f, r * sinf(phi));
+    float3 bend = make_float3(corpus_random(4, i) - 0.5f, 0.0f, corpus_random(5, i) - 0.5f);
+
+    for (int k = 0; k < num_keys; k++) {
+      float t = (float)k / (num_keys - 1);
+      P.push_back(root + make_float3(0.0f, 0.6f * t, 0.0f) + bend * (0.4f * t * t));
+    }
+    nkeys.push_back(num_keys);
+  }
+
+  string body = "<state shader=\"diffuse\">\n";
+  body += corpus_plane(5.0f);
+  body += "<hair radius=\"0.004\" P=\"";
+  corpus_append_float3s(body, P);
+  body += "\" nkeys=\"";
+  corpus_append_ints(body, nkeys);
+  body += "\" />\n";
+  body += "</state>\n";
+  body += "<state shader=\"lamp\">\n";
+  body += "<light type=\"point\" co=\"2 4 -3\" size=\"0.5\" strength=\"800 800 800\" />\n";
+  body += "</state>\n";
+  return corpus_scene(body);
+}
+
+/* Heterogeneous volume lit by a single light. */
+static string corpus_scene_volume()
+{
+  string body =
+      "<shader name=\"smoke\">\n"
+      "  <noise_texture name=\"noise\" scale=\"3.0\" detail=\"4.0\" />\n"
+      "  <principled_volume name=\"vol\" color=\"0.8 0.8 0.8\" />\n"
+      "  <connect from=\"noise fac\" to=\"vol density\" />\n"
+      "  <connect from=\"vol volume\" to=\"output volume\" />\n"
+      "</shader>\n"
+      "<state shader=\"diffuse\">\n";
+  body += corpus_plane(10.0f);
+  body += "</state>\n";
+  body += "<state shader=\"smoke\">\n";
+  body += corpus_cube(2.0f);
+  body += "</state>\n";
+  body += "<state shader=\"lamp\">\n";
+  body += "<light type=\"point\" co=\"3 5 -4\" size=\"0.5\" strength=\"2000 2000 2000\" />\n";
+  body += "</state>\n";
+  return corpus_scene(body);
+}
+
+/* Many small lights around a handful of objects. */
+static string corpus_scene_many_lights()
+{
+  const int grid = 8;
+  const int num_lights = 1024;
+
+  string body = "<state shader=\"diffuse\">\n";
+  body += corpus_plane(10.0f);
+
+  for (int y = 0; y < grid; y++) {
+    for (int x = 0; x < grid; x++) {
+      body += string_printf("<transform translate=\"%g -0.6 %g\" scale=\"0.4 0.4 0.4\">",
+                            (double)((x - grid * 0.5f) * 1.0f),
+                            (double)((y - grid * 0.5f) * 1.0f));
+      body += (x == 0 && y == 0) ? corpus_sphere("sphere", 32, 16, 1.0f) :
+                                   string("<instance geometry=\"sphere\" />");
+      body += "</transform>\n";
+    }
+  }
+
+  body += "</state>\n";
+  body += "<state shader=\"lamp\">\n";
+
+  for (int i = 0; i < num_lights; i++) {
+    float co[3] = {8.0f * (corpus_random(6, i) - 0.5f),
+                   -0.9f + 2.0f * corpus_random(7, i),
+                   8.0f * (corpus_random(8, i) - 0.5f)};
+    float strength[3] = {
+        10.0f * corpus_random(9, i), 10.0f * corpus_random(10, i), 10.0f * corpus_random(11, i)};
+
+    body += "<light type=\"point\" size=\"0.05\" co=\"";
+    corpus_append_floats(body, co, 3);
+    body += "\" strength=\"";
+    corpus_append_floats(body, strength, 3);
+    body += "\" />\n";
+  }
+
+  body += "</state>\n";
+  return corpus_scene(body);
+}
+
+/* Large image textures, written next to the scene file. */
+static bool corpus_write_texture(const string &filepath, int size, uint seed)
+{
+  unique_ptr<ImageOutput> out = unique_ptr<ImageOutput>(ImageOutput::create(filepath));
+  if (!out) {
+    return false;
+  }
+
+  ImageSpec spec(size, size, 3, TypeDesc::UINT8);
+  if (!out->open(filepath, spec)) {
+    return false;
+  }
+
+  vector<uint8_t> pixels(size_t(size) * size * 3);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      uint8_t *pixel = &pixels[(size_t(y) * size + x) * 3];
+      uint8_t checker = (((x >> 6) ^ (y >> 6)) & 1) ? 192 : 64;
+      pixel[0] = checker;
+      pixel[1] = (uint8_t)(hash_uint3(seed, x, y) & 0xff);
+      pixel[2] = (uint8_t)((x + y) & 0xff);
+    }
+  }
+
+  bool success = out->write_image(TypeDesc::UINT8, pixels.data());
+  out->close();
+
+  return success;
+}
+
+static string corpus_scene_textures(const string &dirpath)
+{
+  const int num_textures = 4;
+  const int size = 4096;
+
+  string body;
+
+  for (int i = 0; i < num_textures; i++) {
+    string filename = string_printf("benchmark_texture_%d.png", i);
+    string filepath = path_join(dirpath, filename);
+
+    if (!path_exists(filepath) && !corpus_write_texture(filepath, size, i)) {
+      fprintf(stderr, "Failed to write texture %s\n", filepath.c_str());
+    }
+
+    body += string_printf(
+        "<shader name=\"texture_%d\">\n"
+        "  <texture_coordinate name=\"coord\" />\n"
+        "  <image_texture name=\"tex\" filename=\"%s\" />\n"
+        "  <diffuse_bsdf name=\"diff\" />\n"
+        "  <connect from=\"coord generated\" to=\"tex vector\" />\n"
+        "  <connect from=\"tex color\" to=\"diff color\" />\n"
+        "  <connect from=\"diff bsdf\" to=\"output surface\" />\n"
+        "</shader>\n",
+        i,
+        filename.c_str());
+
+    body += string_printf(
+        "<state shader=\"texture_%d\">\n"
+        "<transform translate=\"%g 0 0\" rotate=\"%d 0 1 0\">\n",
+        i,
+        (double)(i - num_textures * 0.5f + 0.5f) * 2.5,
+        i * 15);
+    body += corpus_plane(1.2f);
+    body += "</transform>\n</state>\n";
+  }
+
+  body += "<state shader=\"lamp\">\n";
+  body += "<light type=\"point\" co=\"2 4 -3\" size=\"0.5\" strength=\"800 800 800\" />\n";
+  body += "</state>\n";
+  return corpus_scene(body);
+}
+
+static const char *corpus_scene_names[] = {
+    "instances", "hair", "volume", "many_lights", "textures"};
+
+static string corpus_generate(const string &name, const string &dirpath)
+{
+  if (name == "instances") {
+    return corpus_scene_instances();
+  }
+  else if (name == "hair") {
+    return corpus_scene_hair();
+  }
+  else if (name == "volume") {
+    return corpus_scene_volume();
+  }
+  else if (name == "many_lights") {
+    return corpus_scene_many_lights();
+  }
+  else if (name == "textures") {
+    return corpus_scene_textures(dirpath);
+  }
+  return "";
+}
+
+/* Returns the path of the scene file, generating it if it does not exist yet. */
+static string corpus_scene_filepath(const string &name)
+{
+  string filepath = path_join(options.corpus_path, name + ".xml");
+
+  if (!path_exists(filepath)) {
+    if (!options.quiet) {
+      printf("Generating scene %s\n", filepath.c_str());
+    }
+
+    path_create_directories(filepath);
+
+    string xml = corpus_generate(name, options.corpus_path);
+    if (xml.empty() || !path_write_text(filepath, xml)) {
+      fprintf(stderr, "Failed to generate scene %s\n", filepath.c_str());
+      return "";
+    }
+  }
+
+  return filepath;
+}
+
+/* Rendering */
+
+static bool benchmark_scene(const string &name, BenchmarkResult &result)
+{
+  string filepath = corpus_scene_filepath(name);
+  if (filepath.empty()) {
+    return false;
+  }
+
+  if (!options.quiet) {
+    printf("Rendering scene %s\n", name.c_str());
+  }
+
+  Session *session = new Session(options.session_params);
+  Scene *scene = new Scene(options.scene_params, session->device);
+
+  /* Read XML. */
+  {
+    scoped_timer timer(&result.sync_time);
+    xml_read_file(scene, filepath.c_str());
+  }
+
+  scene->camera->width = options.width;
+  scene->camera->height = options.height;
+  scene->camera->compute_auto_viewplane();
+
+  session->scene = scene;
+
+  BufferParams buffer_params;
+  buffer_params.width = options.width;
+  buffer_params.height = options.height;
+  buffer_params.full_width = options.width;
+  buffer_params.full_height = options.height;
+
+  session->reset(buffer_params, options.session_params.samples);
+  session->start();
+  session->wait();
+
+  bool success = !session->progress.get_cancel() && !session->device->have_error();
+  if (!success) {
+    fprintf(stderr,
+            "Failed to render scene %s: %s\n",
+            name.c_str(),
+            session->device->error_message().c_str());
+  }
+
+  /* Render time excludes the scene update in background mode. */
+  double total_time, render_time;
+  session->progress.get_time(total_time, render_time);
+
+  result.scene_update_time = max(total_time - render_time, 0.0);
+  result.bvh_build_time = scene->geometry_manager->bvh_build_time;
+  result.render_time = render_time;
+  result.samples_per_second = (render_time > 0.0) ?
+                                  options.session_params.samples / render_time :
+                                  0.0;
+  result.peak_memory = (double)session->stats.mem_peak;
+
+  delete session;
+
+  return success;
+}
+
+/* JSON */
+
+static string results_to_json(const BenchmarkResults &results)
+{
+  string json = "{\n";
+  json += string_printf("  \"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+  json += string_printf("  \"device\": \"%s\",\n", options.device_name.c_str());
+  json += string_printf("  \"samples\": %d,\n", options.session_params.samples);
+  json += string_printf("  \"threads\": %d,\n", options.session_params.threads);
+  json += string_printf("  \"width\": %d,\n", options.width);
+  json += string_printf("  \"height\": %d,\n", options.height);
+  json += "  \"scenes\": {\n";
+
+  size_t scene_index = 0;
+  foreach (const BenchmarkResults::value_type &it, results) {
+    json += string_printf("    \"%s\": {\n", it.first.c_str());
+
+    const size_t num_metrics = sizeof(benchmark_metrics) / sizeof(*benchmark_metrics);
+    for (size_t i = 0; i < num_metrics; i++) {
+      json += string_printf("      \"%s\": %.6g%s\n",
+                            benchmark_metrics[i].name,
+                            it.second.*benchmark_metrics[i].value,
+                            (i + 1 < num_metrics) ? "," : "");
+    }
+
+    json += (++scene_index < results.size()) ? "    },\n" : "    }\n";
+  }
+
+  json += "  }\n";
+  json += "}\n";
+  return json;
+}
+
+/* Read the scene metrics of a results file written by results_to_json(). This is not a general
+ * JSON parser, it relies on the layout of one key per line. */
+static bool results_from_json(const string &json, BenchmarkResults &results)
+{
+  vector<string> lines;
+  string_split(lines, json, "\n", false);
+
+  bool in_scenes = false;
+  string scene_name;
+
+  foreach (const string &line_, lines) {
+    string line = string_strip(line_);
+    if (line.empty()) {
+      continue;
+    }
+
+    if (line[0] == '}') {
+      if (!scene_name.empty()) {
+        scene_name = "";
+      }
+      else {
+        in_scenes = false;
+      }
+      continue;
+    }
+
+    if (line[0] != '"') {
+      continue;
+    }
+
+    size_t key_end = line.find('"', 1);
+    size_t colon = line.find(':', key_end);
+    if (key_end == string::npos || colon == string::npos) {
+      return false;
+    }
+
+    string key = line.substr(1, key_end - 1);
+    string value = string_strip(line.substr(colon + 1));
+
+    if (value == "{") {
+      if (key == "scenes") {
+        in_scenes = true;
+      }
+      else if (in_scenes) {
+        scene_name = key;
+      }
+      continue;
+    }
+
+    if (scene_name.empty()) {
+      continue;
+    }
+
+    for (size_t i = 0; i < sizeof(benchmark_metrics) / sizeof(*benchmark_metrics); i++) {
+      if (key == benchmark_metrics[i].name) {
+        results[scene_name].*benchmark_metrics[i].value = atof(value.c_str());
+      }
+    }
+  }
+
+  return true;
+}
+
+/* Compare results against the baseline, returns the number of regressions. */
+static int results_compare(const BenchmarkResults &results, const BenchmarkResults &baseline)
+{
+  int num_regressions = 0;
+
+  foreach (const BenchmarkResults::value_type &it, results) {
+    BenchmarkResults::const_iterator base_it = baseline.find(it.first);
+    if (base_it == baseline.end()) {
+      printf("%s: no baseline\n", it.first.c_str());
+      continue;
+    }
+
+    for (size_t i = 0; i < sizeof(benchmark_metrics) / sizeof(*benchmark_metrics); i++) {
+      const double value = it.second.*benchmark_metrics[i].value;
+      const double base_value = base_it->second.*benchmark_metrics[i].value;
+
+      if (base_value <= benchmark_metrics[i].min_value || value <= 0.0) {
+        continue;
+      }
+
+      const double change = (value - base_value) / base_value;
+      const bool regression = (benchmark_metrics[i].higher_is_better) ?
+                                  -change > options.tolerance :
+                                  change > options.tolerance;
+
+      if (regression) {
+        num_regressions++;
+      }
+
+      if (regression || !options.quiet) {
+        printf("%s: %-20s %12.6g -> %12.6g  %+6.1f%%%s\n",
+               it.first.c_str(),
+               benchmark_metrics[i].name,
+               base_value,
+               value,
+               change * 100.0,
+               (regression) ? "  REGRESSION" : "");
+      }
+    }
+  }
+
+  return num_regressions;
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+  for (int i = 0; i < argc; i++) {
+    options.scenes.push_back(argv[i]);
+  }
+
+  return 0;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+  options.corpus_path = "cycles_benchmark_corpus";
+  options.tolerance = 0.1f;
+  options.width = 640;
+  options.height = 360;
+  options.quiet = false;
+  options.device_name = "CPU";
+  options.session_params.samples = 16;
+
+  /* device names */
+  string device_names = "";
+  vector<DeviceType> types = Device::available_types();
+  foreach (DeviceType type, types) {
+    if (device_names != "")
+      device_names += ", ";
+
+    device_names += Device::string_from_type(type);
+  }
+
+  /* scene names */
+  string scene_names = "";
+  foreach (const char *name, corpus_scene_names) {
+    if (scene_names != "")
+      scene_names += ", ";
+
+    scene_names += name;
+  }
+
+  ArgParse ap;
+  bool help = false, debug = false, version = false;
+  int verbosity = 1;
+  string usage = "Usage: cycles_benchmark [options] [scene ...]\n\nScenes: " + scene_names;
+
+  ap.options(usage.c_str(),
+             "%*",
+             files_parse,
+             "",
+             "--device %s",
+             &options.device_name,
+             ("Devices to use: " + device_names).c_str(),
+             "--corpus %s",
+             &options.corpus_path,
+             "Directory to read scenes from, missing scenes are generated there",
+             "--output %s",
+             &options.output_path,
+             "File path to write JSON results to",
+             "--baseline %s",
+             &options.baseline_path,
+             "JSON results of an earlier run to compare against",
+             "--tolerance %f",
+             &options.tolerance,
+             "Relative change of a metric considered a regression (default 0.1)",
+             "--quiet",
+             &options.quiet,
+             "Only print results and regressions",
+             "--samples %d",
+             &options.session_params.samples,
+             "Number of samples to render",
+             "--threads %d",
+             &options.session_params.threads,
+             "CPU Rendering Threads",
+             "--width %d",
+             &options.width,
+             "Image width in pixels",
+             "--height %d",
+             &options.height,
+             "Image height in pixels",
+#ifdef WITH_CYCLES_LOGGING
+             "--debug",
+             &debug,
+             "Enable debug logging",
+             "--verbose %d",
+             &verbosity,
+             "Set verbosity of the logger",
+#endif
+             "--help",
+             &help,
+             "Print help message",
+             "--version",
+             &version,
+             "Print version number",
+             NULL);
+
+  if (ap.parse(argc, argv) < 0) {
+    fprintf(stderr, "%s\n", ap.geterror().c_str());
+    ap.usage();
+    exit(EXIT_FAILURE);
+  }
+
+  if (debug) {
+    util_logging_start();
+    util_logging_verbosity_set(verbosity);
+  }
+
+  if (version) {
+    printf("%s\n", CYCLES_VERSION_STRING);
+    exit(EXIT_SUCCESS);
+  }
+  else if (help) {
+    ap.usage();
+    exit(EXIT_SUCCESS);
+  }
+
+  if (options.scenes.empty()) {
+    const size_t num_scenes = sizeof(corpus_scene_names) / sizeof(*corpus_scene_names);
+    options.scenes.assign(corpus_scene_names, corpus_scene_names + num_scenes);
+  }
+
+  options.session_params.background = true;
+  options.session_params.progressive = true;
+
+  /* find matching device */
+  DeviceType device_type = Device::type_from_string(options.device_name.c_str());
+  vector<DeviceInfo> devices = Device::available_devices(DEVICE_MASK(device_type));
+
+  if (devices.empty()) {
+    fprintf(stderr, "Unknown device: %s\n", options.device_name.c_str());
+    exit(EXIT_FAILURE);
+  }
+  else if (options.session_params.samples <= 0) {
+    fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.width <= 0 || options.height <= 0) {
+    fprintf(stderr, "Invalid resolution: %dx%d\n", options.width, options.height);
+    exit(EXIT_FAILURE);
+  }
+
+  options.session_params.device = devices.front();
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+  util_logging_init(argv[0]);
+  path_init();
+  options_parse(argc, argv);
+
+  BenchmarkResults results;
+  bool success = true;
+
+  foreach (const string &name, options.scenes) {
+    BenchmarkResult result;
+    if (!benchmark_scene(name, result)) {
+      success = false;
+      continue;
+    }
+    results[name] = result;
+  }
+
+  string json = results_to_json(results);
+
+  if (!options.output_path.empty()) {
+    if (!path_write_text(options.output_path, json)) {
+      fprintf(stderr, "Failed to write results to %s\n", options.output_path.c_str());
+      success = false;
+    }
+  }
+  else {
+    printf("%s", json.c_str());
+  }
+
+  if (!options.baseline_path.empty()) {
+    string baseline_json;
+    BenchmarkResults baseline;
+
+    if (!path_read_text(options.baseline_path, baseline_json) ||
+        !results_from_json(baseline_json, baseline)) {
+      fprintf(stderr, "Failed to read baseline %s\n", options.baseline_path.c_str());
+      return EXIT_FAILURE;
+    }
+
+    int num_regressions = results_compare(results, baseline);
+    if (num_regressions > 0) {
+      printf("%d regression(s) found\n", num_regressions);
+      success = false;
+    }
+  }
+
+  return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -22,6 +22,7 @@
 #include "render/integrator.h"
 #include "render/scene.h"
 #include "render/session.h"
+#include "render/stats.h"
 
 #include "util/util_args.h"
 #include "util/util_foreach.h"
@@ -52,6 +53,7 @@ struct Options {
   SceneParams scene_params;
   SessionParams session_params;
   bool quiet;
+  bool print_stats;
   bool show_help, interactive, pause;
   string output_path;
 } options;
@@ -168,6 +170,12 @@ static void session_init()
 static void session_exit()
 {
   if (options.session) {
+    if (options.print_stats) {
+      RenderStats stats;
+      options.session->collect_statistics(&stats);
+      printf("\nRender statistics:\n%s\n", stats.full_report().c_str());
+    }
+
     delete options.session;
     options.session = NULL;
   }
@@ -370,6 +378,7 @@ static void options_parse(int argc, const char **argv)
   options.filepath = "";
   options.session = NULL;
   options.quiet = false;
+  options.print_stats = false;
 
   /* device names */
   string device_names = "";
@@ -411,6 +420,9 @@ static void options_parse(int argc, const char **argv)
              "--quiet",
              &options.quiet,
              "In background mode, don't print progress messages",
+             "--stats",
+             &options.print_stats,
+             "Print render statistics, including memory usage per category",
              "--samples %d",
              &options.session_params.samples,
              "Number of samples to render",
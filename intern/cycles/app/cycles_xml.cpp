@@ -26,6 +26,7 @@
 #include "render/camera.h"
 #include "render/film.h"
 #include "render/graph.h"
+#include "render/hair.h"
 #include "render/integrator.h"
 #include "render/light.h"
 #include "render/mesh.h"
@@ -397,6 +398,12 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
   mesh->used_shaders.push_back(state.shader);
 
+  /* read name, so the mesh can be instanced */
+  string name;
+  if (xml_read_string(&name, node, "name")) {
+    mesh->name = ustring(name);
+  }
+
   /* read state */
   int shader = 0;
   bool smooth = state.smooth;
@@ -533,6 +540,81 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   }
 }
 
+/* Hair */
+
+static void xml_read_hair(const XMLReadState &state, xml_node node)
+{
+  /* add hair */
+  Hair *hair = new Hair();
+  state.scene->geometry.push_back(hair);
+
+  Object *object = new Object();
+  object->geometry = hair;
+  object->tfm = state.tfm;
+  state.scene->objects.push_back(object);
+
+  hair->used_shaders.push_back(state.shader);
+
+  /* read name, so the hair can be instanced */
+  string name;
+  if (xml_read_string(&name, node, "name")) {
+    hair->name = ustring(name);
+  }
+
+  /* read curve keys, with either a radius per key or a single radius for all keys */
+  vector<float3> P;
+  vector<float> radius;
+  vector<int> nkeys;
+
+  xml_read_float3_array(P, node, "P");
+  xml_read_float_array(radius, node, "radius");
+  xml_read_int_array(nkeys, node, "nkeys");
+
+  float default_radius = (radius.empty()) ? 0.01f : radius[0];
+
+  hair->reserve_curves(nkeys.size(), P.size());
+
+  int key = 0;
+  for (size_t i = 0; i < nkeys.size(); i++) {
+    if (nkeys[i] < 2 || key + nkeys[i] > (int)P.size()) {
+      fprintf(stderr, "Invalid number of curve keys %d.\n", nkeys[i]);
+      break;
+    }
+
+    hair->add_curve(key, 0);
+
+    for (int j = 0; j < nkeys[i]; j++, key++) {
+      float r = (radius.size() == P.size()) ? radius[key] : default_radius;
+      hair->add_curve_key(P[key], r);
+    }
+  }
+}
+
+/* Instance */
+
+static void xml_read_instance(const XMLReadState &state, xml_node node)
+{
+  string name;
+  if (!xml_read_string(&name, node, "geometry")) {
+    fprintf(stderr, "Instance missing \"geometry\" attribute.\n");
+    return;
+  }
+
+  ustring geom_name(name);
+
+  foreach (Geometry *geom, state.scene->geometry) {
+    if (geom->name == geom_name) {
+      Object *object = new Object();
+      object->geometry = geom;
+      object->tfm = state.tfm;
+      state.scene->objects.push_back(object);
+      return;
+    }
+  }
+
+  fprintf(stderr, "Unknown geometry \"%s\".\n", name.c_str());
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState &state, xml_node node)
@@ -632,6 +714,12 @@ static void xml_read_scene(XMLReadState &state, xml_node scene_node)
     else if (string_iequals(node.name(), "mesh")) {
       xml_read_mesh(state, node);
     }
+    else if (string_iequals(node.name(), "hair")) {
+      xml_read_hair(state, node);
+    }
+    else if (string_iequals(node.name(), "instance")) {
+      xml_read_instance(state, node);
+    }
     else if (string_iequals(node.name(), "light")) {
       xml_read_light(state, node);
     }
@@ -224,6 +224,16 @@ def system_info():
     import _cycles
     return _cycles.system_info()
 
+
+def memory_stats(engine):
+    """Device memory usage of the render session, current and peak per category,
+    and per geometry, BVH and image sizes. None when there is no session."""
+    session = getattr(engine, "session", None)
+    if session is None:
+        return None
+    import _cycles
+    return _cycles.memory_stats(session)
+
 def list_render_passes(scene, srl):
     # Builtin Blender passes.
     yield ("Combined", "RGBA", 'COLOR')
@@ -391,6 +391,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick emissive triangles based on their distance and power relative to the shading point, "
+        "rather than their area only (faster convergence with many mesh lights, CPU only)",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use Adaptive Sampling",
@@ -681,6 +687,11 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Use special type BVH optimized for hair (uses more ram but renders faster)",
         default=True,
     )
+    debug_use_compressed_bvh: BoolProperty(
+        name="Use Compressed BVH",
+        description="Store BVH nodes with quantized bounds (uses less ram but may render slower), only for CPU rendering without Embree",
+        default=False,
+    )
     debug_bvh_time_steps: IntProperty(
         name="BVH Time Steps",
         description="Split BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -794,6 +805,15 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Memory limit in megabytes for loading image textures on demand when rendering on the CPU, "
+        "0 loads image textures fully",
+        default=0,
+        min=0,
+        soft_max=65536,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
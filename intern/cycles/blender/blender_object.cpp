@@ -103,7 +103,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                                  bool use_particle_hair,
                                  bool show_lights,
                                  BlenderObjectCulling &culling,
-                                 bool *use_portal)
+                                 bool *use_portal,
+                                 BlenderGeometryTasks *geometry_tasks)
 {
   const bool is_instance = b_instance.is_instance();
   BL::Object b_ob = b_instance.object();
@@ -198,7 +199,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
       /* mesh deformation */
       if (object->geometry)
-        sync_geometry_motion(b_depsgraph, b_ob, object, motion_time, use_particle_hair);
+        sync_geometry_motion(
+            b_depsgraph, b_ob, object, motion_time, use_particle_hair, geometry_tasks);
     }
 
     return object;
@@ -212,7 +214,7 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
   /* mesh sync */
   object->geometry = sync_geometry(
-      b_depsgraph, b_ob, b_ob_instance, object_updated, use_particle_hair);
+      b_depsgraph, b_ob, b_ob_instance, object_updated, use_particle_hair, geometry_tasks);
 
   /* special case not tracked by object update flags */
 
@@ -354,6 +356,11 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
   bool use_portal = false;
   const bool show_lights = BlenderViewportParameters(b_v3d).use_scene_lights;
 
+  /* Geometry conversion is deferred until all objects are synced, and then done in parallel
+   * per object. Object sync sets geometry level settings like motion steps, which are read
+   * by the conversion, so those are final before any of the tasks run. */
+  BlenderGeometryTasks geometry_tasks;
+
   BL::ViewLayer b_view_layer = b_depsgraph.view_layer_eval();
 
   BL::Depsgraph::object_instances_iterator b_instance_iter;
@@ -381,7 +388,8 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   false,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geometry_tasks);
     }
 
     /* Particle hair as separate object. */
@@ -393,8 +401,24 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   true,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geometry_tasks);
+    }
+
+    cancel = progress.get_cancel();
+  }
+
+  if (!cancel) {
+    TaskPool geometry_task_pool;
+    for (BlenderGeometryTasks::value_type &object_tasks : geometry_tasks) {
+      vector<TaskRunFunction> &tasks = object_tasks.second;
+      geometry_task_pool.push([&tasks]() {
+        foreach (TaskRunFunction &task, tasks) {
+          task();
+        }
+      });
     }
+    geometry_task_pool.wait_work();
 
     cancel = progress.get_cancel();
   }
@@ -25,6 +25,7 @@
 
 #include "render/denoising.h"
 #include "render/merge.h"
+#include "render/stats.h"
 
 #include "util/util_debug.h"
 #include "util/util_foreach.h"
@@ -952,6 +953,60 @@ static PyObject *enable_print_stats_func(PyObject * /*self*/, PyObject * /*args*
   Py_RETURN_NONE;
 }
 
+static PyObject *named_size_stats_to_dict(const NamedSizeStats &stats)
+{
+  PyObject *dict = PyDict_New();
+  foreach (const NamedSizeEntry &entry, stats.entries) {
+    PyObject *size = PyLong_FromSize_t(entry.size);
+    PyDict_SetItemString(dict, entry.name.c_str(), size);
+    Py_DECREF(size);
+  }
+  return dict;
+}
+
+static PyObject *memory_stats_func(PyObject * /*self*/, PyObject *value)
+{
+  BlenderSession *session = (BlenderSession *)PyLong_AsVoidPtr(value);
+  if (session == NULL || session->session == NULL || session->session->scene == NULL) {
+    Py_RETURN_NONE;
+  }
+
+  RenderStats stats;
+  {
+    thread_scoped_lock scene_lock(session->session->scene->mutex);
+    session->session->collect_statistics(&stats);
+  }
+
+  /* Current and peak device memory, in total and per category. */
+  PyObject *categories = PyDict_New();
+  for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+    PyObject *usage = Py_BuildValue(
+        "(nn)",
+        (Py_ssize_t)stats.memory.category_mem_used[i],
+        (Py_ssize_t)stats.memory.category_mem_peak[i]);
+    PyDict_SetItemString(categories, memory_category_name((MemoryCategory)i), usage);
+    Py_DECREF(usage);
+  }
+
+  PyObject *geometry = named_size_stats_to_dict(stats.mesh.geometry);
+  PyObject *bvh = named_size_stats_to_dict(stats.mesh.bvh);
+  PyObject *images = named_size_stats_to_dict(stats.image.textures);
+
+  return Py_BuildValue("{s:n,s:n,s:N,s:N,s:N,s:N}",
+                       "used",
+                       (Py_ssize_t)stats.memory.mem_used,
+                       "peak",
+                       (Py_ssize_t)stats.memory.mem_peak,
+                       "categories",
+                       categories,
+                       "geometry",
+                       geometry,
+                       "bvh",
+                       bvh,
+                       "images",
+                       images);
+}
+
 static PyObject *get_device_types_func(PyObject * /*self*/, PyObject * /*args*/)
 {
   vector<DeviceType> device_types = Device::available_types();
@@ -999,6 +1054,7 @@ static PyMethodDef methods[] = {
 
     /* Statistics. */
     {"enable_print_stats", enable_print_stats_func, METH_NOARGS, ""},
+    {"memory_stats", memory_stats_func, METH_O, ""},
 
     /* Resumable render */
     {"set_resumable_chunk", set_resumable_chunk_func, METH_VARARGS, ""},
@@ -170,6 +170,14 @@ void BlenderSession::create_session()
 
 void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsgraph)
 {
+  /* With persistent data Blender keeps the depsgraph of the previous render as long as it is
+   * for the same data, scene and view layer. Only then can the synced data be updated from the
+   * depsgraph recalc flags, otherwise the evaluated datablocks it was synced from are gone. */
+  const bool same_depsgraph = scene && this->b_data.ptr.data == b_data.ptr.data &&
+                              this->b_depsgraph.ptr.data == b_depsgraph.ptr.data &&
+                              b_rlay_name == b_depsgraph.view_layer_eval().name() &&
+                              scene->name == b_depsgraph.scene_eval().name();
+
   /* Update data, scene and depsgraph pointers. These can change after undo. */
   this->b_data = b_data;
   this->b_depsgraph = b_depsgraph;
@@ -224,7 +232,6 @@ void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsg
   }
 
   session->progress.reset();
-  scene->reset();
 
   session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -233,11 +240,21 @@ void BlenderSession::reset_session(BL::BlendData &b_data, BL::Depsgraph &b_depsg
    */
   session->stats.mem_peak = session->stats.mem_used;
 
-  /* There is no single depsgraph to use for the entire render.
-   * See note on create_session().
-   */
-  /* sync object should be re-created */
-  sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+  if (same_depsgraph) {
+    /* Only update what changed since the previous frame, unchanged geometry, BVH, images and
+     * shaders stay on the device. */
+    sync->sync_recalc(b_depsgraph, b_v3d);
+  }
+  else if (!is_new_session) {
+    scene->reset();
+
+    /* There is no single depsgraph to use for the entire render.
+     * See note on create_session().
+     */
+    /* sync object should be re-created */
+    delete sync;
+    sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+  }
 
   BL::SpaceView3D b_null_space_view3d(PointerRNA_NULL);
   BL::RegionView3D b_null_region_view3d(PointerRNA_NULL);
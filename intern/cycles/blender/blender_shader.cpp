@@ -1498,7 +1498,8 @@ void BlenderSync::sync_shaders(BL::Depsgraph &b_depsgraph, BL::SpaceView3D &b_v3
   /* for auto refresh images */
   bool auto_refresh_update = false;
 
-  if (preview) {
+  /* With persistent data shaders are kept between frames of final renders too. */
+  if (preview || scene->params.persistent_data) {
     ImageManager *image_manager = scene->image_manager;
     int frame = b_scene.frame_current();
     auto_refresh_update = image_manager->set_animation_frame_update(frame);
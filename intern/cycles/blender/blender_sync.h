@@ -30,6 +30,7 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -51,6 +52,10 @@ class Shader;
 class ShaderGraph;
 class ShaderNode;
 
+/* Geometry conversion deferred during object sync, per Blender object. Mesh and particle hair
+ * conversion of one object both use its evaluated mesh, so they run in order in a single task. */
+typedef map<void *, vector<TaskRunFunction>> BlenderGeometryTasks;
+
 class BlenderSync {
  public:
   BlenderSync(BL::RenderEngine &b_engine,
@@ -145,7 +150,8 @@ class BlenderSync {
                       bool use_particle_hair,
                       bool show_lights,
                       BlenderObjectCulling &culling,
-                      bool *use_portal);
+                      bool *use_portal,
+                      BlenderGeometryTasks *geometry_tasks);
 
   /* Volume */
   void sync_volume(BL::Object &b_ob, Mesh *mesh, const vector<Shader *> &used_shaders);
@@ -177,12 +183,14 @@ class BlenderSync {
                           BL::Object &b_ob,
                           BL::Object &b_ob_instance,
                           bool object_updated,
-                          bool use_particle_hair);
+                          bool use_particle_hair,
+                          BlenderGeometryTasks *geometry_tasks);
   void sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                             BL::Object &b_ob,
                             Object *object,
                             float motion_time,
-                            bool use_particle_hair);
+                            bool use_particle_hair,
+                            BlenderGeometryTasks *geometry_tasks);
 
   /* Light */
   void sync_light(BL::Object &b_parent,
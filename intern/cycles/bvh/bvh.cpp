@@ -92,7 +92,13 @@ int BVHStackEntry::encodeIdx() const
 BVH::BVH(const BVHParams &params_,
          const vector<Geometry *> &geometry_,
          const vector<Object *> &objects_)
-    : params(params_), geometry(geometry_), objects(objects_)
+    : params(params_),
+      geometry(geometry_),
+      objects(objects_),
+      top_level_nodes_size(0),
+      top_level_leaf_nodes_size(0),
+      top_level_prims_size(0),
+      top_level_tri_verts_size(0)
 {
 }
 
@@ -182,13 +188,25 @@ void BVH::build(Progress &progress, Stats *)
 void BVH::refit(Progress &progress)
 {
   progress.set_substatus("Packing BVH primitives");
-  pack_primitives();
+  if (params.top_level) {
+    pack_top_level_primitives();
+  }
+  else {
+    pack_primitives();
+  }
 
   if (progress.get_cancel())
     return;
 
   progress.set_substatus("Refitting BVH nodes");
   refit_nodes();
+
+  if (params.top_level) {
+    /* Instance BVHs were refitted by their geometry, copy them in again. Their sizes are
+     * unchanged by refitting, so all offsets into the merged arrays stay valid. */
+    progress.set_substatus("Merging instance BVHs");
+    merge_instances();
+  }
 }
 
 void BVH::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility)
@@ -318,6 +336,34 @@ void BVH::pack_primitives()
   }
 }
 
+/* Update triangle vertices and visibility of the primitives in the top level part of the
+ * packed arrays, in place. Unlike pack_primitives() this leaves merged instance data alone, and
+ * primitive indices are already offset into the global arrays here. */
+void BVH::pack_top_level_primitives()
+{
+  assert(params.top_level);
+
+  for (size_t i = 0; i < top_level_prims_size; i++) {
+    const int pidx = pack.prim_index[i];
+    if (pidx == -1) {
+      continue;
+    }
+
+    const Object *ob = objects[pack.prim_object[i]];
+    if (pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) {
+      const Mesh *mesh = static_cast<const Mesh *>(ob->geometry);
+      const Mesh::Triangle t = mesh->get_triangle(pidx - mesh->prim_offset);
+      const float3 *vpos = &mesh->verts[0];
+      float4 *tri_verts = &pack.prim_tri_verts[pack.prim_tri_index[i]];
+
+      tri_verts[0] = float3_to_float4(vpos[t.v[0]]);
+      tri_verts[1] = float3_to_float4(vpos[t.v[1]]);
+      tri_verts[2] = float3_to_float4(vpos[t.v[2]]);
+    }
+    pack.prim_visibility[i] = ob->visibility_for_tracing();
+  }
+}
+
 /* Pack Instances */
 
 void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
@@ -331,8 +377,21 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
     }
   }
 
+  top_level_nodes_size = nodes_size;
+  top_level_leaf_nodes_size = leaf_nodes_size;
+  top_level_prims_size = pack.prim_index.size();
+  top_level_tri_verts_size = pack.prim_tri_verts.size();
+
+  merge_instances();
+}
+
+void BVH::merge_instances()
+{
+  size_t nodes_size = top_level_nodes_size;
+  size_t leaf_nodes_size = top_level_leaf_nodes_size;
+
   /* track offsets of instanced BVH data in global array */
-  size_t prim_offset = pack.prim_index.size();
+  size_t prim_offset = top_level_prims_size;
   size_t nodes_offset = nodes_size;
   size_t nodes_leaf_offset = leaf_nodes_size;
 
@@ -340,8 +399,8 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
   pack.object_node.clear();
 
   /* reserve */
-  size_t prim_index_size = pack.prim_index.size();
-  size_t prim_tri_verts_size = pack.prim_tri_verts.size();
+  size_t prim_index_size = top_level_prims_size;
+  size_t prim_tri_verts_size = top_level_tri_verts_size;
 
   size_t pack_prim_index_offset = prim_index_size;
   size_t pack_prim_tri_verts_offset = prim_tri_verts_size;
@@ -487,6 +546,10 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
           nsize = BVH_UNALIGNED_NODE_SIZE;
           nsize_bbox = 0;
         }
+        else if (bvh_nodes[i].x & PATH_RAY_NODE_COMPRESSED) {
+          nsize = BVH_COMPRESSED_NODE_SIZE;
+          nsize_bbox = 0;
+        }
         else {
           nsize = BVH_NODE_SIZE;
           nsize_bbox = 0;
@@ -74,6 +74,16 @@ struct PackedBVH {
   {
     root_index = 0;
   }
+
+  /* Total size of the packed arrays in bytes. */
+  size_t memory_size() const
+  {
+    return nodes.size() * sizeof(int4) + leaf_nodes.size() * sizeof(int4) +
+           object_node.size() * sizeof(int) + prim_tri_index.size() * sizeof(uint) +
+           prim_tri_verts.size() * sizeof(float4) + prim_type.size() * sizeof(int) +
+           prim_visibility.size() * sizeof(uint) + prim_index.size() * sizeof(int) +
+           prim_object.size() * sizeof(int) + prim_time.size() * sizeof(float2);
+  }
 };
 
 enum BVH_TYPE { bvh2 };
@@ -99,6 +109,8 @@ class BVH {
   {
   }
 
+  /* Refit the BVH after primitives moved, keeping the tree structure. For the top level BVH
+   * this also merges the (refitted) instance BVHs again. */
   void refit(Progress &progress);
 
  protected:
@@ -112,9 +124,17 @@ class BVH {
   /* triangles and strands */
   void pack_primitives();
   void pack_triangle(int idx, float4 storage[3]);
+  void pack_top_level_primitives();
 
   /* merge instance BVH's */
   void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
+  void merge_instances();
+
+  /* Size of the top level part of the packed arrays, instance BVHs are merged after it. */
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+  size_t top_level_prims_size;
+  size_t top_level_tri_verts_size;
 
   /* for subclasses to implement */
   virtual void pack_nodes(const BVHNode *root) = 0;
@@ -74,13 +74,24 @@ void BVH2::pack_aligned_inner(const BVHStackEntry &e,
                               const BVHStackEntry &e0,
                               const BVHStackEntry &e1)
 {
-  pack_aligned_node(e.idx,
-                    e0.node->bounds,
-                    e1.node->bounds,
-                    e0.encodeIdx(),
-                    e1.encodeIdx(),
-                    e0.node->visibility,
-                    e1.node->visibility);
+  if (params.use_compressed_nodes) {
+    pack_compressed_node(e.idx,
+                         e0.node->bounds,
+                         e1.node->bounds,
+                         e0.encodeIdx(),
+                         e1.encodeIdx(),
+                         e0.node->visibility,
+                         e1.node->visibility);
+  }
+  else {
+    pack_aligned_node(e.idx,
+                      e0.node->bounds,
+                      e1.node->bounds,
+                      e0.encodeIdx(),
+                      e1.encodeIdx(),
+                      e0.node->visibility,
+                      e1.node->visibility);
+  }
 }
 
 void BVH2::pack_aligned_node(int idx,
@@ -95,9 +106,9 @@ void BVH2::pack_aligned_node(int idx,
   assert(c0 < 0 || c0 < pack.nodes.size());
   assert(c1 < 0 || c1 < pack.nodes.size());
 
+  const uint node_flags = PATH_RAY_NODE_UNALIGNED | PATH_RAY_NODE_COMPRESSED;
   int4 data[BVH_NODE_SIZE] = {
-      make_int4(
-          visibility0 & ~PATH_RAY_NODE_UNALIGNED, visibility1 & ~PATH_RAY_NODE_UNALIGNED, c0, c1),
+      make_int4(visibility0 & ~node_flags, visibility1 & ~node_flags, c0, c1),
       make_int4(__float_as_int(b0.min.x),
                 __float_as_int(b1.min.x),
                 __float_as_int(b0.max.x),
@@ -115,6 +126,116 @@ void BVH2::pack_aligned_node(int idx,
   memcpy(&pack.nodes[idx], data, sizeof(int4) * BVH_NODE_SIZE);
 }
 
+/* Compressed nodes store the child bounds per axis as 8 bit offsets from the minimum of the
+ * node bounds, in units of a power of two scale. Offsets are rounded outwards and checked with
+ * the same arithmetic the kernel uses for decoding, so the decoded bounds always contain the
+ * original ones. */
+
+static uint bvh_quantize_lower(const float origin, const float scale, const float value)
+{
+  int q = (int)clamp(floorf((value - origin) / scale), 0.0f, 255.0f);
+  while (q > 0 && origin + (float)q * scale > value) {
+    q--;
+  }
+  return (uint)q;
+}
+
+static bool bvh_quantize_upper(const float origin,
+                               const float scale,
+                               const float value,
+                               uint *r_q)
+{
+  int q = (int)clamp(ceilf((value - origin) / scale), 0.0f, 255.0f);
+  while (q < 255 && origin + (float)q * scale < value) {
+    q++;
+  }
+  *r_q = (uint)q;
+  return origin + (float)q * scale >= value;
+}
+
+/* Returns the child bounds along one axis packed into 4 bytes, and the biased exponent of the
+ * scale in the same format as the exponent bits of a float. */
+static uint bvh_quantize_axis(const float origin,
+                              const float extent,
+                              const float lo0,
+                              const float hi0,
+                              const float lo1,
+                              const float hi1,
+                              uint *r_biased_exponent)
+{
+  int exponent = (extent > 0.0f) ? (int)ceilf(log2f(extent / 255.0f)) : -126;
+  exponent = clamp(exponent, -126, 127);
+
+  for (;; exponent++) {
+    const float scale = __uint_as_float((uint)(exponent + 127) << 23);
+    uint qhi0, qhi1;
+    const bool fits = bvh_quantize_upper(origin, scale, hi0, &qhi0) &
+                      bvh_quantize_upper(origin, scale, hi1, &qhi1);
+
+    /* Float rounding of the extent can make the estimated exponent one too small. */
+    if (fits || exponent == 127) {
+      *r_biased_exponent = (uint)(exponent + 127);
+      return bvh_quantize_lower(origin, scale, lo0) | (qhi0 << 8) |
+             (bvh_quantize_lower(origin, scale, lo1) << 16) | (qhi1 << 24);
+    }
+  }
+}
+
+void BVH2::pack_compressed_node(int idx,
+                                const BoundBox &b0,
+                                const BoundBox &b1,
+                                int c0,
+                                int c1,
+                                uint visibility0,
+                                uint visibility1)
+{
+  assert(idx + BVH_COMPRESSED_NODE_SIZE <= pack.nodes.size());
+  assert(c0 < 0 || c0 < pack.nodes.size());
+  assert(c1 < 0 || c1 < pack.nodes.size());
+
+  BoundBox bounds = BoundBox::empty;
+  if (b0.valid()) {
+    bounds.grow(b0);
+  }
+  if (b1.valid()) {
+    bounds.grow(b1);
+  }
+  if (!bounds.valid()) {
+    bounds = BoundBox(make_float3(0.0f, 0.0f, 0.0f));
+  }
+
+  /* Children without valid bounds are treated as covering the whole node. */
+  const BoundBox child0 = b0.valid() ? b0 : bounds;
+  const BoundBox child1 = b1.valid() ? b1 : bounds;
+  const float3 extent = bounds.max - bounds.min;
+
+  uint exponent[3], quantized[3];
+  for (int axis = 0; axis < 3; axis++) {
+    quantized[axis] = bvh_quantize_axis(bounds.min[axis],
+                                        extent[axis],
+                                        child0.min[axis],
+                                        child0.max[axis],
+                                        child1.min[axis],
+                                        child1.max[axis],
+                                        &exponent[axis]);
+  }
+
+  const uint node_flags = PATH_RAY_NODE_UNALIGNED | PATH_RAY_NODE_COMPRESSED;
+  int4 data[BVH_COMPRESSED_NODE_SIZE] = {
+      make_int4((visibility0 & ~node_flags) | PATH_RAY_NODE_COMPRESSED,
+                (visibility1 & ~node_flags) | PATH_RAY_NODE_COMPRESSED,
+                c0,
+                c1),
+      make_int4(__float_as_int(bounds.min.x),
+                __float_as_int(bounds.min.y),
+                __float_as_int(bounds.min.z),
+                exponent[0] | (exponent[1] << 8) | (exponent[2] << 16)),
+      make_int4(quantized[0], quantized[1], quantized[2], 0),
+  };
+
+  memcpy(&pack.nodes[idx], data, sizeof(int4) * BVH_COMPRESSED_NODE_SIZE);
+}
+
 void BVH2::pack_unaligned_inner(const BVHStackEntry &e,
                                 const BVHStackEntry &e0,
                                 const BVHStackEntry &e1)
@@ -147,8 +268,9 @@ void BVH2::pack_unaligned_node(int idx,
   float4 data[BVH_UNALIGNED_NODE_SIZE];
   Transform space0 = BVHUnaligned::compute_node_transform(bounds0, aligned_space0);
   Transform space1 = BVHUnaligned::compute_node_transform(bounds1, aligned_space1);
-  data[0] = make_float4(__int_as_float(visibility0 | PATH_RAY_NODE_UNALIGNED),
-                        __int_as_float(visibility1 | PATH_RAY_NODE_UNALIGNED),
+  data[0] = make_float4(
+      __int_as_float((visibility0 & ~PATH_RAY_NODE_COMPRESSED) | PATH_RAY_NODE_UNALIGNED),
+      __int_as_float((visibility1 & ~PATH_RAY_NODE_COMPRESSED) | PATH_RAY_NODE_UNALIGNED),
                         __int_as_float(c0),
                         __int_as_float(c1));
 
@@ -168,14 +290,16 @@ void BVH2::pack_nodes(const BVHNode *root)
   const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
   assert(num_leaf_nodes <= num_nodes);
   const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+  const int aligned_node_size = (params.use_compressed_nodes) ? BVH_COMPRESSED_NODE_SIZE :
+                                                                BVH_NODE_SIZE;
   size_t node_size;
   if (params.use_unaligned_nodes) {
     const size_t num_unaligned_nodes = root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
     node_size = (num_unaligned_nodes * BVH_UNALIGNED_NODE_SIZE) +
-                (num_inner_nodes - num_unaligned_nodes) * BVH_NODE_SIZE;
+                (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
   }
   else {
-    node_size = num_inner_nodes * BVH_NODE_SIZE;
+    node_size = num_inner_nodes * aligned_node_size;
   }
   /* Resize arrays */
   pack.nodes.clear();
@@ -198,7 +322,7 @@ void BVH2::pack_nodes(const BVHNode *root)
   }
   else {
     stack.push_back(BVHStackEntry(root, nextNodeIdx));
-    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_NODE_SIZE : BVH_NODE_SIZE;
+    nextNodeIdx += root->has_unaligned() ? BVH_UNALIGNED_NODE_SIZE : aligned_node_size;
   }
 
   while (stack.size()) {
@@ -220,7 +344,7 @@ void BVH2::pack_nodes(const BVHNode *root)
         else {
           idx[i] = nextNodeIdx;
           nextNodeIdx += e.node->get_child(i)->has_unaligned() ? BVH_UNALIGNED_NODE_SIZE :
-                                                                 BVH_NODE_SIZE;
+                                                                 aligned_node_size;
         }
       }
 
@@ -237,8 +361,8 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
+  /* For the top level BVH this only visits its own nodes, instances are leaves bounded by
+   * their object bounds. */
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -253,7 +377,14 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    BVH::refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance leaf of the top level BVH, see pack_leaf(). Takes the current object
+       * bounds and visibility, which may have changed since the build. */
+      BVH::refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+    }
+    else {
+      BVH::refit_primitives(c0, c1, bbox, visibility);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -264,10 +395,11 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4) * BVH_NODE_LEAF_SIZE);
   }
   else {
-    assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
+    assert(idx + BVH_COMPRESSED_NODE_SIZE <= pack.nodes.size());
 
     const int4 *data = &pack.nodes[idx];
     const bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+    const bool is_compressed = (data[0].x & PATH_RAY_NODE_COMPRESSED) != 0;
     const int c0 = data[0].z;
     const int c1 = data[0].w;
     /* refit inner node, set bbox from children */
@@ -282,6 +414,9 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
       pack_unaligned_node(
           idx, aligned_space, aligned_space, bbox0, bbox1, c0, c1, visibility0, visibility1);
     }
+    else if (is_compressed) {
+      pack_compressed_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
+    }
     else {
       pack_aligned_node(idx, bbox0, bbox1, c0, c1, visibility0, visibility1);
     }
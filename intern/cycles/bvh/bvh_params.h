@@ -74,6 +74,11 @@ class BVHParams {
    */
   bool use_unaligned_nodes;
 
+  /* Store aligned inner nodes with child bounds quantized to 8 bits relative to the
+   * node bounds, to reduce memory usage. Only used for BVH2.
+   */
+  bool use_compressed_nodes;
+
   /* Split time range to this number of steps and create leaf node for each
    * of this time steps.
    *
@@ -115,6 +120,7 @@ class BVHParams {
     top_level = false;
     bvh_layout = BVH_LAYOUT_BVH2;
     use_unaligned_nodes = false;
+    use_compressed_nodes = false;
 
     num_motion_curve_steps = 0;
     num_motion_triangle_steps = 0;
@@ -124,6 +130,17 @@ class BVHParams {
     curve_subdivisions = 4;
   }
 
+  bool modified(const BVHParams &params) const
+  {
+    return !(use_spatial_split == params.use_spatial_split && top_level == params.top_level &&
+             bvh_layout == params.bvh_layout &&
+             use_unaligned_nodes == params.use_unaligned_nodes &&
+             use_compressed_nodes == params.use_compressed_nodes &&
+             num_motion_curve_steps == params.num_motion_curve_steps &&
+             num_motion_triangle_steps == params.num_motion_triangle_steps &&
+             bvh_type == params.bvh_type && curve_subdivisions == params.curve_subdivisions);
+  }
+
   /* SAH costs */
   __forceinline float cost(int num_nodes, int num_primitives) const
   {
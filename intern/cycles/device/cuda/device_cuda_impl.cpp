@@ -881,7 +881,7 @@ CUDADevice::CUDAMem *CUDADevice::generic_alloc(device_memory &mem, size_t pitch_
 
   mem.device_pointer = (device_ptr)device_pointer;
   mem.device_size = size;
-  stats.mem_alloc(size);
+  stats.mem_alloc(size, mem.category());
 
   if (!mem.device_pointer) {
     return NULL;
@@ -964,7 +964,7 @@ void CUDADevice::generic_free(device_memory &mem)
       cuda_assert(cuMemFree(mem.device_pointer));
     }
 
-    stats.mem_free(mem.device_size);
+    stats.mem_free(mem.device_size, mem.category());
     mem.device_pointer = 0;
     mem.device_size = 0;
 
@@ -994,8 +994,15 @@ void CUDADevice::mem_copy_to(device_memory &mem)
     assert(!"mem_copy_to not supported for pixels.");
   }
   else if (mem.type == MEM_GLOBAL) {
-    global_free(mem);
-    global_alloc(mem);
+    if (mem.device_pointer && mem.is_resident(this)) {
+      /* Device memory is freed whenever the host size changes, so an existing allocation can
+       * be reused and only needs the new contents. */
+      generic_copy_to(mem);
+    }
+    else {
+      global_free(mem);
+      global_alloc(mem);
+    }
   }
   else if (mem.type == MEM_TEXTURE) {
     tex_free((device_texture &)mem);
@@ -1214,7 +1221,7 @@ void CUDADevice::tex_alloc(device_texture &mem)
 
     mem.device_pointer = (device_ptr)array_3d;
     mem.device_size = size;
-    stats.mem_alloc(size);
+    stats.mem_alloc(size, mem.category());
 
     cmem = &cuda_mem_map[&mem];
     cmem->texobject = 0;
@@ -1321,7 +1328,7 @@ void CUDADevice::tex_free(device_texture &mem)
     else if (cmem.array) {
       /* Free array. */
       cuArrayDestroy(cmem.array);
-      stats.mem_free(mem.device_size);
+      stats.mem_free(mem.device_size, mem.category());
       mem.device_pointer = 0;
       mem.device_size = 0;
 
@@ -2156,7 +2163,7 @@ void CUDADevice::pixels_alloc(device_memory &mem)
     pixel_mem_map[mem.device_pointer] = pmem;
 
     mem.device_size = mem.memory_size();
-    stats.mem_alloc(mem.device_size);
+    stats.mem_alloc(mem.device_size, mem.category());
 
     return;
   }
@@ -2197,7 +2204,7 @@ void CUDADevice::pixels_free(device_memory &mem)
     pixel_mem_map.erase(pixel_mem_map.find(mem.device_pointer));
     mem.device_pointer = 0;
 
-    stats.mem_free(mem.device_size);
+    stats.mem_free(mem.device_size, mem.category());
     mem.device_size = 0;
   }
 }
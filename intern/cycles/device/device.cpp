@@ -599,6 +599,10 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
 
   info.has_half_images = true;
   info.has_volume_decoupled = true;
+  info.has_light_tree = true;
+  info.has_image_cache = true;
+  info.has_sparse_volumes = true;
+  info.has_bvh_compressed_nodes = true;
   info.has_adaptive_stop_per_sample = true;
   info.has_osl = true;
   info.has_profiling = true;
@@ -644,6 +648,10 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
     /* Accumulate device info. */
     info.has_half_images &= device.has_half_images;
     info.has_volume_decoupled &= device.has_volume_decoupled;
+    info.has_light_tree &= device.has_light_tree;
+    info.has_image_cache &= device.has_image_cache;
+    info.has_sparse_volumes &= device.has_sparse_volumes;
+    info.has_bvh_compressed_nodes &= device.has_bvh_compressed_nodes;
     info.has_adaptive_stop_per_sample &= device.has_adaptive_stop_per_sample;
     info.has_osl &= device.has_osl;
     info.has_profiling &= device.has_profiling;
@@ -78,6 +78,10 @@ class DeviceInfo {
   bool display_device;               /* GPU is used as a display device. */
   bool has_half_images;              /* Support half-float textures. */
   bool has_volume_decoupled;         /* Decoupled volume shading. */
+  bool has_light_tree;               /* Light tree for many light sampling. */
+  bool has_image_cache;              /* Images paged in on demand through the image cache. */
+  bool has_sparse_volumes;           /* 3D textures stored as sparse voxel blocks. */
+  bool has_bvh_compressed_nodes;     /* BVH2 nodes with quantized child bounds. */
   bool has_adaptive_stop_per_sample; /* Per-sample adaptive sampling stopping. */
   bool has_osl;                      /* Support Open Shading Language. */
   bool use_split_kernel;             /* Use split or mega kernel. */
@@ -97,6 +101,10 @@ class DeviceInfo {
     display_device = false;
     has_half_images = false;
     has_volume_decoupled = false;
+    has_light_tree = false;
+    has_image_cache = false;
+    has_sparse_volumes = false;
+    has_bvh_compressed_nodes = false;
     has_adaptive_stop_per_sample = false;
     has_osl = false;
     use_split_kernel = false;
@@ -391,7 +391,7 @@ class CPUDevice : public Device {
       }
 
       mem.device_size = mem.memory_size();
-      stats.mem_alloc(mem.device_size);
+      stats.mem_alloc(mem.device_size, mem.category());
     }
   }
 
@@ -446,7 +446,7 @@ class CPUDevice : public Device {
         util_aligned_free((void *)mem.device_pointer);
       }
       mem.device_pointer = 0;
-      stats.mem_free(mem.device_size);
+      stats.mem_free(mem.device_size, mem.category());
       mem.device_size = 0;
     }
   }
@@ -471,14 +471,14 @@ class CPUDevice : public Device {
 
     mem.device_pointer = (device_ptr)mem.host_pointer;
     mem.device_size = mem.memory_size();
-    stats.mem_alloc(mem.device_size);
+    stats.mem_alloc(mem.device_size, mem.category());
   }
 
   void global_free(device_memory &mem)
   {
     if (mem.device_pointer) {
       mem.device_pointer = 0;
-      stats.mem_free(mem.device_size);
+      stats.mem_free(mem.device_size, mem.category());
       mem.device_size = 0;
     }
   }
@@ -491,7 +491,7 @@ class CPUDevice : public Device {
 
     mem.device_pointer = (device_ptr)mem.host_pointer;
     mem.device_size = mem.memory_size();
-    stats.mem_alloc(mem.device_size);
+    stats.mem_alloc(mem.device_size, mem.category());
 
     const uint slot = mem.slot;
     if (slot >= texture_info.size()) {
@@ -500,7 +500,9 @@ class CPUDevice : public Device {
     }
 
     texture_info[slot] = mem.info;
-    texture_info[slot].data = (uint64_t)mem.host_pointer;
+    if (!mem.info.use_cache) {
+      texture_info[slot].data = (uint64_t)mem.host_pointer;
+    }
     need_texture_info = true;
   }
 
@@ -508,7 +510,7 @@ class CPUDevice : public Device {
   {
     if (mem.device_pointer) {
       mem.device_pointer = 0;
-      stats.mem_free(mem.device_size);
+      stats.mem_free(mem.device_size, mem.category());
       mem.device_size = 0;
       need_texture_info = true;
     }
@@ -1574,7 +1576,10 @@ int2 CPUSplitKernel::split_kernel_global_size(device_memory & /*kg*/,
                                               device_memory & /*data*/,
                                               DeviceTask & /*task*/)
 {
-  return make_int2(1, 1);
+  /* Keep a batch of paths in flight per thread, so that intersection and shading work on many
+   * rays at once and the rays can be sorted by shader in between. The batch fits in a single
+   * shader sort block. */
+  return make_int2(32, 32);
 }
 
 uint64_t CPUSplitKernel::state_buffer_size(device_memory &kernel_globals,
@@ -1600,6 +1605,10 @@ void device_cpu_info(vector<DeviceInfo> &devices)
   info.id = "CPU";
   info.num = 0;
   info.has_volume_decoupled = true;
+  info.has_light_tree = true;
+  info.has_image_cache = true;
+  info.has_sparse_volumes = true;
+  info.has_bvh_compressed_nodes = true;
   info.has_adaptive_stop_per_sample = true;
   info.has_osl = true;
   info.has_half_images = true;
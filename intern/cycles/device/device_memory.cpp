@@ -130,6 +130,47 @@ bool device_memory::is_resident(Device *sub_device) const
   return device->is_resident(device_pointer, sub_device);
 }
 
+MemoryCategory device_memory::category() const
+{
+  if (type == MEM_TEXTURE) {
+    return MEM_CATEGORY_IMAGES;
+  }
+  if (name == NULL) {
+    return MEM_CATEGORY_OTHER;
+  }
+
+  static const struct {
+    const char *prefix;
+    MemoryCategory category;
+  } name_categories[] = {
+      {"__bvh_", MEM_CATEGORY_BVH},
+      {"__object_node", MEM_CATEGORY_BVH},
+      {"__prim_", MEM_CATEGORY_BVH},
+      {"__tri_", MEM_CATEGORY_GEOMETRY},
+      {"__curve", MEM_CATEGORY_GEOMETRY},
+      {"__patches", MEM_CATEGORY_GEOMETRY},
+      {"__object", MEM_CATEGORY_GEOMETRY},
+      {"__particles", MEM_CATEGORY_GEOMETRY},
+      {"__attributes_", MEM_CATEGORY_ATTRIBUTES},
+      {"__light", MEM_CATEGORY_LIGHTS},
+      {"__ies", MEM_CATEGORY_LIGHTS},
+      {"__svm_nodes", MEM_CATEGORY_SHADERS},
+      {"__shaders", MEM_CATEGORY_SHADERS},
+      {"RenderBuffers", MEM_CATEGORY_RENDER_BUFFERS},
+      {"display buffer", MEM_CATEGORY_RENDER_BUFFERS},
+      {"denoising", MEM_CATEGORY_DENOISING},
+      {"filter", MEM_CATEGORY_DENOISING},
+  };
+
+  for (size_t i = 0; i < sizeof(name_categories) / sizeof(*name_categories); i++) {
+    if (string_startswith(name, name_categories[i].prefix)) {
+      return name_categories[i].category;
+    }
+  }
+
+  return MEM_CATEGORY_OTHER;
+}
+
 /* Device Sub Ptr */
 
 device_sub_ptr::device_sub_ptr(device_memory &mem, int offset, int size) : device(mem.device)
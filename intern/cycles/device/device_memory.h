@@ -23,6 +23,7 @@
 
 #include "util/util_array.h"
 #include "util/util_half.h"
+#include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_texture.h"
 #include "util/util_types.h"
@@ -232,6 +233,9 @@ class device_memory {
 
   bool is_resident(Device *sub_device) const;
 
+  /* Category for memory statistics, derived from the type and name. */
+  MemoryCategory category() const;
+
  protected:
   friend class CUDADevice;
   friend class OptiXDevice;
@@ -325,7 +325,7 @@ class MultiDevice : public Device {
 
     mem.device = this;
     mem.device_pointer = key;
-    stats.mem_alloc(mem.device_size);
+    stats.mem_alloc(mem.device_size, mem.category());
   }
 
   void mem_copy_to(device_memory &mem)
@@ -368,7 +368,7 @@ class MultiDevice : public Device {
 
     mem.device = this;
     mem.device_pointer = key;
-    stats.mem_alloc(mem.device_size - existing_size);
+    stats.mem_alloc(mem.device_size - existing_size, mem.category());
   }
 
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
@@ -444,7 +444,7 @@ class MultiDevice : public Device {
 
     mem.device = this;
     mem.device_pointer = key;
-    stats.mem_alloc(mem.device_size - existing_size);
+    stats.mem_alloc(mem.device_size - existing_size, mem.category());
   }
 
   void mem_free(device_memory &mem)
@@ -500,7 +500,7 @@ class MultiDevice : public Device {
     mem.device = this;
     mem.device_pointer = 0;
     mem.device_size = 0;
-    stats.mem_free(existing_size);
+    stats.mem_free(existing_size, mem.category());
   }
 
   void const_copy_to(const char *name, void *host, size_t size)
@@ -968,7 +968,7 @@ void OpenCLDevice::mem_alloc(device_memory &mem)
     mem.device_pointer = 0;
   }
 
-  stats.mem_alloc(size);
+  stats.mem_alloc(size, mem.category());
   mem.device_size = size;
 }
 
@@ -1099,7 +1099,7 @@ void OpenCLDevice::mem_free(device_memory &mem)
       }
       mem.device_pointer = 0;
 
-      stats.mem_free(mem.device_size);
+      stats.mem_free(mem.device_size, mem.category());
       mem.device_size = 0;
     }
   }
@@ -28,6 +28,62 @@ ccl_device_forceinline Transform bvh_unaligned_node_fetch_space(KernelGlobals *k
   return space;
 }
 
+#ifdef __BVH_COMPRESSED_NODES__
+/* Child bounds are stored per axis as 8 bit offsets from the node bounds minimum, scaled by a
+ * power of two stored as float exponent bits. */
+ccl_device_forceinline int bvh_compressed_node_intersect(KernelGlobals *kg,
+                                                         const float3 P,
+                                                         const float3 idir,
+                                                         const float t,
+                                                         const int node_addr,
+                                                         const float4 cnodes,
+                                                         const uint visibility,
+                                                         float dist[2])
+{
+  /* fetch node data */
+  const float4 origin = kernel_tex_fetch(__bvh_nodes, node_addr + 1);
+  const float4 qnodes = kernel_tex_fetch(__bvh_nodes, node_addr + 2);
+
+  const uint exponents = __float_as_uint(origin.w);
+  const float scale_x = __uint_as_float((exponents & 0xff) << 23);
+  const float scale_y = __uint_as_float(((exponents >> 8) & 0xff) << 23);
+  const float scale_z = __uint_as_float(((exponents >> 16) & 0xff) << 23);
+
+  const uint qx = __float_as_uint(qnodes.x);
+  const uint qy = __float_as_uint(qnodes.y);
+  const uint qz = __float_as_uint(qnodes.z);
+
+  /* intersect ray against child nodes */
+  float c0lox = (origin.x + (float)(qx & 0xff) * scale_x - P.x) * idir.x;
+  float c0hix = (origin.x + (float)((qx >> 8) & 0xff) * scale_x - P.x) * idir.x;
+  float c0loy = (origin.y + (float)(qy & 0xff) * scale_y - P.y) * idir.y;
+  float c0hiy = (origin.y + (float)((qy >> 8) & 0xff) * scale_y - P.y) * idir.y;
+  float c0loz = (origin.z + (float)(qz & 0xff) * scale_z - P.z) * idir.z;
+  float c0hiz = (origin.z + (float)((qz >> 8) & 0xff) * scale_z - P.z) * idir.z;
+  float c0min = max4(0.0f, min(c0lox, c0hix), min(c0loy, c0hiy), min(c0loz, c0hiz));
+  float c0max = min4(t, max(c0lox, c0hix), max(c0loy, c0hiy), max(c0loz, c0hiz));
+
+  float c1lox = (origin.x + (float)((qx >> 16) & 0xff) * scale_x - P.x) * idir.x;
+  float c1hix = (origin.x + (float)(qx >> 24) * scale_x - P.x) * idir.x;
+  float c1loy = (origin.y + (float)((qy >> 16) & 0xff) * scale_y - P.y) * idir.y;
+  float c1hiy = (origin.y + (float)(qy >> 24) * scale_y - P.y) * idir.y;
+  float c1loz = (origin.z + (float)((qz >> 16) & 0xff) * scale_z - P.z) * idir.z;
+  float c1hiz = (origin.z + (float)(qz >> 24) * scale_z - P.z) * idir.z;
+  float c1min = max4(0.0f, min(c1lox, c1hix), min(c1loy, c1hiy), min(c1loz, c1hiz));
+  float c1max = min4(t, max(c1lox, c1hix), max(c1loy, c1hiy), max(c1loz, c1hiz));
+
+  dist[0] = c0min;
+  dist[1] = c1min;
+
+#  ifdef __VISIBILITY_FLAG__
+  return (((c0max >= c0min) && (__float_as_uint(cnodes.x) & visibility)) ? 1 : 0) |
+         (((c1max >= c1min) && (__float_as_uint(cnodes.y) & visibility)) ? 2 : 0);
+#  else
+  return ((c0max >= c0min) ? 1 : 0) | ((c1max >= c1min) ? 2 : 0);
+#  endif
+}
+#endif /* __BVH_COMPRESSED_NODES__ */
+
 ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
                                                       const float3 P,
                                                       const float3 idir,
@@ -38,8 +94,13 @@ ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
 {
 
   /* fetch node data */
-#ifdef __VISIBILITY_FLAG__
+#if defined(__VISIBILITY_FLAG__) || defined(__BVH_COMPRESSED_NODES__)
   float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr + 0);
+#endif
+#ifdef __BVH_COMPRESSED_NODES__
+  if (__float_as_uint(cnodes.x) & PATH_RAY_NODE_COMPRESSED) {
+    return bvh_compressed_node_intersect(kg, P, idir, t, node_addr, cnodes, visibility, dist);
+  }
 #endif
   float4 node0 = kernel_tex_fetch(__bvh_nodes, node_addr + 1);
   float4 node1 = kernel_tex_fetch(__bvh_nodes, node_addr + 2);
@@ -15,6 +15,7 @@
  */
 
 #include "kernel_light_background.h"
+#include "kernel_light_tree.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -328,12 +329,21 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
-                                                const float3 Ng,
-                                                const float3 I,
-                                                float t)
+/* Probability density per unit area of picking a point on the triangle, given the probability
+ * of the light tree having picked the triangle. Without light tree it is the same for all
+ * emissive triangles. */
+ccl_device_inline float triangle_light_select_pdf(KernelGlobals *kg, float tree_pdf, float area)
+{
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    return (area > 0.0f) ? tree_pdf / area : 0.0f;
+  }
+#endif
+  return kernel_data.integrator.pdf_triangles;
+}
+
+ccl_device_inline float triangle_light_pdf_area(float pdf, const float3 Ng, const float3 I, float t)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -358,10 +368,18 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float3 N = cross(e0, e1);
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
 
+  /* sd contains the point on the light source
+   * calculate Px, the point that we're shading */
+  const float3 Px = sd->P + sd->I * t;
+
+  float tree_pdf = 0.0f;
+#ifdef __LIGHT_TREE__
+  if (kernel_data.integrator.use_light_tree) {
+    tree_pdf = light_tree_triangle_pdf(kg, sd->object, sd->prim, Px);
+  }
+#endif
+
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
-    /* sd contains the point on the light source
-     * calculate Px, the point that we're shading */
-    const float3 Px = sd->P + sd->I * t;
     const float3 v0_p = V[0] - Px;
     const float3 v1_p = V[1] - Px;
     const float3 v2_p = V[2] - Px;
@@ -389,12 +407,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       else {
         area = 0.5f * len(N);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * triangle_light_select_pdf(kg, tree_pdf, area);
       return pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
     if (has_motion) {
       const float area = 0.5f * len(N);
       if (UNLIKELY(area == 0.0f)) {
@@ -405,9 +422,12 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
        * area_pre = the are from which pdf_triangles was calculated from */
       triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
       const float area_pre = triangle_area(V[0], V[1], V[2]);
-      pdf = pdf * area_pre / area;
+      const float pdf = triangle_light_pdf_area(
+          triangle_light_select_pdf(kg, tree_pdf, area_pre), sd->Ng, sd->I, t);
+      return pdf * area_pre / area;
     }
-    return pdf;
+    return triangle_light_pdf_area(
+        triangle_light_select_pdf(kg, tree_pdf, 0.5f * len(N)), sd->Ng, sd->I, t);
   }
 }
 
@@ -417,6 +437,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
                                                   float randu,
                                                   float randv,
                                                   float time,
+                                                  float tree_pdf,
                                                   LightSample *ls,
                                                   const float3 P)
 {
@@ -542,7 +563,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
         triangle_world_space_vertices(kg, object, prim, -1.0f, V);
         area = triangle_area(V[0], V[1], V[2]);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * triangle_light_select_pdf(kg, tree_pdf, area);
       ls->pdf = pdf / solid_angle;
     }
   }
@@ -564,15 +585,20 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
     if (has_motion && area != 0.0f) {
       /* scale the PDF.
        * area = the area the sample was taken from
        * area_pre = the are from which pdf_triangles was calculated from */
       triangle_world_space_vertices(kg, object, prim, -1.0f, V);
       const float area_pre = triangle_area(V[0], V[1], V[2]);
+      ls->pdf = triangle_light_pdf_area(
+          triangle_light_select_pdf(kg, tree_pdf, area_pre), ls->Ng, -ls->D, ls->t);
       ls->pdf = ls->pdf * area_pre / area;
     }
+    else {
+      ls->pdf = triangle_light_pdf_area(
+          triangle_light_select_pdf(kg, tree_pdf, area), ls->Ng, -ls->D, ls->t);
+    }
     ls->u = u;
     ls->v = v;
   }
@@ -633,8 +659,25 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
   if (lamp < 0) {
-    /* sample index */
-    int index = light_distribution_sample(kg, &randu);
+    float tree_pdf = 0.0f;
+    int index;
+
+#ifdef __LIGHT_TREE__
+    /* Emissive triangles occupy the first pdf_light_tree part of the distribution, pick
+     * those through the light tree and lamps through the distribution as usual. */
+    if (kernel_data.integrator.use_light_tree && randu < kernel_data.integrator.pdf_light_tree) {
+      randu = randu / kernel_data.integrator.pdf_light_tree;
+      index = light_tree_sample(kg, P, &randu, &tree_pdf);
+      if (tree_pdf == 0.0f) {
+        return false;
+      }
+    }
+    else
+#endif
+    {
+      /* sample index */
+      index = light_distribution_sample(kg, &randu);
+    }
 
     /* fetch light data */
     const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
@@ -645,7 +688,7 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
       int object = kdistribution->mesh_light.object_id;
       int shader_flag = kdistribution->mesh_light.shader_flag;
 
-      triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+      triangle_light_sample(kg, prim, object, randu, randv, time, tree_pdf, ls, P);
       ls->shader |= shader_flag;
       return (ls->pdf > 0.0f);
     }
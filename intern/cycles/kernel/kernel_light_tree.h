@@ -0,0 +1,154 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __LIGHT_TREE__
+
+/* Light Tree
+ *
+ * Hierarchy over the emissive triangles of the light distribution, used to pick a triangle
+ * proportional to an estimate of its contribution at the shading point instead of its area
+ * alone. Lamps keep being picked uniformly from the light distribution. */
+
+ccl_device_inline float light_tree_node_importance(const ccl_global KernelLightTreeNode *knode,
+                                                   const float3 P)
+{
+  const float3 bounds_min = make_float3(
+      knode->bounds_min[0], knode->bounds_min[1], knode->bounds_min[2]);
+  const float3 bounds_max = make_float3(
+      knode->bounds_max[0], knode->bounds_max[1], knode->bounds_max[2]);
+
+  /* Energy falls off with squared distance to the node, clamped to the node extent so
+   * shading points inside or near the node don't get an infinite importance. */
+  const float distance_squared = len_squared(P - 0.5f * (bounds_min + bounds_max));
+  const float radius_squared = 0.25f * len_squared(bounds_max - bounds_min);
+
+  return knode->energy / max(max(distance_squared, radius_squared), FLT_MIN);
+}
+
+/* Probability of descending into the left child of an inner node. */
+ccl_device_inline float light_tree_left_probability(KernelGlobals *kg, int node, const float3 P)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+  const float importance_left = light_tree_node_importance(
+      &kernel_tex_fetch(__light_tree_nodes, node + 1), P);
+  const float importance_right = light_tree_node_importance(
+      &kernel_tex_fetch(__light_tree_nodes, knode->child_index), P);
+  const float importance = importance_left + importance_right;
+
+  return (importance > 0.0f) ? importance_left / importance : 0.5f;
+}
+
+/* Pick an emissive triangle for shading point P. Returns the index in the light distribution
+ * and the probability of having picked it, randu is rescaled to be reused for sampling the
+ * triangle itself. */
+ccl_device int light_tree_sample(KernelGlobals *kg, const float3 P, float *randu, float *pdf)
+{
+  float r = *randu;
+  float p = 1.0f;
+
+  int node = 0;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+
+  while (knode->num_emitters == 0) {
+    const float p_left = light_tree_left_probability(kg, node, P);
+
+    if (r < p_left) {
+      r = r / p_left;
+      p *= p_left;
+      node = node + 1;
+    }
+    else {
+      r = (r - p_left) / (1.0f - p_left);
+      p *= 1.0f - p_left;
+      node = knode->child_index;
+    }
+
+    knode = &kernel_tex_fetch(__light_tree_nodes, node);
+  }
+
+  /* Pick emitter in the leaf proportional to its energy. */
+  const int first = knode->child_index;
+  const int last = first + knode->num_emitters - 1;
+  const float target = r * knode->energy;
+  float energy_sum = 0.0f;
+  int index = last;
+
+  for (int i = first; i < last; i++) {
+    const float energy = kernel_tex_fetch(__light_tree_emitters, i).energy;
+    if (target < energy_sum + energy) {
+      index = i;
+      break;
+    }
+    energy_sum += energy;
+  }
+
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                         index);
+
+  if (kemitter->energy > 0.0f) {
+    *randu = min((target - energy_sum) / kemitter->energy, 1.0f);
+    *pdf = p * (kemitter->energy / knode->energy) * kernel_data.integrator.pdf_light_tree;
+  }
+  else {
+    *pdf = 0.0f;
+  }
+
+  return kemitter->distribution_index;
+}
+
+/* Probability of light_tree_sample picking the triangle, for multiple importance sampling. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, int object, int prim, const float3 P)
+{
+  const uint prim_map_offset = kernel_tex_fetch(__light_tree_object_map, object * 2);
+  if (prim_map_offset == LIGHT_TREE_NONE) {
+    return 0.0f;
+  }
+
+  const uint prim_offset = kernel_tex_fetch(__light_tree_object_map, object * 2 + 1);
+  const uint emitter = kernel_tex_fetch(__light_tree_prim_map, prim_map_offset + prim - prim_offset);
+  if (emitter == LIGHT_TREE_NONE) {
+    return 0.0f;
+  }
+
+  const ccl_global KernelLightTreeEmitter *kemitter = &kernel_tex_fetch(__light_tree_emitters,
+                                                                         emitter);
+  int node = kemitter->node;
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, node);
+
+  if (knode->energy == 0.0f) {
+    return 0.0f;
+  }
+
+  float pdf = kemitter->energy / knode->energy;
+
+  /* Walk up to the root, accumulating the probabilities of the branches taken. */
+  int parent = knode->parent;
+  while (parent != -1) {
+    const float p_left = light_tree_left_probability(kg, parent, P);
+    pdf *= (node == parent + 1) ? p_left : 1.0f - p_left;
+
+    node = parent;
+    parent = kernel_tex_fetch(__light_tree_nodes, node).parent;
+  }
+
+  return pdf * kernel_data.integrator.pdf_light_tree;
+}
+
+#endif /* __LIGHT_TREE__ */
+
+CCL_NAMESPACE_END
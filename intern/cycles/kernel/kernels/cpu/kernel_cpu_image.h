@@ -251,12 +251,68 @@ template<typename T> struct TextureInterpolator {
     }
   }
 
+  /* ********  3D voxel access ******** */
+
+  /* Voxels stored densely in x, y, z order. */
+  struct DenseVoxels {
+    const T *data;
+    int width, height;
+
+    ccl_always_inline DenseVoxels(const TextureInfo &info)
+        : data((const T *)info.data), width(info.width), height(info.height)
+    {
+    }
+
+    ccl_always_inline float4 operator()(int x, int y, int z) const
+    {
+      return read(data[x + y * width + z * width * height]);
+    }
+  };
+
+  /* Voxels stored in sparse blocks, see util_texture.h for the layout. */
+  struct SparseVoxels {
+    const uint *index;
+    const uint *nodes;
+    const T *leaves;
+    int grid_width, grid_height;
+
+    ccl_always_inline SparseVoxels(const TextureInfo &info)
+    {
+      index = (const uint *)info.data;
+      nodes = index + index[0];
+      leaves = (const T *)(index + index[1]);
+      grid_width = (info.width + TEX_SPARSE_NODE_DIM - 1) / TEX_SPARSE_NODE_DIM;
+      grid_height = (info.height + TEX_SPARSE_NODE_DIM - 1) / TEX_SPARSE_NODE_DIM;
+    }
+
+    ccl_always_inline float4 operator()(int x, int y, int z) const
+    {
+      const int node_shift = TEX_SPARSE_LEAF_LOG2 + TEX_SPARSE_NODE_LOG2;
+      const int node_mask = TEX_SPARSE_NODE_SIZE - 1;
+      const int leaf_mask = TEX_SPARSE_LEAF_SIZE - 1;
+
+      const uint node = index[TEX_SPARSE_HEADER_SIZE + (x >> node_shift) +
+                              grid_width * ((y >> node_shift) + grid_height * (z >> node_shift))];
+
+      const int lx = (x >> TEX_SPARSE_LEAF_LOG2) & node_mask;
+      const int ly = (y >> TEX_SPARSE_LEAF_LOG2) & node_mask;
+      const int lz = (z >> TEX_SPARSE_LEAF_LOG2) & node_mask;
+      const uint leaf = nodes[node * TEX_SPARSE_NODE_LEAVES + lx +
+                              TEX_SPARSE_NODE_SIZE * (ly + TEX_SPARSE_NODE_SIZE * lz)];
+
+      const int vx = x & leaf_mask;
+      const int vy = y & leaf_mask;
+      const int vz = z & leaf_mask;
+      return read(leaves[(size_t)leaf * TEX_SPARSE_LEAF_VOXELS + vx +
+                         TEX_SPARSE_LEAF_SIZE * (vy + TEX_SPARSE_LEAF_SIZE * vz)]);
+    }
+  };
+
   /* ********  3D interpolation ******** */
 
-  static ccl_always_inline float4 interp_3d_closest(const TextureInfo &info,
-                                                    float x,
-                                                    float y,
-                                                    float z)
+  template<typename Voxels>
+  static ccl_always_inline float4 interp_3d_closest(
+      const TextureInfo &info, const Voxels &voxels, float x, float y, float z)
   {
     int width = info.width;
     int height = info.height;
@@ -288,14 +344,12 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
-    return read(data[ix + iy * width + iz * width * height]);
+    return voxels(ix, iy, iz);
   }
 
-  static ccl_always_inline float4 interp_3d_linear(const TextureInfo &info,
-                                                   float x,
-                                                   float y,
-                                                   float z)
+  template<typename Voxels>
+  static ccl_always_inline float4 interp_3d_linear(
+      const TextureInfo &info, const Voxels &voxels, float x, float y, float z)
   {
     int width = info.width;
     int height = info.height;
@@ -336,19 +390,17 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
     float4 r;
 
-    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) *
-        read(data[ix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * (1.0f - ty) * tx * read(data[nix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * (1.0f - tx) * read(data[ix + niy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * tx * read(data[nix + niy * width + iz * width * height]);
+    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) * voxels(ix, iy, iz);
+    r += (1.0f - tz) * (1.0f - ty) * tx * voxels(nix, iy, iz);
+    r += (1.0f - tz) * ty * (1.0f - tx) * voxels(ix, niy, iz);
+    r += (1.0f - tz) * ty * tx * voxels(nix, niy, iz);
 
-    r += tz * (1.0f - ty) * (1.0f - tx) * read(data[ix + iy * width + niz * width * height]);
-    r += tz * (1.0f - ty) * tx * read(data[nix + iy * width + niz * width * height]);
-    r += tz * ty * (1.0f - tx) * read(data[ix + niy * width + niz * width * height]);
-    r += tz * ty * tx * read(data[nix + niy * width + niz * width * height]);
+    r += tz * (1.0f - ty) * (1.0f - tx) * voxels(ix, iy, niz);
+    r += tz * (1.0f - ty) * tx * voxels(nix, iy, niz);
+    r += tz * ty * (1.0f - tx) * voxels(ix, niy, niz);
+    r += tz * ty * tx * voxels(nix, niy, niz);
 
     return r;
   }
@@ -359,13 +411,15 @@ template<typename T> struct TextureInterpolator {
    * Only happens for AVX2 kernel and global __KERNEL_SSE__ vectorization
    * enabled.
    */
+  template<typename Voxels>
 #if defined(__GNUC__) || defined(__clang__)
   static ccl_always_inline
 #else
   static ccl_never_inline
 #endif
       float4
-      interp_3d_tricubic(const TextureInfo &info, float x, float y, float z)
+      interp_3d_tricubic(
+          const TextureInfo &info, const Voxels &voxels, float x, float y, float z)
   {
     int width = info.width;
     int height = info.height;
@@ -424,15 +478,14 @@ template<typename T> struct TextureInterpolator {
     }
 
     const int xc[4] = {pix, ix, nix, nnix};
-    const int yc[4] = {width * piy, width * iy, width * niy, width * nniy};
-    const int zc[4] = {
-        width * height * piz, width * height * iz, width * height * niz, width * height * nniz};
+    const int yc[4] = {piy, iy, niy, nniy};
+    const int zc[4] = {piz, iz, niz, nniz};
     float u[4], v[4], w[4];
 
     /* Some helper macro to keep code reasonable size,
      * let compiler to inline all the matrix multiplications.
      */
-#define DATA(x, y, z) (read(data[xc[x] + yc[y] + zc[z]]))
+#define DATA(x, y, z) (voxels(xc[x], yc[y], zc[z]))
 #define COL_TERM(col, row) \
   (v[col] * (u[0] * DATA(0, col, row) + u[1] * DATA(1, col, row) + u[2] * DATA(2, col, row) + \
              u[3] * DATA(3, col, row)))
@@ -444,7 +497,6 @@ template<typename T> struct TextureInterpolator {
     SET_CUBIC_SPLINE_WEIGHTS(w, tz);
 
     /* Actual interpolation. */
-    const T *data = (const T *)info.data;
     return ROW_TERM(0) + ROW_TERM(1) + ROW_TERM(2) + ROW_TERM(3);
 
 #undef COL_TERM
@@ -458,13 +510,27 @@ template<typename T> struct TextureInterpolator {
     if (UNLIKELY(!info.data))
       return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
+    if (info.use_sparse) {
+      return interp_3d(info, SparseVoxels(info), x, y, z, interp);
+    }
+    return interp_3d(info, DenseVoxels(info), x, y, z, interp);
+  }
+
+  template<typename Voxels>
+  static ccl_always_inline float4 interp_3d(const TextureInfo &info,
+                                            const Voxels &voxels,
+                                            float x,
+                                            float y,
+                                            float z,
+                                            InterpolationType interp)
+  {
     switch ((interp == INTERPOLATION_NONE) ? info.interpolation : interp) {
       case INTERPOLATION_CLOSEST:
-        return interp_3d_closest(info, x, y, z);
+        return interp_3d_closest(info, voxels, x, y, z);
       case INTERPOLATION_LINEAR:
-        return interp_3d_linear(info, x, y, z);
+        return interp_3d_linear(info, voxels, x, y, z);
       default:
-        return interp_3d_tricubic(info, x, y, z);
+        return interp_3d_tricubic(info, voxels, x, y, z);
     }
   }
 #undef SET_CUBIC_SPLINE_WEIGHTS
@@ -474,6 +540,10 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
+  if (info.use_cache) {
+    return ((const TextureCacheImage *)info.data)->lookup(x, y, 0.0f);
+  }
+
   switch (info.data_type) {
     case IMAGE_DATA_TYPE_HALF:
       return TextureInterpolator<half>::interp(info, x, y);
@@ -498,6 +568,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Lookup with a filter width in normalized texture coordinates, used to pick the mip level for
+ * images in the image cache. Other images ignore the filter width. */
+ccl_device float4
+kernel_tex_image_interp_filtered(KernelGlobals *kg, int id, float x, float y, float width)
+{
+  const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
+
+  if (info.use_cache) {
+    return ((const TextureCacheImage *)info.data)->lookup(x, y, width);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg,
                                              int id,
                                              float3 P,
@@ -16,6 +16,48 @@
 
 CCL_NAMESPACE_BEGIN
 
+#ifdef __KERNEL_CPU__
+/* Stable bottom-up merge sort of the block indices by shader, done by a single thread since the
+ * local size is one on the CPU. Keeping the order of rays with the same shader stable preserves
+ * the pixel coherence of the queue as much as possible. */
+ccl_device_inline void kernel_shader_sort_block_cpu(const uint *local_value,
+                                                    ushort *local_index,
+                                                    uint num)
+{
+  ushort scratch[SHADER_SORT_BLOCK_SIZE];
+  ushort *src = local_index;
+  ushort *dst = scratch;
+
+  for (uint width = 1; width < num; width <<= 1) {
+    for (uint start = 0; start < num; start += 2 * width) {
+      uint mid = (start + width < num) ? start + width : num;
+      uint end = (start + 2 * width < num) ? start + 2 * width : num;
+      uint i = start, j = mid, k = start;
+
+      while (i < mid && j < end) {
+        dst[k++] = (local_value[src[j]] < local_value[src[i]]) ? src[j++] : src[i++];
+      }
+      while (i < mid) {
+        dst[k++] = src[i++];
+      }
+      while (j < end) {
+        dst[k++] = src[j++];
+      }
+    }
+
+    ushort *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != local_index) {
+    for (uint i = 0; i < num; i++) {
+      local_index[i] = src[i];
+    }
+  }
+}
+#endif /* __KERNEL_CPU__ */
+
 ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSortLocals *locals)
 {
 #ifndef __KERNEL_CUDA__
@@ -54,7 +96,6 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
   }
   ccl_barrier(CCL_LOCAL_MEM_FENCE);
 
-  /* skip sorting for cpu split kernel */
 #  ifdef __KERNEL_OPENCL__
 
   /* bitonic sort */
@@ -77,6 +118,10 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
       }
     }
   }
+#  elif defined(__KERNEL_CPU__)
+  uint num = qsize - offset;
+  kernel_shader_sort_block_cpu(
+      local_value, local_index, (num < SHADER_SORT_BLOCK_SIZE) ? num : SHADER_SORT_BLOCK_SIZE);
 #  endif /* __KERNEL_OPENCL__ */
 
   /* copy to destination */
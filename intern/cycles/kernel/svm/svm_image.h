@@ -16,14 +16,19 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint flags)
+ccl_device float4
+svm_image_texture(KernelGlobals *kg, int id, float x, float y, float width, uint flags)
 {
   if (id == -1) {
     return make_float4(
         TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
   }
 
+#ifdef __IMAGE_CACHE__
+  float4 r = kernel_tex_image_interp_filtered(kg, id, x, y, width);
+#else
   float4 r = kernel_tex_image_interp(kg, id, x, y);
+#endif
   const float alpha = r.w;
 
   if ((flags & NODE_IMAGE_ALPHA_UNASSOCIATE) && alpha != 1.0f && alpha != 0.0f) {
@@ -44,6 +49,46 @@ ccl_device_inline float3 texco_remap_square(float3 co)
   return (co - make_float3(0.5f, 0.5f, 0.5f)) * 2.0f;
 }
 
+ccl_device_inline float2 svm_image_project(float3 co, uint projection)
+{
+  if (projection == NODE_IMAGE_PROJ_SPHERE) {
+    return map_to_sphere(texco_remap_square(co));
+  }
+  else if (projection == NODE_IMAGE_PROJ_TUBE) {
+    return map_to_tube(texco_remap_square(co));
+  }
+  return make_float2(co.x, co.y);
+}
+
+/* Filter width for picking the mip level of cached images, from the texture coordinates at the
+ * shading point and at the points shifted by the ray differentials. Coordinates that wrap
+ * around in u take the shortest way. */
+ccl_device_inline float svm_image_filter_width(
+    float2 uv, float2 uv_dx, float2 uv_dy, bool wrap_u)
+{
+  float2 dx = uv_dx - uv;
+  float2 dy = uv_dy - uv;
+  if (wrap_u) {
+    dx.x -= floorf(dx.x + 0.5f);
+    dy.x -= floorf(dy.x + 0.5f);
+  }
+  return max(len(dx), len(dy));
+}
+
+/* Read the stack offsets of the differential texture coordinates following the node, when the
+ * shader graph provides them. */
+ccl_device_inline bool svm_image_differentials(
+    KernelGlobals *kg, uint flags, int *offset, uint *dx_offset, uint *dy_offset)
+{
+  if (!(flags & NODE_IMAGE_DIFFERENTIALS)) {
+    return false;
+  }
+  uint4 node = read_node(kg, offset);
+  *dx_offset = node.x;
+  *dy_offset = node.y;
+  return true;
+}
+
 ccl_device void svm_node_tex_image(
     KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
@@ -52,17 +97,16 @@ ccl_device void svm_node_tex_image(
   svm_unpack_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &flags);
 
   float3 co = stack_load_float3(stack, co_offset);
-  float2 tex_co;
-  if (node.w == NODE_IMAGE_PROJ_SPHERE) {
-    co = texco_remap_square(co);
-    tex_co = map_to_sphere(co);
-  }
-  else if (node.w == NODE_IMAGE_PROJ_TUBE) {
-    co = texco_remap_square(co);
-    tex_co = map_to_tube(co);
-  }
-  else {
-    tex_co = make_float2(co.x, co.y);
+  float2 tex_co = svm_image_project(co, node.w);
+
+  /* Differentials are sampled without the tile offset, which does not change the width. */
+  float width = 0.0f;
+  uint dx_offset, dy_offset;
+  if (svm_image_differentials(kg, flags, offset, &dx_offset, &dy_offset)) {
+    const float2 tex_co_dx = svm_image_project(stack_load_float3(stack, dx_offset), node.w);
+    const float2 tex_co_dy = svm_image_project(stack_load_float3(stack, dy_offset), node.w);
+    const bool wrap_u = (node.w == NODE_IMAGE_PROJ_SPHERE || node.w == NODE_IMAGE_PROJ_TUBE);
+    width = svm_image_filter_width(tex_co, tex_co_dx, tex_co_dy, wrap_u);
   }
 
   /* TODO(lukas): Consider moving tile information out of the SVM node.
@@ -108,7 +152,7 @@ ccl_device void svm_node_tex_image(
     id = -num_nodes;
   }
 
-  float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, flags);
+  float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, width, flags);
 
   if (stack_valid(out_offset))
     stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -116,7 +160,8 @@ ccl_device void svm_node_tex_image(
     stack_store_float(stack, alpha_offset, f.w);
 }
 
-ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
+ccl_device void svm_node_tex_image_box(
+    KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
   /* get object space normal */
   float3 N = sd->N;
@@ -193,20 +238,31 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
   float3 co = stack_load_float3(stack, co_offset);
   uint id = node.y;
 
+  /* Each side is projected along one axis, its differentials are the ones of the other two. */
+  float3 width = make_float3(0.0f, 0.0f, 0.0f);
+  uint dx_offset, dy_offset;
+  if (svm_image_differentials(kg, flags, offset, &dx_offset, &dy_offset)) {
+    const float3 dx = stack_load_float3(stack, dx_offset) - co;
+    const float3 dy = stack_load_float3(stack, dy_offset) - co;
+    width.x = max(len(make_float2(dx.y, dx.z)), len(make_float2(dy.y, dy.z)));
+    width.y = max(len(make_float2(dx.x, dx.z)), len(make_float2(dy.x, dy.z)));
+    width.z = max(len(make_float2(dx.x, dx.y)), len(make_float2(dy.x, dy.y)));
+  }
+
   float4 f = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
   /* Map so that no textures are flipped, rotation is somewhat arbitrary. */
   if (weight.x > 0.0f) {
     float2 uv = make_float2((signed_N.x < 0.0f) ? 1.0f - co.y : co.y, co.z);
-    f += weight.x * svm_image_texture(kg, id, uv.x, uv.y, flags);
+    f += weight.x * svm_image_texture(kg, id, uv.x, uv.y, width.x, flags);
   }
   if (weight.y > 0.0f) {
     float2 uv = make_float2((signed_N.y > 0.0f) ? 1.0f - co.x : co.x, co.z);
-    f += weight.y * svm_image_texture(kg, id, uv.x, uv.y, flags);
+    f += weight.y * svm_image_texture(kg, id, uv.x, uv.y, width.y, flags);
   }
   if (weight.z > 0.0f) {
     float2 uv = make_float2((signed_N.z > 0.0f) ? 1.0f - co.y : co.y, co.x);
-    f += weight.z * svm_image_texture(kg, id, uv.x, uv.y, flags);
+    f += weight.z * svm_image_texture(kg, id, uv.x, uv.y, width.z, flags);
   }
 
   if (stack_valid(out_offset))
@@ -215,10 +271,18 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
     stack_store_float(stack, alpha_offset, f.w);
 }
 
-ccl_device void svm_node_tex_environment(KernelGlobals *kg,
-                                         ShaderData *sd,
-                                         float *stack,
-                                         uint4 node)
+ccl_device_inline float2 svm_environment_project(float3 co, uint projection)
+{
+  co = safe_normalize(co);
+
+  if (projection == 0)
+    return direction_to_equirectangular(co);
+  else
+    return direction_to_mirrorball(co);
+}
+
+ccl_device void svm_node_tex_environment(
+    KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
   uint id = node.y;
   uint co_offset, out_offset, alpha_offset, flags;
@@ -227,16 +291,17 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg,
   svm_unpack_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &flags);
 
   float3 co = stack_load_float3(stack, co_offset);
-  float2 uv;
-
-  co = safe_normalize(co);
-
-  if (projection == 0)
-    uv = direction_to_equirectangular(co);
-  else
-    uv = direction_to_mirrorball(co);
+  float2 uv = svm_environment_project(co, projection);
+
+  float width = 0.0f;
+  uint dx_offset, dy_offset;
+  if (svm_image_differentials(kg, flags, offset, &dx_offset, &dy_offset)) {
+    const float2 uv_dx = svm_environment_project(stack_load_float3(stack, dx_offset), projection);
+    const float2 uv_dy = svm_environment_project(stack_load_float3(stack, dy_offset), projection);
+    width = svm_image_filter_width(uv, uv_dx, uv_dy, projection == 0);
+  }
 
-  float4 f = svm_image_texture(kg, id, uv.x, uv.y, flags);
+  float4 f = svm_image_texture(kg, id, uv.x, uv.y, width, flags);
 
   if (stack_valid(out_offset))
     stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -40,6 +40,8 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_tbb.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -60,6 +62,7 @@ Geometry::Geometry(const NodeType *node_type, const Type type)
 {
   need_update = true;
   need_update_rebuild = false;
+  need_update_pack = true;
 
   transform_applied = false;
   transform_negative_scaled = false;
@@ -208,6 +211,8 @@ void Geometry::compute_bvh(
       bparams.bvh_layout = bvh_layout;
       bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                     params->use_bvh_unaligned_nodes;
+      bparams.use_compressed_nodes = params->use_bvh_compressed_nodes &&
+                                     device->info.has_bvh_compressed_nodes;
       bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
       bparams.num_motion_curve_steps = params->num_bvh_time_steps;
       bparams.bvh_type = params->bvh_type;
@@ -263,10 +268,14 @@ GeometryManager::GeometryManager()
 {
   need_update = true;
   need_flags_update = true;
+  bvh_build_time = 0.0;
+  bvh = NULL;
+  need_bvh_rebuild = true;
 }
 
 GeometryManager::~GeometryManager()
 {
+  delete bvh;
 }
 
 void GeometryManager::update_osl_attributes(Device *device,
@@ -799,6 +808,12 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
     if (geom->type == Geometry::MESH) {
       Mesh *mesh = static_cast<Mesh *>(geom);
 
+      if (mesh->vert_offset != vert_size || mesh->prim_offset != tri_size ||
+          mesh->patch_offset != patch_size || mesh->face_offset != face_size ||
+          mesh->corner_offset != corner_size) {
+        mesh->need_update_pack = true;
+      }
+
       mesh->vert_offset = vert_size;
       mesh->prim_offset = tri_size;
 
@@ -815,6 +830,9 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
 
         /* patch tables are stored in same array so include them in patch_size */
         if (mesh->patch_table) {
+          if (mesh->patch_table_offset != patch_size) {
+            mesh->need_update_pack = true;
+          }
           mesh->patch_table_offset = patch_size;
           patch_size += mesh->patch_table->total_size();
         }
@@ -829,6 +847,10 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
     else if (geom->type == Geometry::HAIR) {
       Hair *hair = static_cast<Hair *>(geom);
 
+      if (hair->curvekey_offset != curve_key_size || hair->prim_offset != curve_size) {
+        hair->need_update_pack = true;
+      }
+
       hair->curvekey_offset = curve_key_size;
       hair->prim_offset = curve_size;
 
@@ -904,72 +926,136 @@ void GeometryManager::device_update_mesh(
     }
   }
 
+  /* Geometry that did not change keeps its packed data from the previous update, as long as
+   * the layout of the arrays and the shader indices stay the same. */
+  const bool shaders_changed = (packed_shaders != scene->shaders);
+  const size_t num_geometry = scene->geometry.size();
+  vector<uchar> geom_packed(num_geometry, 0);
+
   /* Fill in all the arrays. */
   if (tri_size != 0) {
     /* normals */
     progress.set_status("Updating Mesh", "Computing normals");
 
+    const bool pack_all = for_displacement || shaders_changed ||
+                          dscene->tri_shader.size() != tri_size ||
+                          dscene->tri_vnormal.size() != vert_size;
+
     uint *tri_shader = dscene->tri_shader.alloc(tri_size);
     float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
     uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
 
-    foreach (Geometry *geom, scene->geometry) {
-      if (geom->type == Geometry::MESH) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
-        mesh->pack_normals(&vnormal[mesh->vert_offset]);
-        mesh->pack_verts(tri_prim_index,
-                         &tri_vindex[mesh->prim_offset],
-                         &tri_patch[mesh->prim_offset],
-                         &tri_patch_uv[mesh->vert_offset],
-                         mesh->vert_offset,
-                         mesh->prim_offset);
-        if (progress.get_cancel())
+    /* Pack in parallel over geometry. Triangle indices into the primitive array depend on the
+     * BVH packing, so they are checked for unchanged geometry too. */
+    vector<uchar> prim_index_changed(num_geometry, 0);
+
+    parallel_for(blocked_range<size_t>(0, num_geometry), [&](const blocked_range<size_t> &r) {
+      for (size_t i = r.begin(); i != r.end(); i++) {
+        if (progress.get_cancel()) {
+          parallel_for_cancel();
           return;
+        }
+
+        Geometry *geom = scene->geometry[i];
+        if (geom->type != Geometry::MESH) {
+          continue;
+        }
+
+        Mesh *mesh = static_cast<Mesh *>(geom);
+        if (pack_all || mesh->need_update_pack) {
+          mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
+          mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          mesh->pack_verts(tri_prim_index,
+                           &tri_vindex[mesh->prim_offset],
+                           &tri_patch[mesh->prim_offset],
+                           &tri_patch_uv[mesh->vert_offset],
+                           mesh->vert_offset,
+                           mesh->prim_offset);
+          geom_packed[i] = 1;
+        }
+        else {
+          uint4 *mesh_tri_vindex = &tri_vindex[mesh->prim_offset];
+          const size_t num_triangles = mesh->num_triangles();
+
+          for (size_t j = 0; j < num_triangles; j++) {
+            const uint prim_index = tri_prim_index[j + mesh->prim_offset];
+            if (mesh_tri_vindex[j].w != prim_index) {
+              mesh_tri_vindex[j].w = prim_index;
+              prim_index_changed[i] = 1;
+            }
+          }
+        }
       }
-    }
+    });
+
+    if (progress.get_cancel())
+      return;
+
+    const bool mesh_packed = pack_all || std::find(geom_packed.begin(), geom_packed.end(), 1) !=
+                                             geom_packed.end();
+    const bool vindex_changed = mesh_packed ||
+                                std::find(prim_index_changed.begin(),
+                                          prim_index_changed.end(),
+                                          1) != prim_index_changed.end();
 
     /* vertex coordinates */
     progress.set_status("Updating Mesh", "Copying Mesh to device");
 
-    dscene->tri_shader.copy_to_device();
-    dscene->tri_vnormal.copy_to_device();
-    dscene->tri_vindex.copy_to_device();
-    dscene->tri_patch.copy_to_device();
-    dscene->tri_patch_uv.copy_to_device();
+    if (mesh_packed) {
+      dscene->tri_shader.copy_to_device();
+      dscene->tri_vnormal.copy_to_device();
+      dscene->tri_patch.copy_to_device();
+      dscene->tri_patch_uv.copy_to_device();
+    }
+    if (vindex_changed) {
+      dscene->tri_vindex.copy_to_device();
+    }
+
+    VLOG(1) << "Packed " << std::count(geom_packed.begin(), geom_packed.end(), 1) << " of "
+            << num_geometry << " geometries.";
   }
 
   if (curve_size != 0) {
     progress.set_status("Updating Mesh", "Copying Strands to device");
 
+    const bool pack_all = shaders_changed || dscene->curve_keys.size() != curve_key_size ||
+                          dscene->curves.size() != curve_size;
+    bool hair_packed = pack_all;
+
     float4 *curve_keys = dscene->curve_keys.alloc(curve_key_size);
     float4 *curves = dscene->curves.alloc(curve_size);
 
     foreach (Geometry *geom, scene->geometry) {
-      if (geom->type == Geometry::HAIR) {
+      if (geom->type == Geometry::HAIR && (pack_all || geom->need_update_pack)) {
         Hair *hair = static_cast<Hair *>(geom);
         hair->pack_curves(scene,
                           &curve_keys[hair->curvekey_offset],
                           &curves[hair->prim_offset],
                           hair->curvekey_offset);
+        hair_packed = true;
         if (progress.get_cancel())
           return;
       }
     }
 
-    dscene->curve_keys.copy_to_device();
-    dscene->curves.copy_to_device();
+    if (hair_packed) {
+      dscene->curve_keys.copy_to_device();
+      dscene->curves.copy_to_device();
+    }
   }
 
   if (patch_size != 0) {
     progress.set_status("Updating Mesh", "Copying Patches to device");
 
+    const bool pack_all = dscene->patches.size() != patch_size;
+    bool patches_packed = pack_all;
+
     uint *patch_data = dscene->patches.alloc(patch_size);
 
     foreach (Geometry *geom, scene->geometry) {
-      if (geom->type == Geometry::MESH) {
+      if (geom->type == Geometry::MESH && (pack_all || geom->need_update_pack)) {
         Mesh *mesh = static_cast<Mesh *>(geom);
         mesh->pack_patches(&patch_data[mesh->patch_offset],
                            mesh->vert_offset,
@@ -981,12 +1067,15 @@ void GeometryManager::device_update_mesh(
                                                     mesh->patch_table_offset);
         }
 
+        patches_packed = true;
         if (progress.get_cancel())
           return;
       }
     }
 
-    dscene->patches.copy_to_device();
+    if (patches_packed) {
+      dscene->patches.copy_to_device();
+    }
   }
 
   if (for_displacement) {
@@ -1005,6 +1094,49 @@ void GeometryManager::device_update_mesh(
     }
     dscene->prim_tri_verts.copy_to_device();
   }
+  else {
+    /* Everything is packed for the final arrays now. */
+    foreach (Geometry *geom, scene->geometry) {
+      geom->need_update_pack = false;
+    }
+    packed_shaders = scene->shaders;
+  }
+}
+
+template<typename T>
+static void device_update_bvh_array(device_vector<T> &dvector, const array<T> &data)
+{
+  if (data.size()) {
+    T *ddata = dvector.alloc(data.size());
+    memcpy(ddata, data.data(), sizeof(T) * data.size());
+    dvector.copy_to_device();
+  }
+}
+
+/* Per object state that determines the structure of the top level BVH, it can only be refitted
+ * as long as this stays the same. */
+static vector<size_t> compute_bvh_objects_state(const Scene *scene, BVHLayout bvh_layout)
+{
+  vector<size_t> state;
+  state.reserve(scene->objects.size() * 4);
+
+  foreach (const Object *object, scene->objects) {
+    const Geometry *geom = object->geometry;
+    size_t num_primitives = 0;
+    if (geom->type == Geometry::MESH) {
+      num_primitives = static_cast<const Mesh *>(geom)->num_triangles();
+    }
+    else if (geom->type == Geometry::HAIR) {
+      num_primitives = static_cast<const Hair *>(geom)->num_segments();
+    }
+
+    state.push_back((size_t)geom);
+    state.push_back((object->is_traceable() ? 1 : 0) | (geom->need_build_bvh(bvh_layout) ? 2 : 0));
+    state.push_back(geom->prim_offset);
+    state.push_back(num_primitives);
+  }
+
+  return state;
 }
 
 void GeometryManager::device_update_bvh(Device *device,
@@ -1012,9 +1144,6 @@ void GeometryManager::device_update_bvh(Device *device,
                                         Scene *scene,
                                         Progress &progress)
 {
-  /* bvh build */
-  progress.set_status("Updating Scene BVH", "Building");
-
   BVHParams bparams;
   bparams.top_level = true;
   bparams.bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
@@ -1022,6 +1151,8 @@ void GeometryManager::device_update_bvh(Device *device,
   bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
   bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
                                 scene->params.use_bvh_unaligned_nodes;
+  bparams.use_compressed_nodes = scene->params.use_bvh_compressed_nodes &&
+                                 device->info.has_bvh_compressed_nodes;
   bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
   bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
   bparams.bvh_type = scene->params.bvh_type;
@@ -1029,8 +1160,28 @@ void GeometryManager::device_update_bvh(Device *device,
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
-  BVH *bvh = BVH::create(bparams, scene->geometry, scene->objects);
-  bvh->build(progress, &device->stats);
+  /* The BVH2 top level is kept for animation and viewport updates, so it can be refitted when
+   * geometry only deformed or objects only moved. Other layouts are always rebuilt. */
+  const bool keep_bvh = bparams.bvh_layout == BVH_LAYOUT_BVH2 &&
+                        (scene->params.persistent_data ||
+                         scene->params.bvh_type == SceneParams::BVH_DYNAMIC);
+  vector<size_t> objects_state;
+  if (keep_bvh) {
+    objects_state = compute_bvh_objects_state(scene, bparams.bvh_layout);
+  }
+
+  if (keep_bvh && bvh && !need_bvh_rebuild && !bvh->params.modified(bparams) &&
+      bvh->geometry == scene->geometry && bvh->objects == scene->objects &&
+      objects_state == bvh_objects_state) {
+    progress.set_status("Updating Scene BVH", "Refitting");
+    bvh->refit(progress);
+  }
+  else {
+    progress.set_status("Updating Scene BVH", "Building");
+    delete bvh;
+    bvh = BVH::create(bparams, scene->geometry, scene->objects);
+    bvh->build(progress, &device->stats);
+  }
 
   if (progress.get_cancel()) {
 #ifdef WITH_EMBREE
@@ -1040,6 +1191,7 @@ void GeometryManager::device_update_bvh(Device *device,
     }
 #endif
     delete bvh;
+    bvh = NULL;
     return;
   }
 
@@ -1048,45 +1200,60 @@ void GeometryManager::device_update_bvh(Device *device,
 
   PackedBVH &pack = bvh->pack;
 
-  if (pack.nodes.size()) {
-    dscene->bvh_nodes.steal_data(pack.nodes);
-    dscene->bvh_nodes.copy_to_device();
+  if (keep_bvh) {
+    /* Copy instead of taking over the packed arrays, the kept BVH refits them in place. */
+    device_update_bvh_array(dscene->bvh_nodes, pack.nodes);
+    device_update_bvh_array(dscene->bvh_leaf_nodes, pack.leaf_nodes);
+    device_update_bvh_array(dscene->object_node, pack.object_node);
+    device_update_bvh_array(dscene->prim_tri_index, pack.prim_tri_index);
+    device_update_bvh_array(dscene->prim_tri_verts, pack.prim_tri_verts);
+    device_update_bvh_array(dscene->prim_type, pack.prim_type);
+    device_update_bvh_array(dscene->prim_visibility, pack.prim_visibility);
+    device_update_bvh_array(dscene->prim_index, pack.prim_index);
+    device_update_bvh_array(dscene->prim_object, pack.prim_object);
+    device_update_bvh_array(dscene->prim_time, pack.prim_time);
   }
-  if (pack.leaf_nodes.size()) {
-    dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
-    dscene->bvh_leaf_nodes.copy_to_device();
-  }
-  if (pack.object_node.size()) {
-    dscene->object_node.steal_data(pack.object_node);
-    dscene->object_node.copy_to_device();
-  }
-  if (pack.prim_tri_index.size()) {
-    dscene->prim_tri_index.steal_data(pack.prim_tri_index);
-    dscene->prim_tri_index.copy_to_device();
-  }
-  if (pack.prim_tri_verts.size()) {
-    dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
-    dscene->prim_tri_verts.copy_to_device();
-  }
-  if (pack.prim_type.size()) {
-    dscene->prim_type.steal_data(pack.prim_type);
-    dscene->prim_type.copy_to_device();
-  }
-  if (pack.prim_visibility.size()) {
-    dscene->prim_visibility.steal_data(pack.prim_visibility);
-    dscene->prim_visibility.copy_to_device();
-  }
-  if (pack.prim_index.size()) {
-    dscene->prim_index.steal_data(pack.prim_index);
-    dscene->prim_index.copy_to_device();
-  }
-  if (pack.prim_object.size()) {
-    dscene->prim_object.steal_data(pack.prim_object);
-    dscene->prim_object.copy_to_device();
-  }
-  if (pack.prim_time.size()) {
-    dscene->prim_time.steal_data(pack.prim_time);
-    dscene->prim_time.copy_to_device();
+  else {
+    if (pack.nodes.size()) {
+      dscene->bvh_nodes.steal_data(pack.nodes);
+      dscene->bvh_nodes.copy_to_device();
+    }
+    if (pack.leaf_nodes.size()) {
+      dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
+      dscene->bvh_leaf_nodes.copy_to_device();
+    }
+    if (pack.object_node.size()) {
+      dscene->object_node.steal_data(pack.object_node);
+      dscene->object_node.copy_to_device();
+    }
+    if (pack.prim_tri_index.size()) {
+      dscene->prim_tri_index.steal_data(pack.prim_tri_index);
+      dscene->prim_tri_index.copy_to_device();
+    }
+    if (pack.prim_tri_verts.size()) {
+      dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
+      dscene->prim_tri_verts.copy_to_device();
+    }
+    if (pack.prim_type.size()) {
+      dscene->prim_type.steal_data(pack.prim_type);
+      dscene->prim_type.copy_to_device();
+    }
+    if (pack.prim_visibility.size()) {
+      dscene->prim_visibility.steal_data(pack.prim_visibility);
+      dscene->prim_visibility.copy_to_device();
+    }
+    if (pack.prim_index.size()) {
+      dscene->prim_index.steal_data(pack.prim_index);
+      dscene->prim_index.copy_to_device();
+    }
+    if (pack.prim_object.size()) {
+      dscene->prim_object.steal_data(pack.prim_object);
+      dscene->prim_object.copy_to_device();
+    }
+    if (pack.prim_time.size()) {
+      dscene->prim_time.steal_data(pack.prim_time);
+      dscene->prim_time.copy_to_device();
+    }
   }
 
   dscene->data.bvh.root = pack.root_index;
@@ -1096,7 +1263,14 @@ void GeometryManager::device_update_bvh(Device *device,
 
   bvh->copy_to_device(progress, dscene);
 
-  delete bvh;
+  if (keep_bvh) {
+    bvh_objects_state.swap(objects_state);
+    need_bvh_rebuild = false;
+  }
+  else {
+    delete bvh;
+    bvh = NULL;
+  }
 }
 
 void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Progress &progress)
@@ -1238,6 +1412,10 @@ void GeometryManager::device_update(Device *device,
         geom->need_update = true;
     }
 
+    if (geom->need_update) {
+      geom->need_update_pack = true;
+    }
+
     if (geom->need_update && geom->type == Geometry::MESH) {
       Mesh *mesh = static_cast<Mesh *>(geom);
 
@@ -1290,7 +1468,7 @@ void GeometryManager::device_update(Device *device,
 
         mesh->subd_params->camera = dicing_camera;
         DiagSplit dsplit(*mesh->subd_params);
-        mesh->tessellate(&dsplit);
+        mesh->tessellate(&dsplit, scene->params.persistent_data);
 
         i++;
 
@@ -1310,7 +1488,7 @@ void GeometryManager::device_update(Device *device,
   }
 
   /* Device update. */
-  device_free(device, dscene);
+  device_free(device, dscene, false);
 
   mesh_calc_offset(scene);
   if (true_displacement_used) {
@@ -1331,6 +1509,12 @@ void GeometryManager::device_update(Device *device,
 
   foreach (Geometry *geom, scene->geometry) {
     if (geom->need_update) {
+      /* Changed topology or newly built geometry BVHs invalidate the top level BVH, checked
+       * here since compute_bvh() clears the flag. */
+      if (geom->need_update_rebuild || (geom->need_build_bvh(bvh_layout) && !geom->bvh)) {
+        need_bvh_rebuild = true;
+      }
+
       if (geom->type == Geometry::MESH) {
         Mesh *mesh = static_cast<Mesh *>(geom);
         if (displace(device, dscene, scene, mesh, progress)) {
@@ -1349,13 +1533,14 @@ void GeometryManager::device_update(Device *device,
 
   /* Device re-update after displacement. */
   if (displacement_done) {
-    device_free(device, dscene);
+    device_free(device, dscene, false);
 
     device_update_attributes(device, dscene, scene, progress);
     if (progress.get_cancel())
       return;
   }
 
+  scoped_timer bvh_timer;
   TaskPool pool;
 
   size_t i = 0;
@@ -1390,6 +1575,7 @@ void GeometryManager::device_update(Device *device,
     return;
 
   device_update_bvh(device, dscene, scene, progress);
+  bvh_build_time = bvh_timer.get_time();
   if (progress.get_cancel())
     return;
 
@@ -1410,7 +1596,7 @@ void GeometryManager::device_update(Device *device,
   }
 }
 
-void GeometryManager::device_free(Device *device, DeviceScene *dscene)
+void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool force_free)
 {
 #ifdef WITH_EMBREE
   if (dscene->data.bvh.scene) {
@@ -1430,20 +1616,31 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
   dscene->prim_index.free();
   dscene->prim_object.free();
   dscene->prim_time.free();
-  dscene->tri_shader.free();
-  dscene->tri_vnormal.free();
-  dscene->tri_vindex.free();
-  dscene->tri_patch.free();
-  dscene->tri_patch_uv.free();
-  dscene->curves.free();
-  dscene->curve_keys.free();
-  dscene->patches.free();
   dscene->attributes_map.free();
   dscene->attributes_float.free();
   dscene->attributes_float2.free();
   dscene->attributes_float3.free();
   dscene->attributes_uchar4.free();
 
+  /* Packed geometry is kept between updates, so that only modified geometry needs to be
+   * packed again. */
+  if (force_free) {
+    dscene->tri_shader.free();
+    dscene->tri_vnormal.free();
+    dscene->tri_vindex.free();
+    dscene->tri_patch.free();
+    dscene->tri_patch_uv.free();
+    dscene->curves.free();
+    dscene->curve_keys.free();
+    dscene->patches.free();
+    packed_shaders.clear();
+
+    delete bvh;
+    bvh = NULL;
+    bvh_objects_state.clear();
+    need_bvh_rebuild = true;
+  }
+
   /* Signal for shaders like displacement not to do ray tracing. */
   dscene->data.bvh.bvh_layout = BVH_LAYOUT_NONE;
 
@@ -1471,6 +1668,15 @@ void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
   foreach (Geometry *geometry, scene->geometry) {
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
+
+    if (geometry->bvh) {
+      stats->mesh.bvh.add_entry(
+          NamedSizeEntry(string(geometry->name.c_str()), geometry->bvh->pack.memory_size()));
+    }
+  }
+
+  if (bvh) {
+    stats->mesh.bvh.add_entry(NamedSizeEntry("Top level", bvh->pack.memory_size()));
   }
 }
 
@@ -88,6 +88,9 @@ class Geometry : public Node {
   /* Update Flags */
   bool need_update;
   bool need_update_rebuild;
+  /* Packed data in the global device arrays is outdated, either because the geometry changed
+   * or because its offsets in the arrays moved. */
+  bool need_update_pack;
 
   /* Constructor/Destructor */
   explicit Geometry(const NodeType *node_type, const Type type);
@@ -148,6 +151,9 @@ class GeometryManager {
   bool need_update;
   bool need_flags_update;
 
+  /* Time spent building BVHs in the last device update, in seconds. */
+  double bvh_build_time;
+
   /* Constructor/Destructor */
   GeometryManager();
   ~GeometryManager();
@@ -155,7 +161,7 @@ class GeometryManager {
   /* Device Updates */
   void device_update_preprocess(Device *device, Scene *scene, Progress &progress);
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
-  void device_free(Device *device, DeviceScene *dscene);
+  void device_free(Device *device, DeviceScene *dscene, bool force_free);
 
   /* Updates */
   void tag_update(Scene *scene);
@@ -198,6 +204,16 @@ class GeometryManager {
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
   void device_update_volume_images(Device *device, Scene *scene, Progress &progress);
+
+  /* Shaders at the time of the last packing, triangle and curve shader indices need to be
+   * repacked when this changes. */
+  vector<Shader *> packed_shaders;
+
+  /* Top level BVH of the last update, kept so it can be refitted instead of rebuilt when only
+   * primitive positions and object transforms changed. */
+  BVH *bvh;
+  vector<size_t> bvh_objects_state;
+  bool need_bvh_rebuild;
 };
 
 CCL_NAMESPACE_END
@@ -17,6 +17,7 @@
 #include "render/graph.h"
 #include "render/attribute.h"
 #include "render/constant_fold.h"
+#include "render/image.h"
 #include "render/nodes.h"
 #include "render/scene.h"
 #include "render/shader.h"
@@ -364,6 +365,7 @@ void ShaderGraph::simplify(Scene *scene)
     expand();
     default_inputs(scene->shader_manager->use_osl());
     clean(scene);
+    refine_image_differentials(scene);
     refine_bump_nodes();
 
     simplified = true;
@@ -400,14 +402,21 @@ void ShaderGraph::finalize(Scene *scene, bool do_bump, bool do_simplify, bool bu
   }
 }
 
-void ShaderGraph::find_dependencies(ShaderNodeSet &dependencies, ShaderInput *input)
+void ShaderGraph::find_dependencies(ShaderNodeSet &dependencies,
+                                    ShaderInput *input,
+                                    bool skip_image_differentials)
 {
   /* find all nodes that this input depends on directly and indirectly */
   ShaderNode *node = (input->link) ? input->link->parent : NULL;
 
   if (node != NULL && dependencies.find(node) == dependencies.end()) {
-    foreach (ShaderInput *in, node->inputs)
-      find_dependencies(dependencies, in);
+    foreach (ShaderInput *in, node->inputs) {
+      if (skip_image_differentials && node->special_type == SHADER_SPECIAL_TYPE_IMAGE_SLOT &&
+          (in->flags() & SocketType::SVM_INTERNAL)) {
+        continue;
+      }
+      find_dependencies(dependencies, in, skip_image_differentials);
+    }
 
     dependencies.insert(node);
   }
@@ -423,8 +432,8 @@ void ShaderGraph::clear_nodes()
 
 void ShaderGraph::copy_nodes(ShaderNodeSet &nodes, ShaderNodeMap &nnodemap)
 {
-  /* copy a set of nodes, and the links between them. the assumption is
-   * made that all nodes that inputs are linked to are in the set too. */
+  /* copy a set of nodes, and the links between them. inputs linked to nodes
+   * outside of the set are linked to the same outputs in the copy. */
 
   /* copy nodes */
   foreach (ShaderNode *node, nodes) {
@@ -444,9 +453,10 @@ void ShaderGraph::copy_nodes(ShaderNodeSet &nodes, ShaderNodeMap &nnodemap)
     foreach (ShaderInput *input, node->inputs) {
       if (input->link) {
         /* find new input and output */
-        ShaderNode *nfrom = nnodemap[input->link->parent];
+        ShaderNodeMap::iterator it = nnodemap.find(input->link->parent);
         ShaderNode *nto = nnodemap[input->parent];
-        ShaderOutput *noutput = nfrom->output(input->link->name());
+        ShaderOutput *noutput = (it != nnodemap.end()) ? it->second->output(input->link->name()) :
+                                                         input->link;
         ShaderInput *ninput = nto->input(input->name());
 
         /* connect */
@@ -914,8 +924,8 @@ void ShaderGraph::refine_bump_nodes()
       ShaderNodeMap nodes_dx;
       ShaderNodeMap nodes_dy;
 
-      /* find dependencies for the given input */
-      find_dependencies(nodes_bump, bump_input);
+      /* find dependencies for the given input, image differentials are shared by all samples */
+      find_dependencies(nodes_bump, bump_input, true);
 
       copy_nodes(nodes_bump, nodes_dx);
       copy_nodes(nodes_bump, nodes_dy);
@@ -953,6 +963,52 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::refine_image_differentials(Scene *scene)
+{
+  /* image textures paged in through the image cache pick their mip level from
+   * the texture coordinates at the points shifted by the ray differentials. like
+   * for bump, we make 2 extra copies of the sub-graph defining the texture
+   * coordinates, with texture coordinate nodes shifted by dx and dy, and connect
+   * them to the "VectorDx" and "VectorDy" inputs. */
+  if (scene->shader_manager->use_osl() || !scene->image_manager->use_image_cache(scene)) {
+    return;
+  }
+
+  vector<ShaderNode *> image_nodes;
+  foreach (ShaderNode *node, nodes) {
+    ShaderInput *vector_dx_in = node->input("VectorDx");
+    if (vector_dx_in && !vector_dx_in->link && node->input("Vector")->link) {
+      image_nodes.push_back(node);
+    }
+  }
+
+  foreach (ShaderNode *node, image_nodes) {
+    ShaderInput *vector_in = node->input("Vector");
+    ShaderNodeSet nodes_vector;
+    ShaderNodeMap nodes_dx;
+    ShaderNodeMap nodes_dy;
+
+    find_dependencies(nodes_vector, vector_in);
+
+    copy_nodes(nodes_vector, nodes_dx);
+    copy_nodes(nodes_vector, nodes_dy);
+
+    foreach (NodePair &pair, nodes_dx)
+      pair.second->bump = SHADER_BUMP_DX;
+    foreach (NodePair &pair, nodes_dy)
+      pair.second->bump = SHADER_BUMP_DY;
+
+    ShaderOutput *out = vector_in->link;
+    connect(nodes_dx[out->parent]->output(out->name()), node->input("VectorDx"));
+    connect(nodes_dy[out->parent]->output(out->name()), node->input("VectorDy"));
+
+    foreach (NodePair &pair, nodes_dx)
+      add(pair.second);
+    foreach (NodePair &pair, nodes_dy)
+      add(pair.second);
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
@@ -973,9 +1029,9 @@ void ShaderGraph::bump_from_displacement(bool use_object_space)
   if (!displacement_in->link)
     return;
 
-  /* find dependencies for the given input */
+  /* find dependencies for the given input, image differentials are shared by all samples */
   ShaderNodeSet nodes_displace;
-  find_dependencies(nodes_displace, displacement_in);
+  find_dependencies(nodes_displace, displacement_in, true);
 
   /* copy nodes for 3 bump samples */
   ShaderNodeMap nodes_center;
@@ -348,13 +348,16 @@ class ShaderGraph {
  protected:
   typedef pair<ShaderNode *const, ShaderNode *> NodePair;
 
-  void find_dependencies(ShaderNodeSet &dependencies, ShaderInput *input);
+  void find_dependencies(ShaderNodeSet &dependencies,
+                         ShaderInput *input,
+                         bool skip_image_differentials = false);
   void clear_nodes();
   void copy_nodes(ShaderNodeSet &nodes, ShaderNodeMap &nnodemap);
 
   void break_cycles(ShaderNode *node, vector<bool> &visited, vector<bool> &on_stack);
   void bump_from_displacement(bool use_object_space);
   void refine_bump_nodes();
+  void refine_image_differentials(Scene *scene);
   void expand();
   void default_inputs(bool do_osl);
   void transform_multi_closure(ShaderNode *node, ShaderOutput *weight_out, bool volume);
@@ -274,6 +274,43 @@ ustring ImageLoader::osl_filepath() const
   return ustring();
 }
 
+bool ImageLoader::supports_load_pixels_rows() const
+{
+  return false;
+}
+
+bool ImageLoader::load_pixels_rows(
+    const ImageMetaData &, const int, const int, float *, const bool)
+{
+  return false;
+}
+
+bool ImageLoader::supports_load_pixels_region() const
+{
+  return false;
+}
+
+bool ImageLoader::load_pixels_region(
+    const ImageMetaData &, const int, const int, const int, const int, float *, const bool)
+{
+  return false;
+}
+
+bool ImageLoader::supports_load_sparse() const
+{
+  return false;
+}
+
+bool ImageLoader::load_sparse_index(const ImageMetaData &, vector<uint> &)
+{
+  return false;
+}
+
+bool ImageLoader::load_sparse_voxels(const ImageMetaData &, const vector<uint> &, float *)
+{
+  return false;
+}
+
 bool ImageLoader::equals(const ImageLoader *a, const ImageLoader *b)
 {
   if (a == NULL && b == NULL) {
@@ -295,16 +332,21 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update = true;
   osl_texture_system = NULL;
+  image_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
   has_half_images = info.has_half_images;
+  has_image_cache = info.has_image_cache;
+  has_sparse_volumes = info.has_sparse_volumes;
 }
 
 ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  delete image_cache;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -327,6 +369,12 @@ bool ImageManager::set_animation_frame_update(int frame)
   return false;
 }
 
+/* 2D images are paged in on demand through the image cache, if the device supports it. */
+bool ImageManager::use_image_cache(const Scene *scene) const
+{
+  return has_image_cache && scene->params.texture_cache_size > 0;
+}
+
 void ImageManager::load_image_metadata(Image *img)
 {
   if (!img->need_metadata) {
@@ -443,6 +491,7 @@ int ImageManager::add_image_slot(ImageLoader *loader,
   img->builtin = builtin;
   img->users = 1;
   img->mem = NULL;
+  img->cache_image = NULL;
 
   images[slot] = img;
 
@@ -641,6 +690,91 @@ bool ImageManager::file_load_image(Image *img, int texture_limit)
   return true;
 }
 
+bool ImageManager::file_load_sparse_image(Image *img, int texture_limit)
+{
+  /* Sparse storage is only used for float volumes that are not scaled down. */
+  const ImageDataType type = img->metadata.type;
+  if (!(has_sparse_volumes && img->metadata.depth > 1 && img->loader->supports_load_sparse())) {
+    return false;
+  }
+  if (!(type == IMAGE_DATA_TYPE_FLOAT || type == IMAGE_DATA_TYPE_FLOAT4)) {
+    return false;
+  }
+
+  const size_t max_size = max(max(img->metadata.width, img->metadata.height),
+                              img->metadata.depth);
+  if (texture_limit > 0 && max_size > texture_limit) {
+    return false;
+  }
+
+  vector<uint> index;
+  if (!img->loader->load_sparse_index(img->metadata, index)) {
+    return false;
+  }
+
+  const int channels = (type == IMAGE_DATA_TYPE_FLOAT4) ? 4 : 1;
+  const size_t voxel_size = sizeof(float) * channels;
+  const size_t index_size = index.size() * sizeof(uint);
+  const size_t num_leaves = index[2];
+  const size_t num_voxels = num_leaves * TEX_SPARSE_LEAF_VOXELS;
+
+  /* Index and voxels share a single buffer, allocated in voxels. */
+  assert(index_size % voxel_size == 0);
+  float *pixels;
+  {
+    thread_scoped_lock device_lock(device_mutex);
+    pixels = (float *)img->mem->alloc(index_size / voxel_size + num_voxels, 1);
+  }
+
+  if (pixels == NULL) {
+    return false;
+  }
+
+  memcpy(pixels, index.data(), index_size);
+
+  /* Initialize to what dense volumes contain outside of active voxels. */
+  float *voxels = pixels + index_size / sizeof(float);
+  if (channels == 4) {
+    for (size_t i = 0; i < num_voxels; i++) {
+      voxels[i * 4 + 0] = 0.0f;
+      voxels[i * 4 + 1] = 0.0f;
+      voxels[i * 4 + 2] = 0.0f;
+      voxels[i * 4 + 3] = 1.0f;
+    }
+  }
+  else {
+    memset(voxels, 0, num_voxels * sizeof(float));
+  }
+
+  if (!img->loader->load_sparse_voxels(img->metadata, index, voxels)) {
+    return false;
+  }
+
+  /* Make sure we don't have buggy values. */
+  for (size_t i = 0; i < num_voxels; i++) {
+    float *voxel = voxels + i * channels;
+    for (int c = 0; c < channels; c++) {
+      if (!isfinite(voxel[c])) {
+        for (int k = 0; k < channels; k++) {
+          voxel[k] = 0.0f;
+        }
+        break;
+      }
+    }
+  }
+
+  img->mem->info.width = img->metadata.width;
+  img->mem->info.height = img->metadata.height;
+  img->mem->info.depth = img->metadata.depth;
+  img->mem->info.use_sparse = true;
+
+  VLOG(1) << "Loaded sparse volume " << img->loader->name() << ", " << num_leaves
+          << " leaves instead of " << img->metadata.width << "x" << img->metadata.height << "x"
+          << img->metadata.depth << " voxels.";
+
+  return true;
+}
+
 void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Progress *progress)
 {
   if (progress->get_cancel()) {
@@ -665,14 +799,40 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
     delete img->mem;
     img->mem = NULL;
   }
+  if (img->cache_image) {
+    image_cache->remove_image(img->cache_image);
+    img->cache_image = NULL;
+  }
 
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
+  /* Page in 2D images on demand through the image cache, if the loader supports it. */
+  if (use_image_cache(scene) && img->metadata.depth <= 1) {
+    thread_scoped_lock device_lock(device_mutex);
+    if (image_cache == NULL) {
+      image_cache = new ImageCache(scene->params.texture_cache_size);
+    }
+    img->cache_image = image_cache->add_image(
+        img->loader, img->metadata, img->params, image_associate_alpha(img), texture_limit);
+  }
+
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (img->cache_image) {
+    /* Kernel samples through the cache, the texture only holds its dimensions. */
+    thread_scoped_lock device_lock(device_mutex);
+    img->mem->alloc(1, 1);
+    img->mem->info.width = img->metadata.width;
+    img->mem->info.height = img->metadata.height;
+    img->mem->info.use_cache = true;
+    img->mem->info.data = (uint64_t)ImageCache::texture_image(img->cache_image);
+  }
+  else if (file_load_sparse_image(img, texture_limit)) {
+    /* Volume stored as sparse voxel blocks. */
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -763,7 +923,9 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   }
 
   /* Cleanup memory in image loader. */
-  img->loader->cleanup();
+  if (!img->cache_image) {
+    img->loader->cleanup();
+  }
   img->need_load = false;
 }
 
@@ -787,6 +949,9 @@ void ImageManager::device_free_image(Device *, int slot)
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
   }
+  if (img->cache_image) {
+    image_cache->remove_image(img->cache_image);
+  }
 
   delete img->loader;
   delete img;
@@ -873,6 +1038,10 @@ void ImageManager::collect_statistics(RenderStats *stats)
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (image_cache) {
+    stats->image.textures.add_entry(NamedSizeEntry("Image cache", image_cache->memory_usage()));
+  }
 }
 
 CCL_NAMESPACE_END
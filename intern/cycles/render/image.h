@@ -20,6 +20,7 @@
 #include "device/device_memory.h"
 
 #include "render/colorspace.h"
+#include "render/image_cache.h"
 
 #include "util/util_string.h"
 #include "util/util_thread.h"
@@ -112,6 +113,37 @@ class ImageLoader {
                            const size_t pixels_size,
                            const bool associate_alpha) = 0;
 
+  /* Optional for the CPU image cache, load a range of rows as float pixels with all channels
+   * of the image, bottom to top like load_pixels(). */
+  virtual bool supports_load_pixels_rows() const;
+  virtual bool load_pixels_rows(const ImageMetaData &metadata,
+                                const int y,
+                                const int num_rows,
+                                float *pixels,
+                                const bool associate_alpha);
+
+  /* Optional for the CPU image cache, load a rectangle of float pixels with all channels of the
+   * image, bottom to top like load_pixels(). Only supported for files stored in tiles, so the
+   * rectangle can be read without decoding full rows. */
+  virtual bool supports_load_pixels_region() const;
+  virtual bool load_pixels_region(const ImageMetaData &metadata,
+                                  const int x,
+                                  const int y,
+                                  const int width,
+                                  const int height,
+                                  float *pixels,
+                                  const bool associate_alpha);
+
+  /* Optional for sparse 3D textures on the CPU, in the layout described in util_texture.h.
+   * The index holds the header, top grid and node table, and the voxels of all leaves are
+   * loaded afterwards as float pixels with 1 or 4 channels. Voxels that are not active in the
+   * source data are left untouched. */
+  virtual bool supports_load_sparse() const;
+  virtual bool load_sparse_index(const ImageMetaData &metadata, vector<uint> &index);
+  virtual bool load_sparse_voxels(const ImageMetaData &metadata,
+                                  const vector<uint> &index,
+                                  float *voxels);
+
   /* Name for logs and stats. */
   virtual string name() const = 0;
 
@@ -186,6 +218,8 @@ class ImageManager {
   void set_osl_texture_system(void *texture_system);
   bool set_animation_frame_update(int frame);
 
+  bool use_image_cache(const Scene *scene) const;
+
   void collect_statistics(RenderStats *stats);
 
   bool need_update;
@@ -202,6 +236,7 @@ class ImageManager {
 
     string mem_name;
     device_texture *mem;
+    ImageCache::Image *cache_image;
 
     int users;
     thread_mutex mutex;
@@ -209,6 +244,8 @@ class ImageManager {
 
  private:
   bool has_half_images;
+  bool has_image_cache;
+  bool has_sparse_volumes;
 
   thread_mutex device_mutex;
   thread_mutex images_mutex;
@@ -216,6 +253,7 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  ImageCache *image_cache;
 
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
@@ -225,6 +263,7 @@ class ImageManager {
 
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
+  bool file_load_sparse_image(Image *img, int texture_limit);
 
   void device_load_image(Device *device, Scene *scene, int slot, Progress *progress);
   void device_free_image(Device *device, int slot);
@@ -0,0 +1,834 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/image_cache.h"
+#include "render/colorspace.h"
+#include "render/image.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_math.h"
+
+#include <atomic>
+
+CCL_NAMESPACE_BEGIN
+
+/* Tile dimensions in pixels, without and with the border. */
+#define IMAGE_CACHE_TILE_SIZE 64
+#define IMAGE_CACHE_TILE_BORDER 1
+#define IMAGE_CACHE_TILE_STRIDE (IMAGE_CACHE_TILE_SIZE + 2 * IMAGE_CACHE_TILE_BORDER)
+
+/* Tiles are spread over multiple independently locked shards, to reduce contention between
+ * render threads. */
+#define IMAGE_CACHE_NUM_SHARDS 16
+
+/* Rows decoded at once for files that can't be read in tiles, and the number of such bands
+ * kept for all images. */
+#define IMAGE_CACHE_BAND_SIZE IMAGE_CACHE_TILE_SIZE
+#define IMAGE_CACHE_MAX_BANDS 32
+
+struct ImageCache::Image : public TextureCacheImage {
+  float4 lookup(float x, float y, float width) const override;
+
+  ImageCache *cache;
+  int id;
+
+  ImageLoader *loader;
+  ImageMetaData metadata;
+  InterpolationType interpolation;
+  ExtensionType extension;
+  ImageAlphaType alpha_type;
+  bool associate_alpha;
+
+  /* Channels stored in tiles, 1 or 4 like the kernel textures. */
+  int channels;
+
+  /* Mip levels, with the finest level used for lookups limited by the texture limit. */
+  int num_levels;
+  int min_level;
+  vector<int> level_width;
+  vector<int> level_height;
+};
+
+struct ImageCache::Tile {
+  uint64_t key;
+  int image_id;
+
+  vector<float> pixels;
+  bool loaded;
+
+  /* Render threads using the tile, it's not evicted while in use. Atomic since tiles are
+   * released without locking the shard. */
+  std::atomic<int> users;
+  /* Used since eviction last looked at the tile, giving it a second chance. */
+  bool used;
+
+  list<Tile *>::iterator lru;
+};
+
+struct ImageCache::Shard {
+  thread_mutex mutex;
+  thread_condition_variable loaded_condition;
+
+  unordered_map<uint64_t, Tile *> tiles;
+  /* Newly added tiles first, reordered only by eviction so lookups don't modify it. */
+  list<Tile *> lru;
+  size_t memory_usage;
+
+  Shard() : memory_usage(0)
+  {
+  }
+};
+
+struct ImageCache::Band {
+  int image_id;
+  int index;
+
+  /* Held while decoding, so threads needing the same band wait instead of decoding it too. */
+  thread_mutex mutex;
+  bool loaded;
+  bool valid;
+  vector<float> rows;
+
+  /* Threads reading from the band, protected by the bands mutex. */
+  int users;
+};
+
+static uint64_t image_cache_tile_key(int image_id, int level, int tx, int ty)
+{
+  return ((uint64_t)image_id << 40) | ((uint64_t)level << 34) | ((uint64_t)ty << 17) |
+         (uint64_t)tx;
+}
+
+static int image_cache_tile_shard(uint64_t key)
+{
+  const uint hash = (uint)(key ^ (key >> 17) ^ (key >> 34) ^ (key >> 40));
+  return (int)(hash % IMAGE_CACHE_NUM_SHARDS);
+}
+
+/* Map pixel coordinate into the image according to the extension type, -1 for transparent
+ * pixels outside the image. */
+static int image_cache_extend_coord(int x, int size, ExtensionType extension)
+{
+  if (x >= 0 && x < size) {
+    return x;
+  }
+
+  switch (extension) {
+    case EXTENSION_REPEAT: {
+      const int m = x % size;
+      return (m < 0) ? m + size : m;
+    }
+    case EXTENSION_EXTEND:
+      return clamp(x, 0, size - 1);
+    case EXTENSION_CLIP:
+    default:
+      return -1;
+  }
+}
+
+ImageCache::ImageCache(size_t memory_limit) : memory_limit(memory_limit)
+{
+  for (int i = 0; i < IMAGE_CACHE_NUM_SHARDS; i++) {
+    shards.push_back(new Shard());
+  }
+}
+
+ImageCache::~ImageCache()
+{
+  foreach (Shard *shard, shards) {
+    foreach (Tile *tile, shard->lru) {
+      delete tile;
+    }
+    delete shard;
+  }
+
+  foreach (Band *band, bands) {
+    delete band;
+  }
+
+  foreach (Image *image, images) {
+    delete image;
+  }
+}
+
+ImageCache::Image *ImageCache::add_image(ImageLoader *loader,
+                                         const ImageMetaData &metadata,
+                                         const ImageParams &params,
+                                         const bool associate_alpha,
+                                         const int texture_limit)
+{
+  if (!loader->supports_load_pixels_rows()) {
+    return NULL;
+  }
+  if (metadata.depth > 1 || metadata.width == 0 || metadata.height == 0 ||
+      metadata.channels < 1) {
+    return NULL;
+  }
+
+  Image *image = new Image();
+  image->cache = this;
+  image->loader = loader;
+  image->metadata = metadata;
+  image->interpolation = params.interpolation;
+  image->extension = params.extension;
+  image->alpha_type = params.alpha_type;
+  image->associate_alpha = associate_alpha;
+  image->channels = (metadata.channels > 1) ? 4 : 1;
+
+  int width = metadata.width;
+  int height = metadata.height;
+  image->level_width.push_back(width);
+  image->level_height.push_back(height);
+  while (width > 1 || height > 1) {
+    width = max(width / 2, 1);
+    height = max(height / 2, 1);
+    image->level_width.push_back(width);
+    image->level_height.push_back(height);
+  }
+  image->num_levels = image->level_width.size();
+
+  image->min_level = 0;
+  if (texture_limit > 0) {
+    const size_t max_size = max(metadata.width, metadata.height);
+    while (image->min_level < image->num_levels - 1 &&
+           (max_size >> image->min_level) > (size_t)texture_limit) {
+      image->min_level++;
+    }
+  }
+
+  /* Reuse free image ids, they are part of the tile keys. */
+  thread_scoped_lock lock(images_mutex);
+
+  image->id = images.size();
+  for (size_t i = 0; i < images.size(); i++) {
+    if (images[i] == NULL) {
+      image->id = i;
+      break;
+    }
+  }
+
+  if (image->id == images.size()) {
+    images.push_back(image);
+  }
+  else {
+    images[image->id] = image;
+  }
+
+  VLOG(1) << "Image cache: added " << loader->name() << " with " << image->num_levels
+          << " mip levels.";
+
+  return image;
+}
+
+void ImageCache::remove_image(Image *image)
+{
+  /* Must not be called while rendering, tiles of the image are assumed to be unused. */
+  foreach (Shard *shard, shards) {
+    thread_scoped_lock lock(shard->mutex);
+
+    for (list<Tile *>::iterator it = shard->lru.begin(); it != shard->lru.end();) {
+      Tile *tile = *it;
+      if (tile->image_id == image->id) {
+        assert(tile->users == 0);
+        shard->tiles.erase(tile->key);
+        shard->memory_usage -= tile->pixels.size() * sizeof(float);
+        it = shard->lru.erase(it);
+        delete tile;
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+
+  {
+    thread_scoped_lock lock(bands_mutex);
+    for (list<Band *>::iterator it = bands.begin(); it != bands.end();) {
+      Band *band = *it;
+      if (band->image_id == image->id) {
+        assert(band->users == 0);
+        it = bands.erase(it);
+        delete band;
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+
+  thread_scoped_lock lock(images_mutex);
+  images[image->id] = NULL;
+  delete image;
+}
+
+void ImageCache::set_memory_limit(size_t memory_limit_)
+{
+  memory_limit = memory_limit_;
+
+  foreach (Shard *shard, shards) {
+    thread_scoped_lock lock(shard->mutex);
+    evict_tiles(*shard);
+  }
+}
+
+size_t ImageCache::memory_usage()
+{
+  size_t usage = 0;
+  foreach (Shard *shard, shards) {
+    thread_scoped_lock lock(shard->mutex);
+    usage += shard->memory_usage;
+  }
+  return usage;
+}
+
+/* Tiles */
+
+ImageCache::Tile *ImageCache::acquire_tile(const Image *image, int level, int tx, int ty)
+{
+  const uint64_t key = image_cache_tile_key(image->id, level, tx, ty);
+  Shard &shard = *shards[image_cache_tile_shard(key)];
+
+  thread_scoped_lock lock(shard.mutex);
+
+  Tile *tile = NULL;
+  unordered_map<uint64_t, Tile *>::iterator it = shard.tiles.find(key);
+  if (it != shard.tiles.end()) {
+    tile = it->second;
+    tile->users++;
+    tile->used = true;
+  }
+
+  if (tile) {
+    /* Another thread may still be loading the tile. */
+    while (!tile->loaded) {
+      shard.loaded_condition.wait(lock);
+    }
+
+    return tile;
+  }
+
+  tile = new Tile();
+  tile->key = key;
+  tile->image_id = image->id;
+  tile->loaded = false;
+  tile->users = 1;
+  tile->used = true;
+  shard.lru.push_front(tile);
+  tile->lru = shard.lru.begin();
+  shard.tiles[key] = tile;
+
+  /* Load without holding the lock, other threads wait for the loaded condition. */
+  lock.unlock();
+
+  tile->pixels.resize(IMAGE_CACHE_TILE_STRIDE * IMAGE_CACHE_TILE_STRIDE * image->channels);
+  load_tile(image, level, tx, ty, tile->pixels.data());
+
+  lock.lock();
+  tile->loaded = true;
+  shard.memory_usage += tile->pixels.size() * sizeof(float);
+  evict_tiles(shard);
+  shard.loaded_condition.notify_all();
+
+  return tile;
+}
+
+void ImageCache::release_tile(const Image * /*image*/, Tile *tile)
+{
+  tile->users--;
+}
+
+void ImageCache::evict_tiles(Shard &shard)
+{
+  const size_t shard_memory_limit = memory_limit / shards.size();
+  if (shard.memory_usage <= shard_memory_limit) {
+    return;
+  }
+
+  /* Second chance eviction starting from the oldest tiles. Tiles used since they were last
+   * looked at move to the front instead, tiles in use or still loading are skipped. */
+  size_t num_tiles = shard.lru.size();
+  while (num_tiles > 0 && shard.memory_usage > shard_memory_limit) {
+    num_tiles--;
+
+    Tile *tile = shard.lru.back();
+    if (tile->used || tile->users > 0 || !tile->loaded) {
+      tile->used = false;
+      shard.lru.splice(shard.lru.begin(), shard.lru, tile->lru);
+      continue;
+    }
+
+    shard.tiles.erase(tile->key);
+    shard.memory_usage -= tile->pixels.size() * sizeof(float);
+    shard.lru.pop_back();
+    delete tile;
+  }
+}
+
+/* Bands */
+
+ImageCache::Band *ImageCache::acquire_band(const Image *image, int index)
+{
+  thread_scoped_lock lock(bands_mutex);
+
+  Band *band = NULL;
+  for (list<Band *>::iterator it = bands.begin(); it != bands.end(); ++it) {
+    if ((*it)->image_id == image->id && (*it)->index == index) {
+      band = *it;
+      bands.splice(bands.begin(), bands, it);
+      break;
+    }
+  }
+
+  if (band == NULL) {
+    band = new Band();
+    band->image_id = image->id;
+    band->index = index;
+    band->loaded = false;
+    band->valid = false;
+    band->users = 0;
+    bands.push_front(band);
+    evict_bands();
+  }
+
+  band->users++;
+  lock.unlock();
+
+  /* Decode without holding the bands lock. */
+  thread_scoped_lock band_lock(band->mutex);
+  if (!band->loaded) {
+    const ImageMetaData &metadata = image->metadata;
+    const int y = index * IMAGE_CACHE_BAND_SIZE;
+    const int num_rows = min(IMAGE_CACHE_BAND_SIZE, (int)metadata.height - y);
+
+    band->rows.resize((size_t)num_rows * metadata.width * metadata.channels);
+    band->valid = image->loader->load_pixels_rows(
+        metadata, y, num_rows, band->rows.data(), image->associate_alpha);
+    band->loaded = true;
+  }
+
+  return band;
+}
+
+void ImageCache::release_band(Band *band)
+{
+  thread_scoped_lock lock(bands_mutex);
+  band->users--;
+  evict_bands();
+}
+
+void ImageCache::evict_bands()
+{
+  /* Least recently used bands first, skipping bands that are in use. */
+  list<Band *>::iterator it = bands.end();
+  while (it != bands.begin() && bands.size() > IMAGE_CACHE_MAX_BANDS) {
+    --it;
+    Band *band = *it;
+    if (band->users > 0) {
+      continue;
+    }
+
+    it = bands.erase(it);
+    delete band;
+  }
+}
+
+/* Read a rectangle of full resolution pixels with all channels of the file, bottom to top.
+ * Tiled files are read directly, other files through bands of decoded rows shared by all tiles
+ * overlapping them. */
+bool ImageCache::load_region(
+    const Image *image, int x, int y, int width, int height, float *pixels)
+{
+  const ImageMetaData &metadata = image->metadata;
+  if (image->loader->supports_load_pixels_region()) {
+    return image->loader->load_pixels_region(
+        metadata, x, y, width, height, pixels, image->associate_alpha);
+  }
+
+  const int file_channels = metadata.channels;
+  const size_t row_size = (size_t)metadata.width * file_channels;
+
+  Band *band = NULL;
+  bool valid = true;
+
+  for (int j = 0; j < height; j++) {
+    const int index = (y + j) / IMAGE_CACHE_BAND_SIZE;
+    if (band == NULL || band->index != index) {
+      if (band) {
+        release_band(band);
+      }
+      band = acquire_band(image, index);
+      valid = valid && band->valid;
+    }
+
+    if (valid) {
+      const int band_y = y + j - index * IMAGE_CACHE_BAND_SIZE;
+      memcpy(pixels + (size_t)j * width * file_channels,
+             &band->rows[band_y * row_size + (size_t)x * file_channels],
+             sizeof(float) * width * file_channels);
+    }
+  }
+
+  if (band) {
+    release_band(band);
+  }
+
+  return valid;
+}
+
+void ImageCache::load_tile(const Image *image, int level, int tx, int ty, float *pixels)
+{
+  if (level == 0) {
+    load_tile_from_file(image, tx, ty, pixels);
+  }
+  else {
+    load_tile_from_level(image, level, tx, ty, pixels);
+  }
+
+  /* Make sure we don't have buggy values, like the kernel textures. */
+  const int channels = image->channels;
+  const int num_pixels = IMAGE_CACHE_TILE_STRIDE * IMAGE_CACHE_TILE_STRIDE;
+  for (int i = 0; i < num_pixels; i++) {
+    float *pixel = pixels + i * channels;
+    bool finite = true;
+    for (int c = 0; c < channels; c++) {
+      finite = finite && isfinite(pixel[c]);
+    }
+    if (!finite) {
+      for (int c = 0; c < channels; c++) {
+        pixel[c] = 0.0f;
+      }
+    }
+  }
+}
+
+/* Split the image coordinates a tile row or column maps to into runs of contiguous coordinates,
+ * so border pixels wrapping around to the other side of the image are read separately instead
+ * of everything in between. Returns the number of runs, with the run of each coordinate in
+ * coord_run, or -1 for coordinates outside the image. */
+static int image_cache_coord_runs(const int coords[IMAGE_CACHE_TILE_STRIDE],
+                                  int2 runs[IMAGE_CACHE_TILE_STRIDE],
+                                  int coord_run[IMAGE_CACHE_TILE_STRIDE])
+{
+  int sorted[IMAGE_CACHE_TILE_STRIDE];
+  int num_sorted = 0;
+  for (int i = 0; i < IMAGE_CACHE_TILE_STRIDE; i++) {
+    if (coords[i] != -1) {
+      sorted[num_sorted++] = coords[i];
+    }
+  }
+  std::sort(sorted, sorted + num_sorted);
+
+  /* Runs as begin and end coordinates. */
+  int num_runs = 0;
+  for (int i = 0; i < num_sorted; i++) {
+    if (num_runs > 0 && sorted[i] <= runs[num_runs - 1].y) {
+      runs[num_runs - 1].y = sorted[i] + 1;
+    }
+    else {
+      runs[num_runs++] = make_int2(sorted[i], sorted[i] + 1);
+    }
+  }
+
+  for (int i = 0; i < IMAGE_CACHE_TILE_STRIDE; i++) {
+    coord_run[i] = -1;
+    for (int r = 0; r < num_runs && coords[i] != -1; r++) {
+      if (coords[i] >= runs[r].x && coords[i] < runs[r].y) {
+        coord_run[i] = r;
+        break;
+      }
+    }
+  }
+
+  return num_runs;
+}
+
+/* Read the pixels of a full resolution tile from the image loader, converting them to the 1 or
+ * 4 channel layout and scene linear color space the kernel expects. */
+void ImageCache::load_tile_from_file(const Image *image, int tx, int ty, float *pixels)
+{
+  const ImageMetaData &metadata = image->metadata;
+  const int width = metadata.width;
+  const int height = metadata.height;
+  const int file_channels = metadata.channels;
+  const int channels = image->channels;
+
+  const int x0 = tx * IMAGE_CACHE_TILE_SIZE - IMAGE_CACHE_TILE_BORDER;
+  const int y0 = ty * IMAGE_CACHE_TILE_SIZE - IMAGE_CACHE_TILE_BORDER;
+
+  /* Image pixels of the tile pixels, depending on the extension type. */
+  int xs[IMAGE_CACHE_TILE_STRIDE], ys[IMAGE_CACHE_TILE_STRIDE];
+  for (int i = 0; i < IMAGE_CACHE_TILE_STRIDE; i++) {
+    xs[i] = image_cache_extend_coord(x0 + i, width, image->extension);
+    ys[i] = image_cache_extend_coord(y0 + i, height, image->extension);
+  }
+
+  int2 x_runs[IMAGE_CACHE_TILE_STRIDE], y_runs[IMAGE_CACHE_TILE_STRIDE];
+  int x_run[IMAGE_CACHE_TILE_STRIDE], y_run[IMAGE_CACHE_TILE_STRIDE];
+  const int num_x_runs = image_cache_coord_runs(xs, x_runs, x_run);
+  const int num_y_runs = image_cache_coord_runs(ys, y_runs, y_run);
+
+  /* Read each combination of runs as one region, usually just the inside of the tile. */
+  vector<size_t> region_offset(num_x_runs * num_y_runs);
+  size_t regions_size = 0;
+  for (int ry = 0; ry < num_y_runs; ry++) {
+    for (int rx = 0; rx < num_x_runs; rx++) {
+      region_offset[ry * num_x_runs + rx] = regions_size;
+      regions_size += (size_t)(x_runs[rx].y - x_runs[rx].x) * (y_runs[ry].y - y_runs[ry].x) *
+                      file_channels;
+    }
+  }
+
+  vector<float> regions(regions_size);
+  for (int ry = 0; ry < num_y_runs; ry++) {
+    for (int rx = 0; rx < num_x_runs; rx++) {
+      float *region = &regions[region_offset[ry * num_x_runs + rx]];
+      const int region_width = x_runs[rx].y - x_runs[rx].x;
+      const int region_height = y_runs[ry].y - y_runs[ry].x;
+      if (!load_region(
+              image, x_runs[rx].x, y_runs[ry].x, region_width, region_height, region)) {
+        VLOG(1) << "Image cache: failed to read " << image->loader->name() << ".";
+        std::fill(region, region + (size_t)region_width * region_height * file_channels, 0.0f);
+      }
+    }
+  }
+
+  for (int j = 0; j < IMAGE_CACHE_TILE_STRIDE; j++) {
+    float *out = pixels + (size_t)j * IMAGE_CACHE_TILE_STRIDE * channels;
+    const int ry = y_run[j];
+
+    for (int i = 0; i < IMAGE_CACHE_TILE_STRIDE; i++, out += channels) {
+      const int rx = x_run[i];
+      if (rx == -1 || ry == -1) {
+        for (int c = 0; c < channels; c++) {
+          out[c] = 0.0f;
+        }
+        continue;
+      }
+
+      const int region_width = x_runs[rx].y - x_runs[rx].x;
+      const float *in = &regions[region_offset[ry * num_x_runs + rx] +
+                                 ((size_t)(ys[j] - y_runs[ry].x) * region_width +
+                                  (xs[i] - x_runs[rx].x)) *
+                                     file_channels];
+      if (channels == 1) {
+        out[0] = in[0];
+      }
+      else if (file_channels == 1) {
+        /* Grayscale to RGBA. */
+        out[0] = out[1] = out[2] = in[0];
+        out[3] = 1.0f;
+      }
+      else if (file_channels == 2) {
+        /* Grayscale + alpha to RGBA. */
+        out[0] = out[1] = out[2] = in[0];
+        out[3] = in[1];
+      }
+      else {
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+        out[3] = (file_channels > 3) ? in[3] : 1.0f;
+      }
+
+      if (channels == 4 && image->alpha_type == IMAGE_ALPHA_IGNORE) {
+        out[3] = 1.0f;
+      }
+    }
+  }
+
+  if (channels == 4 && metadata.colorspace != u_colorspace_raw &&
+      metadata.colorspace != u_colorspace_srgb) {
+    /* Convert to scene linear. */
+    ColorSpaceManager::to_scene_linear(metadata.colorspace,
+                                       pixels,
+                                       IMAGE_CACHE_TILE_STRIDE * IMAGE_CACHE_TILE_STRIDE,
+                                       metadata.compress_as_srgb);
+  }
+}
+
+/* Build a tile of a coarser mip level by box filtering the pixels of the next finer level,
+ * which are themselves loaded through the cache when needed. */
+void ImageCache::load_tile_from_level(const Image *image, int level, int tx, int ty, float *pixels)
+{
+  const int channels = image->channels;
+  const int width = image->level_width[level];
+  const int height = image->level_height[level];
+  const int src_level = level - 1;
+  const int src_width = image->level_width[src_level];
+  const int src_height = image->level_height[src_level];
+
+  const int x0 = tx * IMAGE_CACHE_TILE_SIZE - IMAGE_CACHE_TILE_BORDER;
+  const int y0 = ty * IMAGE_CACHE_TILE_SIZE - IMAGE_CACHE_TILE_BORDER;
+
+  /* Keep the source tile in use while reading pixels from it, the 2x2 pixels of a box never
+   * cross tiles since the tile size is even. */
+  Tile *src_tile = NULL;
+  int src_tx = -1, src_ty = -1;
+
+  for (int j = 0; j < IMAGE_CACHE_TILE_STRIDE; j++) {
+    float *out = pixels + (size_t)j * IMAGE_CACHE_TILE_STRIDE * channels;
+    const int y = image_cache_extend_coord(y0 + j, height, image->extension);
+
+    for (int i = 0; i < IMAGE_CACHE_TILE_STRIDE; i++, out += channels) {
+      const int x = (y != -1) ? image_cache_extend_coord(x0 + i, width, image->extension) : -1;
+      for (int c = 0; c < channels; c++) {
+        out[c] = 0.0f;
+      }
+      if (x == -1) {
+        continue;
+      }
+
+      const int sx0 = 2 * x, sx1 = min(2 * x + 1, src_width - 1);
+      const int sy0 = 2 * y, sy1 = min(2 * y + 1, src_height - 1);
+      const int stx = sx0 / IMAGE_CACHE_TILE_SIZE;
+      const int sty = sy0 / IMAGE_CACHE_TILE_SIZE;
+
+      if (src_tile == NULL || stx != src_tx || sty != src_ty) {
+        if (src_tile) {
+          release_tile(image, src_tile);
+        }
+        src_tile = acquire_tile(image, src_level, stx, sty);
+        src_tx = stx;
+        src_ty = sty;
+      }
+
+      const int sx[2] = {sx0, sx1};
+      const int sy[2] = {sy0, sy1};
+      for (int b = 0; b < 2; b++) {
+        for (int a = 0; a < 2; a++) {
+          const int lx = sx[a] - stx * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+          const int ly = sy[b] - sty * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+          const float *in =
+              &src_tile->pixels[((size_t)ly * IMAGE_CACHE_TILE_STRIDE + lx) * channels];
+          for (int c = 0; c < channels; c++) {
+            out[c] += 0.25f * in[c];
+          }
+        }
+      }
+    }
+  }
+
+  if (src_tile) {
+    release_tile(image, src_tile);
+  }
+}
+
+/* Lookup */
+
+static ccl_always_inline float4 image_cache_pixel(const float *pixel, int channels)
+{
+  return (channels == 1) ? make_float4(pixel[0], pixel[0], pixel[0], 1.0f) :
+                           make_float4(pixel[0], pixel[1], pixel[2], pixel[3]);
+}
+
+float4 ImageCache::lookup_level(const Image *image, int level, float x, float y)
+{
+  const int channels = image->channels;
+  const int width = image->level_width[level];
+  const int height = image->level_height[level];
+
+  if (image->interpolation == INTERPOLATION_CLOSEST) {
+    const int ix = clamp(float_to_int(x * width), 0, width - 1);
+    const int iy = clamp(float_to_int(y * height), 0, height - 1);
+    const int tx = ix / IMAGE_CACHE_TILE_SIZE;
+    const int ty = iy / IMAGE_CACHE_TILE_SIZE;
+    const int lx = ix - tx * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+    const int ly = iy - ty * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+
+    Tile *tile = acquire_tile(image, level, tx, ty);
+    const float4 r = image_cache_pixel(
+        &tile->pixels[((size_t)ly * IMAGE_CACHE_TILE_STRIDE + lx) * channels], channels);
+    release_tile(image, tile);
+    return r;
+  }
+
+  /* Bilinear, the pixel to the left or bottom of the first tile is in its border. */
+  float fx, fy;
+  const int ix = clamp(float_to_int(floorf(x * width - 0.5f)), -1, width - 1);
+  const int iy = clamp(float_to_int(floorf(y * height - 0.5f)), -1, height - 1);
+  fx = clamp(x * width - 0.5f - ix, 0.0f, 1.0f);
+  fy = clamp(y * height - 0.5f - iy, 0.0f, 1.0f);
+
+  const int tx = max(ix, 0) / IMAGE_CACHE_TILE_SIZE;
+  const int ty = max(iy, 0) / IMAGE_CACHE_TILE_SIZE;
+  const int lx = ix - tx * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+  const int ly = iy - ty * IMAGE_CACHE_TILE_SIZE + IMAGE_CACHE_TILE_BORDER;
+
+  Tile *tile = acquire_tile(image, level, tx, ty);
+  const float *p = &tile->pixels[((size_t)ly * IMAGE_CACHE_TILE_STRIDE + lx) * channels];
+  const size_t row = IMAGE_CACHE_TILE_STRIDE * channels;
+
+  const float4 r = (1.0f - fy) * ((1.0f - fx) * image_cache_pixel(p, channels) +
+                                  fx * image_cache_pixel(p + channels, channels)) +
+                   fy * ((1.0f - fx) * image_cache_pixel(p + row, channels) +
+                         fx * image_cache_pixel(p + row + channels, channels));
+  release_tile(image, tile);
+  return r;
+}
+
+float4 ImageCache::lookup(const Image *image, float x, float y, float width)
+{
+  switch (image->extension) {
+    case EXTENSION_REPEAT:
+      x -= floorf(x);
+      y -= floorf(y);
+      break;
+    case EXTENSION_EXTEND:
+      x = saturate(x);
+      y = saturate(y);
+      break;
+    case EXTENSION_CLIP:
+    default:
+      if (x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f) {
+        return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+      }
+      break;
+  }
+
+  /* Pick mip level from the filter width in pixels of the full resolution image. */
+  const float pixel_width = width * max(image->level_width[0], image->level_height[0]);
+  const float lod = clamp((pixel_width > 1.0f) ? log2f(pixel_width) : 0.0f,
+                          (float)image->min_level,
+                          (float)(image->num_levels - 1));
+  const int level = float_to_int(lod);
+
+  if (image->interpolation == INTERPOLATION_CLOSEST) {
+    return lookup_level(image, level, x, y);
+  }
+
+  /* Trilinear filtering between mip levels. Cubic and smart interpolation fall back to this,
+   * as the mip levels already take care of minification. */
+  const float t = lod - level;
+  float4 r = lookup_level(image, level, x, y);
+  if (t > 0.0f && level + 1 < image->num_levels) {
+    r = (1.0f - t) * r + t * lookup_level(image, level + 1, x, y);
+  }
+  return r;
+}
+
+const TextureCacheImage *ImageCache::texture_image(const Image *image)
+{
+  return image;
+}
+
+float4 ImageCache::Image::lookup(float x, float y, float width) const
+{
+  return cache->lookup(this, x, y, width);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include "util/util_list.h"
+#include "util/util_map.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class ImageLoader;
+class ImageMetaData;
+class ImageParams;
+
+/* Image Cache
+ *
+ * Tiled and mipmapped cache for 2D images on the CPU device, so images don't have to be fully
+ * in memory for rendering. Tiles of the full resolution image are read on demand through the
+ * image loader, coarser mip levels are built from the finer ones when first needed, and tiles
+ * that were not used recently are evicted once the memory limit is exceeded.
+ *
+ * Files stored in tiles are read a region at a time. Other files are decoded in bands of rows
+ * that are kept for a while, so neighboring tiles don't decode the same rows again.
+ *
+ * Tiles are stored as 1 or 4 channel float pixels with a border of one pixel on every side, so
+ * bilinear lookups never need more than one tile per mip level. */
+
+class ImageCache {
+ public:
+  /* Handed to the kernel as texture data, see #TextureCacheImage. */
+  struct Image;
+
+  explicit ImageCache(size_t memory_limit);
+  ~ImageCache();
+
+  /* Returns NULL if the loader can't read the image in parts. */
+  Image *add_image(ImageLoader *loader,
+                   const ImageMetaData &metadata,
+                   const ImageParams &params,
+                   const bool associate_alpha,
+                   const int texture_limit);
+  void remove_image(Image *image);
+
+  /* Image as seen by the kernel, to be stored in the texture data. */
+  static const TextureCacheImage *texture_image(const Image *image);
+
+  /* Filtered lookup, with the filter width in normalized texture coordinates selecting the mip
+   * level. Thread safe, can be called from the render threads. */
+  float4 lookup(const Image *image, float x, float y, float width);
+
+  void set_memory_limit(size_t memory_limit);
+  size_t memory_usage();
+
+ protected:
+  struct Tile;
+  struct Shard;
+  struct Band;
+
+  Tile *acquire_tile(const Image *image, int level, int tx, int ty);
+  void release_tile(const Image *image, Tile *tile);
+
+  void load_tile(const Image *image, int level, int tx, int ty, float *pixels);
+  void load_tile_from_file(const Image *image, int tx, int ty, float *pixels);
+  void load_tile_from_level(const Image *image, int level, int tx, int ty, float *pixels);
+
+  float4 lookup_level(const Image *image, int level, float x, float y);
+
+  void evict_tiles(Shard &shard);
+
+  Band *acquire_band(const Image *image, int index);
+  void release_band(Band *band);
+  void evict_bands();
+
+  bool load_region(const Image *image, int x, int y, int width, int height, float *pixels);
+
+  size_t memory_limit;
+
+  thread_mutex images_mutex;
+  vector<Image *> images;
+
+  vector<Shard *> shards;
+
+  /* Most recently used bands first. */
+  thread_mutex bands_mutex;
+  list<Band *> bands;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __IMAGE_CACHE_H__ */
@@ -22,12 +22,13 @@
 
 CCL_NAMESPACE_BEGIN
 
-OIIOImageLoader::OIIOImageLoader(const string &filepath) : filepath(filepath)
+OIIOImageLoader::OIIOImageLoader(const string &filepath) : filepath(filepath), tiled(false)
 {
 }
 
 OIIOImageLoader::~OIIOImageLoader()
 {
+  close_rows_input();
 }
 
 bool OIIOImageLoader::load_metadata(ImageMetaData &metadata)
@@ -98,6 +99,8 @@ bool OIIOImageLoader::load_metadata(ImageMetaData &metadata)
 
   metadata.colorspace_file_format = in->format_name();
 
+  tiled = spec.tile_width > 0 && spec.tile_height > 0 && spec.depth <= 1;
+
   in->close();
 
   return true;
@@ -217,6 +220,183 @@ bool OIIOImageLoader::load_pixels(const ImageMetaData &metadata,
   return true;
 }
 
+/* Limit the number of files kept open for reading rows, to stay below the open file limit of
+ * the system when many images are paged in. */
+#define OIIO_MAX_OPEN_ROWS_INPUTS 256
+static thread_mutex open_rows_inputs_mutex;
+static int num_open_rows_inputs = 0;
+
+bool OIIOImageLoader::supports_load_pixels_rows() const
+{
+  return true;
+}
+
+bool OIIOImageLoader::load_pixels_rows(const ImageMetaData &metadata,
+                                       const int y,
+                                       const int num_rows,
+                                       float *pixels,
+                                       const bool associate_alpha)
+{
+  thread_scoped_lock lock(rows_mutex);
+
+  if (!open_rows_input(associate_alpha)) {
+    return false;
+  }
+
+  const ImageSpec &spec = rows_input->spec();
+  const int components = metadata.channels;
+  const stride_t scanlinesize = ((stride_t)metadata.width) * components * sizeof(float);
+
+  /* Rows are bottom to top, flip them while reading like oiio_load_pixels(). */
+  const int ybegin = spec.y + (int)metadata.height - (y + num_rows);
+  const int yend = spec.y + (int)metadata.height - y;
+  if (!rows_input->read_scanlines(ybegin,
+                                  yend,
+                                  spec.z,
+                                  TypeDesc::FLOAT,
+                                  (uchar *)pixels + (num_rows - 1) * scanlinesize,
+                                  AutoStride,
+                                  -scanlinesize)) {
+    return false;
+  }
+
+  finish_rows_input(metadata, pixels, ((size_t)metadata.width) * num_rows);
+  return true;
+}
+
+bool OIIOImageLoader::supports_load_pixels_region() const
+{
+  return tiled;
+}
+
+bool OIIOImageLoader::load_pixels_region(const ImageMetaData &metadata,
+                                         const int x,
+                                         const int y,
+                                         const int width,
+                                         const int height,
+                                         float *pixels,
+                                         const bool associate_alpha)
+{
+  thread_scoped_lock lock(rows_mutex);
+
+  if (!open_rows_input(associate_alpha)) {
+    return false;
+  }
+
+  const ImageSpec &spec = rows_input->spec();
+  const int components = metadata.channels;
+
+  /* Rows of the file are top to bottom, and only whole tiles can be read. */
+  const int file_y = (int)metadata.height - (y + height);
+  const int tile_x_begin = (x / spec.tile_width) * spec.tile_width;
+  const int tile_x_end = min((int)divide_up(x + width, spec.tile_width) * spec.tile_width,
+                             (int)metadata.width);
+  const int tile_y_begin = (file_y / spec.tile_height) * spec.tile_height;
+  const int tile_y_end = min((int)divide_up(file_y + height, spec.tile_height) *
+                                 spec.tile_height,
+                             (int)metadata.height);
+
+  const size_t tiles_width = tile_x_end - tile_x_begin;
+  vector<float> tiles(tiles_width * (tile_y_end - tile_y_begin) * components);
+  if (!rows_input->read_tiles(spec.x + tile_x_begin,
+                              spec.x + tile_x_end,
+                              spec.y + tile_y_begin,
+                              spec.y + tile_y_end,
+                              spec.z,
+                              spec.z + 1,
+                              TypeDesc::FLOAT,
+                              tiles.data())) {
+    return false;
+  }
+
+  /* Copy the requested rectangle, flipping rows to bottom to top. */
+  for (int j = 0; j < height; j++) {
+    const int tiles_y = file_y + height - 1 - j - tile_y_begin;
+    const float *in = &tiles[((size_t)tiles_y * tiles_width + (x - tile_x_begin)) * components];
+    memcpy(pixels + (size_t)j * width * components, in, sizeof(float) * width * components);
+  }
+
+  finish_rows_input(metadata, pixels, ((size_t)width) * height);
+  return true;
+}
+
+bool OIIOImageLoader::open_rows_input(const bool associate_alpha)
+{
+  /* Keep the file open, the image cache reads a few rows or tiles at a time. */
+  if (rows_input) {
+    return true;
+  }
+
+  if (!path_exists(filepath.string()) || path_is_directory(filepath.string())) {
+    return false;
+  }
+
+  rows_input = unique_ptr<ImageInput>(ImageInput::create(filepath.string()));
+  if (!rows_input) {
+    return false;
+  }
+
+  ImageSpec spec = ImageSpec();
+  ImageSpec config = ImageSpec();
+
+  if (!associate_alpha) {
+    config.attribute("oiio:UnassociatedAlpha", 1);
+  }
+
+  if (!rows_input->open(filepath.string(), spec, config)) {
+    rows_input.reset();
+    return false;
+  }
+
+  thread_scoped_lock open_lock(open_rows_inputs_mutex);
+  num_open_rows_inputs++;
+  return true;
+}
+
+void OIIOImageLoader::finish_rows_input(const ImageMetaData &metadata,
+                                        float *pixels,
+                                        const size_t num_pixels)
+{
+  /* CMYK to RGBA. */
+  const bool cmyk = strcmp(rows_input->format_name(), "jpeg") == 0 && metadata.channels == 4;
+  if (cmyk) {
+    for (size_t i = 0; i < num_pixels; i++) {
+      float *pixel = pixels + i * 4;
+      const float c = pixel[0], m = pixel[1], ye = pixel[2], k = pixel[3];
+      pixel[0] = (1.0f - c) * (1.0f - k);
+      pixel[1] = (1.0f - m) * (1.0f - k);
+      pixel[2] = (1.0f - ye) * (1.0f - k);
+      pixel[3] = 1.0f;
+    }
+  }
+
+  bool close_input;
+  {
+    thread_scoped_lock open_lock(open_rows_inputs_mutex);
+    close_input = num_open_rows_inputs > OIIO_MAX_OPEN_ROWS_INPUTS;
+  }
+  if (close_input) {
+    close_rows_input();
+  }
+}
+
+void OIIOImageLoader::close_rows_input()
+{
+  if (rows_input) {
+    rows_input->close();
+    rows_input.reset();
+
+    thread_scoped_lock open_lock(open_rows_inputs_mutex);
+    num_open_rows_inputs--;
+  }
+}
+
+void OIIOImageLoader::cleanup()
+{
+  thread_scoped_lock lock(rows_mutex);
+  close_rows_input();
+}
+
 string OIIOImageLoader::name() const
 {
   return path_filename(filepath.string());
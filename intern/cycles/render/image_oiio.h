@@ -19,6 +19,8 @@
 
 #include "render/image.h"
 
+#include "util/util_image.h"
+
 CCL_NAMESPACE_BEGIN
 
 class OIIOImageLoader : public ImageLoader {
@@ -33,14 +35,43 @@ class OIIOImageLoader : public ImageLoader {
                    const size_t pixels_size,
                    const bool associate_alpha) override;
 
+  bool supports_load_pixels_rows() const override;
+  bool load_pixels_rows(const ImageMetaData &metadata,
+                        const int y,
+                        const int num_rows,
+                        float *pixels,
+                        const bool associate_alpha) override;
+
+  bool supports_load_pixels_region() const override;
+  bool load_pixels_region(const ImageMetaData &metadata,
+                          const int x,
+                          const int y,
+                          const int width,
+                          const int height,
+                          float *pixels,
+                          const bool associate_alpha) override;
+
   string name() const override;
 
   ustring osl_filepath() const override;
 
+  void cleanup() override;
+
   bool equals(const ImageLoader &other) const override;
 
  protected:
   ustring filepath;
+
+  /* File stores pixels in tiles, found when loading metadata. */
+  bool tiled;
+
+  /* File kept open for reading rows or tiles on demand. */
+  unique_ptr<ImageInput> rows_input;
+  thread_mutex rows_mutex;
+
+  bool open_rows_input(const bool associate_alpha);
+  void finish_rows_input(const ImageMetaData &metadata, float *pixels, const size_t num_pixels);
+  void close_rows_input();
 };
 
 CCL_NAMESPACE_END
@@ -23,6 +23,205 @@
 
 CCL_NAMESPACE_BEGIN
 
+#ifdef WITH_OPENVDB
+/* Sparse voxel layout in texture space, see util_texture.h. */
+struct VDBSparseLayout {
+  openvdb::CoordBBox bbox;
+  int grid_width, grid_height, grid_depth;
+  size_t nodes_offset;
+
+  VDBSparseLayout(const openvdb::CoordBBox &bbox) : bbox(bbox)
+  {
+    const openvdb::Coord dim = bbox.dim();
+    grid_width = divide_up(dim.x(), TEX_SPARSE_NODE_DIM);
+    grid_height = divide_up(dim.y(), TEX_SPARSE_NODE_DIM);
+    grid_depth = divide_up(dim.z(), TEX_SPARSE_NODE_DIM);
+    nodes_offset = TEX_SPARSE_HEADER_SIZE + (size_t)grid_width * grid_height * grid_depth;
+  }
+
+  /* Slot in the top grid, for leaf coordinates. */
+  size_t node_slot(int lx, int ly, int lz) const
+  {
+    return TEX_SPARSE_HEADER_SIZE + (lx >> TEX_SPARSE_NODE_LOG2) +
+           (size_t)grid_width *
+               ((ly >> TEX_SPARSE_NODE_LOG2) + (size_t)grid_height * (lz >> TEX_SPARSE_NODE_LOG2));
+  }
+
+  /* Slot in the node table, for leaf coordinates. */
+  size_t leaf_slot(uint node, int lx, int ly, int lz) const
+  {
+    const int mask = TEX_SPARSE_NODE_SIZE - 1;
+    return nodes_offset + (size_t)node * TEX_SPARSE_NODE_LEAVES + (lx & mask) +
+           TEX_SPARSE_NODE_SIZE * ((ly & mask) + TEX_SPARSE_NODE_SIZE * (lz & mask));
+  }
+
+  /* Offset in the leaf voxels, for voxel coordinates. */
+  size_t voxel_offset(uint leaf, int x, int y, int z) const
+  {
+    const int mask = TEX_SPARSE_LEAF_SIZE - 1;
+    return (size_t)leaf * TEX_SPARSE_LEAF_VOXELS + (x & mask) +
+           TEX_SPARSE_LEAF_SIZE * ((y & mask) + TEX_SPARSE_LEAF_SIZE * (z & mask));
+  }
+};
+
+/* Allocate nodes and leaves for all active voxels and tiles of the grid. */
+struct VDBSparseIndexBuilder {
+  const VDBSparseLayout &layout;
+  vector<uint> &index;
+  uint num_nodes, num_leaves;
+
+  VDBSparseIndexBuilder(const VDBSparseLayout &layout, vector<uint> &index)
+      : layout(layout), index(index), num_nodes(0), num_leaves(0)
+  {
+  }
+
+  template<typename GridType> void operator()(const GridType &grid)
+  {
+    /* Node 0 and leaf 0 are shared by all empty space. */
+    index.clear();
+    index.resize(layout.nodes_offset + TEX_SPARSE_NODE_LEAVES, 0);
+    num_nodes = 1;
+    num_leaves = 1;
+
+    for (typename GridType::ValueOnCIter iter = grid.cbeginValueOn(); iter; ++iter) {
+      openvdb::CoordBBox box;
+      iter.getBoundingBox(box);
+      box.intersect(layout.bbox);
+      if (box.empty()) {
+        continue;
+      }
+
+      const openvdb::Coord min = (box.min() - layout.bbox.min()) >> TEX_SPARSE_LEAF_LOG2;
+      const openvdb::Coord max = (box.max() - layout.bbox.min()) >> TEX_SPARSE_LEAF_LOG2;
+      for (int lz = min.z(); lz <= max.z(); lz++) {
+        for (int ly = min.y(); ly <= max.y(); ly++) {
+          for (int lx = min.x(); lx <= max.x(); lx++) {
+            add_leaf(lx, ly, lz);
+          }
+        }
+      }
+    }
+  }
+
+  void add_leaf(int lx, int ly, int lz)
+  {
+    const size_t node_slot = layout.node_slot(lx, ly, lz);
+    if (index[node_slot] == 0) {
+      index[node_slot] = num_nodes++;
+      index.resize(index.size() + TEX_SPARSE_NODE_LEAVES, 0);
+    }
+
+    const size_t leaf_slot = layout.leaf_slot(index[node_slot], lx, ly, lz);
+    if (index[leaf_slot] == 0) {
+      index[leaf_slot] = num_leaves++;
+    }
+  }
+};
+
+static inline void vdb_sparse_store(float *voxel, const int, const float value)
+{
+  voxel[0] = value;
+}
+
+template<typename T>
+static inline void vdb_sparse_store(float *voxel, const int channels, const T &value)
+{
+  vdb_sparse_store(voxel, channels, (float)value);
+}
+
+template<typename T>
+static inline void vdb_sparse_store(float *voxel, const int, const openvdb::math::Vec3<T> &value)
+{
+  voxel[0] = (float)value.x();
+  voxel[1] = (float)value.y();
+  voxel[2] = (float)value.z();
+  voxel[3] = 1.0f;
+}
+
+/* Copy values of all active voxels and tiles of the grid into their leaves. */
+struct VDBSparseVoxelCopier {
+  const VDBSparseLayout &layout;
+  const vector<uint> &index;
+  float *voxels;
+  int channels;
+
+  VDBSparseVoxelCopier(const VDBSparseLayout &layout,
+                       const vector<uint> &index,
+                       float *voxels,
+                       int channels)
+      : layout(layout), index(index), voxels(voxels), channels(channels)
+  {
+  }
+
+  template<typename GridType> void operator()(const GridType &grid)
+  {
+    for (typename GridType::ValueOnCIter iter = grid.cbeginValueOn(); iter; ++iter) {
+      openvdb::CoordBBox box;
+      iter.getBoundingBox(box);
+      box.intersect(layout.bbox);
+      if (box.empty()) {
+        continue;
+      }
+
+      const typename GridType::ValueType value = iter.getValue();
+      const openvdb::Coord min = box.min() - layout.bbox.min();
+      const openvdb::Coord max = box.max() - layout.bbox.min();
+      for (int z = min.z(); z <= max.z(); z++) {
+        for (int y = min.y(); y <= max.y(); y++) {
+          for (int x = min.x(); x <= max.x(); x++) {
+            const int lx = x >> TEX_SPARSE_LEAF_LOG2;
+            const int ly = y >> TEX_SPARSE_LEAF_LOG2;
+            const int lz = z >> TEX_SPARSE_LEAF_LOG2;
+            const uint node = index[layout.node_slot(lx, ly, lz)];
+            const uint leaf = index[layout.leaf_slot(node, lx, ly, lz)];
+            float *voxel = voxels + layout.voxel_offset(leaf, x, y, z) * channels;
+            vdb_sparse_store(voxel, channels, value);
+          }
+        }
+      }
+    }
+  }
+};
+
+/* Call functor with the grid cast to its actual type. */
+template<typename Functor>
+static bool vdb_grid_apply(const openvdb::GridBase::ConstPtr &grid, Functor &functor)
+{
+  if (grid->isType<openvdb::FloatGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::FloatGrid>(grid));
+  }
+  else if (grid->isType<openvdb::Vec3fGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::Vec3fGrid>(grid));
+  }
+  else if (grid->isType<openvdb::BoolGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::BoolGrid>(grid));
+  }
+  else if (grid->isType<openvdb::DoubleGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::DoubleGrid>(grid));
+  }
+  else if (grid->isType<openvdb::Int32Grid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::Int32Grid>(grid));
+  }
+  else if (grid->isType<openvdb::Int64Grid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::Int64Grid>(grid));
+  }
+  else if (grid->isType<openvdb::Vec3IGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::Vec3IGrid>(grid));
+  }
+  else if (grid->isType<openvdb::Vec3dGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::Vec3dGrid>(grid));
+  }
+  else if (grid->isType<openvdb::MaskGrid>()) {
+    functor(*openvdb::gridConstPtrCast<openvdb::MaskGrid>(grid));
+  }
+  else {
+    return false;
+  }
+
+  return true;
+}
+#endif
+
 VDBImageLoader::VDBImageLoader(const string &grid_name) : grid_name(grid_name)
 {
 }
@@ -161,6 +360,63 @@ bool VDBImageLoader::load_pixels(const ImageMetaData &, void *pixels, const size
 #endif
 }
 
+bool VDBImageLoader::supports_load_sparse() const
+{
+#ifdef WITH_OPENVDB
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool VDBImageLoader::load_sparse_index(const ImageMetaData &, vector<uint> &index)
+{
+#ifdef WITH_OPENVDB
+  if (!grid) {
+    return false;
+  }
+
+  VDBSparseLayout layout(bbox);
+  VDBSparseIndexBuilder builder(layout, index);
+  if (!vdb_grid_apply(grid, builder)) {
+    return false;
+  }
+
+  /* Pad so leaf voxels are aligned to 16 bytes. */
+  const size_t leaves_offset = align_up(index.size(), 4);
+  index.resize(leaves_offset, 0);
+  index[0] = layout.nodes_offset;
+  index[1] = leaves_offset;
+  index[2] = builder.num_leaves;
+  index[3] = builder.num_nodes;
+
+  return true;
+#else
+  (void)index;
+  return false;
+#endif
+}
+
+bool VDBImageLoader::load_sparse_voxels(const ImageMetaData &metadata,
+                                        const vector<uint> &index,
+                                        float *voxels)
+{
+#ifdef WITH_OPENVDB
+  if (!grid) {
+    return false;
+  }
+
+  VDBSparseLayout layout(bbox);
+  VDBSparseVoxelCopier copier(layout, index, voxels, (metadata.channels == 1) ? 1 : 4);
+  return vdb_grid_apply(grid, copier);
+#else
+  (void)metadata;
+  (void)index;
+  (void)voxels;
+  return false;
+#endif
+}
+
 string VDBImageLoader::name() const
 {
   return grid_name;
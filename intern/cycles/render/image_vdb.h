@@ -37,6 +37,12 @@ class VDBImageLoader : public ImageLoader {
                            const size_t pixels_size,
                            const bool associate_alpha) override;
 
+  virtual bool supports_load_sparse() const override;
+  virtual bool load_sparse_index(const ImageMetaData &metadata, vector<uint> &index) override;
+  virtual bool load_sparse_voxels(const ImageMetaData &metadata,
+                                  const vector<uint> &index,
+                                  float *voxels) override;
+
   virtual string name() const override;
 
   virtual bool equals(const ImageLoader &other) const override;
@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -29,6 +30,7 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_logging.h"
+#include "util/util_map.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_task.h"
@@ -274,7 +276,17 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
-void LightManager::device_update_distribution(Device *,
+/* Rough estimate of the power emitted per unit area, to guide the light tree. */
+static float light_tree_shader_energy(Shader *shader)
+{
+  float3 emission;
+  if (shader->is_constant_emission(&emission)) {
+    return max(average(emission), 0.0f);
+  }
+  return 1.0f;
+}
+
+void LightManager::device_update_distribution(Device *device,
                                               DeviceScene *dscene,
                                               Scene *scene,
                                               Progress &progress)
@@ -286,6 +298,7 @@ void LightManager::device_update_distribution(Device *,
   size_t num_portals = 0;
   size_t num_background_lights = 0;
   size_t num_triangles = 0;
+  size_t num_light_object_triangles = 0;
 
   bool background_mis = false;
 
@@ -309,6 +322,7 @@ void LightManager::device_update_distribution(Device *,
     /* Count triangles. */
     Mesh *mesh = static_cast<Mesh *>(object->geometry);
     size_t mesh_num_triangles = mesh->num_triangles();
+    num_light_object_triangles += mesh_num_triangles;
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->shader[i];
       Shader *shader = (shader_index < mesh->used_shaders.size()) ?
@@ -328,6 +342,27 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* Light tree over the emissive triangles, with a map from object and primitive to emitter
+   * for evaluating the pdf of triangles hit by indirect rays. */
+  const bool use_light_tree = scene->integrator->use_light_tree && device->info.has_light_tree &&
+                              num_triangles > 0;
+  vector<LightTree::Primitive> tree_primitives;
+  vector<uint> tree_prim_map_slots;
+  uint *tree_object_map = NULL;
+  uint *tree_prim_map = NULL;
+  map<Shader *, float> tree_shader_energy;
+
+  if (use_light_tree) {
+    tree_primitives.reserve(num_triangles);
+    tree_prim_map_slots.resize(num_triangles);
+
+    tree_object_map = dscene->light_tree_object_map.alloc(scene->objects.size() * 2);
+    tree_prim_map = dscene->light_tree_prim_map.alloc(num_light_object_triangles);
+    std::fill_n(tree_object_map, scene->objects.size() * 2, LIGHT_TREE_NONE);
+    std::fill_n(tree_prim_map, dscene->light_tree_prim_map.size(), LIGHT_TREE_NONE);
+  }
+  size_t tree_prim_map_offset = 0;
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -365,6 +400,12 @@ void LightManager::device_update_distribution(Device *,
     }
 
     size_t mesh_num_triangles = mesh->num_triangles();
+
+    if (use_light_tree) {
+      tree_object_map[object_id * 2] = tree_prim_map_offset;
+      tree_object_map[object_id * 2 + 1] = mesh->prim_offset;
+    }
+
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->shader[i];
       Shader *shader = (shader_index < mesh->used_shaders.size()) ?
@@ -372,6 +413,10 @@ void LightManager::device_update_distribution(Device *,
                            scene->default_surface;
 
       if (shader->use_mis && shader->has_surface_emission) {
+        if (use_light_tree) {
+          tree_prim_map_slots[offset] = tree_prim_map_offset + i;
+        }
+
         distribution[offset].totarea = totarea;
         distribution[offset].prim = i + mesh->prim_offset;
         distribution[offset].mesh_light.shader_flag = shader_flag;
@@ -392,10 +437,30 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree) {
+          map<Shader *, float>::iterator it = tree_shader_energy.find(shader);
+          if (it == tree_shader_energy.end()) {
+            it = tree_shader_energy.insert(std::make_pair(shader, light_tree_shader_energy(shader)))
+                     .first;
+          }
+
+          LightTree::Primitive primitive;
+          primitive.bounds = BoundBox::empty;
+          primitive.bounds.grow(p1);
+          primitive.bounds.grow(p2);
+          primitive.bounds.grow(p3);
+          primitive.centroid = (p1 + p2 + p3) * (1.0f / 3.0f);
+          primitive.energy = area * it->second;
+          primitive.distribution_index = offset - 1;
+          tree_primitives.push_back(primitive);
+        }
       }
     }
 
+    tree_prim_map_offset += mesh_num_triangles;
     j++;
   }
 
@@ -446,6 +511,33 @@ void LightManager::device_update_distribution(Device *,
     distribution[num_distribution].totarea = 1.0f;
   }
 
+  if (progress.get_cancel())
+    return;
+
+  /* Build light tree. */
+  float tree_energy = 0.0f;
+
+  if (use_light_tree && trianglearea > 0.0f) {
+    progress.set_status("Updating Lights", "Building light tree");
+
+    LightTree tree(tree_primitives);
+    tree_energy = tree.nodes.empty() ? 0.0f : tree.nodes[0].energy;
+
+    if (tree_energy > 0.0f) {
+      for (size_t i = 0; i < tree.emitters.size(); i++) {
+        tree_prim_map[tree_prim_map_slots[tree.emitters[i].distribution_index]] = i;
+      }
+
+      KernelLightTreeNode *nodes = dscene->light_tree_nodes.alloc(tree.nodes.size());
+      KernelLightTreeEmitter *emitters = dscene->light_tree_emitters.alloc(tree.emitters.size());
+      std::copy(tree.nodes.begin(), tree.nodes.end(), nodes);
+      std::copy(tree.emitters.begin(), tree.emitters.end(), emitters);
+
+      VLOG(1) << "Light tree with " << tree.nodes.size() << " nodes over "
+              << tree.emitters.size() << " triangles.";
+    }
+  }
+
   if (progress.get_cancel())
     return;
 
@@ -480,6 +572,26 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree replaces the triangle part of the distribution. */
+    if (tree_energy > 0.0f) {
+      kintegrator->use_light_tree = true;
+      kintegrator->pdf_light_tree = (num_lights) ? 0.5f : 1.0f;
+
+      dscene->light_tree_nodes.copy_to_device();
+      dscene->light_tree_emitters.copy_to_device();
+      dscene->light_tree_object_map.copy_to_device();
+      dscene->light_tree_prim_map.copy_to_device();
+    }
+    else {
+      kintegrator->use_light_tree = false;
+      kintegrator->pdf_light_tree = 0.0f;
+
+      dscene->light_tree_nodes.free();
+      dscene->light_tree_emitters.free();
+      dscene->light_tree_object_map.free();
+      dscene->light_tree_prim_map.free();
+    }
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -510,12 +622,18 @@ void LightManager::device_update_distribution(Device *,
   }
   else {
     dscene->light_distribution.free();
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_emitters.free();
+    dscene->light_tree_object_map.free();
+    dscene->light_tree_prim_map.free();
 
     kintegrator->num_distribution = 0;
     kintegrator->num_all_lights = 0;
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
+    kintegrator->pdf_light_tree = 0.0f;
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -1000,6 +1118,10 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_emitters.free();
+  dscene->light_tree_object_map.free();
+  dscene->light_tree_prim_map.free();
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
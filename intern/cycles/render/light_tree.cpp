@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+
+CCL_NAMESPACE_BEGIN
+
+LightTree::LightTree(vector<Primitive> &primitives, int max_leaf_size)
+    : max_leaf_size(max(max_leaf_size, 1))
+{
+  if (primitives.empty()) {
+    return;
+  }
+
+  nodes.reserve(2 * primitives.size() / this->max_leaf_size + 1);
+  emitters.reserve(primitives.size());
+
+  build(primitives, 0, primitives.size(), -1);
+}
+
+int LightTree::build(vector<Primitive> &primitives, int start, int end, int parent)
+{
+  BoundBox bounds = BoundBox::empty;
+  BoundBox centroid_bounds = BoundBox::empty;
+  float energy = 0.0f;
+
+  for (int i = start; i < end; i++) {
+    bounds.grow(primitives[i].bounds);
+    centroid_bounds.grow(primitives[i].centroid);
+    energy += primitives[i].energy;
+  }
+
+  const int index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+
+  KernelLightTreeNode &knode = nodes[index];
+  knode.bounds_min[0] = bounds.min.x;
+  knode.bounds_min[1] = bounds.min.y;
+  knode.bounds_min[2] = bounds.min.z;
+  knode.bounds_max[0] = bounds.max.x;
+  knode.bounds_max[1] = bounds.max.y;
+  knode.bounds_max[2] = bounds.max.z;
+  knode.energy = energy;
+  knode.parent = parent;
+  knode.child_index = 0;
+  knode.num_emitters = 0;
+  knode.pad1 = 0;
+  knode.pad2 = 0;
+
+  if (end - start <= max_leaf_size) {
+    knode.child_index = emitters.size();
+    knode.num_emitters = end - start;
+
+    for (int i = start; i < end; i++) {
+      KernelLightTreeEmitter kemitter;
+      kemitter.energy = primitives[i].energy;
+      kemitter.distribution_index = primitives[i].distribution_index;
+      kemitter.node = index;
+      kemitter.pad = 0;
+      emitters.push_back(kemitter);
+    }
+
+    return index;
+  }
+
+  /* Median split along the largest axis of the centroids. */
+  const float3 extent = centroid_bounds.size();
+  const int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2) :
+                                           ((extent.y > extent.z) ? 1 : 2);
+  const int middle = (start + end) / 2;
+
+  std::nth_element(primitives.begin() + start,
+                   primitives.begin() + middle,
+                   primitives.begin() + end,
+                   [axis](const Primitive &a, const Primitive &b) {
+                     return a.centroid[axis] < b.centroid[axis];
+                   });
+
+  /* Left child directly follows its parent, the right one is stored explicitly. Note the node
+   * vector may be reallocated while building the children. */
+  build(primitives, start, middle, index);
+  const int right = build(primitives, middle, end, index);
+  nodes[index].child_index = right;
+
+  return index;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Binary hierarchy over emissive triangles, flattened in depth first order into the
+ * node and emitter arrays used by the kernel. Each node stores its bounds and the total
+ * energy of the emitters below it, which the kernel uses to estimate the contribution
+ * of a subtree at the shading point. */
+
+class LightTree {
+ public:
+  struct Primitive {
+    BoundBox bounds;
+    float3 centroid;
+    float energy;
+    int distribution_index;
+  };
+
+  LightTree(vector<Primitive> &primitives, int max_leaf_size = 4);
+
+  vector<KernelLightTreeNode> nodes;
+  vector<KernelLightTreeEmitter> emitters;
+
+ protected:
+  int build(vector<Primitive> &primitives, int start, int end, int parent);
+
+  int max_leaf_size;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
@@ -153,6 +153,7 @@ Mesh::Mesh() : Geometry(node_type, Geometry::MESH), subd_attributes(this, ATTR_P
 
   subdivision_type = SUBDIVISION_NONE;
   subd_params = NULL;
+  subd_cache = NULL;
 
   patch_table = NULL;
 }
@@ -161,6 +162,7 @@ Mesh::~Mesh()
 {
   delete patch_table;
   delete subd_params;
+  free_subd_cache();
 }
 
 void Mesh::resize_mesh(int numverts, int numtris)
@@ -214,6 +216,8 @@ void Mesh::reserve_subd_faces(int numfaces, int num_ngons_, int numcorners)
 
 void Mesh::clear(bool preserve_voxel_data)
 {
+  take_subd_cache_tessellation();
+
   Geometry::clear();
 
   /* clear all verts and triangles */
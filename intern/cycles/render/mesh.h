@@ -46,6 +46,7 @@ class Scene;
 class SceneParams;
 class AttributeRequest;
 struct SubdParams;
+struct SubdCache;
 class DiagSplit;
 struct PackedPatchTable;
 
@@ -159,12 +160,16 @@ class Mesh : public Geometry {
 
   size_t num_subd_verts;
 
+  /* Tessellation kept across syncs, reused when dicing inputs did not change. */
+  SubdCache *subd_cache;
+
  private:
   unordered_map<int, int> vert_to_stitching_key_map; /* real vert index -> stitching index */
   unordered_multimap<int, int>
       vert_stitching_map; /* stitching index -> multiple real vert indices */
   friend class DiagSplit;
   friend class GeometryManager;
+  friend struct SubdCache;
 
  public:
   /* Functions */
@@ -202,7 +207,10 @@ class Mesh : public Geometry {
                   size_t tri_offset);
   void pack_patches(uint *patch_data, uint vert_offset, uint face_offset, uint corner_offset);
 
-  void tessellate(DiagSplit *split);
+  void tessellate(DiagSplit *split, bool use_cache = false);
+  void free_subd_cache();
+  /* Move the tessellation kept in the mesh back into the cache, before clearing the mesh. */
+  void take_subd_cache_tessellation();
 };
 
 CCL_NAMESPACE_END
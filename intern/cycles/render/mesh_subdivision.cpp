@@ -366,14 +366,331 @@ struct OsdPatch : Patch {
 
 #endif
 
-void Mesh::tessellate(DiagSplit *split)
+/* Tessellation Cache
+ *
+ * Splitting and dicing evaluate the limit surface many times, so when persistent data is used
+ * the tessellated geometry is kept and reused on the next sync if the control mesh, the
+ * subdivision settings and the dicing camera are unchanged.
+ *
+ * The control mesh is compared by hash rather than keeping a copy of it. The tessellation stays
+ * in the mesh after dicing and is only taken back when the mesh is cleared for the next sync,
+ * except with displacement, which modifies it in place and so needs a copy. */
+
+class SubdCacheHash {
+ public:
+  SubdCacheHash() : hash(0xcbf29ce484222325ULL)
+  {
+  }
+
+  void add(uint value)
+  {
+    hash = (hash ^ value) * 0x100000001b3ULL;
+  }
+
+  void add(int value)
+  {
+    add((uint)value);
+  }
+
+  void add(float value)
+  {
+    add(__float_as_uint(value));
+  }
+
+  /* Component wise, float3 may contain padding. */
+  void add(float3 value)
+  {
+    add(value.x);
+    add(value.y);
+    add(value.z);
+  }
+
+  void add(size_t value)
+  {
+    add((uint)value);
+    add((uint)(value >> 32));
+  }
+
+  uint64_t hash;
+};
+
+static uint64_t subd_cache_control_hash(const Mesh *mesh)
+{
+  SubdCacheHash hash;
+
+  hash.add(mesh->verts.size());
+  for (size_t i = 0; i < mesh->verts.size(); i++) {
+    hash.add(mesh->verts[i]);
+  }
+
+  /* Field by field, the struct has padding. */
+  hash.add(mesh->subd_faces.size());
+  for (size_t i = 0; i < mesh->subd_faces.size(); i++) {
+    const Mesh::SubdFace &face = mesh->subd_faces[i];
+    hash.add(face.start_corner);
+    hash.add(face.num_corners);
+    hash.add(face.shader);
+    hash.add((int)face.smooth);
+    hash.add(face.ptex_offset);
+  }
+
+  hash.add(mesh->subd_face_corners.size());
+  for (size_t i = 0; i < mesh->subd_face_corners.size(); i++) {
+    hash.add(mesh->subd_face_corners[i]);
+  }
+
+  hash.add(mesh->subd_creases.size());
+  for (size_t i = 0; i < mesh->subd_creases.size(); i++) {
+    const Mesh::SubdEdgeCrease &crease = mesh->subd_creases[i];
+    hash.add(crease.v[0]);
+    hash.add(crease.v[1]);
+    hash.add(crease.crease);
+  }
+
+  const Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+  const size_t num_normals = (attr_vN) ? attr_vN->buffer.size() / sizeof(float3) : 0;
+  hash.add(num_normals);
+  for (size_t i = 0; i < num_normals; i++) {
+    hash.add(attr_vN->data_float3()[i]);
+  }
+
+  return hash.hash;
+}
+
+struct SubdCache {
+  /* Dicing inputs. */
+  Mesh::SubdivisionType subdivision_type;
+  uint64_t control_hash;
+
+  bool ptex;
+  int test_steps;
+  int split_threshold;
+  float dicing_rate;
+  int max_level;
+  Transform objecttoworld;
+
+  bool use_camera;
+  CameraType camera_type;
+  Transform cameratoworld;
+  ProjectionTransform full_rastertocamera;
+  int full_width, full_height;
+  float offscreen_dicing_scale;
+
+  /* Tessellated geometry, only valid once stored. While in_mesh is set the arrays are owned by
+   * the mesh and are taken back when it's cleared. */
+  bool stored;
+  bool in_mesh;
+  array<float3> verts;
+  array<float2> vert_patch_uv;
+  vector<char> vertex_normals;
+  array<int> triangles;
+  array<int> shader;
+  array<bool> smooth;
+  array<int> triangle_patch;
+  size_t num_subd_verts;
+  unordered_map<int, int> vert_to_stitching_key_map;
+  unordered_multimap<int, int> vert_stitching_map;
+
+  explicit SubdCache(const Mesh *mesh)
+  {
+    const SubdParams &params = *mesh->subd_params;
+
+    subdivision_type = mesh->subdivision_type;
+    control_hash = subd_cache_control_hash(mesh);
+
+    ptex = params.ptex;
+    test_steps = params.test_steps;
+    split_threshold = params.split_threshold;
+    dicing_rate = params.dicing_rate;
+    max_level = params.max_level;
+    objecttoworld = params.objecttoworld;
+
+    use_camera = (params.camera != NULL);
+    if (use_camera) {
+      const Camera *camera = params.camera;
+      camera_type = camera->type;
+      cameratoworld = camera->cameratoworld;
+      full_rastertocamera = camera->full_rastertocamera;
+      full_width = camera->full_width;
+      full_height = camera->full_height;
+      offscreen_dicing_scale = camera->offscreen_dicing_scale;
+    }
+
+    stored = false;
+    in_mesh = false;
+    num_subd_verts = 0;
+  }
+
+  bool matches(const Mesh *mesh) const
+  {
+    const SubdParams &params = *mesh->subd_params;
+
+    if (!stored || in_mesh) {
+      return false;
+    }
+
+    if (subdivision_type != mesh->subdivision_type) {
+      return false;
+    }
+
+    if (ptex != params.ptex || test_steps != params.test_steps ||
+        split_threshold != params.split_threshold || dicing_rate != params.dicing_rate ||
+        max_level != params.max_level ||
+        memcmp(&objecttoworld, &params.objecttoworld, sizeof(Transform)) != 0) {
+      return false;
+    }
+
+    if (use_camera != (params.camera != NULL)) {
+      return false;
+    }
+    if (use_camera) {
+      const Camera *camera = params.camera;
+      if (camera_type != camera->type || full_width != camera->full_width ||
+          full_height != camera->full_height ||
+          offscreen_dicing_scale != camera->offscreen_dicing_scale ||
+          memcmp(&cameratoworld, &camera->cameratoworld, sizeof(Transform)) != 0 ||
+          memcmp(&full_rastertocamera,
+                 &camera->full_rastertocamera,
+                 sizeof(ProjectionTransform)) != 0) {
+        return false;
+      }
+    }
+
+    /* Most expensive test last. */
+    return control_hash == subd_cache_control_hash(mesh);
+  }
+
+  void store(const Mesh *mesh)
+  {
+    stored = true;
+
+    if (!mesh->has_true_displacement()) {
+      in_mesh = true;
+      return;
+    }
+
+    verts = mesh->verts;
+    vert_patch_uv = mesh->vert_patch_uv;
+    triangles = mesh->triangles;
+    shader = mesh->shader;
+    smooth = mesh->smooth;
+    triangle_patch = mesh->triangle_patch;
+    num_subd_verts = mesh->num_subd_verts;
+    vert_to_stitching_key_map = mesh->vert_to_stitching_key_map;
+    vert_stitching_map = mesh->vert_stitching_map;
+
+    const Attribute *attr_vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL);
+    if (attr_vN) {
+      vertex_normals = attr_vN->buffer;
+    }
+  }
+
+  /* Take back the tessellation from the mesh, before it is cleared. */
+  void take(Mesh *mesh)
+  {
+    verts.steal_data(mesh->verts);
+    vert_patch_uv.steal_data(mesh->vert_patch_uv);
+    triangles.steal_data(mesh->triangles);
+    shader.steal_data(mesh->shader);
+    smooth.steal_data(mesh->smooth);
+    triangle_patch.steal_data(mesh->triangle_patch);
+    num_subd_verts = mesh->num_subd_verts;
+    vert_to_stitching_key_map.swap(mesh->vert_to_stitching_key_map);
+    vert_stitching_map.swap(mesh->vert_stitching_map);
+
+    Attribute *attr_vN = mesh->attributes.find(ATTR_STD_VERTEX_NORMAL);
+    vertex_normals.clear();
+    if (attr_vN) {
+      vertex_normals.swap(attr_vN->buffer);
+    }
+
+    in_mesh = false;
+  }
+
+  void restore(Mesh *mesh)
+  {
+    /* Displacement modifies the tessellation, so it gets a copy. */
+    const bool copy = mesh->has_true_displacement();
+
+    if (copy) {
+      mesh->verts = verts;
+      mesh->vert_patch_uv = vert_patch_uv;
+      mesh->triangles = triangles;
+      mesh->shader = shader;
+      mesh->smooth = smooth;
+      mesh->triangle_patch = triangle_patch;
+      mesh->vert_to_stitching_key_map = vert_to_stitching_key_map;
+      mesh->vert_stitching_map = vert_stitching_map;
+    }
+    else {
+      mesh->verts.steal_data(verts);
+      mesh->vert_patch_uv.steal_data(vert_patch_uv);
+      mesh->triangles.steal_data(triangles);
+      mesh->shader.steal_data(shader);
+      mesh->smooth.steal_data(smooth);
+      mesh->triangle_patch.steal_data(triangle_patch);
+      mesh->vert_to_stitching_key_map.swap(vert_to_stitching_key_map);
+      mesh->vert_stitching_map.swap(vert_stitching_map);
+      vert_to_stitching_key_map.clear();
+      vert_stitching_map.clear();
+    }
+    mesh->num_subd_verts = num_subd_verts;
+
+    /* Same attributes as added by EdgeDice. */
+    Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+    if (ptex) {
+      mesh->attributes.add(ATTR_STD_PTEX_UV);
+      mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
+    }
+    mesh->attributes.resize();
+
+    if (copy) {
+      attr_vN->buffer = vertex_normals;
+    }
+    else {
+      attr_vN->buffer.swap(vertex_normals);
+      vertex_normals.clear();
+      in_mesh = true;
+    }
+  }
+};
+
+void Mesh::free_subd_cache()
+{
+  delete subd_cache;
+  subd_cache = NULL;
+}
+
+void Mesh::take_subd_cache_tessellation()
 {
+  if (subd_cache && subd_cache->in_mesh) {
+    subd_cache->take(this);
+  }
+}
+
+void Mesh::tessellate(DiagSplit *split, bool use_cache)
+{
+  /* Reuse the tessellation from the previous sync if none of its inputs changed. */
+  const bool use_cached = use_cache && subd_cache && subd_cache->matches(this);
+  if (!use_cached) {
+    free_subd_cache();
+    if (use_cache) {
+      subd_cache = new SubdCache(this);
+    }
+  }
+
 #ifdef WITH_OPENSUBDIV
   OsdData osd_data;
   bool need_packed_patch_table = false;
 
   if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-    if (subd_faces.size()) {
+    /* With a cached tessellation, OpenSubdiv is only needed to subdivide attributes. */
+    bool need_osd_data = !use_cached;
+    foreach (Attribute &attr, subd_attributes.attributes) {
+      need_osd_data |= (attr.flags & ATTR_SUBDIVIDED) != 0;
+    }
+
+    if (subd_faces.size() && need_osd_data) {
       osd_data.build_from_mesh(this);
     }
   }
@@ -393,130 +710,78 @@ void Mesh::tessellate(DiagSplit *split)
 
   int num_faces = subd_faces.size();
 
-  Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
-  float3 *vN = (attr_vN) ? attr_vN->data_float3() : NULL;
-
-  /* count patches */
-  int num_patches = 0;
-  for (int f = 0; f < num_faces; f++) {
-    SubdFace &face = subd_faces[f];
-
-    if (face.is_quad()) {
-      num_patches++;
-    }
-    else {
-      num_patches += face.num_corners;
-    }
+  if (use_cached) {
+    subd_cache->restore(this);
   }
+  else {
+    Attribute *attr_vN = subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+    float3 *vN = (attr_vN) ? attr_vN->data_float3() : NULL;
 
-  /* build patches from faces */
-#ifdef WITH_OPENSUBDIV
-  if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
-    vector<OsdPatch> osd_patches(num_patches, &osd_data);
-    OsdPatch *patch = osd_patches.data();
-
+    /* count patches */
+    int num_patches = 0;
     for (int f = 0; f < num_faces; f++) {
       SubdFace &face = subd_faces[f];
 
       if (face.is_quad()) {
-        patch->patch_index = face.ptex_offset;
-        patch->from_ngon = false;
-        patch->shader = face.shader;
-        patch++;
+        num_patches++;
       }
       else {
-        for (int corner = 0; corner < face.num_corners; corner++) {
-          patch->patch_index = face.ptex_offset + corner;
-          patch->from_ngon = true;
-          patch->shader = face.shader;
-          patch++;
-        }
+        num_patches += face.num_corners;
       }
     }
 
-    /* split patches */
-    split->split_patches(osd_patches.data(), sizeof(OsdPatch));
-  }
-  else
-#endif
-  {
-    vector<LinearQuadPatch> linear_patches(num_patches);
-    LinearQuadPatch *patch = linear_patches.data();
-
-    for (int f = 0; f < num_faces; f++) {
-      SubdFace &face = subd_faces[f];
-
-      if (face.is_quad()) {
-        float3 *hull = patch->hull;
-        float3 *normals = patch->normals;
-
-        patch->patch_index = face.ptex_offset;
-        patch->from_ngon = false;
+    /* build patches from faces */
+#ifdef WITH_OPENSUBDIV
+    if (subdivision_type == SUBDIVISION_CATMULL_CLARK) {
+      vector<OsdPatch> osd_patches(num_patches, &osd_data);
+      OsdPatch *patch = osd_patches.data();
 
-        for (int i = 0; i < 4; i++) {
-          hull[i] = verts[subd_face_corners[face.start_corner + i]];
-        }
+      for (int f = 0; f < num_faces; f++) {
+        SubdFace &face = subd_faces[f];
 
-        if (face.smooth) {
-          for (int i = 0; i < 4; i++) {
-            normals[i] = vN[subd_face_corners[face.start_corner + i]];
-          }
+        if (face.is_quad()) {
+          patch->patch_index = face.ptex_offset;
+          patch->from_ngon = false;
+          patch->shader = face.shader;
+          patch++;
         }
         else {
-          float3 N = face.normal(this);
-          for (int i = 0; i < 4; i++) {
-            normals[i] = N;
+          for (int corner = 0; corner < face.num_corners; corner++) {
+            patch->patch_index = face.ptex_offset + corner;
+            patch->from_ngon = true;
+            patch->shader = face.shader;
+            patch++;
           }
         }
+      }
 
-        swap(hull[2], hull[3]);
-        swap(normals[2], normals[3]);
+      /* split patches */
+      split->split_patches(osd_patches.data(), sizeof(OsdPatch));
+    }
+    else
+#endif
+    {
+      vector<LinearQuadPatch> linear_patches(num_patches);
+      LinearQuadPatch *patch = linear_patches.data();
 
-        patch->shader = face.shader;
-        patch++;
-      }
-      else {
-        /* ngon */
-        float3 center_vert = make_float3(0.0f, 0.0f, 0.0f);
-        float3 center_normal = make_float3(0.0f, 0.0f, 0.0f);
-
-        float inv_num_corners = 1.0f / float(face.num_corners);
-        for (int corner = 0; corner < face.num_corners; corner++) {
-          center_vert += verts[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
-          center_normal += vN[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
-        }
+      for (int f = 0; f < num_faces; f++) {
+        SubdFace &face = subd_faces[f];
 
-        for (int corner = 0; corner < face.num_corners; corner++) {
+        if (face.is_quad()) {
           float3 *hull = patch->hull;
           float3 *normals = patch->normals;
 
-          patch->patch_index = face.ptex_offset + corner;
-          patch->from_ngon = true;
-
-          patch->shader = face.shader;
-
-          hull[0] =
-              verts[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-          hull[1] =
-              verts[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-          hull[2] =
-              verts[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
-          hull[3] = center_vert;
+          patch->patch_index = face.ptex_offset;
+          patch->from_ngon = false;
 
-          hull[1] = (hull[1] + hull[0]) * 0.5;
-          hull[2] = (hull[2] + hull[0]) * 0.5;
+          for (int i = 0; i < 4; i++) {
+            hull[i] = verts[subd_face_corners[face.start_corner + i]];
+          }
 
           if (face.smooth) {
-            normals[0] =
-                vN[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
-            normals[1] =
-                vN[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
-            normals[2] =
-                vN[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
-            normals[3] = center_normal;
-
-            normals[1] = (normals[1] + normals[0]) * 0.5;
-            normals[2] = (normals[2] + normals[0]) * 0.5;
+            for (int i = 0; i < 4; i++) {
+              normals[i] = vN[subd_face_corners[face.start_corner + i]];
+            }
           }
           else {
             float3 N = face.normal(this);
@@ -525,13 +790,74 @@ void Mesh::tessellate(DiagSplit *split)
             }
           }
 
+          swap(hull[2], hull[3]);
+          swap(normals[2], normals[3]);
+
+          patch->shader = face.shader;
           patch++;
         }
+        else {
+          /* ngon */
+          float3 center_vert = make_float3(0.0f, 0.0f, 0.0f);
+          float3 center_normal = make_float3(0.0f, 0.0f, 0.0f);
+
+          float inv_num_corners = 1.0f / float(face.num_corners);
+          for (int corner = 0; corner < face.num_corners; corner++) {
+            center_vert += verts[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+            center_normal += vN[subd_face_corners[face.start_corner + corner]] * inv_num_corners;
+          }
+
+          for (int corner = 0; corner < face.num_corners; corner++) {
+            float3 *hull = patch->hull;
+            float3 *normals = patch->normals;
+
+            patch->patch_index = face.ptex_offset + corner;
+            patch->from_ngon = true;
+
+            patch->shader = face.shader;
+
+            hull[0] =
+                verts[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+            hull[1] =
+                verts[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+            hull[2] =
+                verts[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+            hull[3] = center_vert;
+
+            hull[1] = (hull[1] + hull[0]) * 0.5;
+            hull[2] = (hull[2] + hull[0]) * 0.5;
+
+            if (face.smooth) {
+              normals[0] =
+                  vN[subd_face_corners[face.start_corner + mod(corner + 0, face.num_corners)]];
+              normals[1] =
+                  vN[subd_face_corners[face.start_corner + mod(corner + 1, face.num_corners)]];
+              normals[2] =
+                  vN[subd_face_corners[face.start_corner + mod(corner - 1, face.num_corners)]];
+              normals[3] = center_normal;
+
+              normals[1] = (normals[1] + normals[0]) * 0.5;
+              normals[2] = (normals[2] + normals[0]) * 0.5;
+            }
+            else {
+              float3 N = face.normal(this);
+              for (int i = 0; i < 4; i++) {
+                normals[i] = N;
+              }
+            }
+
+            patch++;
+          }
+        }
       }
+
+      /* split patches */
+      split->split_patches(linear_patches.data(), sizeof(LinearQuadPatch));
     }
 
-    /* split patches */
-    split->split_patches(linear_patches.data(), sizeof(LinearQuadPatch));
+    if (subd_cache) {
+      subd_cache->store(this);
+    }
   }
 
   /* interpolate center points for attributes */
@@ -405,28 +405,76 @@ static openvdb::GridBase::ConstPtr openvdb_grid_from_device_texture(device_textu
 {
   using ValueType = typename GridType::ValueType;
 
-  openvdb::CoordBBox dense_bbox(0,
-                                0,
-                                0,
-                                image_memory->data_width - 1,
-                                image_memory->data_height - 1,
-                                image_memory->data_depth - 1);
-  openvdb::tools::Dense<ValueType, openvdb::tools::MemoryLayout::LayoutXYZ> dense(
-      dense_bbox, static_cast<ValueType *>(image_memory->host_pointer));
-
+  const int width = image_memory->info.width;
+  const int height = image_memory->info.height;
+  const int depth = image_memory->info.depth;
   typename GridType::Ptr sparse = GridType::create(ValueType(0.0f));
-  openvdb::tools::copyFromDense(dense, *sparse, ValueType(volume_clipping));
 
-  /* copyFromDense will remove any leaf node that contains constant data and replace it with a
-   * tile, however, we need to preserve the leaves in order to generate the mesh, so revoxelize the
-   * leaves that were pruned. This should not affect areas that were skipped due to the
-   * volume_clipping parameter. */
-  sparse->tree().voxelizeActiveTiles();
+  if (image_memory->info.use_sparse) {
+    /* Only visit leaves stored in the sparse texture, see util_texture.h for the layout. */
+    const uint *index = static_cast<const uint *>(image_memory->host_pointer);
+    const uint *nodes = index + index[0];
+    const ValueType *leaves = reinterpret_cast<const ValueType *>(index + index[1]);
+    const ValueType background(0.0f);
+    const ValueType tolerance(volume_clipping);
+    const int grid_width = divide_up(width, TEX_SPARSE_NODE_DIM);
+    const int grid_height = divide_up(height, TEX_SPARSE_NODE_DIM);
+    const int grid_depth = divide_up(depth, TEX_SPARSE_NODE_DIM);
+    typename GridType::Accessor accessor = sparse->getAccessor();
+
+    for (int n = 0; n < grid_width * grid_height * grid_depth; n++) {
+      const uint node = index[TEX_SPARSE_HEADER_SIZE + n];
+      if (node == 0) {
+        continue;
+      }
+      const openvdb::Coord node_min(TEX_SPARSE_NODE_DIM * (n % grid_width),
+                                    TEX_SPARSE_NODE_DIM * ((n / grid_width) % grid_height),
+                                    TEX_SPARSE_NODE_DIM * (n / (grid_width * grid_height)));
+
+      for (int l = 0; l < TEX_SPARSE_NODE_LEAVES; l++) {
+        const uint leaf = nodes[node * TEX_SPARSE_NODE_LEAVES + l];
+        if (leaf == 0) {
+          continue;
+        }
+        const openvdb::Coord leaf_min =
+            node_min + openvdb::Coord(TEX_SPARSE_LEAF_SIZE * (l % TEX_SPARSE_NODE_SIZE),
+                                      TEX_SPARSE_LEAF_SIZE * ((l / TEX_SPARSE_NODE_SIZE) %
+                                                              TEX_SPARSE_NODE_SIZE),
+                                      TEX_SPARSE_LEAF_SIZE *
+                                          (l / (TEX_SPARSE_NODE_SIZE * TEX_SPARSE_NODE_SIZE)));
+        const ValueType *voxels = leaves + (size_t)leaf * TEX_SPARSE_LEAF_VOXELS;
+
+        for (int v = 0; v < TEX_SPARSE_LEAF_VOXELS; v++) {
+          const openvdb::Coord coord =
+              leaf_min + openvdb::Coord(v % TEX_SPARSE_LEAF_SIZE,
+                                        (v / TEX_SPARSE_LEAF_SIZE) % TEX_SPARSE_LEAF_SIZE,
+                                        v / (TEX_SPARSE_LEAF_SIZE * TEX_SPARSE_LEAF_SIZE));
+          if (coord.x() >= width || coord.y() >= height || coord.z() >= depth) {
+            continue;
+          }
+          if (!openvdb::math::isApproxEqual(voxels[v], background, tolerance)) {
+            accessor.setValue(coord, voxels[v]);
+          }
+        }
+      }
+    }
+  }
+  else {
+    openvdb::CoordBBox dense_bbox(0, 0, 0, width - 1, height - 1, depth - 1);
+    openvdb::tools::Dense<ValueType, openvdb::tools::MemoryLayout::LayoutXYZ> dense(
+        dense_bbox, static_cast<ValueType *>(image_memory->host_pointer));
+
+    openvdb::tools::copyFromDense(dense, *sparse, ValueType(volume_clipping));
+
+    /* copyFromDense will remove any leaf node that contains constant data and replace it with a
+     * tile, however, we need to preserve the leaves in order to generate the mesh, so revoxelize
+     * the leaves that were pruned. This should not affect areas that were skipped due to the
+     * volume_clipping parameter. */
+    sparse->tree().voxelizeActiveTiles();
+  }
 
   /* Compute index to world matrix. */
-  float3 voxel_size = make_float3(1.0f / image_memory->data_width,
-                                  1.0f / image_memory->data_height,
-                                  1.0f / image_memory->data_depth);
+  float3 voxel_size = make_float3(1.0f / width, 1.0f / height, 1.0f / depth);
 
   transform_3d = transform_inverse(transform_3d);
 
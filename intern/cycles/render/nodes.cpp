@@ -248,6 +248,11 @@ NODE_DEFINE(ImageTextureNode)
   SOCKET_FLOAT(projection_blend, "Projection Blend", 0.0f);
 
   SOCKET_IN_POINT(vector, "Vector", make_float3(0.0f, 0.0f, 0.0f), SocketType::LINK_TEXTURE_UV);
+  /* Texture coordinates shifted by the ray differentials, for picking the mip level. */
+  SOCKET_IN_POINT(
+      vector_dx, "VectorDx", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+  SOCKET_IN_POINT(
+      vector_dy, "VectorDy", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
 
   SOCKET_OUT_COLOR(color, "Color");
   SOCKET_OUT_FLOAT(alpha, "Alpha");
@@ -359,6 +364,8 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 void ImageTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
+  ShaderInput *vector_dx_in = input("VectorDx");
+  ShaderInput *vector_dy_in = input("VectorDy");
   ShaderOutput *color_out = output("Color");
   ShaderOutput *alpha_out = output("Alpha");
 
@@ -376,6 +383,16 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
   int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
   uint flags = 0;
 
+  /* Texture coordinates shifted by the ray differentials, for picking the mip level. */
+  const bool use_differentials = (vector_dx_in->link && vector_dy_in->link);
+  int vector_dx_offset = SVM_STACK_INVALID;
+  int vector_dy_offset = SVM_STACK_INVALID;
+  if (use_differentials) {
+    vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+    vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+    flags |= NODE_IMAGE_DIFFERENTIALS;
+  }
+
   if (compress_as_srgb) {
     flags |= NODE_IMAGE_COMPRESS_AS_SRGB;
   }
@@ -406,6 +423,9 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                                              compiler.stack_assign_if_linked(alpha_out),
                                              flags),
                       projection);
+    if (use_differentials) {
+      compiler.add_node(vector_dx_offset, vector_dy_offset, 0, 0);
+    }
 
     if (num_nodes > 0) {
       for (int i = 0; i < num_nodes; i++) {
@@ -433,8 +453,15 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                                              compiler.stack_assign_if_linked(alpha_out),
                                              flags),
                       __float_as_int(projection_blend));
+    if (use_differentials) {
+      compiler.add_node(vector_dx_offset, vector_dy_offset, 0, 0);
+    }
   }
 
+  if (use_differentials) {
+    tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+    tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+  }
   tex_mapping.compile_end(compiler, vector_in, vector_offset);
 }
 
@@ -512,6 +539,10 @@ NODE_DEFINE(EnvironmentTextureNode)
   SOCKET_ENUM(projection, "Projection", projection_enum, NODE_ENVIRONMENT_EQUIRECTANGULAR);
 
   SOCKET_IN_POINT(vector, "Vector", make_float3(0.0f, 0.0f, 0.0f), SocketType::LINK_POSITION);
+  SOCKET_IN_POINT(
+      vector_dx, "VectorDx", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+  SOCKET_IN_POINT(
+      vector_dy, "VectorDy", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
 
   SOCKET_OUT_COLOR(color, "Color");
   SOCKET_OUT_FLOAT(alpha, "Alpha");
@@ -559,6 +590,8 @@ void EnvironmentTextureNode::attributes(Shader *shader, AttributeRequestSet *att
 void EnvironmentTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
+  ShaderInput *vector_dx_in = input("VectorDx");
+  ShaderInput *vector_dy_in = input("VectorDy");
   ShaderOutput *color_out = output("Color");
   ShaderOutput *alpha_out = output("Alpha");
 
@@ -574,6 +607,16 @@ void EnvironmentTextureNode::compile(SVMCompiler &compiler)
   int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
   uint flags = 0;
 
+  /* Texture coordinates shifted by the ray differentials, for picking the mip level. */
+  const bool use_differentials = (vector_dx_in->link && vector_dy_in->link);
+  int vector_dx_offset = SVM_STACK_INVALID;
+  int vector_dy_offset = SVM_STACK_INVALID;
+  if (use_differentials) {
+    vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+    vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+    flags |= NODE_IMAGE_DIFFERENTIALS;
+  }
+
   if (compress_as_srgb) {
     flags |= NODE_IMAGE_COMPRESS_AS_SRGB;
   }
@@ -585,6 +628,11 @@ void EnvironmentTextureNode::compile(SVMCompiler &compiler)
                                            compiler.stack_assign_if_linked(alpha_out),
                                            flags),
                     projection);
+  if (use_differentials) {
+    compiler.add_node(vector_dx_offset, vector_dy_offset, 0, 0);
+    tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+    tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+  }
 
   tex_mapping.compile_end(compiler, vector_in, vector_offset);
 }
@@ -117,6 +117,7 @@ class ImageTextureNode : public ImageSlotTextureNode {
   float projection_blend;
   bool animated;
   float3 vector;
+  float3 vector_dx, vector_dy;
   ccl::vector<int> tiles;
 
  protected:
@@ -153,6 +154,7 @@ class EnvironmentTextureNode : public ImageSlotTextureNode {
   InterpolationType interpolation;
   bool animated;
   float3 vector;
+  float3 vector_dx, vector_dy;
 };
 
 class SkyTextureNode : public TextureNode {
@@ -207,6 +207,7 @@ string MeshStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Geometry:\n" + geometry.full_report(indent_level + 1);
+  result += indent + "BVH:\n" + bvh.full_report(indent_level + 1);
   return result;
 }
 
@@ -224,6 +225,46 @@ string ImageStats::full_report(int indent_level)
   return result;
 }
 
+/* Memory statistics. */
+
+MemoryStats::MemoryStats() : mem_used(0), mem_peak(0)
+{
+  for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+    category_mem_used[i] = 0;
+    category_mem_peak[i] = 0;
+  }
+}
+
+void MemoryStats::collect(const Stats &stats)
+{
+  mem_used = stats.mem_used;
+  mem_peak = stats.mem_peak;
+
+  for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+    category_mem_used[i] = stats.category_mem_used[i];
+    category_mem_peak[i] = stats.category_mem_peak[i];
+  }
+}
+
+string MemoryStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string double_indent = indent + indent;
+  string result = "";
+  result += string_printf("%sTotal memory: %s (peak %s)\n",
+                          indent.c_str(),
+                          string_human_readable_size(mem_used).c_str(),
+                          string_human_readable_size(mem_peak).c_str());
+  for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+    result += string_printf("%s%-32s %s (peak %s)\n",
+                            double_indent.c_str(),
+                            memory_category_name((MemoryCategory)i),
+                            string_human_readable_size(category_mem_used[i]).c_str(),
+                            string_human_readable_size(category_mem_peak[i]).c_str());
+  }
+  return result;
+}
+
 /* Overall statistics. */
 
 RenderStats::RenderStats()
@@ -306,6 +347,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "Memory statistics:\n" + memory.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
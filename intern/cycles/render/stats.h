@@ -122,6 +122,9 @@ class MeshStats {
    * memory like BVH.
    */
   NamedSizeStats geometry;
+
+  /* Packed BVH memory per geometry, and of the top level BVH. */
+  NamedSizeStats bvh;
 };
 
 /* Statistics about images held in memory. */
@@ -135,6 +138,24 @@ class ImageStats {
   NamedSizeStats textures;
 };
 
+/* Statistics about device memory, current and peak usage broken down per category. */
+class MemoryStats {
+ public:
+  MemoryStats();
+
+  /* Copy memory usage from the device statistics. */
+  void collect(const Stats &stats);
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  size_t mem_used;
+  size_t mem_peak;
+
+  size_t category_mem_used[MEM_NUM_CATEGORIES];
+  size_t category_mem_peak[MEM_NUM_CATEGORIES];
+};
+
 /* Render process statistics. */
 class RenderStats {
  public:
@@ -150,6 +171,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  MemoryStats memory;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
@@ -45,8 +45,8 @@ void EdgeDice::reserve(int num_verts, int num_triangles)
   vert_offset = mesh->verts.size();
   tri_offset = mesh->num_triangles();
 
-  mesh->resize_mesh(mesh->verts.size() + num_verts, mesh->num_triangles());
-  mesh->reserve_mesh(mesh->verts.size() + num_verts, mesh->num_triangles() + num_triangles);
+  /* Triangles are written at known offsets, so subpatches can be diced in parallel. */
+  mesh->resize_mesh(mesh->verts.size() + num_verts, mesh->num_triangles() + num_triangles);
 
   Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
 
@@ -73,8 +73,14 @@ void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
 {
   Mesh *mesh = params.mesh;
 
-  mesh->add_triangle(v0 + vert_offset, v1 + vert_offset, v2 + vert_offset, patch->shader, true);
-  params.mesh->triangle_patch[params.mesh->num_triangles() - 1] = patch->patch_index;
+  assert(tri_offset < mesh->num_triangles());
+
+  mesh->triangles[tri_offset * 3 + 0] = v0 + vert_offset;
+  mesh->triangles[tri_offset * 3 + 1] = v1 + vert_offset;
+  mesh->triangles[tri_offset * 3 + 2] = v2 + vert_offset;
+  mesh->shader[tri_offset] = patch->shader;
+  mesh->smooth[tri_offset] = true;
+  mesh->triangle_patch[tri_offset] = patch->patch_index;
 
   tri_offset++;
 }
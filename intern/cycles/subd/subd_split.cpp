@@ -25,6 +25,7 @@
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
 #include "util/util_math.h"
+#include "util/util_task.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -337,11 +338,14 @@ Edge *DiagSplit::alloc_edge()
   return &edges.back();
 }
 
-void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
+void DiagSplit::split_faces(
+    Patch *patches, size_t patches_byte_stride, int face_begin, int face_end, int patch_begin)
 {
-  int patch_index = 0;
+  /* Every patch allocates 4 verts, so the first vertex index follows from the patch index. */
+  int patch_index = patch_begin;
+  num_alloced_verts = patch_begin * 4;
 
-  for (int f = 0; f < params.mesh->subd_faces.size(); f++) {
+  for (int f = face_begin; f < face_end; f++) {
     Mesh::SubdFace &face = params.mesh->subd_faces[f];
 
     Patch *patch = (Patch *)(((char *)patches) + patch_index * patches_byte_stride);
@@ -357,6 +361,46 @@ void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
       split_ngon(face, patch, patches_byte_stride);
     }
   }
+}
+
+void DiagSplit::split_patches(Patch *patches, size_t patches_byte_stride)
+{
+  /* Split ranges of faces in parallel. Each patch allocates 4 verts and its own edges before
+   * post_split(), so faces are independent and vertex indices only depend on the patch index.
+   * Results are gathered in face order, giving the same tessellation as splitting serially. */
+  const int num_faces = params.mesh->subd_faces.size();
+  const int faces_per_task = 256;
+  const int num_tasks = divide_up(num_faces, faces_per_task);
+
+  vector<DiagSplit> tasks(num_tasks, DiagSplit(params));
+  TaskPool pool;
+  int patch_index = 0;
+
+  for (int i = 0; i < num_tasks; i++) {
+    const int face_begin = i * faces_per_task;
+    const int face_end = min(face_begin + faces_per_task, num_faces);
+
+    pool.push(function_bind(&DiagSplit::split_faces,
+                            &tasks[i],
+                            patches,
+                            patches_byte_stride,
+                            face_begin,
+                            face_end,
+                            patch_index));
+
+    for (int f = face_begin; f < face_end; f++) {
+      patch_index += params.mesh->subd_faces[f].num_ptex_faces();
+    }
+  }
+
+  pool.wait_work();
+
+  split_edges.reserve(split_edges.size() + num_tasks);
+  foreach (DiagSplit &task, tasks) {
+    subpatches.insert(subpatches.end(), task.subpatches.begin(), task.subpatches.end());
+    split_edges.push_back(std::move(task.edges));
+  }
+  num_alloced_verts = patch_index * 4;
 
   params.mesh->vert_to_stitching_key_map.clear();
   params.mesh->vert_stitching_map.clear();
@@ -606,8 +650,18 @@ void DiagSplit::post_split()
   int num_stitch_verts = 0;
 
   /* All patches are now split, and all T values known. */
-
+  vector<Edge *> all_edges;
   foreach (Edge &edge, edges) {
+    all_edges.push_back(&edge);
+  }
+  foreach (deque<Edge> &task_edges, split_edges) {
+    foreach (Edge &edge, task_edges) {
+      all_edges.push_back(&edge);
+    }
+  }
+
+  foreach (Edge *edge_ptr, all_edges) {
+    Edge &edge = *edge_ptr;
     if (edge.second_vert_index < 0) {
       edge.second_vert_index = alloc_verts(edge.T - 1);
     }
@@ -630,7 +684,8 @@ void DiagSplit::post_split()
   typedef unordered_map<pair<int, int>, int, pair_hasher> edge_stitch_verts_map_t;
   edge_stitch_verts_map_t edge_stitch_verts_map;
 
-  foreach (Edge &edge, edges) {
+  foreach (Edge *edge_ptr, all_edges) {
+    Edge &edge = *edge_ptr;
     if (edge.is_stitch_edge) {
       if (edge.stitch_edge_T == 0) {
         edge.stitch_edge_T = edge.T;
@@ -644,7 +699,8 @@ void DiagSplit::post_split()
   }
 
   /* Set start and end indices for edges generated from a split. */
-  foreach (Edge &edge, edges) {
+  foreach (Edge *edge_ptr, all_edges) {
+    Edge &edge = *edge_ptr;
     if (edge.start_vert_index < 0) {
       /* Fixup offsets. */
       if (edge.top_indices_decrease) {
@@ -666,7 +722,8 @@ void DiagSplit::post_split()
   int vert_offset = params.mesh->verts.size();
 
   /* Add verts to stitching map. */
-  foreach (const Edge &edge, edges) {
+  foreach (const Edge *edge_ptr, all_edges) {
+    const Edge &edge = *edge_ptr;
     if (edge.is_stitch_edge) {
       int second_stitch_vert_index = edge_stitch_verts_map[edge.stitch_edge_key];
 
@@ -721,15 +778,51 @@ void DiagSplit::post_split()
   int num_verts = num_alloced_verts;
   int num_triangles = 0;
 
+  /* Subpatches of the same patch share edges, so dice them together in one task. Vertex and
+   * triangle offsets are assigned up front so the result does not depend on task order. */
+  vector<size_t> task_begin;
+  vector<size_t> task_tri_offset;
+
   for (size_t i = 0; i < subpatches.size(); i++) {
+    if (i == 0 || subpatches[i].patch != subpatches[i - 1].patch) {
+      task_begin.push_back(i);
+      task_tri_offset.push_back(num_triangles);
+    }
+
     subpatches[i].inner_grid_vert_offset = num_verts;
     num_verts += subpatches[i].calc_num_inner_verts();
     num_triangles += subpatches[i].calc_num_triangles();
   }
+  task_begin.push_back(subpatches.size());
 
   dice.reserve(num_verts, num_triangles);
 
-  for (size_t i = 0; i < subpatches.size(); i++) {
+  TaskPool pool;
+  for (size_t i = 0; i + 1 < task_begin.size(); i++) {
+    pool.push(function_bind(&DiagSplit::dice_subpatches,
+                            this,
+                            &dice,
+                            task_begin[i],
+                            task_begin[i + 1],
+                            dice.tri_offset + task_tri_offset[i]));
+  }
+  pool.wait_work();
+
+  /* Cleanup */
+  subpatches.clear();
+  edges.clear();
+  split_edges.clear();
+}
+
+void DiagSplit::dice_subpatches(const QuadDice *dice,
+                                size_t sub_begin,
+                                size_t sub_end,
+                                size_t tri_offset)
+{
+  QuadDice task_dice(*dice);
+  task_dice.tri_offset = tri_offset;
+
+  for (size_t i = sub_begin; i < sub_end; i++) {
     Subpatch &sub = subpatches[i];
 
     sub.edge_u0.T = max(sub.edge_u0.T, 1);
@@ -737,12 +830,8 @@ void DiagSplit::post_split()
     sub.edge_v0.T = max(sub.edge_v0.T, 1);
     sub.edge_v1.T = max(sub.edge_v1.T, 1);
 
-    dice.dice(sub);
+    task_dice.dice(sub);
   }
-
-  /* Cleanup */
-  subpatches.clear();
-  edges.clear();
 }
 
 CCL_NAMESPACE_END
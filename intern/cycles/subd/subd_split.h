@@ -42,6 +42,8 @@ class DiagSplit {
   vector<Subpatch> subpatches;
   /* deque is used so that element pointers remain vaild when size is changed. */
   deque<Edge> edges;
+  /* Edges of faces split in parallel, kept in their own deques so pointers remain valid. */
+  vector<deque<Edge>> split_edges;
 
   float3 to_world(Patch *patch, float2 uv);
   int T(Patch *patch, float2 Pstart, float2 Pend, bool recursive_resolve = false);
@@ -53,6 +55,12 @@ class DiagSplit {
       Patch *patch, float2 *P, int *t0, int *t1, float2 Pstart, float2 Pend, int t);
 
   void split(Subpatch &sub, int depth = 0);
+  void split_faces(Patch *patches,
+                   size_t patches_byte_stride,
+                   int face_begin,
+                   int face_end,
+                   int patch_begin);
+  void dice_subpatches(const QuadDice *dice, size_t sub_begin, size_t sub_end, size_t tri_offset);
 
   int num_alloced_verts = 0;
   int alloc_verts(int n); /* Returns start index of new verts. */
@@ -22,31 +22,86 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Categories of memory usage, to break down where memory goes. */
+typedef enum MemoryCategory {
+  MEM_CATEGORY_BVH = 0,
+  MEM_CATEGORY_GEOMETRY,
+  MEM_CATEGORY_ATTRIBUTES,
+  MEM_CATEGORY_IMAGES,
+  MEM_CATEGORY_LIGHTS,
+  MEM_CATEGORY_SHADERS,
+  MEM_CATEGORY_RENDER_BUFFERS,
+  MEM_CATEGORY_DENOISING,
+  MEM_CATEGORY_OTHER,
+
+  MEM_NUM_CATEGORIES,
+} MemoryCategory;
+
+inline const char *memory_category_name(MemoryCategory category)
+{
+  switch (category) {
+    case MEM_CATEGORY_BVH:
+      return "BVH";
+    case MEM_CATEGORY_GEOMETRY:
+      return "Geometry";
+    case MEM_CATEGORY_ATTRIBUTES:
+      return "Attributes";
+    case MEM_CATEGORY_IMAGES:
+      return "Images";
+    case MEM_CATEGORY_LIGHTS:
+      return "Lights";
+    case MEM_CATEGORY_SHADERS:
+      return "Shaders";
+    case MEM_CATEGORY_RENDER_BUFFERS:
+      return "Render Buffers";
+    case MEM_CATEGORY_DENOISING:
+      return "Denoising";
+    case MEM_CATEGORY_OTHER:
+    case MEM_NUM_CATEGORIES:
+      break;
+  }
+  return "Other";
+}
+
 class Stats {
  public:
   enum static_init_t { static_init = 0 };
 
   Stats() : mem_used(0), mem_peak(0)
   {
+    for (int i = 0; i < MEM_NUM_CATEGORIES; i++) {
+      category_mem_used[i] = 0;
+      category_mem_peak[i] = 0;
+    }
   }
   explicit Stats(static_init_t)
   {
   }
 
-  void mem_alloc(size_t size)
+  void mem_alloc(size_t size, MemoryCategory category = MEM_CATEGORY_OTHER)
   {
     atomic_add_and_fetch_z(&mem_used, size);
     atomic_fetch_and_update_max_z(&mem_peak, mem_used);
+
+    size_t used = atomic_add_and_fetch_z(&category_mem_used[category], size);
+    atomic_fetch_and_update_max_z(&category_mem_peak[category], used);
   }
 
-  void mem_free(size_t size)
+  void mem_free(size_t size, MemoryCategory category = MEM_CATEGORY_OTHER)
   {
     assert(mem_used >= size);
     atomic_sub_and_fetch_z(&mem_used, size);
+
+    assert(category_mem_used[category] >= size);
+    atomic_sub_and_fetch_z(&category_mem_used[category], size);
   }
 
   size_t mem_used;
   size_t mem_peak;
+
+  /* Same as above, broken down per category. */
+  size_t category_mem_used[MEM_NUM_CATEGORIES];
+  size_t category_mem_peak[MEM_NUM_CATEGORIES];
 };
 
 CCL_NAMESPACE_END
@@ -90,6 +90,41 @@ typedef enum ExtensionType {
   EXTENSION_NUM_TYPES,
 } ExtensionType;
 
+/* Sparse 3D textures.
+ *
+ * Only blocks of voxels containing active values are stored, everything else reads as background.
+ * Voxels are grouped into leaves of 8x8x8 voxels, and leaves into nodes of 4x4x4 leaves. The
+ * data is a single read-only buffer, indexed as uint:
+ *
+ * - header: offset of the node table, offset of the leaf data, number of leaves and nodes.
+ * - top grid: one node index per 32x32x32 voxels, covering the texture dimensions.
+ * - node table: one leaf index per leaf in each node, padded to 16 bytes.
+ * - leaf data: voxels of each leaf in x, y, z order, using the texture data type.
+ *
+ * Node 0 and leaf 0 are empty and shared by all background, so lookups need no branches. */
+#define TEX_SPARSE_LEAF_LOG2 3
+#define TEX_SPARSE_LEAF_SIZE (1 << TEX_SPARSE_LEAF_LOG2)
+#define TEX_SPARSE_LEAF_VOXELS (TEX_SPARSE_LEAF_SIZE * TEX_SPARSE_LEAF_SIZE * TEX_SPARSE_LEAF_SIZE)
+#define TEX_SPARSE_NODE_LOG2 2
+#define TEX_SPARSE_NODE_SIZE (1 << TEX_SPARSE_NODE_LOG2)
+#define TEX_SPARSE_NODE_LEAVES (TEX_SPARSE_NODE_SIZE * TEX_SPARSE_NODE_SIZE * TEX_SPARSE_NODE_SIZE)
+#define TEX_SPARSE_NODE_DIM (TEX_SPARSE_LEAF_SIZE * TEX_SPARSE_NODE_SIZE)
+#define TEX_SPARSE_HEADER_SIZE 4
+
+#ifndef __KERNEL_GPU__
+/* Image paged in on demand by a cache on the host. The data of textures with the use_cache flag
+ * points to it, so the CPU kernel can sample them without depending on the cache itself. */
+class TextureCacheImage {
+ public:
+  virtual ~TextureCacheImage()
+  {
+  }
+
+  /* Filtered lookup, with the filter width in normalized texture coordinates. */
+  virtual float4 lookup(float x, float y, float width) const = 0;
+};
+#endif
+
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
@@ -103,6 +138,10 @@ typedef struct TextureInfo {
   uint width, height, depth;
   /* Transform for 3D textures. */
   uint use_transform_3d;
+  /* Pixels are paged in through the CPU image cache, data points to the cached image. */
+  uint use_cache;
+  /* Voxels are stored in the sparse layout described above. */
+  uint use_sparse;
   Transform transform_3d;
 } TextureInfo;
 
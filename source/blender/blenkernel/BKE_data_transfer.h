@@ -29,7 +29,9 @@
 extern "C" {
 #endif
 
+struct DataTransferRemapCache;
 struct Depsgraph;
+struct Mesh;
 struct Object;
 struct ReportList;
 struct Scene;
@@ -131,6 +133,18 @@ void BKE_object_data_transfer_layout(struct Depsgraph *depsgraph,
                                      const int fromlayers_select[DT_MULTILAYER_INDEX_MAX],
                                      const int tolayers_select[DT_MULTILAYER_INDEX_MAX]);
 
+/**
+ * Geometry mappings kept between transfers (e.g. by the modifier),
+ * reused as long as the geometry of both meshes and the mapping settings do not change.
+ */
+typedef struct DataTransferRemapCache DataTransferRemapCache;
+
+struct DataTransferRemapCache *BKE_data_transfer_remap_cache_new(void);
+void BKE_data_transfer_remap_cache_free(struct DataTransferRemapCache *remap_cache);
+bool BKE_data_transfer_remap_cache_validate(struct DataTransferRemapCache *remap_cache,
+                                            const struct Mesh *me_src,
+                                            const struct Mesh *me_dst);
+
 bool BKE_object_data_transfer_mesh(struct Depsgraph *depsgraph,
                                    struct Scene *scene,
                                    struct Object *ob_src,
@@ -175,6 +189,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  const float mix_factor,
                                  const char *vgroup_name,
                                  const bool invert_vgroup,
+                                 struct DataTransferRemapCache *remap_cache,
                                  struct ReportList *reports);
 
 #ifdef __cplusplus
@@ -135,6 +135,19 @@ void BKE_keyblock_data_set(struct Key *key, const int shape_index, const void *d
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Key-Block Sparse Storage
+ * \{ */
+
+bool BKE_keyblock_sparse_data_create(const struct Key *key,
+                                     const struct KeyBlock *kb,
+                                     int **r_index,
+                                     float (**r_data)[3],
+                                     int *r_totelem);
+void BKE_keyblock_sparse_data_expand(const struct Key *key, struct KeyBlock *kb);
+
+/** \} */
+
 #ifdef __cplusplus
 };
 #endif
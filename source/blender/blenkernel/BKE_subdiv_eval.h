@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 struct Mesh;
+struct OpenSubdiv_PatchCoord;
 struct Subdiv;
 
 /* Returns true if evaluator is ready for use. */
@@ -102,21 +103,56 @@ void BKE_subdiv_eval_displacement(struct Subdiv *subdiv,
 void BKE_subdiv_eval_final_point(
     struct Subdiv *subdiv, const int ptex_face_index, const float u, const float v, float r_P[3]);
 
+/* Batched point queries.
+ *
+ * Evaluate limit surface at an array of (ptex_face, u, v) coordinates in one go. This goes
+ * through the evaluator's batched path and is much cheaper than a single point query per
+ * coordinate. Coordinates are allowed to belong to different ptex faces.
+ *
+ * Derivatives are optional, pass NULL to skip their evaluation. */
+
+void BKE_subdiv_eval_limit_points(struct Subdiv *subdiv,
+                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3]);
+void BKE_subdiv_eval_limit_points_and_derivatives(struct Subdiv *subdiv,
+                                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_patch_coords,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3]);
+
 /* Patch queries at given resolution.
  *
  * Will evaluate patch at uniformly distributed (u, v) coordinates on a grid
  * of given resolution, producing resolution^2 evaluation points. The order
- * goes as u in rows, v in columns. */
+ * goes as u in rows, v in columns.
+ *
+ * Evaluation goes through scratch buffers provided by the caller, so evaluating many patches
+ * does not allocate for every patch. They are to be zero initialized, grow as needed, and are
+ * freed with BKE_subdiv_eval_patch_buffers_free(). Every thread needs its own buffers. */
+
+typedef struct SubdivEvalPatchBuffers {
+  struct OpenSubdiv_PatchCoord *patch_coords;
+  float (*P)[3];
+  float (*dPdu)[3];
+  float (*dPdv)[3];
+  int num_allocated_points;
+} SubdivEvalPatchBuffers;
+
+void BKE_subdiv_eval_patch_buffers_free(SubdivEvalPatchBuffers *buffers);
 
 void BKE_subdiv_eval_limit_patch_resolution_point(struct Subdiv *subdiv,
                                                   const int ptex_face_index,
                                                   const int resolution,
+                                                  SubdivEvalPatchBuffers *buffers,
                                                   void *buffer,
                                                   const int offset,
                                                   const int stride);
 void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(struct Subdiv *subdiv,
                                                                   const int ptex_face_index,
                                                                   const int resolution,
+                                                                  SubdivEvalPatchBuffers *buffers,
                                                                   void *point_buffer,
                                                                   const int point_offset,
                                                                   const int point_stride,
@@ -129,6 +165,7 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(struct Subdiv
 void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(struct Subdiv *subdiv,
                                                              const int ptex_face_index,
                                                              const int resolution,
+                                                             SubdivEvalPatchBuffers *buffers,
                                                              void *point_buffer,
                                                              const int point_offset,
                                                              const int point_stride,
@@ -138,6 +175,7 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(struct Subdiv *subd
 void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(struct Subdiv *subdiv,
                                                                    const int ptex_face_index,
                                                                    const int resolution,
+                                                                   SubdivEvalPatchBuffers *buffers,
                                                                    void *point_buffer,
                                                                    const int point_offset,
                                                                    const int point_stride,
@@ -49,6 +49,16 @@ struct Mesh *BKE_subdiv_to_mesh(struct Subdiv *subdiv,
                                 const SubdivToMeshSettings *settings,
                                 const struct Mesh *coarse_mesh);
 
+/* Re-evaluate vertex positions and normals of a mesh which was created by BKE_subdiv_to_mesh()
+ * with the same settings from a coarse mesh which only differs in vertex positions. Edges, loops,
+ * polygons and custom data are kept as-is.
+ *
+ * Returns false if the subdivided mesh does not match topology of the coarse one. */
+bool BKE_subdiv_to_mesh_update_positions(struct Subdiv *subdiv,
+                                         const SubdivToMeshSettings *settings,
+                                         const struct Mesh *coarse_mesh,
+                                         struct Mesh *subdiv_mesh);
+
 #ifdef __cplusplus
 }
 #endif
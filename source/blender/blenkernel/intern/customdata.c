@@ -41,6 +41,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -4399,6 +4400,16 @@ bool CustomData_layertype_is_singleton(int type)
   return typeInfo->defaultname == NULL;
 }
 
+/**
+ * Elements of the layer type own dynamically allocated data (such as deform weights),
+ * so they can not be compared or copied byte-wise.
+ */
+bool CustomData_layertype_is_dynamic(int type)
+{
+  const LayerTypeInfo *typeInfo = layerType_getInfo(type);
+  return typeInfo->free != NULL;
+}
+
 /**
  * \return Maximum number of layers of given \a type, -1 means 'no limit'.
  */
@@ -5077,35 +5088,99 @@ void customdata_data_transfer_interp_normal_normals(const CustomDataTransferLaye
   CustomData_data_mix_value(data_type, tmp_dst, data_dst, mix_mode, mix_factor);
 }
 
+typedef struct CustomDataTransferData {
+  const MeshPairRemap *me_remap;
+  const CustomDataTransferLayerMap *laymap;
+  cd_datatransfer_interp interp;
+
+  const void *data_src;
+  void *data_dst;
+  size_t data_step;
+  size_t data_offset;
+} CustomDataTransferData;
+
+typedef struct CustomDataTransferTLS {
+  size_t tmp_buff_size;
+  const void **tmp_data_src;
+} CustomDataTransferTLS;
+
+static void customdata_data_transfer_elem_cb(void *__restrict userdata,
+                                             const int i,
+                                             const TaskParallelTLS *__restrict tls)
+{
+  const CustomDataTransferData *data = userdata;
+  CustomDataTransferTLS *transfer_tls = tls->userdata_chunk;
+  const CustomDataTransferLayerMap *laymap = data->laymap;
+  const MeshPairRemapItem *mapit = &data->me_remap->items[i];
+  const int sources_num = mapit->sources_num;
+  const float mix_factor = laymap->mix_factor *
+                           (laymap->mix_weights ? laymap->mix_weights[i] : 1.0f);
+  void *data_dst = POINTER_OFFSET(data->data_dst, data->data_step * (size_t)i);
+  const void **tmp_data_src = NULL;
+  int j;
+
+  if (!sources_num) {
+    /* No sources for this element, skip it. */
+    return;
+  }
+
+  /* Note: NULL data_src may happen and be valid (see vgroups...). */
+  if (data->data_src) {
+    if (transfer_tls->tmp_data_src == NULL) {
+      transfer_tls->tmp_buff_size = 32;
+      transfer_tls->tmp_data_src = MEM_malloc_arrayN(
+          transfer_tls->tmp_buff_size, sizeof(*transfer_tls->tmp_data_src), __func__);
+    }
+    if (UNLIKELY(sources_num > transfer_tls->tmp_buff_size)) {
+      transfer_tls->tmp_buff_size = (size_t)sources_num;
+      transfer_tls->tmp_data_src = MEM_reallocN(
+          (void *)transfer_tls->tmp_data_src,
+          sizeof(*transfer_tls->tmp_data_src) * transfer_tls->tmp_buff_size);
+    }
+    tmp_data_src = transfer_tls->tmp_data_src;
+
+    for (j = 0; j < sources_num; j++) {
+      const size_t src_idx = (size_t)mapit->indices_src[j];
+      tmp_data_src[j] = POINTER_OFFSET(data->data_src,
+                                       (data->data_step * src_idx) + data->data_offset);
+    }
+  }
+
+  data->interp(laymap,
+               POINTER_OFFSET(data_dst, data->data_offset),
+               tmp_data_src,
+               mapit->weights_src,
+               sources_num,
+               mix_factor);
+}
+
+static void customdata_data_transfer_free_cb(const void *__restrict UNUSED(userdata),
+                                             void *__restrict chunk)
+{
+  CustomDataTransferTLS *transfer_tls = chunk;
+  MEM_SAFE_FREE(transfer_tls->tmp_data_src);
+}
+
+/**
+ * Destination elements only depend on their own mapping item,
+ * so they are interpolated in parallel.
+ */
 void CustomData_data_transfer(const MeshPairRemap *me_remap,
                               const CustomDataTransferLayerMap *laymap)
 {
-  MeshPairRemapItem *mapit = me_remap->items;
   const int totelem = me_remap->items_num;
-  int i;
 
   const int data_type = laymap->data_type;
-  const void *data_src = laymap->data_src;
   void *data_dst = laymap->data_dst;
 
   size_t data_step;
   size_t data_size;
   size_t data_offset;
 
-  cd_datatransfer_interp interp = NULL;
-
-  size_t tmp_buff_size = 32;
-  const void **tmp_data_src = NULL;
-
-  /* Note: NULL data_src may happen and be valid (see vgroups...). */
   if (!data_dst) {
     return;
   }
 
-  if (data_src) {
-    tmp_data_src = MEM_malloc_arrayN(tmp_buff_size, sizeof(*tmp_data_src), __func__);
-  }
-
   if (data_type & CD_FAKE) {
     data_step = laymap->elem_size;
     data_size = laymap->data_size;
@@ -5120,38 +5195,23 @@ void CustomData_data_transfer(const MeshPairRemap *me_remap,
     data_offset = laymap->data_offset;
   }
 
-  interp = laymap->interp ? laymap->interp : customdata_data_transfer_interp_generic;
-
-  for (i = 0; i < totelem; i++, data_dst = POINTER_OFFSET(data_dst, data_step), mapit++) {
-    const int sources_num = mapit->sources_num;
-    const float mix_factor = laymap->mix_factor *
-                             (laymap->mix_weights ? laymap->mix_weights[i] : 1.0f);
-    int j;
-
-    if (!sources_num) {
-      /* No sources for this element, skip it. */
-      continue;
-    }
-
-    if (tmp_data_src) {
-      if (UNLIKELY(sources_num > tmp_buff_size)) {
-        tmp_buff_size = (size_t)sources_num;
-        tmp_data_src = MEM_reallocN((void *)tmp_data_src, sizeof(*tmp_data_src) * tmp_buff_size);
-      }
-
-      for (j = 0; j < sources_num; j++) {
-        const size_t src_idx = (size_t)mapit->indices_src[j];
-        tmp_data_src[j] = POINTER_OFFSET(data_src, (data_step * src_idx) + data_offset);
-      }
-    }
-
-    interp(laymap,
-           POINTER_OFFSET(data_dst, data_offset),
-           tmp_data_src,
-           mapit->weights_src,
-           sources_num,
-           mix_factor);
-  }
+  CustomDataTransferData data = {
+      .me_remap = me_remap,
+      .laymap = laymap,
+      .interp = laymap->interp ? laymap->interp : customdata_data_transfer_interp_generic,
+      .data_src = laymap->data_src,
+      .data_dst = data_dst,
+      .data_step = data_step,
+      .data_offset = data_offset,
+  };
 
-  MEM_SAFE_FREE(tmp_data_src);
+  CustomDataTransferTLS transfer_tls = {0};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (totelem > 1024);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = &transfer_tls;
+  settings.userdata_chunk_size = sizeof(transfer_tls);
+  settings.func_free = customdata_data_transfer_free_cb;
+  BLI_task_parallel_range(0, totelem, &data, customdata_data_transfer_elem_cb, &settings);
 }
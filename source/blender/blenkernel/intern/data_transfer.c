@@ -33,6 +33,7 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 
@@ -1375,6 +1376,200 @@ void BKE_object_data_transfer_layout(struct Depsgraph *depsgraph,
   }
 }
 
+/* Remap cache: mappings only depend on the geometry of both meshes and on the mapping settings,
+ * so they can be reused from one transfer to the next as long as none of those change.
+ * Geometry is compared through the element counts and a 64 bit hash of the arrays used by the
+ * previous mapping. */
+
+#define DT_REMAP_CACHE_DOMAINS 4
+
+typedef struct DataTransferRemapSettings {
+  int map_mode;
+  float max_distance;
+  float ray_radius;
+  float islands_precision;
+  bool use_space_transform;
+  SpaceTransform space_transform;
+  MeshRemapIslandsCalc island_callback;
+} DataTransferRemapSettings;
+
+typedef struct DataTransferRemapMeshKey {
+  int totvert, totedge, totpoly, totloop;
+  /* Two 32 bit hashes with different seeds. */
+  uint32_t hash[2];
+} DataTransferRemapMeshKey;
+
+struct DataTransferRemapCache {
+  /* Indexed like the element domains in #BKE_object_data_transfer_ex. */
+  MeshPairRemap maps[DT_REMAP_CACHE_DOMAINS];
+  DataTransferRemapSettings settings[DT_REMAP_CACHE_DOMAINS];
+  bool is_valid[DT_REMAP_CACHE_DOMAINS];
+
+  /* Geometry of the source and destination meshes. */
+  DataTransferRemapMeshKey mesh_key[2];
+};
+
+DataTransferRemapCache *BKE_data_transfer_remap_cache_new(void)
+{
+  return MEM_callocN(sizeof(DataTransferRemapCache), __func__);
+}
+
+void BKE_data_transfer_remap_cache_free(DataTransferRemapCache *remap_cache)
+{
+  for (int i = 0; i < DT_REMAP_CACHE_DOMAINS; i++) {
+    BKE_mesh_remap_free(&remap_cache->maps[i]);
+  }
+  MEM_freeN(remap_cache);
+}
+
+static void data_transfer_remap_hash_array(BLI_HashMurmur2A *mm2,
+                                           const void *data,
+                                           const int elem_size,
+                                           const int elem_num)
+{
+  /* Element count is part of the hash, so arrays don't alias with their neighbors. */
+  BLI_hash_mm2a_add_int(mm2, data ? elem_num : -1);
+  if (data && elem_num) {
+    BLI_hash_mm2a_add(mm2, data, (size_t)elem_size * (size_t)elem_num);
+  }
+}
+
+/* Hash of all mesh data used by geometry mappings. */
+static uint32_t data_transfer_remap_mesh_hash(const Mesh *me, const uint32_t seed)
+{
+  const short(*custom_nors)[2] = CustomData_get_layer(&me->ldata, CD_CUSTOMLOOPNORMAL);
+  BLI_HashMurmur2A mm2;
+
+  BLI_hash_mm2a_init(&mm2, seed);
+  /* Edge flags are needed too, seams define the islands of UV mappings. */
+  data_transfer_remap_hash_array(&mm2, me->mvert, sizeof(*me->mvert), me->totvert);
+  data_transfer_remap_hash_array(&mm2, me->medge, sizeof(*me->medge), me->totedge);
+  data_transfer_remap_hash_array(&mm2, me->mpoly, sizeof(*me->mpoly), me->totpoly);
+  data_transfer_remap_hash_array(&mm2, me->mloop, sizeof(*me->mloop), me->totloop);
+  /* Loop normals are used by some mapping modes. */
+  data_transfer_remap_hash_array(&mm2, custom_nors, sizeof(*custom_nors), me->totloop);
+  BLI_hash_mm2a_add_int(&mm2, me->flag);
+  BLI_hash_mm2a_add(&mm2, (const unsigned char *)&me->smoothresh, sizeof(me->smoothresh));
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+static void data_transfer_remap_mesh_key_init(DataTransferRemapMeshKey *r_key, const Mesh *me)
+{
+  r_key->totvert = me->totvert;
+  r_key->totedge = me->totedge;
+  r_key->totpoly = me->totpoly;
+  r_key->totloop = me->totloop;
+  r_key->hash[0] = data_transfer_remap_mesh_hash(me, 0);
+  r_key->hash[1] = data_transfer_remap_mesh_hash(me, 0x9e3779b9);
+}
+
+static bool data_transfer_remap_mesh_key_equal(const DataTransferRemapMeshKey *key_a,
+                                               const DataTransferRemapMeshKey *key_b)
+{
+  return (key_a->totvert == key_b->totvert && key_a->totedge == key_b->totedge &&
+          key_a->totpoly == key_b->totpoly && key_a->totloop == key_b->totloop &&
+          key_a->hash[0] == key_b->hash[0] && key_a->hash[1] == key_b->hash[1]);
+}
+
+/**
+ * Invalidate all cached mappings if the geometry of either mesh changed.
+ *
+ * \return true when the cached mappings are still valid.
+ */
+bool BKE_data_transfer_remap_cache_validate(DataTransferRemapCache *remap_cache,
+                                            const Mesh *me_src,
+                                            const Mesh *me_dst)
+{
+  const Mesh *meshes[2] = {me_src, me_dst};
+  bool is_valid = true;
+
+  for (int i = 0; i < 2; i++) {
+    DataTransferRemapMeshKey key;
+    data_transfer_remap_mesh_key_init(&key, meshes[i]);
+    if (!data_transfer_remap_mesh_key_equal(&key, &remap_cache->mesh_key[i])) {
+      remap_cache->mesh_key[i] = key;
+      is_valid = false;
+    }
+  }
+
+  if (!is_valid) {
+    memset(remap_cache->is_valid, 0, sizeof(remap_cache->is_valid));
+  }
+  return is_valid;
+}
+
+static void data_transfer_remap_settings_init(DataTransferRemapSettings *r_settings,
+                                              const int map_mode,
+                                              const SpaceTransform *space_transform,
+                                              const float max_distance,
+                                              const float ray_radius,
+                                              const float islands_precision,
+                                              const MeshRemapIslandsCalc island_callback)
+{
+  memset(r_settings, 0, sizeof(*r_settings));
+  r_settings->map_mode = map_mode;
+  r_settings->max_distance = max_distance;
+  r_settings->ray_radius = ray_radius;
+  r_settings->islands_precision = islands_precision;
+  r_settings->use_space_transform = (space_transform != NULL);
+  if (space_transform) {
+    r_settings->space_transform = *space_transform;
+  }
+  r_settings->island_callback = island_callback;
+}
+
+static bool data_transfer_remap_settings_equal(const DataTransferRemapSettings *settings_a,
+                                               const DataTransferRemapSettings *settings_b)
+{
+  return (settings_a->map_mode == settings_b->map_mode &&
+          settings_a->max_distance == settings_b->max_distance &&
+          settings_a->ray_radius == settings_b->ray_radius &&
+          settings_a->islands_precision == settings_b->islands_precision &&
+          settings_a->use_space_transform == settings_b->use_space_transform &&
+          memcmp(&settings_a->space_transform,
+                 &settings_b->space_transform,
+                 sizeof(settings_a->space_transform)) == 0 &&
+          settings_a->island_callback == settings_b->island_callback);
+}
+
+/**
+ * Return true when the cached mapping of given domain can be used as is,
+ * else tag it valid for given settings, assuming the caller (re)computes it.
+ */
+static bool data_transfer_remap_cache_use(DataTransferRemapCache *remap_cache,
+                                          const int domain,
+                                          const int map_mode,
+                                          const SpaceTransform *space_transform,
+                                          const float max_distance,
+                                          const float ray_radius,
+                                          const float islands_precision,
+                                          const MeshRemapIslandsCalc island_callback)
+{
+  DataTransferRemapSettings settings;
+
+  if (remap_cache == NULL) {
+    return false;
+  }
+
+  data_transfer_remap_settings_init(&settings,
+                                    map_mode,
+                                    space_transform,
+                                    max_distance,
+                                    ray_radius,
+                                    islands_precision,
+                                    island_callback);
+  if (remap_cache->is_valid[domain] &&
+      data_transfer_remap_settings_equal(&remap_cache->settings[domain], &settings)) {
+    return true;
+  }
+
+  remap_cache->settings[domain] = settings;
+  remap_cache->is_valid[domain] = true;
+  return false;
+}
+
+/* ********** */
+
 bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  Scene *scene,
                                  Object *ob_src,
@@ -1397,6 +1592,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
                                  const float mix_factor,
                                  const char *vgroup_name,
                                  const bool invert_vgroup,
+                                 DataTransferRemapCache *remap_cache,
                                  ReportList *reports)
 {
 #define VDATA 0
@@ -1416,7 +1612,8 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   int vg_idx = -1;
   float *weights[DATAMAX] = {NULL};
 
-  MeshPairRemap geom_map[DATAMAX] = {{0}};
+  MeshPairRemap geom_map_local[DATAMAX] = {{0}};
+  MeshPairRemap *geom_map = remap_cache ? remap_cache->maps : geom_map_local;
   bool geom_map_init[DATAMAX] = {0};
   ListBase lay_map = {NULL};
   bool changed = false;
@@ -1476,6 +1673,10 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
         me_dst->mvert, me_dst->totvert, me_src, space_transform);
   }
 
+  if (remap_cache) {
+    BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst);
+  }
+
   /* Check all possible data types.
    * Note item mappings and dest mix weights are cached. */
   for (i = 0; i < DT_TYPE_MAX; i++) {
@@ -1536,15 +1737,24 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_verts_from_mesh(map_vert_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[VDATA]);
+        if (!data_transfer_remap_cache_use(remap_cache,
+                                           VDATA,
+                                           map_vert_mode,
+                                           space_transform,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           NULL)) {
+          BKE_mesh_remap_calc_verts_from_mesh(map_vert_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[VDATA]);
+        }
         geom_map_init[VDATA] = true;
       }
 
@@ -1612,17 +1822,26 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_edges_from_mesh(map_edge_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            edges_dst,
-                                            num_edges_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[EDATA]);
+        if (!data_transfer_remap_cache_use(remap_cache,
+                                           EDATA,
+                                           map_edge_mode,
+                                           space_transform,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           NULL)) {
+          BKE_mesh_remap_calc_edges_from_mesh(map_edge_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              edges_dst,
+                                              num_edges_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[EDATA]);
+        }
         geom_map_init[EDATA] = true;
       }
 
@@ -1698,27 +1917,36 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_loops_from_mesh(map_loop_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            edges_dst,
-                                            num_edges_dst,
-                                            loops_dst,
-                                            num_loops_dst,
-                                            polys_dst,
-                                            num_polys_dst,
-                                            ldata_dst,
-                                            pdata_dst,
-                                            (me_dst->flag & ME_AUTOSMOOTH) != 0,
-                                            me_dst->smoothresh,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            island_callback,
-                                            islands_handling_precision,
-                                            &geom_map[LDATA]);
+        if (!data_transfer_remap_cache_use(remap_cache,
+                                           LDATA,
+                                           map_loop_mode,
+                                           space_transform,
+                                           max_distance,
+                                           ray_radius,
+                                           islands_handling_precision,
+                                           island_callback)) {
+          BKE_mesh_remap_calc_loops_from_mesh(map_loop_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              edges_dst,
+                                              num_edges_dst,
+                                              loops_dst,
+                                              num_loops_dst,
+                                              polys_dst,
+                                              num_polys_dst,
+                                              ldata_dst,
+                                              pdata_dst,
+                                              (me_dst->flag & ME_AUTOSMOOTH) != 0,
+                                              me_dst->smoothresh,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              island_callback,
+                                              islands_handling_precision,
+                                              &geom_map[LDATA]);
+        }
         geom_map_init[LDATA] = true;
       }
 
@@ -1789,20 +2017,29 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
           continue;
         }
 
-        BKE_mesh_remap_calc_polys_from_mesh(map_poly_mode,
-                                            space_transform,
-                                            max_distance,
-                                            ray_radius,
-                                            verts_dst,
-                                            num_verts_dst,
-                                            loops_dst,
-                                            num_loops_dst,
-                                            polys_dst,
-                                            num_polys_dst,
-                                            pdata_dst,
-                                            dirty_nors_dst,
-                                            me_src,
-                                            &geom_map[PDATA]);
+        if (!data_transfer_remap_cache_use(remap_cache,
+                                           PDATA,
+                                           map_poly_mode,
+                                           space_transform,
+                                           max_distance,
+                                           ray_radius,
+                                           0.0f,
+                                           NULL)) {
+          BKE_mesh_remap_calc_polys_from_mesh(map_poly_mode,
+                                              space_transform,
+                                              max_distance,
+                                              ray_radius,
+                                              verts_dst,
+                                              num_verts_dst,
+                                              loops_dst,
+                                              num_loops_dst,
+                                              polys_dst,
+                                              num_polys_dst,
+                                              pdata_dst,
+                                              dirty_nors_dst,
+                                              me_src,
+                                              &geom_map[PDATA]);
+        }
         geom_map_init[PDATA] = true;
       }
 
@@ -1851,7 +2088,7 @@ bool BKE_object_data_transfer_ex(struct Depsgraph *depsgraph,
   }
 
   for (i = 0; i < DATAMAX; i++) {
-    BKE_mesh_remap_free(&geom_map[i]);
+    BKE_mesh_remap_free(&geom_map_local[i]);
     MEM_SAFE_FREE(weights[i]);
   }
 
@@ -1909,5 +2146,6 @@ bool BKE_object_data_transfer_mesh(struct Depsgraph *depsgraph,
                                      mix_factor,
                                      vgroup_name,
                                      invert_vgroup,
+                                     NULL,
                                      reports);
 }
@@ -0,0 +1,232 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cfloat>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_data_transfer.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_remap.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+class DataTransferTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    /* Needed to allocate meshes outside of any Main database. */
+    BKE_idtype_init();
+  }
+};
+
+/* Grid of quads in the XY plane, vertices are jittered by given amount. */
+static Mesh *data_transfer_test_grid_create(const int size, const float jitter, RNG *rng)
+{
+  const int quads_num = (size - 1) * (size - 1);
+  Mesh *me = BKE_mesh_new_nomain(size * size, 0, 0, quads_num * 4, quads_num);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float *co = me->mvert[y * size + x].co;
+      co[0] = (float)x + jitter * (BLI_rng_get_float(rng) - 0.5f);
+      co[1] = (float)y + jitter * (BLI_rng_get_float(rng) - 0.5f);
+      co[2] = 0.0f;
+    }
+  }
+
+  int loop_index = 0;
+  for (int y = 0; y < size - 1; y++) {
+    for (int x = 0; x < size - 1; x++) {
+      MPoly *mp = &me->mpoly[y * (size - 1) + x];
+      mp->loopstart = loop_index;
+      mp->totloop = 4;
+      me->mloop[loop_index++].v = y * size + x;
+      me->mloop[loop_index++].v = y * size + x + 1;
+      me->mloop[loop_index++].v = (y + 1) * size + x + 1;
+      me->mloop[loop_index++].v = (y + 1) * size + x;
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  return me;
+}
+
+static int data_transfer_test_nearest_vert(const Mesh *me, const float co[3])
+{
+  int nearest = -1;
+  float nearest_dist_sq = FLT_MAX;
+  for (int i = 0; i < me->totvert; i++) {
+    const float dist_sq = len_squared_v3v3(co, me->mvert[i].co);
+    if (dist_sq < nearest_dist_sq) {
+      nearest_dist_sq = dist_sq;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+TEST_F(DataTransferTest, RemapVertsNearest)
+{
+  RNG *rng = BLI_rng_new(0);
+  /* Enough destination vertices to be mapped in several threaded chunks. */
+  Mesh *me_src = data_transfer_test_grid_create(20, 0.5f, rng);
+  Mesh *me_dst = data_transfer_test_grid_create(50, 0.9f, rng);
+  for (int i = 0; i < me_dst->totvert; i++) {
+    mul_v3_fl(me_dst->mvert[i].co, 0.4f);
+  }
+
+  MeshPairRemap map = {0};
+  BKE_mesh_remap_calc_verts_from_mesh(MREMAP_MODE_VERT_NEAREST,
+                                      nullptr,
+                                      FLT_MAX,
+                                      0.0f,
+                                      me_dst->mvert,
+                                      me_dst->totvert,
+                                      false,
+                                      me_src,
+                                      &map);
+
+  ASSERT_EQ(map.items_num, me_dst->totvert);
+  for (int i = 0; i < me_dst->totvert; i++) {
+    const MeshPairRemapItem *item = &map.items[i];
+    const int nearest = data_transfer_test_nearest_vert(me_src, me_dst->mvert[i].co);
+    ASSERT_EQ(item->sources_num, 1);
+    EXPECT_EQ(item->indices_src[0], nearest);
+    EXPECT_FLOAT_EQ(item->weights_src[0], 1.0f);
+  }
+
+  BKE_mesh_remap_free(&map);
+  BKE_id_free(nullptr, me_dst);
+  BKE_id_free(nullptr, me_src);
+  BLI_rng_free(rng);
+}
+
+TEST_F(DataTransferTest, RemapPolysDeterministic)
+{
+  RNG *rng = BLI_rng_new(0);
+  Mesh *me_src = data_transfer_test_grid_create(20, 0.5f, rng);
+  Mesh *me_dst = data_transfer_test_grid_create(40, 0.5f, rng);
+  for (int i = 0; i < me_dst->totvert; i++) {
+    mul_v3_fl(me_dst->mvert[i].co, 0.45f);
+    me_dst->mvert[i].co[2] = 1.0f;
+  }
+
+  /* Ray-casting uses random samples per polygon, results must not depend on the threading.
+   * The first run is the serial reference, the second one uses all threads. */
+  MeshPairRemap maps[2] = {{0}};
+  for (int run = 0; run < 2; run++) {
+    BLI_system_num_threads_override_set(run == 0 ? 1 : 0);
+    BLI_task_scheduler_init();
+    BKE_mesh_remap_calc_polys_from_mesh(MREMAP_MODE_POLY_POLYINTERP_PNORPROJ,
+                                        nullptr,
+                                        FLT_MAX,
+                                        0.0f,
+                                        me_dst->mvert,
+                                        me_dst->totvert,
+                                        me_dst->mloop,
+                                        me_dst->totloop,
+                                        me_dst->mpoly,
+                                        me_dst->totpoly,
+                                        &me_dst->pdata,
+                                        true,
+                                        me_src,
+                                        &maps[run]);
+    BLI_task_scheduler_exit();
+  }
+  BLI_system_num_threads_override_set(0);
+
+  ASSERT_EQ(maps[0].items_num, me_dst->totpoly);
+  ASSERT_EQ(maps[1].items_num, me_dst->totpoly);
+  int mapped_num = 0;
+  for (int i = 0; i < me_dst->totpoly; i++) {
+    const MeshPairRemapItem *item_a = &maps[0].items[i];
+    const MeshPairRemapItem *item_b = &maps[1].items[i];
+    ASSERT_EQ(item_a->sources_num, item_b->sources_num);
+    float weights_sum = 0.0f;
+    for (int j = 0; j < item_a->sources_num; j++) {
+      EXPECT_EQ(item_a->indices_src[j], item_b->indices_src[j]);
+      EXPECT_EQ(item_a->weights_src[j], item_b->weights_src[j]);
+      weights_sum += item_a->weights_src[j];
+    }
+    if (item_a->sources_num) {
+      EXPECT_NEAR(weights_sum, 1.0f, 1e-5f);
+      mapped_num++;
+    }
+  }
+  /* The destination grid lies right above the inside of the source one, all polygons hit it. */
+  EXPECT_EQ(mapped_num, me_dst->totpoly);
+
+  BKE_mesh_remap_free(&maps[0]);
+  BKE_mesh_remap_free(&maps[1]);
+  BKE_id_free(nullptr, me_dst);
+  BKE_id_free(nullptr, me_src);
+  BLI_rng_free(rng);
+}
+
+TEST_F(DataTransferTest, RemapCacheValidate)
+{
+  RNG *rng = BLI_rng_new(0);
+  Mesh *me_src = data_transfer_test_grid_create(10, 0.5f, rng);
+  Mesh *me_dst = data_transfer_test_grid_create(12, 0.5f, rng);
+  DataTransferRemapCache *remap_cache = BKE_data_transfer_remap_cache_new();
+
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  EXPECT_TRUE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+
+  /* Moving a single vertex of either mesh. */
+  me_src->mvert[5].co[2] += 1e-4f;
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  EXPECT_TRUE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  me_dst->mvert[me_dst->totvert - 1].co[0] -= 1e-4f;
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+
+  /* Seams change UV islands. */
+  EXPECT_TRUE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  me_dst->medge[3].flag |= ME_SEAM;
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+
+  /* Auto-smooth settings change loop normals. */
+  EXPECT_TRUE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  me_src->flag |= ME_AUTOSMOOTH;
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+  EXPECT_TRUE(BKE_data_transfer_remap_cache_validate(remap_cache, me_src, me_dst));
+
+  /* Swapping both meshes. */
+  EXPECT_FALSE(BKE_data_transfer_remap_cache_validate(remap_cache, me_dst, me_src));
+
+  BKE_data_transfer_remap_cache_free(remap_cache);
+  BKE_id_free(nullptr, me_dst);
+  BKE_id_free(nullptr, me_src);
+  BLI_rng_free(rng);
+}
+
+}  // namespace blender::bke::tests
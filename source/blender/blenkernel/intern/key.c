@@ -30,6 +30,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -56,6 +58,8 @@
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 
+#include "DEG_depsgraph_query.h"
+
 #include "RNA_access.h"
 
 static void shapekey_copy_data(Main *UNUSED(bmain),
@@ -73,6 +77,8 @@ static void shapekey_copy_data(Main *UNUSED(bmain),
     if (kb_dst->data) {
       kb_dst->data = MEM_dupallocN(kb_dst->data);
     }
+    kb_dst->moved_index = NULL;
+    kb_dst->moved_totelem = 0;
     if (kb_src == key_src->refkey) {
       key_dst->refkey = kb_dst;
     }
@@ -88,6 +94,7 @@ static void shapekey_free_data(ID *id)
     if (kb->data) {
       MEM_freeN(kb->data);
     }
+    MEM_SAFE_FREE(kb->moved_index);
     MEM_freeN(kb);
   }
 }
@@ -144,6 +151,7 @@ void BKE_key_free_nolib(Key *key)
     if (kb->data) {
       MEM_freeN(kb->data);
     }
+    MEM_SAFE_FREE(kb->moved_index);
     MEM_freeN(kb);
   }
 }
@@ -800,6 +808,296 @@ static void cp_cu_key(Curve *cu,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Key-Block Moved Elements
+ *
+ * Corrective shapes usually move a small part of the mesh. Key-blocks of evaluated keys keep
+ * the indices of the elements that differ from the key-block they are relative to, so blending
+ * only visits those. Original key-blocks are written in place in many places (RNA, sculpt,
+ * bmesh conversion), so the indices are never used for them. Evaluated keys are copied again
+ * from the original whenever it changes, the BKE_keyblock_* write functions clear them too.
+ * \{ */
+
+/* Only index key-blocks where at most this fraction of the elements moved. */
+#define KEY_MOVED_INDEX_MAX_FACTOR 4
+
+/* Evaluated keys can be shared by several objects evaluated in parallel. */
+static ThreadMutex key_moved_index_lock = BLI_MUTEX_INITIALIZER;
+
+/* Bitwise comparison, unlike #equals_v3v3 -0.0 and 0.0 differ. */
+static bool key_coord_equals_exact(const float a[3], const float b[3])
+{
+  return memcmp(a, b, sizeof(float[3])) == 0;
+}
+
+static void key_block_moved_index_clear(KeyBlock *kb)
+{
+  MEM_SAFE_FREE(kb->moved_index);
+  kb->moved_totelem = 0;
+}
+
+/**
+ * Clear the moved elements of \a kb after its data changed, and the ones of all key-blocks of
+ * \a key since they may be relative to it.
+ */
+static void key_moved_index_clear(Key *key, KeyBlock *kb)
+{
+  if (key) {
+    LISTBASE_FOREACH (KeyBlock *, kb_iter, &key->block) {
+      key_block_moved_index_clear(kb_iter);
+    }
+  }
+  if (kb) {
+    key_block_moved_index_clear(kb);
+  }
+}
+
+/**
+ * Compute the indices of the elements of \a kb that differ from \a refb, unless done already.
+ * Must be called with #key_moved_index_lock held.
+ */
+static void key_block_moved_index_ensure(KeyBlock *kb, const KeyBlock *refb)
+{
+  if (kb->moved_index != NULL || kb->moved_totelem == -1) {
+    return;
+  }
+
+  const float(*co)[3] = kb->data;
+  const float(*ref_co)[3] = refb->data;
+  const int max_totelem = kb->totelem / KEY_MOVED_INDEX_MAX_FACTOR;
+  int totelem = 0;
+
+  for (int i = 0; i < kb->totelem; i++) {
+    if (!key_coord_equals_exact(co[i], ref_co[i]) && ++totelem > max_totelem) {
+      kb->moved_totelem = -1;
+      return;
+    }
+  }
+
+  /* Allocate at least one item, a NULL array means not computed yet. */
+  int *index = MEM_malloc_arrayN((size_t)max_ii(totelem, 1), sizeof(*index), __func__);
+  int j = 0;
+  for (int i = 0; i < kb->totelem && j < totelem; i++) {
+    if (!key_coord_equals_exact(co[i], ref_co[i])) {
+      index[j++] = i;
+    }
+  }
+
+  kb->moved_index = index;
+  kb->moved_totelem = totelem;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Relative Coordinate Key Blending
+ *
+ * Mesh and lattice keys store plain coordinates, which allows blending relative keys over
+ * ranges of elements in parallel. All keys are accumulated into one range before moving on to
+ * the next, so the output stays in cache while the (possibly many) keys are applied.
+ * \{ */
+
+/* Number of elements blended by a single task. */
+#define KEY_BLEND_CHUNK_SIZE 1024
+
+typedef struct KeyBlendTarget {
+  const float (*from)[3];
+  const float (*reffrom)[3];
+  /* Vertex group weights, NULL when the key affects all elements. */
+  const float *weights;
+  float influence;
+  /* Sorted indices of the only elements that differ, NULL to blend all elements. */
+  const int *moved_index;
+  int moved_num;
+} KeyBlendTarget;
+
+typedef struct KeyBlendData {
+  float (*out)[3];
+  const float (*basis)[3];
+  const KeyBlendTarget *targets;
+  int targets_num;
+  int tot;
+} KeyBlendData;
+
+static bool key_blend_weights_are_zero(const float *weights, const int start, const int end)
+{
+  for (int a = start; a < end; a++) {
+    if (weights[a] != 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* First item of the moved elements of \a target that isn't before \a start. */
+static int key_blend_moved_index_find(const KeyBlendTarget *target, const int start)
+{
+  int lo = 0, hi = target->moved_num;
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (target->moved_index[mid] < start) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static void key_blend_relative_coords_task(void *__restrict userdata,
+                                           const int chunk,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeyBlendData *data = userdata;
+  const int start = chunk * KEY_BLEND_CHUNK_SIZE;
+  const int end = min_ii(start + KEY_BLEND_CHUNK_SIZE, data->tot);
+  float(*out)[3] = data->out;
+
+  memcpy(out[start], data->basis[start], sizeof(*out) * (size_t)(end - start));
+
+  for (int i = 0; i < data->targets_num; i++) {
+    const KeyBlendTarget *target = &data->targets[i];
+    const float(*from)[3] = target->from;
+    const float(*reffrom)[3] = target->reffrom;
+    const float *weights = target->weights;
+    const float influence = target->influence;
+
+    /* Same arithmetic as #rel_flerp, written out so the loops vectorize. */
+    if (target->moved_index) {
+      /* Elements that didn't move add nothing. */
+      const int *moved_index = target->moved_index;
+      for (int j = key_blend_moved_index_find(target, start);
+           j < target->moved_num && moved_index[j] < end;
+           j++) {
+        const int a = moved_index[j];
+        const float weight = weights ? weights[a] * influence : influence;
+        out[a][0] -= weight * (reffrom[a][0] - from[a][0]);
+        out[a][1] -= weight * (reffrom[a][1] - from[a][1]);
+        out[a][2] -= weight * (reffrom[a][2] - from[a][2]);
+      }
+    }
+    else if (weights) {
+      /* Vertex groups usually limit a key to a small region, skip ranges it doesn't touch. */
+      if (key_blend_weights_are_zero(weights, start, end)) {
+        continue;
+      }
+      for (int a = start; a < end; a++) {
+        const float weight = weights[a] * influence;
+        out[a][0] -= weight * (reffrom[a][0] - from[a][0]);
+        out[a][1] -= weight * (reffrom[a][1] - from[a][1]);
+        out[a][2] -= weight * (reffrom[a][2] - from[a][2]);
+      }
+    }
+    else {
+      for (int a = start; a < end; a++) {
+        out[a][0] -= influence * (reffrom[a][0] - from[a][0]);
+        out[a][1] -= influence * (reffrom[a][1] - from[a][1]);
+        out[a][2] -= influence * (reffrom[a][2] - from[a][2]);
+      }
+    }
+  }
+}
+
+static bool key_evaluate_relative_coords_supported(const Key *key, const int tot)
+{
+  return (key->elemstr[0] == KEYELEM_FLOAT_LEN_COORD && key->elemstr[1] == IPO_FLOAT &&
+          key->elemstr[2] == 0 && key->elemsize == sizeof(float[KEYELEM_FLOAT_LEN_COORD]) &&
+          key->refkey != NULL && key->refkey->totelem == tot);
+}
+
+/**
+ * Equivalent of #key_evaluate_relative for the full range of mesh and lattice keys.
+ * Muted keys and keys without influence are skipped up-front, elements keys don't move are
+ * skipped on evaluated keys.
+ */
+static void key_evaluate_relative_coords(const int tot,
+                                         float (*out)[3],
+                                         Key *key,
+                                         KeyBlock *actkb,
+                                         float **per_keyblock_weights)
+{
+  KeyBlendTarget *targets = MEM_malloc_arrayN(
+      (size_t)key->totkey, sizeof(*targets), __func__);
+  char **freedata = MEM_calloc_arrayN((size_t)key->totkey + 1, sizeof(*freedata), __func__);
+  int targets_num = 0, freedata_num = 0;
+  KeyBlock *kb;
+  int keyblock_index;
+  const bool use_moved_index = DEG_is_evaluated_id(&key->id);
+
+  const float(*basis)[3] = (const float(*)[3])key_block_get_data(
+      key, actkb, key->refkey, &freedata[freedata_num]);
+  if (freedata[freedata_num]) {
+    freedata_num++;
+  }
+
+  if (use_moved_index) {
+    BLI_mutex_lock(&key_moved_index_lock);
+  }
+
+  for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+    if (kb == key->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f ||
+        kb->totelem != tot) {
+      continue;
+    }
+
+    /* reference now can be any block */
+    KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+    if (refb == NULL) {
+      continue;
+    }
+
+    KeyBlendTarget *target = &targets[targets_num++];
+    target->from = (const float(*)[3])key_block_get_data(key, actkb, kb, &freedata[freedata_num]);
+    if (freedata[freedata_num]) {
+      freedata_num++;
+    }
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    target->reffrom = refb->data;
+    target->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+    target->influence = kb->curval;
+    target->moved_index = NULL;
+    target->moved_num = 0;
+
+    /* Edit-mode data is not indexed. */
+    if (use_moved_index && (const void *)target->from == kb->data && refb->totelem == tot) {
+      key_block_moved_index_ensure(kb, refb);
+      target->moved_index = kb->moved_index;
+      target->moved_num = max_ii(kb->moved_totelem, 0);
+    }
+  }
+
+  if (use_moved_index) {
+    BLI_mutex_unlock(&key_moved_index_lock);
+  }
+
+  KeyBlendData data = {
+      .out = out,
+      .basis = basis,
+      .targets = targets,
+      .targets_num = targets_num,
+      .tot = tot,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (tot > KEY_BLEND_CHUNK_SIZE);
+  BLI_task_parallel_range(0,
+                          (tot + KEY_BLEND_CHUNK_SIZE - 1) / KEY_BLEND_CHUNK_SIZE,
+                          &data,
+                          key_blend_relative_coords_task,
+                          &settings);
+
+  for (int i = 0; i < freedata_num; i++) {
+    MEM_freeN(freedata[i]);
+  }
+  MEM_freeN(freedata);
+  MEM_freeN(targets);
+}
+
+/** \} */
+
 static void key_evaluate_relative(const int start,
                                   int end,
                                   const int tot,
@@ -825,6 +1123,12 @@ static void key_evaluate_relative(const int start,
     end = tot;
   }
 
+  if (mode == KEY_MODE_DUMMY && start == 0 && end == tot &&
+      key_evaluate_relative_coords_supported(key, tot)) {
+    key_evaluate_relative_coords(tot, (float(*)[3])basispoin, key, actkb, per_keyblock_weights);
+    return;
+  }
+
   /* in case of beztriple */
   elemstr[0] = 1; /* nr of ipofloats */
   elemstr[1] = IPO_BEZTRIPLE;
@@ -1622,6 +1926,7 @@ void BKE_keyblock_data_set_with_mat4(Key *key,
   }
 
   const float(*elements)[3] = coords;
+  key_moved_index_clear(key, NULL);
 
   int index = 0;
   for (KeyBlock *kb = key->block.first; kb; kb = kb->next, index++) {
@@ -1646,6 +1951,7 @@ void BKE_keyblock_curve_data_set_with_mat4(
     Key *key, const ListBase *nurb, const int shape_index, const void *data, const float mat[4][4])
 {
   const uint8_t *elements = data;
+  key_moved_index_clear(key, NULL);
 
   int index = 0;
   for (KeyBlock *kb = key->block.first; kb; kb = kb->next, index++) {
@@ -1663,6 +1969,7 @@ void BKE_keyblock_curve_data_set_with_mat4(
 void BKE_keyblock_data_set(Key *key, const int shape_index, const void *data)
 {
   const uint8_t *elements = data;
+  key_moved_index_clear(key, NULL);
   int index = 0;
   for (KeyBlock *kb = key->block.first; kb; kb = kb->next, index++) {
     if ((shape_index == -1) || (index == shape_index)) {
@@ -1675,6 +1982,112 @@ void BKE_keyblock_data_set(Key *key, const int shape_index, const void *data)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Key-Block Sparse Storage
+ *
+ * Corrective shapes usually only move a small part of the mesh, such coordinate key-blocks are
+ * stored in files as the indices and coordinates of the elements that differ from the reference
+ * key. The sparse data only exists in files, key-blocks are always dense in memory.
+ * \{ */
+
+/**
+ * Create the sparse representation of \a kb, the coordinates in \a r_data are stored exactly
+ * so saving and loading is lossless.
+ *
+ * \return false when the key-block can't be stored sparsely or wouldn't get any smaller.
+ */
+bool BKE_keyblock_sparse_data_create(const Key *key,
+                                     const KeyBlock *kb,
+                                     int **r_index,
+                                     float (**r_data)[3],
+                                     int *r_totelem)
+{
+  const KeyBlock *refkey = key->refkey;
+
+  if (key->elemsize != sizeof(float[3]) || key->elemstr[1] != IPO_FLOAT) {
+    return false;
+  }
+  if (kb == refkey || refkey == NULL || kb->data == NULL || refkey->data == NULL ||
+      kb->totelem != refkey->totelem) {
+    return false;
+  }
+
+  const float(*co)[3] = kb->data;
+  const float(*ref_co)[3] = refkey->data;
+  int totelem = 0;
+
+  for (int i = 0; i < kb->totelem; i++) {
+    if (!key_coord_equals_exact(co[i], ref_co[i])) {
+      totelem++;
+    }
+  }
+
+  /* An index and a coordinate take a third more space than a coordinate, only use sparse
+   * storage when it gives a significant saving. */
+  if (kb->totelem == 0 || totelem > kb->totelem / 2) {
+    return false;
+  }
+
+  /* Always store at least one element, files can't contain empty arrays. */
+  const bool is_unchanged = (totelem == 0);
+  if (is_unchanged) {
+    totelem = 1;
+  }
+
+  int *index = MEM_malloc_arrayN((size_t)totelem, sizeof(*index), __func__);
+  float(*data)[3] = MEM_malloc_arrayN((size_t)totelem, sizeof(*data), __func__);
+  int j = 0;
+
+  for (int i = 0; i < kb->totelem; i++) {
+    if (is_unchanged || !key_coord_equals_exact(co[i], ref_co[i])) {
+      index[j] = i;
+      copy_v3_v3(data[j], co[i]);
+      if (++j == totelem) {
+        break;
+      }
+    }
+  }
+
+  *r_index = index;
+  *r_data = data;
+  *r_totelem = totelem;
+  return true;
+}
+
+/**
+ * Replace the sparse data of \a kb read from a file with dense data,
+ * the reference key must already be dense.
+ */
+void BKE_keyblock_sparse_data_expand(const Key *key, KeyBlock *kb)
+{
+  const KeyBlock *refkey = key->refkey;
+  const int *index = kb->sparse_index;
+  const float(*data)[3] = kb->data;
+
+  BLI_assert(kb->sparse_index != NULL && kb != refkey);
+
+  float(*co)[3] = MEM_calloc_arrayN((size_t)kb->totelem, sizeof(*co), __func__);
+  if (refkey && refkey->data && refkey->totelem == kb->totelem) {
+    memcpy(co, refkey->data, sizeof(*co) * (size_t)kb->totelem);
+  }
+
+  if (data) {
+    for (int i = 0; i < kb->sparse_totelem; i++) {
+      if (index[i] >= 0 && index[i] < kb->totelem) {
+        copy_v3_v3(co[index[i]], data[i]);
+      }
+    }
+    MEM_freeN(kb->data);
+  }
+  MEM_freeN(kb->sparse_index);
+
+  kb->data = co;
+  kb->sparse_index = NULL;
+  kb->sparse_totelem = 0;
+}
+
+/** \} */
+
 bool BKE_key_idtype_support(const short id_type)
 {
   switch (id_type) {
@@ -1924,6 +2337,7 @@ void BKE_keyblock_update_from_lattice(Lattice *lt, KeyBlock *kb)
   int a, tot;
 
   BLI_assert(kb->totelem == lt->pntsu * lt->pntsv * lt->pntsw);
+  key_moved_index_clear(lt->key, kb);
 
   tot = kb->totelem;
   if (tot == 0) {
@@ -1992,7 +2406,7 @@ int BKE_keyblock_curve_element_count(ListBase *nurb)
   return tot;
 }
 
-void BKE_keyblock_update_from_curve(Curve *UNUSED(cu), KeyBlock *kb, ListBase *nurb)
+void BKE_keyblock_update_from_curve(Curve *cu, KeyBlock *kb, ListBase *nurb)
 {
   Nurb *nu;
   BezTriple *bezt;
@@ -2002,6 +2416,7 @@ void BKE_keyblock_update_from_curve(Curve *UNUSED(cu), KeyBlock *kb, ListBase *n
 
   /* count */
   BLI_assert(BKE_keyblock_curve_element_count(nurb) == kb->totelem);
+  key_moved_index_clear(cu->key, kb);
 
   tot = kb->totelem;
   if (tot == 0) {
@@ -2124,6 +2539,7 @@ void BKE_keyblock_update_from_mesh(Mesh *me, KeyBlock *kb)
   int a, tot;
 
   BLI_assert(me->totvert == kb->totelem);
+  key_moved_index_clear(me->key, kb);
 
   tot = me->totvert;
   if (tot == 0) {
@@ -2272,6 +2688,7 @@ void BKE_keyblock_update_from_vertcos(Object *ob, KeyBlock *kb, const float (*ve
     BLI_assert(0 == kb->totelem);
   }
 #endif
+  key_moved_index_clear(BKE_key_from_object(ob), kb);
 
   tot = kb->totelem;
   if (tot == 0) {
@@ -2407,6 +2824,8 @@ void BKE_keyblock_update_from_offset(Object *ob, KeyBlock *kb, const float (*ofs
   int a;
   float *fp = kb->data;
 
+  key_moved_index_clear(BKE_key_from_object(ob), kb);
+
   if (ELEM(ob->type, OB_MESH, OB_LATTICE)) {
     for (a = 0; a < kb->totelem; a++, fp += 3, ofs++) {
       add_v3_v3(fp, *ofs);
@@ -0,0 +1,335 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_deform.h"
+#include "BKE_key.h"
+
+#include "DNA_ID.h"
+#include "DNA_ipo_types.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+namespace blender::bke::tests {
+
+/* Mesh object with relative shape keys, without any Main database. */
+struct KeyTestRig {
+  Object *ob;
+  Mesh *me;
+  Key *key;
+  int verts_num;
+};
+
+static KeyTestRig key_test_rig_create(const int verts_num)
+{
+  KeyTestRig rig;
+  rig.verts_num = verts_num;
+  rig.key = static_cast<Key *>(MEM_callocN(sizeof(Key), __func__));
+  rig.key->type = KEY_RELATIVE;
+  rig.key->elemstr[0] = KEYELEM_FLOAT_LEN_COORD;
+  rig.key->elemstr[1] = IPO_FLOAT;
+  rig.key->elemsize = sizeof(float[KEYELEM_FLOAT_LEN_COORD]);
+  rig.key->uidgen = 1;
+
+  rig.me = static_cast<Mesh *>(MEM_callocN(sizeof(Mesh), __func__));
+  /* The ID code is how keys are found from object data. */
+  STRNCPY(rig.me->id.name, "MEKeyTestMesh");
+  rig.me->totvert = verts_num;
+  rig.me->key = rig.key;
+  rig.key->from = &rig.me->id;
+
+  rig.ob = static_cast<Object *>(MEM_callocN(sizeof(Object), __func__));
+  rig.ob->type = OB_MESH;
+  rig.ob->data = rig.me;
+  rig.ob->shapenr = 1;
+  return rig;
+}
+
+static void key_test_rig_free(KeyTestRig &rig)
+{
+  BKE_key_free_nolib(rig.key);
+  MEM_freeN(rig.key);
+  if (rig.me->dvert) {
+    BKE_defvert_array_free(rig.me->dvert, rig.verts_num);
+  }
+  MEM_freeN(rig.me);
+  BLI_freelistN(&rig.ob->defbase);
+  MEM_freeN(rig.ob);
+}
+
+/* Add a vertex group with the given weight for every vertex, vertices with zero weight are left
+ * out of the group. */
+static void key_test_rig_add_vgroup(KeyTestRig &rig,
+                                    const char *name,
+                                    float (*weight_fn)(const int index))
+{
+  bDeformGroup *defgroup = static_cast<bDeformGroup *>(
+      MEM_callocN(sizeof(bDeformGroup), __func__));
+  BLI_strncpy(defgroup->name, name, sizeof(defgroup->name));
+  BLI_addtail(&rig.ob->defbase, defgroup);
+  const int defgroup_index = BLI_listbase_count(&rig.ob->defbase) - 1;
+
+  if (rig.me->dvert == nullptr) {
+    rig.me->dvert = static_cast<MDeformVert *>(
+        MEM_calloc_arrayN(rig.verts_num, sizeof(MDeformVert), __func__));
+  }
+  for (int i = 0; i < rig.verts_num; i++) {
+    const float weight = weight_fn(i);
+    if (weight != 0.0f) {
+      BKE_defvert_ensure_index(&rig.me->dvert[i], defgroup_index)->weight = weight;
+    }
+  }
+}
+
+static float (*key_test_rig_add_shape(KeyTestRig &rig, const float value))[3]
+{
+  KeyBlock *kb = BKE_keyblock_add(rig.key, nullptr);
+  kb->data = MEM_calloc_arrayN(rig.verts_num, sizeof(float[3]), __func__);
+  kb->totelem = rig.verts_num;
+  kb->curval = value;
+  return static_cast<float(*)[3]>(kb->data);
+}
+
+/* Straightforward blend of all keys, one key after another. */
+static void key_test_rig_blend_reference(const KeyTestRig &rig, float (*r_cos)[3])
+{
+  const KeyBlock *refkey = rig.key->refkey;
+  memcpy(r_cos, refkey->data, sizeof(float[3]) * rig.verts_num);
+
+  LISTBASE_FOREACH (const KeyBlock *, kb, &rig.key->block) {
+    if (kb == refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f) {
+      continue;
+    }
+    const KeyBlock *refb = static_cast<const KeyBlock *>(
+        BLI_findlink(&rig.key->block, kb->relative));
+    const float(*from)[3] = static_cast<const float(*)[3]>(kb->data);
+    const float(*reffrom)[3] = static_cast<const float(*)[3]>(refb->data);
+    const int defgroup_index = (kb->vgroup[0] != '\0') ?
+                                   BKE_object_defgroup_name_index(rig.ob, kb->vgroup) :
+                                   -1;
+    for (int i = 0; i < rig.verts_num; i++) {
+      const float weight = (defgroup_index != -1) ?
+                               BKE_defvert_find_weight(&rig.me->dvert[i], defgroup_index) :
+                               1.0f;
+      for (int j = 0; j < 3; j++) {
+        r_cos[i][j] -= kb->curval * weight * (reffrom[i][j] - from[i][j]);
+      }
+    }
+  }
+}
+
+static void key_test_rig_expect_reference(const KeyTestRig &rig)
+{
+  int totelem = 0;
+  float(*cos)[3] = reinterpret_cast<float(*)[3]>(BKE_key_evaluate_object(rig.ob, &totelem));
+  ASSERT_NE(cos, nullptr);
+  EXPECT_EQ(totelem, rig.verts_num);
+
+  float(*expected)[3] = static_cast<float(*)[3]>(
+      MEM_malloc_arrayN(rig.verts_num, sizeof(float[3]), __func__));
+  key_test_rig_blend_reference(rig, expected);
+  for (int i = 0; i < rig.verts_num; i++) {
+    EXPECT_V3_NEAR(cos[i], expected[i], 1e-6f);
+  }
+
+  MEM_freeN(expected);
+  MEM_freeN(cos);
+}
+
+/* Synthetic face rig: many keys, each moving a small region of the mesh. */
+static void key_test_rig_fill_face(KeyTestRig &rig, const int keys_num, const int region_size)
+{
+  RNG *rng = BLI_rng_new(0);
+
+  float(*basis)[3] = key_test_rig_add_shape(rig, 0.0f);
+  for (int i = 0; i < rig.verts_num; i++) {
+    BLI_rng_get_float_unit_v3(rng, basis[i]);
+  }
+
+  for (int k = 0; k < keys_num; k++) {
+    float(*cos)[3] = key_test_rig_add_shape(rig, BLI_rng_get_float(rng));
+    memcpy(cos, basis, sizeof(float[3]) * rig.verts_num);
+
+    const int region_start = BLI_rng_get_int(rng) % (rig.verts_num - region_size);
+    for (int i = region_start; i < region_start + region_size; i++) {
+      float offset[3];
+      BLI_rng_get_float_unit_v3(rng, offset);
+      madd_v3_v3fl(cos[i], offset, 0.1f);
+    }
+  }
+
+  BLI_rng_free(rng);
+}
+
+TEST(key_evaluate, RelativeMesh)
+{
+  KeyTestRig rig = key_test_rig_create(3000);
+  key_test_rig_fill_face(rig, 8, 500);
+
+  /* Muted, disabled and chained keys. */
+  KeyBlock *kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 2));
+  kb->flag |= KEYBLOCK_MUTE;
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 3));
+  kb->curval = 0.0f;
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 4));
+  kb->relative = 1;
+
+  key_test_rig_expect_reference(rig);
+  key_test_rig_free(rig);
+}
+
+TEST(key_evaluate, RelativeMeshSmall)
+{
+  /* Less elements than a single blending chunk. */
+  KeyTestRig rig = key_test_rig_create(10);
+  key_test_rig_fill_face(rig, 3, 4);
+  key_test_rig_expect_reference(rig);
+  key_test_rig_free(rig);
+}
+
+static float key_test_weight_upper_half(const int index)
+{
+  return (index < 2500) ? 0.0f : (float)(index % 5) * 0.25f;
+}
+
+static float key_test_weight_sparse(const int index)
+{
+  return (index % 1500 == 7) ? 0.5f : 0.0f;
+}
+
+TEST(key_evaluate, RelativeMeshVertexGroups)
+{
+  /* Keys moving the whole mesh, limited by groups that leave out some of the blending chunks
+   * entirely, or only touch a few vertices of them. */
+  KeyTestRig rig = key_test_rig_create(5000);
+  key_test_rig_fill_face(rig, 4, 4900);
+  key_test_rig_add_vgroup(rig, "UpperHalf", key_test_weight_upper_half);
+  key_test_rig_add_vgroup(rig, "Sparse", key_test_weight_sparse);
+
+  KeyBlock *kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 1));
+  STRNCPY(kb->vgroup, "UpperHalf");
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 2));
+  STRNCPY(kb->vgroup, "Sparse");
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 3));
+  STRNCPY(kb->vgroup, "UpperHalf");
+  kb->relative = 2;
+
+  key_test_rig_expect_reference(rig);
+  key_test_rig_free(rig);
+}
+
+TEST(key_evaluate, RelativeMeshEvaluatedKey)
+{
+  KeyTestRig rig = key_test_rig_create(3000);
+  key_test_rig_fill_face(rig, 8, 100);
+  key_test_rig_add_vgroup(rig, "UpperHalf", key_test_weight_upper_half);
+  KeyBlock *kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 2));
+  STRNCPY(kb->vgroup, "UpperHalf");
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 3));
+  kb->relative = 1;
+  /* A key moving every vertex. */
+  float(*moved)[3] = key_test_rig_add_shape(rig, 0.5f);
+  for (int i = 0; i < rig.verts_num; i++) {
+    copy_v3_v3(moved[i], static_cast<float(*)[3]>(rig.key->refkey->data)[i]);
+    moved[i][2] += 1.0f;
+  }
+
+  /* Only key-blocks of evaluated keys index their moved elements. */
+  key_test_rig_expect_reference(rig);
+  EXPECT_EQ(static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 1))->moved_index, nullptr);
+
+  rig.key->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  key_test_rig_expect_reference(rig);
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 1));
+  ASSERT_NE(kb->moved_index, nullptr);
+  EXPECT_LE(kb->moved_totelem, 100);
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 3));
+  /* Relative to a key moving another region. */
+  ASSERT_NE(kb->moved_index, nullptr);
+  EXPECT_LE(kb->moved_totelem, 200);
+  kb = static_cast<KeyBlock *>(rig.key->block.last);
+  EXPECT_EQ(kb->moved_index, nullptr);
+  EXPECT_EQ(kb->moved_totelem, -1);
+
+  /* Writing through the key-block functions clears the indices. */
+  kb = static_cast<KeyBlock *>(BLI_findlink(&rig.key->block, 1));
+  float(*cos)[3] = static_cast<float(*)[3]>(MEM_dupallocN(kb->data));
+  cos[rig.verts_num - 1][0] += 1.0f;
+  BKE_keyblock_data_set(rig.key, 1, cos);
+  MEM_freeN(cos);
+  LISTBASE_FOREACH (KeyBlock *, kb_iter, &rig.key->block) {
+    EXPECT_EQ(kb_iter->moved_index, nullptr);
+  }
+  key_test_rig_expect_reference(rig);
+
+  rig.key->id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+  key_test_rig_free(rig);
+}
+
+TEST(keyblock_sparse, RoundTrip)
+{
+  KeyTestRig rig = key_test_rig_create(3000);
+  key_test_rig_fill_face(rig, 2, 100);
+  float(*basis)[3] = static_cast<float(*)[3]>(rig.key->refkey->data);
+  basis[5][1] = 0.0f;
+  /* Unchanged key, still stored sparsely. */
+  float(*unchanged)[3] = key_test_rig_add_shape(rig, 1.0f);
+  memcpy(unchanged, basis, sizeof(float[3]) * rig.verts_num);
+  /* Negative zero compares equal to zero, but must be stored to be bit exact. */
+  float(*signed_zero)[3] = key_test_rig_add_shape(rig, 1.0f);
+  memcpy(signed_zero, basis, sizeof(float[3]) * rig.verts_num);
+  signed_zero[5][1] = -0.0f;
+
+  LISTBASE_FOREACH (KeyBlock *, kb, &rig.key->block) {
+    int *index;
+    float(*data)[3];
+    int totelem;
+    if (!BKE_keyblock_sparse_data_create(rig.key, kb, &index, &data, &totelem)) {
+      EXPECT_EQ(kb, rig.key->refkey);
+      continue;
+    }
+    /* The moved region, plus the coordinate zeroed in the basis after the keys were made. */
+    EXPECT_LE(totelem, 101);
+
+    KeyBlock kb_sparse = *kb;
+    kb_sparse.data = data;
+    kb_sparse.sparse_index = index;
+    kb_sparse.sparse_totelem = totelem;
+    BKE_keyblock_sparse_data_expand(rig.key, &kb_sparse);
+
+    EXPECT_EQ(kb_sparse.sparse_index, nullptr);
+    EXPECT_EQ(memcmp(kb_sparse.data, kb->data, sizeof(float[3]) * rig.verts_num), 0);
+    MEM_freeN(kb_sparse.data);
+  }
+
+  key_test_rig_free(rig);
+}
+
+}  // namespace blender::bke::tests
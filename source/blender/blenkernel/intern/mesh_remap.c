@@ -36,6 +36,8 @@
 #include "BLI_memarena.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_bvhutils.h"
@@ -367,16 +369,20 @@ void BKE_mesh_remap_free(MeshPairRemap *map)
   map->mem = NULL;
 }
 
-static void mesh_remap_item_define(MeshPairRemap *map,
-                                   const int index,
-                                   const float UNUSED(hit_dist),
-                                   const int island,
-                                   const int sources_num,
-                                   const int *indices_src,
-                                   const float *weights_src)
+/**
+ * \param mem: Memory to allocate the sources from,
+ * the map's own arena or the one of the calling thread.
+ */
+static void mesh_remap_item_define_ex(MeshPairRemap *map,
+                                      MemArena *mem,
+                                      const int index,
+                                      const float UNUSED(hit_dist),
+                                      const int island,
+                                      const int sources_num,
+                                      const int *indices_src,
+                                      const float *weights_src)
 {
   MeshPairRemapItem *mapit = &map->items[index];
-  MemArena *mem = map->mem;
 
   if (sources_num) {
     mapit->sources_num = sources_num;
@@ -397,6 +403,18 @@ static void mesh_remap_item_define(MeshPairRemap *map,
   mapit->island = island;
 }
 
+static void mesh_remap_item_define(MeshPairRemap *map,
+                                   const int index,
+                                   const float hit_dist,
+                                   const int island,
+                                   const int sources_num,
+                                   const int *indices_src,
+                                   const float *weights_src)
+{
+  mesh_remap_item_define_ex(
+      map, map->mem, index, hit_dist, island, sources_num, indices_src, weights_src);
+}
+
 void BKE_mesh_remap_item_define_invalid(MeshPairRemap *map, const int index)
 {
   mesh_remap_item_define(map, index, FLT_MAX, 0, 0, NULL, NULL);
@@ -491,6 +509,268 @@ typedef struct IslandResult {
 /* Will be enough in 99% of cases. */
 #define MREMAP_DEFAULT_BUFSIZE 32
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Mapping
+ *
+ * Destination elements are mapped in parallel, in chunks of fixed size so the result doesn't
+ * depend on threading (nearest searches use the previous hit of the chunk as a hint).
+ * Each thread defines its items from its own memory arena, merged into the map's one when done.
+ * \{ */
+
+#define MREMAP_CHUNK_SIZE 256
+
+/** Must be the first member of the user-data of all threaded mapping tasks. */
+typedef struct MeshRemapThreadData {
+  MeshPairRemap *map;
+  ThreadMutex mem_lock;
+} MeshRemapThreadData;
+
+typedef struct MeshRemapTLS {
+  MemArena *mem;
+
+  /* Buffers for #mesh_remap_interp_poly_data_get. */
+  size_t buff_size;
+  float (*vcos)[3];
+  int *indices;
+  float *weights;
+} MeshRemapTLS;
+
+static void mesh_remap_thread_data_init(MeshRemapThreadData *thread_data, MeshPairRemap *map)
+{
+  thread_data->map = map;
+  BLI_mutex_init(&thread_data->mem_lock);
+}
+
+static void mesh_remap_thread_data_end(MeshRemapThreadData *thread_data)
+{
+  BLI_mutex_end(&thread_data->mem_lock);
+}
+
+static MemArena *mesh_remap_tls_mem_ensure(MeshRemapTLS *remap_tls)
+{
+  if (remap_tls->mem == NULL) {
+    remap_tls->mem = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+  }
+  return remap_tls->mem;
+}
+
+static void mesh_remap_tls_buffers_ensure(MeshRemapTLS *remap_tls)
+{
+  if (remap_tls->vcos == NULL) {
+    remap_tls->buff_size = MREMAP_DEFAULT_BUFSIZE;
+    remap_tls->vcos = MEM_mallocN(sizeof(*remap_tls->vcos) * remap_tls->buff_size, __func__);
+    remap_tls->indices = MEM_mallocN(sizeof(*remap_tls->indices) * remap_tls->buff_size,
+                                     __func__);
+    remap_tls->weights = MEM_mallocN(sizeof(*remap_tls->weights) * remap_tls->buff_size,
+                                     __func__);
+  }
+}
+
+/** Hand over the items memory to the map, and free the thread's buffers. */
+static void mesh_remap_tls_free(MeshRemapThreadData *thread_data, MeshRemapTLS *remap_tls)
+{
+  if (remap_tls->mem) {
+    BLI_mutex_lock(&thread_data->mem_lock);
+    BLI_memarena_merge(thread_data->map->mem, remap_tls->mem);
+    BLI_mutex_unlock(&thread_data->mem_lock);
+    BLI_memarena_free(remap_tls->mem);
+    remap_tls->mem = NULL;
+  }
+  MEM_SAFE_FREE(remap_tls->vcos);
+  MEM_SAFE_FREE(remap_tls->indices);
+  MEM_SAFE_FREE(remap_tls->weights);
+}
+
+static void mesh_remap_tls_free_cb(const void *__restrict userdata, void *__restrict chunk)
+{
+  mesh_remap_tls_free((MeshRemapThreadData *)userdata, chunk);
+}
+
+static void mesh_remap_parallel_settings(TaskParallelSettings *settings,
+                                         MeshRemapTLS *remap_tls,
+                                         const int items_num)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (items_num > MREMAP_CHUNK_SIZE);
+  settings->userdata_chunk = remap_tls;
+  settings->userdata_chunk_size = sizeof(*remap_tls);
+  settings->func_free = mesh_remap_tls_free_cb;
+}
+
+static int mesh_remap_chunks_num(const int items_num)
+{
+  return (items_num + MREMAP_CHUNK_SIZE - 1) / MREMAP_CHUNK_SIZE;
+}
+
+/** \} */
+
+typedef struct MeshRemapVertsData {
+  MeshRemapThreadData thread_data;
+
+  int mode;
+  const SpaceTransform *space_transform;
+  float max_dist;
+  float max_dist_sq;
+  float ray_radius;
+
+  const MVert *verts_dst;
+  int numverts_dst;
+
+  BVHTreeFromMesh *treedata;
+  const MEdge *edges_src;
+  const MPoly *polys_src;
+  MLoop *loops_src;
+  const float (*vcos_src)[3];
+} MeshRemapVertsData;
+
+static void mesh_remap_calc_verts_chunk(void *__restrict userdata,
+                                        const int chunk,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const MeshRemapVertsData *data = userdata;
+  MeshRemapTLS *remap_tls = tls->userdata_chunk;
+  MeshPairRemap *r_map = data->thread_data.map;
+  MemArena *mem = mesh_remap_tls_mem_ensure(remap_tls);
+
+  const int mode = data->mode;
+  const SpaceTransform *space_transform = data->space_transform;
+  const MVert *verts_dst = data->verts_dst;
+  BVHTreeFromMesh *treedata = data->treedata;
+
+  const float full_weight = 1.0f;
+  const int start = chunk * MREMAP_CHUNK_SIZE;
+  const int end = min_ii(start + MREMAP_CHUNK_SIZE, data->numverts_dst);
+
+  BVHTreeNearest nearest = {0};
+  BVHTreeRayHit rayhit = {0};
+  float hit_dist;
+  float tmp_co[3], tmp_no[3];
+
+  nearest.index = -1;
+
+  if (mode & MREMAP_USE_POLY) {
+    mesh_remap_tls_buffers_ensure(remap_tls);
+  }
+
+  for (int i = start; i < end; i++) {
+    copy_v3_v3(tmp_co, verts_dst[i].co);
+
+    if (mode == MREMAP_MODE_VERT_POLYINTERP_VNORPROJ) {
+      normal_short_to_float_v3(tmp_no, verts_dst[i].no);
+
+      /* Convert the vertex to tree coordinates, if needed. */
+      if (space_transform) {
+        BLI_space_transform_apply(space_transform, tmp_co);
+        BLI_space_transform_apply_normal(space_transform, tmp_no);
+      }
+
+      if (mesh_remap_bvhtree_query_raycast(
+              treedata, &rayhit, tmp_co, tmp_no, data->ray_radius, data->max_dist, &hit_dist)) {
+        const MLoopTri *lt = &treedata->looptri[rayhit.index];
+        const MPoly *mp_src = &data->polys_src[lt->poly];
+        const int sources_num = mesh_remap_interp_poly_data_get(mp_src,
+                                                                data->loops_src,
+                                                                data->vcos_src,
+                                                                rayhit.co,
+                                                                &remap_tls->buff_size,
+                                                                &remap_tls->vcos,
+                                                                false,
+                                                                &remap_tls->indices,
+                                                                &remap_tls->weights,
+                                                                true,
+                                                                NULL);
+
+        mesh_remap_item_define_ex(
+            r_map, mem, i, hit_dist, 0, sources_num, remap_tls->indices, remap_tls->weights);
+      }
+      else {
+        /* No source for this dest vertex! */
+        BKE_mesh_remap_item_define_invalid(r_map, i);
+      }
+      continue;
+    }
+
+    /* Convert the vertex to tree coordinates, if needed. */
+    if (space_transform) {
+      BLI_space_transform_apply(space_transform, tmp_co);
+    }
+
+    if (!mesh_remap_bvhtree_query_nearest(
+            treedata, &nearest, tmp_co, data->max_dist_sq, &hit_dist)) {
+      /* No source for this dest vertex! */
+      BKE_mesh_remap_item_define_invalid(r_map, i);
+      continue;
+    }
+
+    if (mode == MREMAP_MODE_VERT_NEAREST) {
+      mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 1, &nearest.index, &full_weight);
+    }
+    else if (mode & MREMAP_USE_EDGE) {
+      const MEdge *me = &data->edges_src[nearest.index];
+      const float *v1cos = data->vcos_src[me->v1];
+      const float *v2cos = data->vcos_src[me->v2];
+
+      if (mode == MREMAP_MODE_VERT_EDGE_NEAREST) {
+        const float dist_v1 = len_squared_v3v3(tmp_co, v1cos);
+        const float dist_v2 = len_squared_v3v3(tmp_co, v2cos);
+        const int index = (int)((dist_v1 > dist_v2) ? me->v2 : me->v1);
+        mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 1, &index, &full_weight);
+      }
+      else if (mode == MREMAP_MODE_VERT_EDGEINTERP_NEAREST) {
+        int indices[2];
+        float weights[2];
+
+        indices[0] = (int)me->v1;
+        indices[1] = (int)me->v2;
+
+        /* Weight is inverse of point factor here... */
+        weights[0] = line_point_factor_v3(tmp_co, v2cos, v1cos);
+        CLAMP(weights[0], 0.0f, 1.0f);
+        weights[1] = 1.0f - weights[0];
+
+        mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 2, indices, weights);
+      }
+    }
+    else {
+      const MLoopTri *lt = &treedata->looptri[nearest.index];
+      const MPoly *mp = &data->polys_src[lt->poly];
+
+      if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
+        int index;
+        mesh_remap_interp_poly_data_get(mp,
+                                        data->loops_src,
+                                        data->vcos_src,
+                                        nearest.co,
+                                        &remap_tls->buff_size,
+                                        &remap_tls->vcos,
+                                        false,
+                                        &remap_tls->indices,
+                                        &remap_tls->weights,
+                                        false,
+                                        &index);
+
+        mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 1, &index, &full_weight);
+      }
+      else if (mode == MREMAP_MODE_VERT_POLYINTERP_NEAREST) {
+        const int sources_num = mesh_remap_interp_poly_data_get(mp,
+                                                                data->loops_src,
+                                                                data->vcos_src,
+                                                                nearest.co,
+                                                                &remap_tls->buff_size,
+                                                                &remap_tls->vcos,
+                                                                false,
+                                                                &remap_tls->indices,
+                                                                &remap_tls->weights,
+                                                                true,
+                                                                NULL);
+
+        mesh_remap_item_define_ex(
+            r_map, mem, i, hit_dist, 0, sources_num, remap_tls->indices, remap_tls->weights);
+      }
+    }
+  }
+}
+
 void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
                                          const SpaceTransform *space_transform,
                                          const float max_dist,
@@ -502,7 +782,6 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
                                          MeshPairRemap *r_map)
 {
   const float full_weight = 1.0f;
-  const float max_dist_sq = max_dist * max_dist;
   int i;
 
   BLI_assert(mode & MREMAP_MODE_VERT);
@@ -515,202 +794,61 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
       mesh_remap_item_define(r_map, i, FLT_MAX, 0, 1, &i, &full_weight);
     }
   }
-  else {
+  else if (ELEM(mode,
+                MREMAP_MODE_VERT_NEAREST,
+                MREMAP_MODE_VERT_EDGE_NEAREST,
+                MREMAP_MODE_VERT_EDGEINTERP_NEAREST,
+                MREMAP_MODE_VERT_POLY_NEAREST,
+                MREMAP_MODE_VERT_POLYINTERP_NEAREST,
+                MREMAP_MODE_VERT_POLYINTERP_VNORPROJ)) {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
-    float hit_dist;
-    float tmp_co[3], tmp_no[3];
+    float(*vcos_src)[3] = NULL;
 
     if (mode == MREMAP_MODE_VERT_NEAREST) {
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_VERTS, 2);
-      nearest.index = -1;
-
-      for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest.index, &full_weight);
-        }
-        else {
-          /* No source for this dest vertex! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
     }
-    else if (ELEM(mode, MREMAP_MODE_VERT_EDGE_NEAREST, MREMAP_MODE_VERT_EDGEINTERP_NEAREST)) {
-      MEdge *edges_src = me_src->medge;
-      float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
-
+    else if (mode & MREMAP_USE_EDGE) {
+      vcos_src = BKE_mesh_vert_coords_alloc(me_src, NULL);
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_EDGES, 2);
-      nearest.index = -1;
-
-      for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          MEdge *me = &edges_src[nearest.index];
-          const float *v1cos = vcos_src[me->v1];
-          const float *v2cos = vcos_src[me->v2];
-
-          if (mode == MREMAP_MODE_VERT_EDGE_NEAREST) {
-            const float dist_v1 = len_squared_v3v3(tmp_co, v1cos);
-            const float dist_v2 = len_squared_v3v3(tmp_co, v2cos);
-            const int index = (int)((dist_v1 > dist_v2) ? me->v2 : me->v1);
-            mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &index, &full_weight);
-          }
-          else if (mode == MREMAP_MODE_VERT_EDGEINTERP_NEAREST) {
-            int indices[2];
-            float weights[2];
-
-            indices[0] = (int)me->v1;
-            indices[1] = (int)me->v2;
-
-            /* Weight is inverse of point factor here... */
-            weights[0] = line_point_factor_v3(tmp_co, v2cos, v1cos);
-            CLAMP(weights[0], 0.0f, 1.0f);
-            weights[1] = 1.0f - weights[0];
-
-            mesh_remap_item_define(r_map, i, hit_dist, 0, 2, indices, weights);
-          }
-        }
-        else {
-          /* No source for this dest vertex! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
-
-      MEM_freeN(vcos_src);
     }
-    else if (ELEM(mode,
-                  MREMAP_MODE_VERT_POLY_NEAREST,
-                  MREMAP_MODE_VERT_POLYINTERP_NEAREST,
-                  MREMAP_MODE_VERT_POLYINTERP_VNORPROJ)) {
-      MPoly *polys_src = me_src->mpoly;
-      MLoop *loops_src = me_src->mloop;
-      float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
-
-      size_t tmp_buff_size = MREMAP_DEFAULT_BUFSIZE;
-      float(*vcos)[3] = MEM_mallocN(sizeof(*vcos) * tmp_buff_size, __func__);
-      int *indices = MEM_mallocN(sizeof(*indices) * tmp_buff_size, __func__);
-      float *weights = MEM_mallocN(sizeof(*weights) * tmp_buff_size, __func__);
-
+    else {
+      vcos_src = BKE_mesh_vert_coords_alloc(me_src, NULL);
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
+    }
 
-      if (mode == MREMAP_MODE_VERT_POLYINTERP_VNORPROJ) {
-        for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-          normal_short_to_float_v3(tmp_no, verts_dst[i].no);
-
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-            BLI_space_transform_apply_normal(space_transform, tmp_no);
-          }
-
-          if (mesh_remap_bvhtree_query_raycast(
-                  &treedata, &rayhit, tmp_co, tmp_no, ray_radius, max_dist, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[rayhit.index];
-            MPoly *mp_src = &polys_src[lt->poly];
-            const int sources_num = mesh_remap_interp_poly_data_get(mp_src,
-                                                                    loops_src,
-                                                                    (const float(*)[3])vcos_src,
-                                                                    rayhit.co,
-                                                                    &tmp_buff_size,
-                                                                    &vcos,
-                                                                    false,
-                                                                    &indices,
-                                                                    &weights,
-                                                                    true,
-                                                                    NULL);
-
-            mesh_remap_item_define(r_map, i, hit_dist, 0, sources_num, indices, weights);
-          }
-          else {
-            /* No source for this dest vertex! */
-            BKE_mesh_remap_item_define_invalid(r_map, i);
-          }
-        }
-      }
-      else {
-        nearest.index = -1;
-
-        for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-          }
-
-          if (mesh_remap_bvhtree_query_nearest(
-                  &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[nearest.index];
-            MPoly *mp = &polys_src[lt->poly];
-
-            if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
-              int index;
-              mesh_remap_interp_poly_data_get(mp,
-                                              loops_src,
-                                              (const float(*)[3])vcos_src,
-                                              nearest.co,
-                                              &tmp_buff_size,
-                                              &vcos,
-                                              false,
-                                              &indices,
-                                              &weights,
-                                              false,
-                                              &index);
-
-              mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &index, &full_weight);
-            }
-            else if (mode == MREMAP_MODE_VERT_POLYINTERP_NEAREST) {
-              const int sources_num = mesh_remap_interp_poly_data_get(mp,
-                                                                      loops_src,
-                                                                      (const float(*)[3])vcos_src,
-                                                                      nearest.co,
-                                                                      &tmp_buff_size,
-                                                                      &vcos,
-                                                                      false,
-                                                                      &indices,
-                                                                      &weights,
-                                                                      true,
-                                                                      NULL);
-
-              mesh_remap_item_define(r_map, i, hit_dist, 0, sources_num, indices, weights);
-            }
-          }
-          else {
-            /* No source for this dest vertex! */
-            BKE_mesh_remap_item_define_invalid(r_map, i);
-          }
-        }
-      }
+    MeshRemapVertsData data = {
+        .mode = mode,
+        .space_transform = space_transform,
+        .max_dist = max_dist,
+        .max_dist_sq = max_dist * max_dist,
+        .ray_radius = ray_radius,
+        .verts_dst = verts_dst,
+        .numverts_dst = numverts_dst,
+        .treedata = &treedata,
+        .edges_src = me_src->medge,
+        .polys_src = me_src->mpoly,
+        .loops_src = me_src->mloop,
+        .vcos_src = (const float(*)[3])vcos_src,
+    };
+    mesh_remap_thread_data_init(&data.thread_data, r_map);
+
+    MeshRemapTLS remap_tls = {NULL};
+    TaskParallelSettings settings;
+    mesh_remap_parallel_settings(&settings, &remap_tls, numverts_dst);
+    BLI_task_parallel_range(
+        0, mesh_remap_chunks_num(numverts_dst), &data, mesh_remap_calc_verts_chunk, &settings);
+
+    mesh_remap_thread_data_end(&data.thread_data);
 
+    if (vcos_src) {
       MEM_freeN(vcos_src);
-      MEM_freeN(vcos);
-      MEM_freeN(indices);
-      MEM_freeN(weights);
-    }
-    else {
-      CLOG_WARN(&LOG, "Unsupported mesh-to-mesh vertex mapping mode (%d)!", mode);
-      memset(r_map->items, 0, sizeof(*r_map->items) * (size_t)numverts_dst);
     }
-
     free_bvhtree_from_mesh(&treedata);
   }
+  else {
+    CLOG_WARN(&LOG, "Unsupported mesh-to-mesh vertex mapping mode (%d)!", mode);
+    memset(r_map->items, 0, sizeof(*r_map->items) * (size_t)numverts_dst);
+  }
 }
 
 void BKE_mesh_remap_calc_edges_from_mesh(const int mode,
@@ -1245,52 +1383,711 @@ static float mesh_remap_calc_loops_astar_f_cost(BLI_AStarGraph *as_graph,
 
 #define ASTAR_STEPS_MAX 64
 
-void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
-                                         const SpaceTransform *space_transform,
-                                         const float max_dist,
-                                         const float ray_radius,
-                                         MVert *verts_dst,
-                                         const int numverts_dst,
-                                         MEdge *edges_dst,
-                                         const int numedges_dst,
-                                         MLoop *loops_dst,
-                                         const int numloops_dst,
-                                         MPoly *polys_dst,
-                                         const int numpolys_dst,
-                                         CustomData *ldata_dst,
-                                         CustomData *pdata_dst,
-                                         const bool use_split_nors_dst,
-                                         const float split_angle_dst,
-                                         const bool dirty_nors_dst,
-                                         Mesh *me_src,
-                                         MeshRemapIslandsCalc gen_islands_src,
-                                         const float islands_precision_src,
-                                         MeshPairRemap *r_map)
+typedef struct MeshRemapLoopsData {
+  MeshRemapThreadData thread_data;
+
+  int mode;
+  const SpaceTransform *space_transform;
+  float max_dist;
+  float max_dist_sq;
+  float ray_radius;
+
+  MVert *verts_dst;
+  MLoop *loops_dst;
+  MPoly *polys_dst;
+  int numpolys_dst;
+  float (*poly_nors_dst)[3];
+  float (*loop_nors_dst)[3];
+
+  bool use_from_vert;
+  bool use_islands;
+  MeshIslandStore *island_store;
+  int num_trees;
+  BVHTreeFromMesh *treedata;
+  BLI_AStarGraph *as_graphdata;
+  int isld_steps_src;
+
+  MVert *verts_src;
+  float (*vcos_src)[3];
+  MLoop *loops_src;
+  MPoly *polys_src;
+  const MLoopTri *looptri_src;
+  float (*poly_nors_src)[3];
+  float (*loop_nors_src)[3];
+  float (*poly_cents_src)[3];
+
+  MeshElemMap *vert_to_loop_map_src;
+  MeshElemMap *vert_to_poly_map_src;
+  MeshElemMap *poly_to_looptri_map_src;
+  int *loop_to_poly_map_src;
+} MeshRemapLoopsData;
+
+typedef struct MeshRemapLoopsTLS {
+  MeshRemapTLS remap_tls;
+
+  /* One array of results per tree, as large as the biggest dest poly processed so far. */
+  IslandResult **islands_res;
+  size_t islands_res_buff_size;
+
+  BLI_AStarSolution as_solution;
+} MeshRemapLoopsTLS;
+
+static void mesh_remap_loops_tls_free_cb(const void *__restrict userdata, void *__restrict chunk)
+{
+  const MeshRemapLoopsData *data = userdata;
+  MeshRemapLoopsTLS *loops_tls = chunk;
+
+  mesh_remap_tls_free((MeshRemapThreadData *)userdata, &loops_tls->remap_tls);
+
+  if (loops_tls->islands_res) {
+    for (int tindex = 0; tindex < data->num_trees; tindex++) {
+      MEM_freeN(loops_tls->islands_res[tindex]);
+    }
+    MEM_freeN(loops_tls->islands_res);
+  }
+  BLI_astar_solution_free(&loops_tls->as_solution);
+}
+
+/* Map all loops of a given dest poly, checking them against all source islands. */
+static void mesh_remap_calc_loops_poly(const MeshRemapLoopsData *data,
+                                       MeshRemapLoopsTLS *loops_tls,
+                                       MemArena *mem,
+                                       const int pidx_dst)
 {
+  MeshPairRemap *r_map = data->thread_data.map;
+  MeshRemapTLS *remap_tls = &loops_tls->remap_tls;
+  IslandResult **islands_res = loops_tls->islands_res;
+  BLI_AStarSolution *as_solution = &loops_tls->as_solution;
+
   const float full_weight = 1.0f;
-  const float max_dist_sq = max_dist * max_dist;
+  const int mode = data->mode;
+  const SpaceTransform *space_transform = data->space_transform;
+  const float max_dist = data->max_dist;
+  const float max_dist_sq = data->max_dist_sq;
+  const float ray_radius = data->ray_radius;
+
+  const bool use_from_vert = data->use_from_vert;
+  const bool use_islands = data->use_islands;
+  const MeshIslandStore *island_store = data->island_store;
+  const int num_trees = data->num_trees;
+  BVHTreeFromMesh *treedata = data->treedata;
+  BLI_AStarGraph *as_graphdata = data->as_graphdata;
+  const int isld_steps_src = data->isld_steps_src;
+
+  MVert *verts_dst = data->verts_dst;
+  MLoop *loops_dst = data->loops_dst;
+  MPoly *mp_dst = &data->polys_dst[pidx_dst];
+  float(*poly_nors_dst)[3] = data->poly_nors_dst;
+  float(*loop_nors_dst)[3] = data->loop_nors_dst;
+
+  MVert *verts_src = data->verts_src;
+  const float(*vcos_src)[3] = (const float(*)[3])data->vcos_src;
+  MLoop *loops_src = data->loops_src;
+  MPoly *polys_src = data->polys_src;
+  const MLoopTri *looptri_src = data->looptri_src;
+  float(*poly_nors_src)[3] = data->poly_nors_src;
+  float(*loop_nors_src)[3] = data->loop_nors_src;
+  float(*poly_cents_src)[3] = data->poly_cents_src;
+
+  MeshElemMap *vert_to_loop_map_src = data->vert_to_loop_map_src;
+  MeshElemMap *vert_to_poly_map_src = data->vert_to_poly_map_src;
+  MeshElemMap *poly_to_looptri_map_src = data->poly_to_looptri_map_src;
+  const int *loop_to_poly_map_src = data->loop_to_poly_map_src;
+
+  BVHTreeNearest nearest = {0};
+  BVHTreeRayHit rayhit = {0};
+  float hit_dist;
+  float tmp_co[3], tmp_no[3];
 
+  MLoop *ml_src, *ml_dst;
+  MPoly *mp_src;
+  int tindex, lidx_dst, plidx_dst, pidx_src, lidx_src, plidx_src;
   int i;
 
-  BLI_assert(mode & MREMAP_MODE_LOOP);
-  BLI_assert((islands_precision_src >= 0.0f) && (islands_precision_src <= 1.0f));
+  float pnor_dst[3];
 
-  BKE_mesh_remap_init(r_map, numloops_dst);
+  /* Only in use_from_vert case, we may need polys' centers as fallback
+   * in case we cannot decide which corner to use from normals only. */
+  float pcent_dst[3];
+  bool pcent_dst_valid = false;
 
-  if (mode == MREMAP_MODE_TOPOLOGY) {
-    /* In topology mapping, we assume meshes are identical, islands included! */
-    BLI_assert(numloops_dst == me_src->totloop);
-    for (i = 0; i < numloops_dst; i++) {
-      mesh_remap_item_define(r_map, i, FLT_MAX, 0, 1, &i, &full_weight);
+  if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
+    copy_v3_v3(pnor_dst, poly_nors_dst[pidx_dst]);
+    if (space_transform) {
+      BLI_space_transform_apply_normal(space_transform, pnor_dst);
     }
   }
-  else {
-    BVHTreeFromMesh *treedata = NULL;
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
-    int num_trees = 0;
-    float hit_dist;
-    float tmp_co[3], tmp_no[3];
+
+  if ((size_t)mp_dst->totloop > loops_tls->islands_res_buff_size) {
+    loops_tls->islands_res_buff_size = (size_t)mp_dst->totloop + MREMAP_DEFAULT_BUFSIZE;
+    for (tindex = 0; tindex < num_trees; tindex++) {
+      islands_res[tindex] = MEM_reallocN(
+          islands_res[tindex], sizeof(**islands_res) * loops_tls->islands_res_buff_size);
+    }
+  }
+
+  for (tindex = 0; tindex < num_trees; tindex++) {
+    BVHTreeFromMesh *tdata = &treedata[tindex];
+
+    ml_dst = &loops_dst[mp_dst->loopstart];
+    for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++, ml_dst++) {
+      if (use_from_vert) {
+        MeshElemMap *vert_to_refelem_map_src = NULL;
+
+        copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+        nearest.index = -1;
+
+        /* Convert the vertex to tree coordinates, if needed. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+        }
+
+        if (mesh_remap_bvhtree_query_nearest(
+                tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
+          float(*nor_dst)[3];
+          float(*nors_src)[3];
+          float best_nor_dot = -2.0f;
+          float best_sqdist_fallback = FLT_MAX;
+          int best_index_src = -1;
+
+          if (mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) {
+            copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
+            if (space_transform) {
+              BLI_space_transform_apply_normal(space_transform, tmp_no);
+            }
+            nor_dst = &tmp_no;
+            nors_src = loop_nors_src;
+            vert_to_refelem_map_src = vert_to_loop_map_src;
+          }
+          else { /* if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) { */
+            nor_dst = &pnor_dst;
+            nors_src = poly_nors_src;
+            vert_to_refelem_map_src = vert_to_poly_map_src;
+          }
+
+          for (i = vert_to_refelem_map_src[nearest.index].count; i--;) {
+            const int index_src = vert_to_refelem_map_src[nearest.index].indices[i];
+            BLI_assert(index_src != -1);
+            const float dot = dot_v3v3(nors_src[index_src], *nor_dst);
+
+            pidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
+                            loop_to_poly_map_src[index_src] :
+                            index_src);
+            /* WARNING! This is not the *real* lidx_src in case of POLYNOR, we only use it
+             *          to check we stay on current island (all loops from a given poly are
+             *          on same island!). */
+            lidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
+                            index_src :
+                            polys_src[pidx_src].loopstart);
+
+            /* A same vert may be at the boundary of several islands! Hence, we have to ensure
+             * poly/loop we are currently considering *belongs* to current island! */
+            if (use_islands && island_store->items_to_islands[lidx_src] != tindex) {
+              continue;
+            }
+
+            if (dot > best_nor_dot - 1e-6f) {
+              /* We need something as fallback decision in case dest normal matches several
+               * source normals (see T44522), using distance between polys' centers here. */
+              float *pcent_src;
+              float sqdist;
+
+              mp_src = &polys_src[pidx_src];
+              ml_src = &loops_src[mp_src->loopstart];
+
+              if (!pcent_dst_valid) {
+                BKE_mesh_calc_poly_center(
+                    mp_dst, &loops_dst[mp_dst->loopstart], verts_dst, pcent_dst);
+                pcent_dst_valid = true;
+              }
+              pcent_src = poly_cents_src[pidx_src];
+              sqdist = len_squared_v3v3(pcent_dst, pcent_src);
+
+              if ((dot > best_nor_dot + 1e-6f) || (sqdist < best_sqdist_fallback)) {
+                best_nor_dot = dot;
+                best_sqdist_fallback = sqdist;
+                best_index_src = index_src;
+              }
+            }
+          }
+          if (best_index_src == -1) {
+            /* We found no item to map back from closest vertex... */
+            best_nor_dot = -1.0f;
+            hit_dist = FLT_MAX;
+          }
+          else if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
+            /* Our best_index_src is a poly one for now!
+             * Have to find its loop matching our closest vertex. */
+            mp_src = &polys_src[best_index_src];
+            ml_src = &loops_src[mp_src->loopstart];
+            for (plidx_src = 0; plidx_src < mp_src->totloop; plidx_src++, ml_src++) {
+              if ((int)ml_src->v == nearest.index) {
+                best_index_src = plidx_src + mp_src->loopstart;
+                break;
+              }
+            }
+          }
+          best_nor_dot = (best_nor_dot + 1.0f) * 0.5f;
+          islands_res[tindex][plidx_dst].factor = hit_dist ? (best_nor_dot / hit_dist) : 1e18f;
+          islands_res[tindex][plidx_dst].hit_dist = hit_dist;
+          islands_res[tindex][plidx_dst].index_src = best_index_src;
+        }
+        else {
+          /* No source for this dest loop! */
+          islands_res[tindex][plidx_dst].factor = 0.0f;
+          islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
+          islands_res[tindex][plidx_dst].index_src = -1;
+        }
+      }
+      else if (mode & MREMAP_USE_NORPROJ) {
+        int n = (ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
+        float w = 1.0f;
+
+        copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+        copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
+
+        /* We do our transform here, since we may do several raycast/nearest queries. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+          BLI_space_transform_apply_normal(space_transform, tmp_no);
+        }
+
+        while (n--) {
+          if (mesh_remap_bvhtree_query_raycast(
+                  tdata, &rayhit, tmp_co, tmp_no, ray_radius / w, max_dist, &hit_dist)) {
+            islands_res[tindex][plidx_dst].factor = (hit_dist ? (1.0f / hit_dist) : 1e18f) * w;
+            islands_res[tindex][plidx_dst].hit_dist = hit_dist;
+            islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[rayhit.index].poly;
+            copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, rayhit.co);
+            break;
+          }
+          /* Next iteration will get bigger radius but smaller weight! */
+          w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
+        }
+        if (n == -1) {
+          /* Fallback to 'nearest' hit here, loops usually comes in 'face group', not good to
+           * have only part of one dest face's loops to map to source.
+           * Note that since we give this a null weight, if whole weight for a given face
+           * is null, it means none of its loop mapped to this source island,
+           * hence we can skip it later.
+           */
+          copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+          nearest.index = -1;
+
+          /* Convert the vertex to tree coordinates, if needed. */
+          if (space_transform) {
+            BLI_space_transform_apply(space_transform, tmp_co);
+          }
+
+          /* In any case, this fallback nearest hit should have no weight at all
+           * in 'best island' decision! */
+          islands_res[tindex][plidx_dst].factor = 0.0f;
+
+          if (mesh_remap_bvhtree_query_nearest(
+                  tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
+            islands_res[tindex][plidx_dst].hit_dist = hit_dist;
+            islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
+            copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
+          }
+          else {
+            /* No source for this dest loop! */
+            islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
+            islands_res[tindex][plidx_dst].index_src = -1;
+          }
+        }
+      }
+      else { /* Nearest poly either to use all its loops/verts or just closest one. */
+        copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+        nearest.index = -1;
+
+        /* Convert the vertex to tree coordinates, if needed. */
+        if (space_transform) {
+          BLI_space_transform_apply(space_transform, tmp_co);
+        }
+
+        if (mesh_remap_bvhtree_query_nearest(
+                tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
+          islands_res[tindex][plidx_dst].factor = hit_dist ? (1.0f / hit_dist) : 1e18f;
+          islands_res[tindex][plidx_dst].hit_dist = hit_dist;
+          islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
+          copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
+        }
+        else {
+          /* No source for this dest loop! */
+          islands_res[tindex][plidx_dst].factor = 0.0f;
+          islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
+          islands_res[tindex][plidx_dst].index_src = -1;
+        }
+      }
+    }
+  }
+
+  /* And now, find best island to use! */
+  /* We have to first select the 'best source island' for given dst poly and its loops.
+   * Then, we have to check that poly does not 'spread' across some island's limits
+   * (like inner seams for UVs, etc.).
+   * Note we only still partially support that kind of situation here, i.e.
+   * Polys spreading over actual cracks
+   * (like a narrow space without faces on src, splitting a 'tube-like' geometry).
+   * That kind of situation should be relatively rare, though.
+   */
+  /* XXX This block in itself is big and complex enough to be a separate function but...
+   *     it uses a bunch of locale vars.
+   *     Not worth sending all that through parameters (for now at least). */
+  {
+    BLI_AStarGraph *as_graph = NULL;
+    int *poly_island_index_map = NULL;
+    int pidx_src_prev = -1;
+
+    MeshElemMap *best_island = NULL;
+    float best_island_fac = 0.0f;
+    int best_island_index = -1;
+
+    for (tindex = 0; tindex < num_trees; tindex++) {
+      float island_fac = 0.0f;
+
+      for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++) {
+        island_fac += islands_res[tindex][plidx_dst].factor;
+      }
+      island_fac /= (float)mp_dst->totloop;
+
+      if (island_fac > best_island_fac) {
+        best_island_fac = island_fac;
+        best_island_index = tindex;
+      }
+    }
+
+    if (best_island_index != -1 && isld_steps_src) {
+      best_island = use_islands ? island_store->islands[best_island_index] : NULL;
+      as_graph = &as_graphdata[best_island_index];
+      poly_island_index_map = (int *)as_graph->custom_data;
+      BLI_astar_solution_init(as_graph, as_solution, NULL);
+    }
+
+    for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++) {
+      IslandResult *isld_res;
+      lidx_dst = plidx_dst + mp_dst->loopstart;
+
+      if (best_island_index == -1) {
+        /* No source for any loops of our dest poly in any source islands. */
+        BKE_mesh_remap_item_define_invalid(r_map, lidx_dst);
+        continue;
+      }
+
+      as_solution->custom_data = POINTER_FROM_INT(false);
+
+      isld_res = &islands_res[best_island_index][plidx_dst];
+      if (use_from_vert) {
+        /* Indices stored in islands_res are those of loops, one per dest loop. */
+        lidx_src = isld_res->index_src;
+        if (lidx_src >= 0) {
+          pidx_src = loop_to_poly_map_src[lidx_src];
+          /* If prev and curr poly are the same, no need to do anything more!!! */
+          if (!ELEM(pidx_src_prev, -1, pidx_src) && isld_steps_src) {
+            int pidx_isld_src, pidx_isld_src_prev;
+            if (poly_island_index_map) {
+              pidx_isld_src = poly_island_index_map[pidx_src];
+              pidx_isld_src_prev = poly_island_index_map[pidx_src_prev];
+            }
+            else {
+              pidx_isld_src = pidx_src;
+              pidx_isld_src_prev = pidx_src_prev;
+            }
+
+            BLI_astar_graph_solve(as_graph,
+                                  pidx_isld_src_prev,
+                                  pidx_isld_src,
+                                  mesh_remap_calc_loops_astar_f_cost,
+                                  as_solution,
+                                  isld_steps_src);
+            if (POINTER_AS_INT(as_solution->custom_data) && (as_solution->steps > 0)) {
+              /* Find first 'cutting edge' on path, and bring back lidx_src on poly just
+               * before that edge.
+               * Note we could try to be much smarter, g.g. Storing a whole poly's indices,
+               * and making decision (on which side of cutting edge(s!) to be) on the end,
+               * but this is one more level of complexity, better to first see if
+               * simple solution works!
+               */
+              int last_valid_pidx_isld_src = -1;
+              /* Note we go backward here, from dest to src poly. */
+              for (i = as_solution->steps - 1; i--;) {
+                BLI_AStarGNLink *as_link = as_solution->prev_links[pidx_isld_src];
+                const int eidx = POINTER_AS_INT(as_link->custom_data);
+                pidx_isld_src = as_solution->prev_nodes[pidx_isld_src];
+                BLI_assert(pidx_isld_src != -1);
+                if (eidx != -1) {
+                  /* we are 'crossing' a cutting edge. */
+                  last_valid_pidx_isld_src = pidx_isld_src;
+                }
+              }
+              if (last_valid_pidx_isld_src != -1) {
+                /* Find a new valid loop in that new poly (nearest one for now).
+                 * Note we could be much more subtle here, again that's for later... */
+                int j;
+                float best_dist_sq = FLT_MAX;
+
+                ml_dst = &loops_dst[lidx_dst];
+                copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+
+                /* We do our transform here,
+                 * since we may do several raycast/nearest queries. */
+                if (space_transform) {
+                  BLI_space_transform_apply(space_transform, tmp_co);
+                }
+
+                pidx_src = (use_islands ? best_island->indices[last_valid_pidx_isld_src] :
+                                          last_valid_pidx_isld_src);
+                mp_src = &polys_src[pidx_src];
+                ml_src = &loops_src[mp_src->loopstart];
+                for (j = 0; j < mp_src->totloop; j++, ml_src++) {
+                  const float dist_sq = len_squared_v3v3(verts_src[ml_src->v].co, tmp_co);
+                  if (dist_sq < best_dist_sq) {
+                    best_dist_sq = dist_sq;
+                    lidx_src = mp_src->loopstart + j;
+                  }
+                }
+              }
+            }
+          }
+          mesh_remap_item_define_ex(r_map,
+                                    mem,
+                                    lidx_dst,
+                                    isld_res->hit_dist,
+                                    best_island_index,
+                                    1,
+                                    &lidx_src,
+                                    &full_weight);
+          pidx_src_prev = pidx_src;
+        }
+        else {
+          /* No source for this loop in this island. */
+          /* TODO: would probably be better to get a source
+           * at all cost in best island anyway? */
+          mesh_remap_item_define_ex(
+              r_map, mem, lidx_dst, FLT_MAX, best_island_index, 0, NULL, NULL);
+        }
+      }
+      else {
+        /* Else, we use source poly, indices stored in islands_res are those of polygons. */
+        pidx_src = isld_res->index_src;
+        if (pidx_src >= 0) {
+          float *hit_co = isld_res->hit_point;
+          int best_loop_index_src;
+
+          mp_src = &polys_src[pidx_src];
+          /* If prev and curr poly are the same, no need to do anything more!!! */
+          if (!ELEM(pidx_src_prev, -1, pidx_src) && isld_steps_src) {
+            int pidx_isld_src, pidx_isld_src_prev;
+            if (poly_island_index_map) {
+              pidx_isld_src = poly_island_index_map[pidx_src];
+              pidx_isld_src_prev = poly_island_index_map[pidx_src_prev];
+            }
+            else {
+              pidx_isld_src = pidx_src;
+              pidx_isld_src_prev = pidx_src_prev;
+            }
+
+            BLI_astar_graph_solve(as_graph,
+                                  pidx_isld_src_prev,
+                                  pidx_isld_src,
+                                  mesh_remap_calc_loops_astar_f_cost,
+                                  as_solution,
+                                  isld_steps_src);
+            if (POINTER_AS_INT(as_solution->custom_data) && (as_solution->steps > 0)) {
+              /* Find first 'cutting edge' on path, and bring back lidx_src on poly just
+               * before that edge.
+               * Note we could try to be much smarter: e.g. Storing a whole poly's indices,
+               * and making decision (one which side of cutting edge(s)!) to be on the end,
+               * but this is one more level of complexity, better to first see if
+               * simple solution works!
+               */
+              int last_valid_pidx_isld_src = -1;
+              /* Note we go backward here, from dest to src poly. */
+              for (i = as_solution->steps - 1; i--;) {
+                BLI_AStarGNLink *as_link = as_solution->prev_links[pidx_isld_src];
+                int eidx = POINTER_AS_INT(as_link->custom_data);
+
+                pidx_isld_src = as_solution->prev_nodes[pidx_isld_src];
+                BLI_assert(pidx_isld_src != -1);
+                if (eidx != -1) {
+                  /* we are 'crossing' a cutting edge. */
+                  last_valid_pidx_isld_src = pidx_isld_src;
+                }
+              }
+              if (last_valid_pidx_isld_src != -1) {
+                /* Find a new valid loop in that new poly (nearest point on poly for now).
+                 * Note we could be much more subtle here, again that's for later... */
+                float best_dist_sq = FLT_MAX;
+                int j;
+
+                ml_dst = &loops_dst[lidx_dst];
+                copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
+
+                /* We do our transform here,
+                 * since we may do several raycast/nearest queries. */
+                if (space_transform) {
+                  BLI_space_transform_apply(space_transform, tmp_co);
+                }
+
+                pidx_src = (use_islands ? best_island->indices[last_valid_pidx_isld_src] :
+                                          last_valid_pidx_isld_src);
+                mp_src = &polys_src[pidx_src];
+
+                for (j = poly_to_looptri_map_src[pidx_src].count; j--;) {
+                  float h[3];
+                  const MLoopTri *lt =
+                      &looptri_src[poly_to_looptri_map_src[pidx_src].indices[j]];
+                  float dist_sq;
+
+                  closest_on_tri_to_point_v3(h,
+                                             tmp_co,
+                                             vcos_src[loops_src[lt->tri[0]].v],
+                                             vcos_src[loops_src[lt->tri[1]].v],
+                                             vcos_src[loops_src[lt->tri[2]].v]);
+                  dist_sq = len_squared_v3v3(tmp_co, h);
+                  if (dist_sq < best_dist_sq) {
+                    copy_v3_v3(hit_co, h);
+                    best_dist_sq = dist_sq;
+                  }
+                }
+              }
+            }
+          }
+
+          if (mode == MREMAP_MODE_LOOP_POLY_NEAREST) {
+            mesh_remap_interp_poly_data_get(mp_src,
+                                            loops_src,
+                                            (const float(*)[3])vcos_src,
+                                            hit_co,
+                                            &remap_tls->buff_size,
+                                            &remap_tls->vcos,
+                                            true,
+                                            &remap_tls->indices,
+                                            &remap_tls->weights,
+                                            false,
+                                            &best_loop_index_src);
+
+            mesh_remap_item_define_ex(r_map,
+                                      mem,
+                                      lidx_dst,
+                                      isld_res->hit_dist,
+                                      best_island_index,
+                                      1,
+                                      &best_loop_index_src,
+                                      &full_weight);
+          }
+          else {
+            const int sources_num = mesh_remap_interp_poly_data_get(
+                mp_src,
+                loops_src,
+                (const float(*)[3])vcos_src,
+                hit_co,
+                &remap_tls->buff_size,
+                &remap_tls->vcos,
+                true,
+                &remap_tls->indices,
+                &remap_tls->weights,
+                true,
+                NULL);
+
+            mesh_remap_item_define_ex(r_map,
+                                      mem,
+                                      lidx_dst,
+                                      isld_res->hit_dist,
+                                      best_island_index,
+                                      sources_num,
+                                      remap_tls->indices,
+                                      remap_tls->weights);
+          }
+
+          pidx_src_prev = pidx_src;
+        }
+        else {
+          /* No source for this loop in this island. */
+          /* TODO: would probably be better to get a source
+           * at all cost in best island anyway? */
+          mesh_remap_item_define_ex(
+              r_map, mem, lidx_dst, FLT_MAX, best_island_index, 0, NULL, NULL);
+        }
+      }
+    }
+
+    BLI_astar_solution_clear(as_solution);
+  }
+}
+
+static void mesh_remap_calc_loops_chunk(void *__restrict userdata,
+                                        const int chunk,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const MeshRemapLoopsData *data = userdata;
+  MeshRemapLoopsTLS *loops_tls = tls->userdata_chunk;
+  MemArena *mem = mesh_remap_tls_mem_ensure(&loops_tls->remap_tls);
+
+  const int start = chunk * MREMAP_CHUNK_SIZE;
+  const int end = min_ii(start + MREMAP_CHUNK_SIZE, data->numpolys_dst);
+
+  if (loops_tls->islands_res == NULL) {
+    loops_tls->islands_res_buff_size = MREMAP_DEFAULT_BUFSIZE;
+    loops_tls->islands_res = MEM_mallocN(sizeof(*loops_tls->islands_res) *
+                                             (size_t)data->num_trees,
+                                         __func__);
+    for (int tindex = 0; tindex < data->num_trees; tindex++) {
+      loops_tls->islands_res[tindex] = MEM_mallocN(
+          sizeof(**loops_tls->islands_res) * loops_tls->islands_res_buff_size, __func__);
+    }
+  }
+  if (!data->use_from_vert) {
+    mesh_remap_tls_buffers_ensure(&loops_tls->remap_tls);
+  }
+
+  for (int pidx_dst = start; pidx_dst < end; pidx_dst++) {
+    mesh_remap_calc_loops_poly(data, loops_tls, mem, pidx_dst);
+  }
+}
+
+void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
+                                         const SpaceTransform *space_transform,
+                                         const float max_dist,
+                                         const float ray_radius,
+                                         MVert *verts_dst,
+                                         const int numverts_dst,
+                                         MEdge *edges_dst,
+                                         const int numedges_dst,
+                                         MLoop *loops_dst,
+                                         const int numloops_dst,
+                                         MPoly *polys_dst,
+                                         const int numpolys_dst,
+                                         CustomData *ldata_dst,
+                                         CustomData *pdata_dst,
+                                         const bool use_split_nors_dst,
+                                         const float split_angle_dst,
+                                         const bool dirty_nors_dst,
+                                         Mesh *me_src,
+                                         MeshRemapIslandsCalc gen_islands_src,
+                                         const float islands_precision_src,
+                                         MeshPairRemap *r_map)
+{
+  const float full_weight = 1.0f;
+  const float max_dist_sq = max_dist * max_dist;
+
+  int i;
+
+  BLI_assert(mode & MREMAP_MODE_LOOP);
+  BLI_assert((islands_precision_src >= 0.0f) && (islands_precision_src <= 1.0f));
+
+  BKE_mesh_remap_init(r_map, numloops_dst);
+
+  if (mode == MREMAP_MODE_TOPOLOGY) {
+    /* In topology mapping, we assume meshes are identical, islands included! */
+    BLI_assert(numloops_dst == me_src->totloop);
+    for (i = 0; i < numloops_dst; i++) {
+      mesh_remap_item_define(r_map, i, FLT_MAX, 0, 1, &i, &full_weight);
+    }
+  }
+  else {
+    BVHTreeFromMesh *treedata = NULL;
+    int num_trees = 0;
 
     const bool use_from_vert = (mode & MREMAP_USE_VERT);
 
@@ -1298,7 +2095,6 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
     bool use_islands = false;
 
     BLI_AStarGraph *as_graphdata = NULL;
-    BLI_AStarSolution as_solution = {0};
     const int isld_steps_src = (islands_precision_src ?
                                     max_ii((int)(ASTAR_STEPS_MAX * islands_precision_src + 0.499f),
                                            1) :
@@ -1335,24 +2131,12 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
     const MLoopTri *looptri_src = NULL;
     int num_looptri_src = 0;
 
-    size_t buff_size_interp = MREMAP_DEFAULT_BUFSIZE;
-    float(*vcos_interp)[3] = NULL;
-    int *indices_interp = NULL;
-    float *weights_interp = NULL;
-
-    MLoop *ml_src, *ml_dst;
-    MPoly *mp_src, *mp_dst;
-    int tindex, pidx_dst, lidx_dst, plidx_dst, pidx_src, lidx_src, plidx_src;
-
-    IslandResult **islands_res;
-    size_t islands_res_buff_size = MREMAP_DEFAULT_BUFSIZE;
+    MLoop *ml_src;
+    MPoly *mp_src;
+    int tindex, pidx_src, lidx_src, plidx_src;
 
     if (!use_from_vert) {
       vcos_src = BKE_mesh_vert_coords_alloc(me_src, NULL);
-
-      vcos_interp = MEM_mallocN(sizeof(*vcos_interp) * buff_size_interp, __func__);
-      indices_interp = MEM_mallocN(sizeof(*indices_interp) * buff_size_interp, __func__);
-      weights_interp = MEM_mallocN(sizeof(*weights_interp) * buff_size_interp, __func__);
     }
 
     {
@@ -1609,586 +2393,461 @@ void BKE_mesh_remap_calc_loops_from_mesh(const int mode,
       }
     }
 
+    if (!use_from_vert && isld_steps_src) {
+      /* Used to find the closest point of a source poly, when crossing inner cuts. */
+      BKE_mesh_origindex_map_create_looptri(&poly_to_looptri_map_src,
+                                            &poly_to_looptri_map_src_buff,
+                                            polys_src,
+                                            num_polys_src,
+                                            looptri_src,
+                                            num_looptri_src);
+    }
+
     /* And check each dest poly! */
-    islands_res = MEM_mallocN(sizeof(*islands_res) * (size_t)num_trees, __func__);
+    MeshRemapLoopsData data = {
+        .mode = mode,
+        .space_transform = space_transform,
+        .max_dist = max_dist,
+        .max_dist_sq = max_dist_sq,
+        .ray_radius = ray_radius,
+        .verts_dst = verts_dst,
+        .loops_dst = loops_dst,
+        .polys_dst = polys_dst,
+        .numpolys_dst = numpolys_dst,
+        .poly_nors_dst = poly_nors_dst,
+        .loop_nors_dst = loop_nors_dst,
+        .use_from_vert = use_from_vert,
+        .use_islands = use_islands,
+        .island_store = &island_store,
+        .num_trees = num_trees,
+        .treedata = treedata,
+        .as_graphdata = as_graphdata,
+        .isld_steps_src = isld_steps_src,
+        .verts_src = verts_src,
+        .vcos_src = vcos_src,
+        .loops_src = loops_src,
+        .polys_src = polys_src,
+        .looptri_src = looptri_src,
+        .poly_nors_src = poly_nors_src,
+        .loop_nors_src = loop_nors_src,
+        .poly_cents_src = poly_cents_src,
+        .vert_to_loop_map_src = vert_to_loop_map_src,
+        .vert_to_poly_map_src = vert_to_poly_map_src,
+        .poly_to_looptri_map_src = poly_to_looptri_map_src,
+        .loop_to_poly_map_src = loop_to_poly_map_src,
+    };
+    mesh_remap_thread_data_init(&data.thread_data, r_map);
+
+    MeshRemapLoopsTLS loops_tls = {{NULL}};
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (numpolys_dst > MREMAP_CHUNK_SIZE);
+    settings.userdata_chunk = &loops_tls;
+    settings.userdata_chunk_size = sizeof(loops_tls);
+    settings.func_free = mesh_remap_loops_tls_free_cb;
+    BLI_task_parallel_range(
+        0, mesh_remap_chunks_num(numpolys_dst), &data, mesh_remap_calc_loops_chunk, &settings);
+
+    mesh_remap_thread_data_end(&data.thread_data);
+
     for (tindex = 0; tindex < num_trees; tindex++) {
-      islands_res[tindex] = MEM_mallocN(sizeof(**islands_res) * islands_res_buff_size, __func__);
+      free_bvhtree_from_mesh(&treedata[tindex]);
+      if (isld_steps_src) {
+        BLI_astar_graph_free(&as_graphdata[tindex]);
+      }
+    }
+    BKE_mesh_loop_islands_free(&island_store);
+    MEM_freeN(treedata);
+    if (isld_steps_src) {
+      MEM_freeN(as_graphdata);
     }
 
-    for (pidx_dst = 0, mp_dst = polys_dst; pidx_dst < numpolys_dst; pidx_dst++, mp_dst++) {
-      float pnor_dst[3];
+    if (vcos_src) {
+      MEM_freeN(vcos_src);
+    }
+    if (vert_to_loop_map_src) {
+      MEM_freeN(vert_to_loop_map_src);
+    }
+    if (vert_to_loop_map_src_buff) {
+      MEM_freeN(vert_to_loop_map_src_buff);
+    }
+    if (vert_to_poly_map_src) {
+      MEM_freeN(vert_to_poly_map_src);
+    }
+    if (vert_to_poly_map_src_buff) {
+      MEM_freeN(vert_to_poly_map_src_buff);
+    }
+    if (edge_to_poly_map_src) {
+      MEM_freeN(edge_to_poly_map_src);
+    }
+    if (edge_to_poly_map_src_buff) {
+      MEM_freeN(edge_to_poly_map_src_buff);
+    }
+    if (poly_to_looptri_map_src) {
+      MEM_freeN(poly_to_looptri_map_src);
+    }
+    if (poly_to_looptri_map_src_buff) {
+      MEM_freeN(poly_to_looptri_map_src_buff);
+    }
+    if (loop_to_poly_map_src) {
+      MEM_freeN(loop_to_poly_map_src);
+    }
+    if (poly_cents_src) {
+      MEM_freeN(poly_cents_src);
+    }
+  }
+}
 
-      /* Only in use_from_vert case, we may need polys' centers as fallback
-       * in case we cannot decide which corner to use from normals only. */
-      float pcent_dst[3];
-      bool pcent_dst_valid = false;
+typedef struct MeshRemapPolysData {
+  MeshRemapThreadData thread_data;
+
+  int mode;
+  const SpaceTransform *space_transform;
+  float max_dist;
+  float max_dist_sq;
+  float ray_radius;
+
+  const MVert *verts_dst;
+  const MLoop *loops_dst;
+  const MPoly *polys_dst;
+  int numpolys_dst;
+  const float (*poly_nors_dst)[3];
+
+  BVHTreeFromMesh *treedata;
+} MeshRemapPolysData;
+
+/** Accumulated weight of a source poly hit by the rays cast from a destination poly. */
+typedef struct MeshRemapPolyHit {
+  int index;
+  float weight;
+} MeshRemapPolyHit;
+
+/** Per thread buffers of #MREMAP_MODE_POLY_POLYINTERP_PNORPROJ mapping. */
+typedef struct MeshRemapPolysTLS {
+  MeshRemapTLS remap_tls;
+
+  RNG *rng;
+  MeshRemapPolyHit *hits;
+  int hits_size;
+  int *indices;
+  float *weights;
+  float (*poly_vcos_2d)[2];
+  int (*tri_vidx_2d)[3];
+  size_t tmp_poly_size;
+} MeshRemapPolysTLS;
+
+static int mesh_remap_poly_hit_cmp(const void *a, const void *b)
+{
+  const MeshRemapPolyHit *hit_a = a;
+  const MeshRemapPolyHit *hit_b = b;
+  return (hit_a->index > hit_b->index) - (hit_a->index < hit_b->index);
+}
 
-      if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
-        copy_v3_v3(pnor_dst, poly_nors_dst[pidx_dst]);
-        if (space_transform) {
-          BLI_space_transform_apply_normal(space_transform, pnor_dst);
-        }
-      }
+static void mesh_remap_polys_tls_free_cb(const void *__restrict userdata, void *__restrict chunk)
+{
+  MeshRemapPolysTLS *polys_tls = chunk;
 
-      if ((size_t)mp_dst->totloop > islands_res_buff_size) {
-        islands_res_buff_size = (size_t)mp_dst->totloop + MREMAP_DEFAULT_BUFSIZE;
-        for (tindex = 0; tindex < num_trees; tindex++) {
-          islands_res[tindex] = MEM_reallocN(islands_res[tindex],
-                                             sizeof(**islands_res) * islands_res_buff_size);
-        }
-      }
+  mesh_remap_tls_free((MeshRemapThreadData *)userdata, &polys_tls->remap_tls);
 
-      for (tindex = 0; tindex < num_trees; tindex++) {
-        BVHTreeFromMesh *tdata = &treedata[tindex];
+  if (polys_tls->rng) {
+    BLI_rng_free(polys_tls->rng);
+  }
+  MEM_SAFE_FREE(polys_tls->hits);
+  MEM_SAFE_FREE(polys_tls->indices);
+  MEM_SAFE_FREE(polys_tls->weights);
+  MEM_SAFE_FREE(polys_tls->poly_vcos_2d);
+  MEM_SAFE_FREE(polys_tls->tri_vidx_2d);
+}
 
-        ml_dst = &loops_dst[mp_dst->loopstart];
-        for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++, ml_dst++) {
-          if (use_from_vert) {
-            MeshElemMap *vert_to_refelem_map_src = NULL;
+/**
+ * Sample some rays from the destination poly (2D grid in its normal space),
+ * and use their hits to interpolate from source polys.
+ */
+static void mesh_remap_calc_poly_polyinterp_pnorproj(const MeshRemapPolysData *data,
+                                                     MeshRemapPolysTLS *polys_tls,
+                                                     MemArena *mem,
+                                                     const int i)
+{
+  MeshPairRemap *r_map = data->thread_data.map;
+  const SpaceTransform *space_transform = data->space_transform;
+  const MVert *verts_dst = data->verts_dst;
+  const MLoop *loops_dst = data->loops_dst;
+  BVHTreeFromMesh *treedata = data->treedata;
+  const float ray_radius = data->ray_radius;
 
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            nearest.index = -1;
+  /* Note: dst poly is early-converted into src space! */
+  const MPoly *mp = &data->polys_dst[i];
 
-            /* Convert the vertex to tree coordinates, if needed. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-            }
+  BVHTreeRayHit rayhit = {0};
+  float hit_dist;
+  float tmp_co[3], tmp_no[3];
 
-            if (mesh_remap_bvhtree_query_nearest(
-                    tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-              float(*nor_dst)[3];
-              float(*nors_src)[3];
-              float best_nor_dot = -2.0f;
-              float best_sqdist_fallback = FLT_MAX;
-              int best_index_src = -1;
-
-              if (mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) {
-                copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
-                if (space_transform) {
-                  BLI_space_transform_apply_normal(space_transform, tmp_no);
-                }
-                nor_dst = &tmp_no;
-                nors_src = loop_nors_src;
-                vert_to_refelem_map_src = vert_to_loop_map_src;
-              }
-              else { /* if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) { */
-                nor_dst = &pnor_dst;
-                nors_src = poly_nors_src;
-                vert_to_refelem_map_src = vert_to_poly_map_src;
-              }
+  int tot_rays, done_rays = 0;
+  float poly_area_2d_inv, done_area = 0.0f;
 
-              for (i = vert_to_refelem_map_src[nearest.index].count; i--;) {
-                const int index_src = vert_to_refelem_map_src[nearest.index].indices[i];
-                BLI_assert(index_src != -1);
-                const float dot = dot_v3v3(nors_src[index_src], *nor_dst);
-
-                pidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
-                                loop_to_poly_map_src[index_src] :
-                                index_src);
-                /* WARNING! This is not the *real* lidx_src in case of POLYNOR, we only use it
-                 *          to check we stay on current island (all loops from a given poly are
-                 *          on same island!). */
-                lidx_src = ((mode == MREMAP_MODE_LOOP_NEAREST_LOOPNOR) ?
-                                index_src :
-                                polys_src[pidx_src].loopstart);
-
-                /* A same vert may be at the boundary of several islands! Hence, we have to ensure
-                 * poly/loop we are currently considering *belongs* to current island! */
-                if (use_islands && island_store.items_to_islands[lidx_src] != tindex) {
-                  continue;
-                }
+  float pcent_dst[3];
+  float to_pnor_2d_mat[3][3], from_pnor_2d_mat[3][3];
+  float poly_dst_2d_min[2], poly_dst_2d_max[2], poly_dst_2d_z;
+  float poly_dst_2d_size[2];
 
-                if (dot > best_nor_dot - 1e-6f) {
-                  /* We need something as fallback decision in case dest normal matches several
-                   * source normals (see T44522), using distance between polys' centers here. */
-                  float *pcent_src;
-                  float sqdist;
+  float totweights = 0.0f;
+  float hit_dist_accum = 0.0f;
+  int hits_num = 0;
+  const int tris_num = mp->totloop - 2;
+  int j;
 
-                  mp_src = &polys_src[pidx_src];
-                  ml_src = &loops_src[mp_src->loopstart];
+  /* Seed from the poly index, so the sampling doesn't depend on threading. */
+  BLI_rng_seed(polys_tls->rng, (uint)i);
 
-                  if (!pcent_dst_valid) {
-                    BKE_mesh_calc_poly_center(
-                        mp_dst, &loops_dst[mp_dst->loopstart], verts_dst, pcent_dst);
-                    pcent_dst_valid = true;
-                  }
-                  pcent_src = poly_cents_src[pidx_src];
-                  sqdist = len_squared_v3v3(pcent_dst, pcent_src);
+  BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, pcent_dst);
+  copy_v3_v3(tmp_no, data->poly_nors_dst[i]);
 
-                  if ((dot > best_nor_dot + 1e-6f) || (sqdist < best_sqdist_fallback)) {
-                    best_nor_dot = dot;
-                    best_sqdist_fallback = sqdist;
-                    best_index_src = index_src;
-                  }
-                }
-              }
-              if (best_index_src == -1) {
-                /* We found no item to map back from closest vertex... */
-                best_nor_dot = -1.0f;
-                hit_dist = FLT_MAX;
-              }
-              else if (mode == MREMAP_MODE_LOOP_NEAREST_POLYNOR) {
-                /* Our best_index_src is a poly one for now!
-                 * Have to find its loop matching our closest vertex. */
-                mp_src = &polys_src[best_index_src];
-                ml_src = &loops_src[mp_src->loopstart];
-                for (plidx_src = 0; plidx_src < mp_src->totloop; plidx_src++, ml_src++) {
-                  if ((int)ml_src->v == nearest.index) {
-                    best_index_src = plidx_src + mp_src->loopstart;
-                    break;
-                  }
-                }
-              }
-              best_nor_dot = (best_nor_dot + 1.0f) * 0.5f;
-              islands_res[tindex][plidx_dst].factor = hit_dist ? (best_nor_dot / hit_dist) : 1e18f;
-              islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-              islands_res[tindex][plidx_dst].index_src = best_index_src;
-            }
-            else {
-              /* No source for this dest loop! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
-              islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-              islands_res[tindex][plidx_dst].index_src = -1;
-            }
-          }
-          else if (mode & MREMAP_USE_NORPROJ) {
-            int n = (ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
-            float w = 1.0f;
+  /* We do our transform here, else it'd be redone by raycast helper for each ray, ugh! */
+  if (space_transform) {
+    BLI_space_transform_apply(space_transform, pcent_dst);
+    BLI_space_transform_apply_normal(space_transform, tmp_no);
+  }
 
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            copy_v3_v3(tmp_no, loop_nors_dst[plidx_dst + mp_dst->loopstart]);
+  if (UNLIKELY((size_t)mp->totloop > polys_tls->tmp_poly_size)) {
+    polys_tls->tmp_poly_size = (size_t)mp->totloop;
+    polys_tls->poly_vcos_2d = MEM_reallocN(
+        polys_tls->poly_vcos_2d, sizeof(*polys_tls->poly_vcos_2d) * polys_tls->tmp_poly_size);
+    polys_tls->tri_vidx_2d = MEM_reallocN(
+        polys_tls->tri_vidx_2d,
+        sizeof(*polys_tls->tri_vidx_2d) * (polys_tls->tmp_poly_size - 2));
+  }
+  float(*poly_vcos_2d)[2] = polys_tls->poly_vcos_2d;
+  int(*tri_vidx_2d)[3] = polys_tls->tri_vidx_2d;
 
-            /* We do our transform here, since we may do several raycast/nearest queries. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-              BLI_space_transform_apply_normal(space_transform, tmp_no);
-            }
+  axis_dominant_v3_to_m3(to_pnor_2d_mat, tmp_no);
+  invert_m3_m3(from_pnor_2d_mat, to_pnor_2d_mat);
 
-            while (n--) {
-              if (mesh_remap_bvhtree_query_raycast(
-                      tdata, &rayhit, tmp_co, tmp_no, ray_radius / w, max_dist, &hit_dist)) {
-                islands_res[tindex][plidx_dst].factor = (hit_dist ? (1.0f / hit_dist) : 1e18f) * w;
-                islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-                islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[rayhit.index].poly;
-                copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, rayhit.co);
-                break;
-              }
-              /* Next iteration will get bigger radius but smaller weight! */
-              w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
-            }
-            if (n == -1) {
-              /* Fallback to 'nearest' hit here, loops usually comes in 'face group', not good to
-               * have only part of one dest face's loops to map to source.
-               * Note that since we give this a null weight, if whole weight for a given face
-               * is null, it means none of its loop mapped to this source island,
-               * hence we can skip it later.
-               */
-              copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-              nearest.index = -1;
+  mul_m3_v3(to_pnor_2d_mat, pcent_dst);
+  poly_dst_2d_z = pcent_dst[2];
 
-              /* Convert the vertex to tree coordinates, if needed. */
-              if (space_transform) {
-                BLI_space_transform_apply(space_transform, tmp_co);
-              }
+  /* Get (2D) bounding square of our poly. */
+  INIT_MINMAX2(poly_dst_2d_min, poly_dst_2d_max);
 
-              /* In any case, this fallback nearest hit should have no weight at all
-               * in 'best island' decision! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
+  for (j = 0; j < mp->totloop; j++) {
+    const MLoop *ml = &loops_dst[j + mp->loopstart];
+    copy_v3_v3(tmp_co, verts_dst[ml->v].co);
+    if (space_transform) {
+      BLI_space_transform_apply(space_transform, tmp_co);
+    }
+    mul_v2_m3v3(poly_vcos_2d[j], to_pnor_2d_mat, tmp_co);
+    minmax_v2v2_v2(poly_dst_2d_min, poly_dst_2d_max, poly_vcos_2d[j]);
+  }
 
-              if (mesh_remap_bvhtree_query_nearest(
-                      tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-                islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-                islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
-                copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
-              }
-              else {
-                /* No source for this dest loop! */
-                islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-                islands_res[tindex][plidx_dst].index_src = -1;
-              }
-            }
-          }
-          else { /* Nearest poly either to use all its loops/verts or just closest one. */
-            copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-            nearest.index = -1;
+  /* We adjust our ray-casting grid to ray_radius (the smaller, the more rays are cast),
+   * with lower/upper bounds. */
+  sub_v2_v2v2(poly_dst_2d_size, poly_dst_2d_max, poly_dst_2d_min);
 
-            /* Convert the vertex to tree coordinates, if needed. */
-            if (space_transform) {
-              BLI_space_transform_apply(space_transform, tmp_co);
-            }
+  if (ray_radius) {
+    tot_rays = (int)((max_ff(poly_dst_2d_size[0], poly_dst_2d_size[1]) / ray_radius) + 0.5f);
+    CLAMP(tot_rays, MREMAP_RAYCAST_TRI_SAMPLES_MIN, MREMAP_RAYCAST_TRI_SAMPLES_MAX);
+  }
+  else {
+    /* If no radius (pure rays), give max number of rays! */
+    tot_rays = MREMAP_RAYCAST_TRI_SAMPLES_MIN;
+  }
+  tot_rays *= tot_rays;
 
-            if (mesh_remap_bvhtree_query_nearest(
-                    tdata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-              islands_res[tindex][plidx_dst].factor = hit_dist ? (1.0f / hit_dist) : 1e18f;
-              islands_res[tindex][plidx_dst].hit_dist = hit_dist;
-              islands_res[tindex][plidx_dst].index_src = (int)tdata->looptri[nearest.index].poly;
-              copy_v3_v3(islands_res[tindex][plidx_dst].hit_point, nearest.co);
-            }
-            else {
-              /* No source for this dest loop! */
-              islands_res[tindex][plidx_dst].factor = 0.0f;
-              islands_res[tindex][plidx_dst].hit_dist = FLT_MAX;
-              islands_res[tindex][plidx_dst].index_src = -1;
-            }
-          }
-        }
-      }
+  poly_area_2d_inv = area_poly_v2((const float(*)[2])poly_vcos_2d, (unsigned int)mp->totloop);
+  /* In case we have a null-area degenerated poly... */
+  poly_area_2d_inv = 1.0f / max_ff(poly_area_2d_inv, 1e-9f);
+
+  /* Tessellate our poly. */
+  if (mp->totloop == 3) {
+    tri_vidx_2d[0][0] = 0;
+    tri_vidx_2d[0][1] = 1;
+    tri_vidx_2d[0][2] = 2;
+  }
+  if (mp->totloop == 4) {
+    tri_vidx_2d[0][0] = 0;
+    tri_vidx_2d[0][1] = 1;
+    tri_vidx_2d[0][2] = 2;
+    tri_vidx_2d[1][0] = 0;
+    tri_vidx_2d[1][1] = 2;
+    tri_vidx_2d[1][2] = 3;
+  }
+  else {
+    BLI_polyfill_calc(
+        poly_vcos_2d, (unsigned int)mp->totloop, -1, (unsigned int(*)[3])tri_vidx_2d);
+  }
 
-      /* And now, find best island to use! */
-      /* We have to first select the 'best source island' for given dst poly and its loops.
-       * Then, we have to check that poly does not 'spread' across some island's limits
-       * (like inner seams for UVs, etc.).
-       * Note we only still partially support that kind of situation here, i.e.
-       * Polys spreading over actual cracks
-       * (like a narrow space without faces on src, splitting a 'tube-like' geometry).
-       * That kind of situation should be relatively rare, though.
-       */
-      /* XXX This block in itself is big and complex enough to be a separate function but...
-       *     it uses a bunch of locale vars.
-       *     Not worth sending all that through parameters (for now at least). */
-      {
-        BLI_AStarGraph *as_graph = NULL;
-        int *poly_island_index_map = NULL;
-        int pidx_src_prev = -1;
-
-        MeshElemMap *best_island = NULL;
-        float best_island_fac = 0.0f;
-        int best_island_index = -1;
+  for (j = 0; j < tris_num; j++) {
+    float *v1 = poly_vcos_2d[tri_vidx_2d[j][0]];
+    float *v2 = poly_vcos_2d[tri_vidx_2d[j][1]];
+    float *v3 = poly_vcos_2d[tri_vidx_2d[j][2]];
+    int rays_num;
 
-        for (tindex = 0; tindex < num_trees; tindex++) {
-          float island_fac = 0.0f;
+    /* All this allows us to get 'absolute' number of rays for each tri,
+     * avoiding accumulating errors over iterations, and helping better even distribution. */
+    done_area += area_tri_v2(v1, v2, v3);
+    rays_num = max_ii((int)((float)tot_rays * done_area * poly_area_2d_inv + 0.5f) - done_rays,
+                      0);
+    done_rays += rays_num;
 
-          for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++) {
-            island_fac += islands_res[tindex][plidx_dst].factor;
-          }
-          island_fac /= (float)mp_dst->totloop;
+    while (rays_num--) {
+      int n = (ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
+      float w = 1.0f;
+
+      BLI_rng_get_tri_sample_float_v2(polys_tls->rng, v1, v2, v3, tmp_co);
+
+      tmp_co[2] = poly_dst_2d_z;
+      mul_m3_v3(from_pnor_2d_mat, tmp_co);
 
-          if (island_fac > best_island_fac) {
-            best_island_fac = island_fac;
-            best_island_index = tindex;
+      /* At this point, tmp_co is a point on our poly surface, in mesh_src space! */
+      while (n--) {
+        if (mesh_remap_bvhtree_query_raycast(
+                treedata, &rayhit, tmp_co, tmp_no, ray_radius / w, data->max_dist, &hit_dist)) {
+          const int poly_src = (int)treedata->looptri[rayhit.index].poly;
+          int k;
+
+          /* Rays of a same poly only hit a few source polys, a linear search is fine. */
+          for (k = 0; k < hits_num && polys_tls->hits[k].index != poly_src; k++) {
+            /* pass */
+          }
+          if (k == hits_num) {
+            if (hits_num == polys_tls->hits_size) {
+              polys_tls->hits_size *= 2;
+              polys_tls->hits = MEM_reallocN(polys_tls->hits,
+                                             sizeof(*polys_tls->hits) *
+                                                 (size_t)polys_tls->hits_size);
+              polys_tls->indices = MEM_reallocN(polys_tls->indices,
+                                                sizeof(*polys_tls->indices) *
+                                                    (size_t)polys_tls->hits_size);
+              polys_tls->weights = MEM_reallocN(polys_tls->weights,
+                                                sizeof(*polys_tls->weights) *
+                                                    (size_t)polys_tls->hits_size);
+            }
+            polys_tls->hits[hits_num].index = poly_src;
+            polys_tls->hits[hits_num].weight = 0.0f;
+            hits_num++;
           }
-        }
 
-        if (best_island_index != -1 && isld_steps_src) {
-          best_island = use_islands ? island_store.islands[best_island_index] : NULL;
-          as_graph = &as_graphdata[best_island_index];
-          poly_island_index_map = (int *)as_graph->custom_data;
-          BLI_astar_solution_init(as_graph, &as_solution, NULL);
+          polys_tls->hits[k].weight += w;
+          totweights += w;
+          hit_dist_accum += hit_dist;
+          break;
         }
+        /* Next iteration will get bigger radius but smaller weight! */
+        w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
+      }
+    }
+  }
 
-        for (plidx_dst = 0; plidx_dst < mp_dst->totloop; plidx_dst++) {
-          IslandResult *isld_res;
-          lidx_dst = plidx_dst + mp_dst->loopstart;
+  if (totweights > 0.0f) {
+    /* Sources are sorted by index. */
+    qsort(polys_tls->hits, (size_t)hits_num, sizeof(*polys_tls->hits), mesh_remap_poly_hit_cmp);
+    for (j = 0; j < hits_num; j++) {
+      polys_tls->indices[j] = polys_tls->hits[j].index;
+      polys_tls->weights[j] = polys_tls->hits[j].weight / totweights;
+    }
+    mesh_remap_item_define_ex(r_map,
+                              mem,
+                              i,
+                              hit_dist_accum / totweights,
+                              0,
+                              hits_num,
+                              polys_tls->indices,
+                              polys_tls->weights);
+  }
+  else {
+    /* No source for this dest poly! */
+    BKE_mesh_remap_item_define_invalid(r_map, i);
+  }
+}
 
-          if (best_island_index == -1) {
-            /* No source for any loops of our dest poly in any source islands. */
-            BKE_mesh_remap_item_define_invalid(r_map, lidx_dst);
-            continue;
-          }
+static void mesh_remap_calc_polys_chunk(void *__restrict userdata,
+                                        const int chunk,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  const MeshRemapPolysData *data = userdata;
+  MeshRemapPolysTLS *polys_tls = tls->userdata_chunk;
+  MeshPairRemap *r_map = data->thread_data.map;
+  MemArena *mem = mesh_remap_tls_mem_ensure(&polys_tls->remap_tls);
 
-          as_solution.custom_data = POINTER_FROM_INT(false);
-
-          isld_res = &islands_res[best_island_index][plidx_dst];
-          if (use_from_vert) {
-            /* Indices stored in islands_res are those of loops, one per dest loop. */
-            lidx_src = isld_res->index_src;
-            if (lidx_src >= 0) {
-              pidx_src = loop_to_poly_map_src[lidx_src];
-              /* If prev and curr poly are the same, no need to do anything more!!! */
-              if (!ELEM(pidx_src_prev, -1, pidx_src) && isld_steps_src) {
-                int pidx_isld_src, pidx_isld_src_prev;
-                if (poly_island_index_map) {
-                  pidx_isld_src = poly_island_index_map[pidx_src];
-                  pidx_isld_src_prev = poly_island_index_map[pidx_src_prev];
-                }
-                else {
-                  pidx_isld_src = pidx_src;
-                  pidx_isld_src_prev = pidx_src_prev;
-                }
+  const int mode = data->mode;
+  const SpaceTransform *space_transform = data->space_transform;
+  const MVert *verts_dst = data->verts_dst;
+  const MLoop *loops_dst = data->loops_dst;
+  BVHTreeFromMesh *treedata = data->treedata;
 
-                BLI_astar_graph_solve(as_graph,
-                                      pidx_isld_src_prev,
-                                      pidx_isld_src,
-                                      mesh_remap_calc_loops_astar_f_cost,
-                                      &as_solution,
-                                      isld_steps_src);
-                if (POINTER_AS_INT(as_solution.custom_data) && (as_solution.steps > 0)) {
-                  /* Find first 'cutting edge' on path, and bring back lidx_src on poly just
-                   * before that edge.
-                   * Note we could try to be much smarter, g.g. Storing a whole poly's indices,
-                   * and making decision (on which side of cutting edge(s!) to be) on the end,
-                   * but this is one more level of complexity, better to first see if
-                   * simple solution works!
-                   */
-                  int last_valid_pidx_isld_src = -1;
-                  /* Note we go backward here, from dest to src poly. */
-                  for (i = as_solution.steps - 1; i--;) {
-                    BLI_AStarGNLink *as_link = as_solution.prev_links[pidx_isld_src];
-                    const int eidx = POINTER_AS_INT(as_link->custom_data);
-                    pidx_isld_src = as_solution.prev_nodes[pidx_isld_src];
-                    BLI_assert(pidx_isld_src != -1);
-                    if (eidx != -1) {
-                      /* we are 'crossing' a cutting edge. */
-                      last_valid_pidx_isld_src = pidx_isld_src;
-                    }
-                  }
-                  if (last_valid_pidx_isld_src != -1) {
-                    /* Find a new valid loop in that new poly (nearest one for now).
-                     * Note we could be much more subtle here, again that's for later... */
-                    int j;
-                    float best_dist_sq = FLT_MAX;
-
-                    ml_dst = &loops_dst[lidx_dst];
-                    copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-
-                    /* We do our transform here,
-                     * since we may do several raycast/nearest queries. */
-                    if (space_transform) {
-                      BLI_space_transform_apply(space_transform, tmp_co);
-                    }
-
-                    pidx_src = (use_islands ? best_island->indices[last_valid_pidx_isld_src] :
-                                              last_valid_pidx_isld_src);
-                    mp_src = &polys_src[pidx_src];
-                    ml_src = &loops_src[mp_src->loopstart];
-                    for (j = 0; j < mp_src->totloop; j++, ml_src++) {
-                      const float dist_sq = len_squared_v3v3(verts_src[ml_src->v].co, tmp_co);
-                      if (dist_sq < best_dist_sq) {
-                        best_dist_sq = dist_sq;
-                        lidx_src = mp_src->loopstart + j;
-                      }
-                    }
-                  }
-                }
-              }
-              mesh_remap_item_define(r_map,
-                                     lidx_dst,
-                                     isld_res->hit_dist,
-                                     best_island_index,
-                                     1,
-                                     &lidx_src,
-                                     &full_weight);
-              pidx_src_prev = pidx_src;
-            }
-            else {
-              /* No source for this loop in this island. */
-              /* TODO: would probably be better to get a source
-               * at all cost in best island anyway? */
-              mesh_remap_item_define(r_map, lidx_dst, FLT_MAX, best_island_index, 0, NULL, NULL);
-            }
-          }
-          else {
-            /* Else, we use source poly, indices stored in islands_res are those of polygons. */
-            pidx_src = isld_res->index_src;
-            if (pidx_src >= 0) {
-              float *hit_co = isld_res->hit_point;
-              int best_loop_index_src;
+  const float full_weight = 1.0f;
+  const int start = chunk * MREMAP_CHUNK_SIZE;
+  const int end = min_ii(start + MREMAP_CHUNK_SIZE, data->numpolys_dst);
 
-              mp_src = &polys_src[pidx_src];
-              /* If prev and curr poly are the same, no need to do anything more!!! */
-              if (!ELEM(pidx_src_prev, -1, pidx_src) && isld_steps_src) {
-                int pidx_isld_src, pidx_isld_src_prev;
-                if (poly_island_index_map) {
-                  pidx_isld_src = poly_island_index_map[pidx_src];
-                  pidx_isld_src_prev = poly_island_index_map[pidx_src_prev];
-                }
-                else {
-                  pidx_isld_src = pidx_src;
-                  pidx_isld_src_prev = pidx_src_prev;
-                }
+  BVHTreeNearest nearest = {0};
+  BVHTreeRayHit rayhit = {0};
+  float hit_dist;
+  float tmp_co[3], tmp_no[3];
 
-                BLI_astar_graph_solve(as_graph,
-                                      pidx_isld_src_prev,
-                                      pidx_isld_src,
-                                      mesh_remap_calc_loops_astar_f_cost,
-                                      &as_solution,
-                                      isld_steps_src);
-                if (POINTER_AS_INT(as_solution.custom_data) && (as_solution.steps > 0)) {
-                  /* Find first 'cutting edge' on path, and bring back lidx_src on poly just
-                   * before that edge.
-                   * Note we could try to be much smarter: e.g. Storing a whole poly's indices,
-                   * and making decision (one which side of cutting edge(s)!) to be on the end,
-                   * but this is one more level of complexity, better to first see if
-                   * simple solution works!
-                   */
-                  int last_valid_pidx_isld_src = -1;
-                  /* Note we go backward here, from dest to src poly. */
-                  for (i = as_solution.steps - 1; i--;) {
-                    BLI_AStarGNLink *as_link = as_solution.prev_links[pidx_isld_src];
-                    int eidx = POINTER_AS_INT(as_link->custom_data);
-
-                    pidx_isld_src = as_solution.prev_nodes[pidx_isld_src];
-                    BLI_assert(pidx_isld_src != -1);
-                    if (eidx != -1) {
-                      /* we are 'crossing' a cutting edge. */
-                      last_valid_pidx_isld_src = pidx_isld_src;
-                    }
-                  }
-                  if (last_valid_pidx_isld_src != -1) {
-                    /* Find a new valid loop in that new poly (nearest point on poly for now).
-                     * Note we could be much more subtle here, again that's for later... */
-                    float best_dist_sq = FLT_MAX;
-                    int j;
-
-                    ml_dst = &loops_dst[lidx_dst];
-                    copy_v3_v3(tmp_co, verts_dst[ml_dst->v].co);
-
-                    /* We do our transform here,
-                     * since we may do several raycast/nearest queries. */
-                    if (space_transform) {
-                      BLI_space_transform_apply(space_transform, tmp_co);
-                    }
-
-                    pidx_src = (use_islands ? best_island->indices[last_valid_pidx_isld_src] :
-                                              last_valid_pidx_isld_src);
-                    mp_src = &polys_src[pidx_src];
-
-                    /* Create that one on demand. */
-                    if (poly_to_looptri_map_src == NULL) {
-                      BKE_mesh_origindex_map_create_looptri(&poly_to_looptri_map_src,
-                                                            &poly_to_looptri_map_src_buff,
-                                                            polys_src,
-                                                            num_polys_src,
-                                                            looptri_src,
-                                                            num_looptri_src);
-                    }
-
-                    for (j = poly_to_looptri_map_src[pidx_src].count; j--;) {
-                      float h[3];
-                      const MLoopTri *lt =
-                          &looptri_src[poly_to_looptri_map_src[pidx_src].indices[j]];
-                      float dist_sq;
-
-                      closest_on_tri_to_point_v3(h,
-                                                 tmp_co,
-                                                 vcos_src[loops_src[lt->tri[0]].v],
-                                                 vcos_src[loops_src[lt->tri[1]].v],
-                                                 vcos_src[loops_src[lt->tri[2]].v]);
-                      dist_sq = len_squared_v3v3(tmp_co, h);
-                      if (dist_sq < best_dist_sq) {
-                        copy_v3_v3(hit_co, h);
-                        best_dist_sq = dist_sq;
-                      }
-                    }
-                  }
-                }
-              }
+  nearest.index = -1;
 
-              if (mode == MREMAP_MODE_LOOP_POLY_NEAREST) {
-                mesh_remap_interp_poly_data_get(mp_src,
-                                                loops_src,
-                                                (const float(*)[3])vcos_src,
-                                                hit_co,
-                                                &buff_size_interp,
-                                                &vcos_interp,
-                                                true,
-                                                &indices_interp,
-                                                &weights_interp,
-                                                false,
-                                                &best_loop_index_src);
-
-                mesh_remap_item_define(r_map,
-                                       lidx_dst,
-                                       isld_res->hit_dist,
-                                       best_island_index,
-                                       1,
-                                       &best_loop_index_src,
-                                       &full_weight);
-              }
-              else {
-                const int sources_num = mesh_remap_interp_poly_data_get(
-                    mp_src,
-                    loops_src,
-                    (const float(*)[3])vcos_src,
-                    hit_co,
-                    &buff_size_interp,
-                    &vcos_interp,
-                    true,
-                    &indices_interp,
-                    &weights_interp,
-                    true,
-                    NULL);
-
-                mesh_remap_item_define(r_map,
-                                       lidx_dst,
-                                       isld_res->hit_dist,
-                                       best_island_index,
-                                       sources_num,
-                                       indices_interp,
-                                       weights_interp);
-              }
+  if (mode == MREMAP_MODE_POLY_POLYINTERP_PNORPROJ && polys_tls->rng == NULL) {
+    polys_tls->rng = BLI_rng_new(0);
+    polys_tls->hits_size = MREMAP_DEFAULT_BUFSIZE;
+    polys_tls->hits = MEM_mallocN(sizeof(*polys_tls->hits) * (size_t)polys_tls->hits_size,
+                                  __func__);
+    polys_tls->indices = MEM_mallocN(
+        sizeof(*polys_tls->indices) * (size_t)polys_tls->hits_size, __func__);
+    polys_tls->weights = MEM_mallocN(
+        sizeof(*polys_tls->weights) * (size_t)polys_tls->hits_size, __func__);
+    polys_tls->tmp_poly_size = MREMAP_DEFAULT_BUFSIZE;
+    polys_tls->poly_vcos_2d = MEM_mallocN(
+        sizeof(*polys_tls->poly_vcos_2d) * polys_tls->tmp_poly_size, __func__);
+    /* Tessellated 2D poly, always (num_loops - 2) triangles. */
+    polys_tls->tri_vidx_2d = MEM_mallocN(
+        sizeof(*polys_tls->tri_vidx_2d) * (polys_tls->tmp_poly_size - 2), __func__);
+  }
 
-              pidx_src_prev = pidx_src;
-            }
-            else {
-              /* No source for this loop in this island. */
-              /* TODO: would probably be better to get a source
-               * at all cost in best island anyway? */
-              mesh_remap_item_define(r_map, lidx_dst, FLT_MAX, best_island_index, 0, NULL, NULL);
-            }
-          }
-        }
+  for (int i = start; i < end; i++) {
+    const MPoly *mp = &data->polys_dst[i];
 
-        BLI_astar_solution_clear(&as_solution);
+    if (mode == MREMAP_MODE_POLY_NEAREST) {
+      BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
+
+      /* Convert the vertex to tree coordinates, if needed. */
+      if (space_transform) {
+        BLI_space_transform_apply(space_transform, tmp_co);
       }
-    }
 
-    for (tindex = 0; tindex < num_trees; tindex++) {
-      MEM_freeN(islands_res[tindex]);
-      free_bvhtree_from_mesh(&treedata[tindex]);
-      if (isld_steps_src) {
-        BLI_astar_graph_free(&as_graphdata[tindex]);
+      if (mesh_remap_bvhtree_query_nearest(
+              treedata, &nearest, tmp_co, data->max_dist_sq, &hit_dist)) {
+        const MLoopTri *lt = &treedata->looptri[nearest.index];
+        const int poly_index = (int)lt->poly;
+        mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 1, &poly_index, &full_weight);
+      }
+      else {
+        /* No source for this dest poly! */
+        BKE_mesh_remap_item_define_invalid(r_map, i);
       }
     }
-    MEM_freeN(islands_res);
-    BKE_mesh_loop_islands_free(&island_store);
-    MEM_freeN(treedata);
-    if (isld_steps_src) {
-      MEM_freeN(as_graphdata);
-      BLI_astar_solution_free(&as_solution);
-    }
+    else if (mode == MREMAP_MODE_POLY_NOR) {
+      BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
+      copy_v3_v3(tmp_no, data->poly_nors_dst[i]);
 
-    if (vcos_src) {
-      MEM_freeN(vcos_src);
-    }
-    if (vert_to_loop_map_src) {
-      MEM_freeN(vert_to_loop_map_src);
-    }
-    if (vert_to_loop_map_src_buff) {
-      MEM_freeN(vert_to_loop_map_src_buff);
-    }
-    if (vert_to_poly_map_src) {
-      MEM_freeN(vert_to_poly_map_src);
-    }
-    if (vert_to_poly_map_src_buff) {
-      MEM_freeN(vert_to_poly_map_src_buff);
-    }
-    if (edge_to_poly_map_src) {
-      MEM_freeN(edge_to_poly_map_src);
-    }
-    if (edge_to_poly_map_src_buff) {
-      MEM_freeN(edge_to_poly_map_src_buff);
-    }
-    if (poly_to_looptri_map_src) {
-      MEM_freeN(poly_to_looptri_map_src);
-    }
-    if (poly_to_looptri_map_src_buff) {
-      MEM_freeN(poly_to_looptri_map_src_buff);
-    }
-    if (loop_to_poly_map_src) {
-      MEM_freeN(loop_to_poly_map_src);
-    }
-    if (poly_cents_src) {
-      MEM_freeN(poly_cents_src);
-    }
-    if (vcos_interp) {
-      MEM_freeN(vcos_interp);
-    }
-    if (indices_interp) {
-      MEM_freeN(indices_interp);
+      /* Convert the vertex to tree coordinates, if needed. */
+      if (space_transform) {
+        BLI_space_transform_apply(space_transform, tmp_co);
+        BLI_space_transform_apply_normal(space_transform, tmp_no);
+      }
+
+      if (mesh_remap_bvhtree_query_raycast(
+              treedata, &rayhit, tmp_co, tmp_no, data->ray_radius, data->max_dist, &hit_dist)) {
+        const MLoopTri *lt = &treedata->looptri[rayhit.index];
+        const int poly_index = (int)lt->poly;
+
+        mesh_remap_item_define_ex(r_map, mem, i, hit_dist, 0, 1, &poly_index, &full_weight);
+      }
+      else {
+        /* No source for this dest poly! */
+        BKE_mesh_remap_item_define_invalid(r_map, i);
+      }
     }
-    if (weights_interp) {
-      MEM_freeN(weights_interp);
+    else {
+      mesh_remap_calc_poly_polyinterp_pnorproj(data, polys_tls, mem, i);
     }
   }
 }
@@ -2209,9 +2868,7 @@ void BKE_mesh_remap_calc_polys_from_mesh(const int mode,
                                          MeshPairRemap *r_map)
 {
   const float full_weight = 1.0f;
-  const float max_dist_sq = max_dist * max_dist;
   float(*poly_nors_dst)[3] = NULL;
-  float tmp_co[3], tmp_no[3];
   int i;
 
   BLI_assert(mode & MREMAP_MODE_POLY);
@@ -2244,250 +2901,52 @@ void BKE_mesh_remap_calc_polys_from_mesh(const int mode,
       mesh_remap_item_define(r_map, i, FLT_MAX, 0, 1, &i, &full_weight);
     }
   }
-  else {
+  else if (ELEM(mode,
+                MREMAP_MODE_POLY_NEAREST,
+                MREMAP_MODE_POLY_NOR,
+                MREMAP_MODE_POLY_POLYINTERP_PNORPROJ)) {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
-    float hit_dist;
-
-    BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
-
-    if (mode == MREMAP_MODE_POLY_NEAREST) {
-      nearest.index = -1;
-
-      for (i = 0; i < numpolys_dst; i++) {
-        MPoly *mp = &polys_dst[i];
-
-        BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          const MLoopTri *lt = &treedata.looptri[nearest.index];
-          const int poly_index = (int)lt->poly;
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &poly_index, &full_weight);
-        }
-        else {
-          /* No source for this dest poly! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
-    }
-    else if (mode == MREMAP_MODE_POLY_NOR) {
-      BLI_assert(poly_nors_dst);
-
-      for (i = 0; i < numpolys_dst; i++) {
-        MPoly *mp = &polys_dst[i];
-
-        BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, tmp_co);
-        copy_v3_v3(tmp_no, poly_nors_dst[i]);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-          BLI_space_transform_apply_normal(space_transform, tmp_no);
-        }
-
-        if (mesh_remap_bvhtree_query_raycast(
-                &treedata, &rayhit, tmp_co, tmp_no, ray_radius, max_dist, &hit_dist)) {
-          const MLoopTri *lt = &treedata.looptri[rayhit.index];
-          const int poly_index = (int)lt->poly;
 
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &poly_index, &full_weight);
-        }
-        else {
-          /* No source for this dest poly! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
-    }
-    else if (mode == MREMAP_MODE_POLY_POLYINTERP_PNORPROJ) {
-      /* We cast our rays randomly, with a pseudo-even distribution
-       * (since we spread across tessellated tris,
-       * with additional weighting based on each tri's relative area).
-       */
-      RNG *rng = BLI_rng_new(0);
-
-      const size_t numpolys_src = (size_t)me_src->totpoly;
-
-      /* Here it's simpler to just allocate for all polys :/ */
-      int *indices = MEM_mallocN(sizeof(*indices) * numpolys_src, __func__);
-      float *weights = MEM_mallocN(sizeof(*weights) * numpolys_src, __func__);
-
-      size_t tmp_poly_size = MREMAP_DEFAULT_BUFSIZE;
-      float(*poly_vcos_2d)[2] = MEM_mallocN(sizeof(*poly_vcos_2d) * tmp_poly_size, __func__);
-      /* Tessellated 2D poly, always (num_loops - 2) triangles. */
-      int(*tri_vidx_2d)[3] = MEM_mallocN(sizeof(*tri_vidx_2d) * (tmp_poly_size - 2), __func__);
-
-      for (i = 0; i < numpolys_dst; i++) {
-        /* For each dst poly, we sample some rays from it (2D grid in pnor space)
-         * and use their hits to interpolate from source polys. */
-        /* Note: dst poly is early-converted into src space! */
-        MPoly *mp = &polys_dst[i];
+    BLI_assert(mode == MREMAP_MODE_POLY_NEAREST || poly_nors_dst);
 
-        int tot_rays, done_rays = 0;
-        float poly_area_2d_inv, done_area = 0.0f;
-
-        float pcent_dst[3];
-        float to_pnor_2d_mat[3][3], from_pnor_2d_mat[3][3];
-        float poly_dst_2d_min[2], poly_dst_2d_max[2], poly_dst_2d_z;
-        float poly_dst_2d_size[2];
-
-        float totweights = 0.0f;
-        float hit_dist_accum = 0.0f;
-        int sources_num = 0;
-        const int tris_num = mp->totloop - 2;
-        int j;
-
-        BKE_mesh_calc_poly_center(mp, &loops_dst[mp->loopstart], verts_dst, pcent_dst);
-        copy_v3_v3(tmp_no, poly_nors_dst[i]);
-
-        /* We do our transform here, else it'd be redone by raycast helper for each ray, ugh! */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, pcent_dst);
-          BLI_space_transform_apply_normal(space_transform, tmp_no);
-        }
-
-        copy_vn_fl(weights, (int)numpolys_src, 0.0f);
-
-        if (UNLIKELY((size_t)mp->totloop > tmp_poly_size)) {
-          tmp_poly_size = (size_t)mp->totloop;
-          poly_vcos_2d = MEM_reallocN(poly_vcos_2d, sizeof(*poly_vcos_2d) * tmp_poly_size);
-          tri_vidx_2d = MEM_reallocN(tri_vidx_2d, sizeof(*tri_vidx_2d) * (tmp_poly_size - 2));
-        }
-
-        axis_dominant_v3_to_m3(to_pnor_2d_mat, tmp_no);
-        invert_m3_m3(from_pnor_2d_mat, to_pnor_2d_mat);
-
-        mul_m3_v3(to_pnor_2d_mat, pcent_dst);
-        poly_dst_2d_z = pcent_dst[2];
-
-        /* Get (2D) bounding square of our poly. */
-        INIT_MINMAX2(poly_dst_2d_min, poly_dst_2d_max);
-
-        for (j = 0; j < mp->totloop; j++) {
-          MLoop *ml = &loops_dst[j + mp->loopstart];
-          copy_v3_v3(tmp_co, verts_dst[ml->v].co);
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-          }
-          mul_v2_m3v3(poly_vcos_2d[j], to_pnor_2d_mat, tmp_co);
-          minmax_v2v2_v2(poly_dst_2d_min, poly_dst_2d_max, poly_vcos_2d[j]);
-        }
-
-        /* We adjust our ray-casting grid to ray_radius (the smaller, the more rays are cast),
-         * with lower/upper bounds. */
-        sub_v2_v2v2(poly_dst_2d_size, poly_dst_2d_max, poly_dst_2d_min);
-
-        if (ray_radius) {
-          tot_rays = (int)((max_ff(poly_dst_2d_size[0], poly_dst_2d_size[1]) / ray_radius) + 0.5f);
-          CLAMP(tot_rays, MREMAP_RAYCAST_TRI_SAMPLES_MIN, MREMAP_RAYCAST_TRI_SAMPLES_MAX);
-        }
-        else {
-          /* If no radius (pure rays), give max number of rays! */
-          tot_rays = MREMAP_RAYCAST_TRI_SAMPLES_MIN;
-        }
-        tot_rays *= tot_rays;
-
-        poly_area_2d_inv = area_poly_v2((const float(*)[2])poly_vcos_2d,
-                                        (unsigned int)mp->totloop);
-        /* In case we have a null-area degenerated poly... */
-        poly_area_2d_inv = 1.0f / max_ff(poly_area_2d_inv, 1e-9f);
-
-        /* Tessellate our poly. */
-        if (mp->totloop == 3) {
-          tri_vidx_2d[0][0] = 0;
-          tri_vidx_2d[0][1] = 1;
-          tri_vidx_2d[0][2] = 2;
-        }
-        if (mp->totloop == 4) {
-          tri_vidx_2d[0][0] = 0;
-          tri_vidx_2d[0][1] = 1;
-          tri_vidx_2d[0][2] = 2;
-          tri_vidx_2d[1][0] = 0;
-          tri_vidx_2d[1][1] = 2;
-          tri_vidx_2d[1][2] = 3;
-        }
-        else {
-          BLI_polyfill_calc(
-              poly_vcos_2d, (unsigned int)mp->totloop, -1, (unsigned int(*)[3])tri_vidx_2d);
-        }
-
-        for (j = 0; j < tris_num; j++) {
-          float *v1 = poly_vcos_2d[tri_vidx_2d[j][0]];
-          float *v2 = poly_vcos_2d[tri_vidx_2d[j][1]];
-          float *v3 = poly_vcos_2d[tri_vidx_2d[j][2]];
-          int rays_num;
-
-          /* All this allows us to get 'absolute' number of rays for each tri,
-           * avoiding accumulating errors over iterations, and helping better even distribution. */
-          done_area += area_tri_v2(v1, v2, v3);
-          rays_num = max_ii(
-              (int)((float)tot_rays * done_area * poly_area_2d_inv + 0.5f) - done_rays, 0);
-          done_rays += rays_num;
-
-          while (rays_num--) {
-            int n = (ray_radius > 0.0f) ? MREMAP_RAYCAST_APPROXIMATE_NR : 1;
-            float w = 1.0f;
-
-            BLI_rng_get_tri_sample_float_v2(rng, v1, v2, v3, tmp_co);
-
-            tmp_co[2] = poly_dst_2d_z;
-            mul_m3_v3(from_pnor_2d_mat, tmp_co);
-
-            /* At this point, tmp_co is a point on our poly surface, in mesh_src space! */
-            while (n--) {
-              if (mesh_remap_bvhtree_query_raycast(
-                      &treedata, &rayhit, tmp_co, tmp_no, ray_radius / w, max_dist, &hit_dist)) {
-                const MLoopTri *lt = &treedata.looptri[rayhit.index];
-
-                weights[lt->poly] += w;
-                totweights += w;
-                hit_dist_accum += hit_dist;
-                break;
-              }
-              /* Next iteration will get bigger radius but smaller weight! */
-              w /= MREMAP_RAYCAST_APPROXIMATE_FAC;
-            }
-          }
-        }
-
-        if (totweights > 0.0f) {
-          for (j = 0; j < (int)numpolys_src; j++) {
-            if (!weights[j]) {
-              continue;
-            }
-            /* Note: sources_num is always <= j! */
-            weights[sources_num] = weights[j] / totweights;
-            indices[sources_num] = j;
-            sources_num++;
-          }
-          mesh_remap_item_define(
-              r_map, i, hit_dist_accum / totweights, 0, sources_num, indices, weights);
-        }
-        else {
-          /* No source for this dest poly! */
-          BKE_mesh_remap_item_define_invalid(r_map, i);
-        }
-      }
+    BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
 
-      MEM_freeN(tri_vidx_2d);
-      MEM_freeN(poly_vcos_2d);
-      MEM_freeN(indices);
-      MEM_freeN(weights);
-      BLI_rng_free(rng);
-    }
-    else {
-      CLOG_WARN(&LOG, "Unsupported mesh-to-mesh poly mapping mode (%d)!", mode);
-      memset(r_map->items, 0, sizeof(*r_map->items) * (size_t)numpolys_dst);
-    }
+    /* For #MREMAP_MODE_POLY_POLYINTERP_PNORPROJ, we cast our rays randomly,
+     * with a pseudo-even distribution (since we spread across tessellated tris,
+     * with additional weighting based on each tri's relative area). */
+    MeshRemapPolysData data = {
+        .mode = mode,
+        .space_transform = space_transform,
+        .max_dist = max_dist,
+        .max_dist_sq = max_dist * max_dist,
+        .ray_radius = ray_radius,
+        .verts_dst = verts_dst,
+        .loops_dst = loops_dst,
+        .polys_dst = polys_dst,
+        .numpolys_dst = numpolys_dst,
+        .poly_nors_dst = (const float(*)[3])poly_nors_dst,
+        .treedata = &treedata,
+    };
+    mesh_remap_thread_data_init(&data.thread_data, r_map);
+
+    MeshRemapPolysTLS polys_tls = {{NULL}};
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (numpolys_dst > MREMAP_CHUNK_SIZE);
+    settings.userdata_chunk = &polys_tls;
+    settings.userdata_chunk_size = sizeof(polys_tls);
+    settings.func_free = mesh_remap_polys_tls_free_cb;
+    BLI_task_parallel_range(
+        0, mesh_remap_chunks_num(numpolys_dst), &data, mesh_remap_calc_polys_chunk, &settings);
+
+    mesh_remap_thread_data_end(&data.thread_data);
 
     free_bvhtree_from_mesh(&treedata);
   }
+  else {
+    CLOG_WARN(&LOG, "Unsupported mesh-to-mesh poly mapping mode (%d)!", mode);
+    memset(r_map->items, 0, sizeof(*r_map->items) * (size_t)numpolys_dst);
+  }
 }
 
 #undef MREMAP_RAYCAST_APPROXIMATE_NR
@@ -2495,5 +2954,6 @@ void BKE_mesh_remap_calc_polys_from_mesh(const int mode,
 #undef MREMAP_RAYCAST_TRI_SAMPLES_MIN
 #undef MREMAP_RAYCAST_TRI_SAMPLES_MAX
 #undef MREMAP_DEFAULT_BUFSIZE
+#undef MREMAP_CHUNK_SIZE
 
 /** \} */
@@ -42,13 +42,27 @@
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
+#include "atomic_ops.h"
+
 #include "BKE_global.h"
 #include "BKE_main.h"
 #include "BKE_scene.h"
 #include "BKE_sequencer.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_HEAP_ALLOC(var, size) \
+    lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+#  define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+#endif
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -81,8 +95,15 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
+ * Image data is stored per image with codec chosen by user definable compression level:
+ * no compression stores raw pixels, low compression uses LZO (falls back to zlib when Blender
+ * is built without LZO) and high compression uses zlib.
+ * Codec is stored per entry, so files written with different settings can still be read.
  * Images are written in order in which they are rendered.
+ * Writing is done by a serial background task pool, so rendering thread doesn't have to wait
+ * for compression and disk IO. Pending writes are flushed before invalidation.
+ * Number of queued images is limited by DCACHE_MAX_PENDING_WRITES, because each of them holds
+ * a reference to a full resolution image. When disk can't keep up, images are written directly.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -94,11 +115,22 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+/* Version 2 added codecs, older builds would decode LZO and raw images as zlib. */
+#define DCACHE_CURRENT_VERSION 2
+/* Maximum number of images waiting in the background write queue. */
+#define DCACHE_MAX_PENDING_WRITES 8
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
+/* Codec of image data stored in cache file. */
+enum {
+  DCACHE_CODEC_ZLIB = 0,
+  DCACHE_CODEC_RAW = 1,
+  DCACHE_CODEC_LZO = 2,
+};
+
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -116,8 +148,18 @@ typedef struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+  /* Serial background pool for writing images. */
+  TaskPool *write_pool;
+  /* Number of images queued in write_pool, accessed atomically. */
+  int32_t pending_writes;
 } SeqDiskCache;
 
+typedef struct DiskCacheWriteTaskData {
+  char path[FILE_MAX];
+  float nfra;
+  ImBuf *ibuf;
+} DiskCacheWriteTaskData;
+
 typedef struct DiskCacheFile {
   struct DiskCacheFile *next, *prev;
   char path[FILE_MAX];
@@ -186,6 +228,22 @@ static int seq_disk_cache_compression_level(void)
   return U.sequencer_disk_cache_compression;
 }
 
+static unsigned char seq_disk_cache_codec(void)
+{
+  switch (U.sequencer_disk_cache_compression) {
+    case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
+      return DCACHE_CODEC_RAW;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+#ifdef WITH_LZO
+      return DCACHE_CODEC_LZO;
+#else
+      return DCACHE_CODEC_ZLIB;
+#endif
+  }
+
+  return DCACHE_CODEC_ZLIB;
+}
+
 static size_t seq_disk_cache_size_limit(void)
 {
   return (size_t)U.sequencer_disk_cache_size_limit * (1024 * 1024 * 1024);
@@ -455,6 +513,12 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
   }
 }
 
+/* Wait until all queued images are written. */
+static void seq_disk_cache_flush_writes(SeqDiskCache *disk_cache)
+{
+  BLI_task_pool_work_and_wait(disk_cache->write_pool);
+}
+
 static void seq_disk_cache_invalidate(Scene *scene,
                                       Sequence *seq,
                                       Sequence *seq_changed,
@@ -464,6 +528,9 @@ static void seq_disk_cache_invalidate(Scene *scene,
   int end;
   SeqDiskCache *disk_cache = scene->ed->cache->disk_cache;
 
+  /* Queued images may belong to invalidated range, they must not be written afterwards. */
+  seq_disk_cache_flush_writes(disk_cache);
+
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
   start = seq_changed->startdisp - DCACHE_IMAGES_PER_FILE;
@@ -499,6 +566,97 @@ static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntr
       ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
 }
 
+static void *seq_disk_cache_imbuf_data(ImBuf *ibuf)
+{
+  if (ibuf->rect) {
+    return ibuf->rect;
+  }
+  return ibuf->rect_float;
+}
+
+static size_t seq_disk_cache_write_raw(const void *data, size_t size, FILE *file, uint64_t offset)
+{
+  if (BLI_fseek(file, (int64_t)offset, SEEK_SET) != 0) {
+    return 0;
+  }
+  return fwrite(data, 1, size, file) == size ? size : 0;
+}
+
+/* Write image data with codec set in header_entry. Codec may be changed to
+ * #DCACHE_CODEC_RAW if data can not be compressed. Returns number of bytes written. */
+static size_t seq_disk_cache_encode_imbuf_to_file(ImBuf *ibuf,
+                                                  FILE *file,
+                                                  DiskCacheHeaderEntry *header_entry)
+{
+  void *data = seq_disk_cache_imbuf_data(ibuf);
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_RAW:
+      return seq_disk_cache_write_raw(data, header_entry->size_raw, file, header_entry->offset);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO: {
+      const size_t in_len = header_entry->size_raw;
+      lzo_uint out_len = LZO_OUT_LEN(in_len);
+      unsigned char *out = MEM_mallocN(out_len, "seq_disk_cache_lzo_buffer");
+      LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
+
+      size_t bytes_written;
+      int r = lzo1x_1_compress(data, (lzo_uint)in_len, out, &out_len, wrkmem);
+      if (r == LZO_E_OK && out_len < in_len) {
+        bytes_written = seq_disk_cache_write_raw(out, out_len, file, header_entry->offset);
+      }
+      else {
+        header_entry->codec = DCACHE_CODEC_RAW;
+        bytes_written = seq_disk_cache_write_raw(data, in_len, file, header_entry->offset);
+      }
+      MEM_freeN(out);
+      return bytes_written;
+    }
+#endif
+    default:
+      return deflate_imbuf_to_file(
+          ibuf, file, seq_disk_cache_compression_level(), header_entry);
+  }
+}
+
+/* Decode image data directly into ibuf buffer. Returns number of decoded bytes. */
+static size_t seq_disk_cache_decode_file_to_imbuf(ImBuf *ibuf,
+                                                  FILE *file,
+                                                  DiskCacheHeaderEntry *header_entry)
+{
+  void *data = seq_disk_cache_imbuf_data(ibuf);
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_ZLIB:
+      return inflate_file_to_imbuf(ibuf, file, header_entry);
+    case DCACHE_CODEC_RAW:
+      if (header_entry->size_compressed != header_entry->size_raw ||
+          BLI_fseek(file, (int64_t)header_entry->offset, SEEK_SET) != 0) {
+        return 0;
+      }
+      return fread(data, 1, header_entry->size_raw, file);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO: {
+      const size_t in_len = header_entry->size_compressed;
+      if (BLI_fseek(file, (int64_t)header_entry->offset, SEEK_SET) != 0) {
+        return 0;
+      }
+      unsigned char *in = MEM_mallocN(in_len, "seq_disk_cache_lzo_buffer");
+      lzo_uint out_len = header_entry->size_raw;
+      int r = LZO_E_ERROR;
+      if (fread(in, 1, in_len, file) == in_len) {
+        r = lzo1x_decompress_safe(in, (lzo_uint)in_len, data, &out_len, NULL);
+      }
+      MEM_freeN(in);
+      return (r == LZO_E_OK) ? out_len : 0;
+    }
+#endif
+  }
+
+  /* Unknown codec, or codec not available in this build. */
+  return 0;
+}
+
 static void seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
 {
   fseek(file, 0, 0);
@@ -520,7 +678,7 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(float nfra, ImBuf *ibuf, DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -552,8 +710,9 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
     header->entry[i].encoding = 0;
   }
 
+  header->entry[i].codec = seq_disk_cache_codec();
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->nfra;
+  header->entry[i].frameno = nfra;
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
@@ -582,11 +741,11 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache,
+                                      char *path,
+                                      float nfra,
+                                      ImBuf *ibuf)
 {
-  char path[FILE_MAX];
-
-  seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
   BLI_make_existing_file(path);
 
   FILE *file = BLI_fopen(path, "rb+");
@@ -601,9 +760,9 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
   DiskCacheHeader header;
   memset(&header, 0, sizeof(header));
   seq_disk_cache_read_header(file, &header);
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  int entry_index = seq_disk_cache_add_header_entry(nfra, ibuf, &header);
+  size_t bytes_written = seq_disk_cache_encode_imbuf_to_file(
+      ibuf, file, &header.entry[entry_index]);
 
   if (bytes_written != 0) {
     /* Last step is writing header, as image data can be overwritten,
@@ -617,9 +776,63 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
     return true;
   }
 
+  fclose(file);
   return false;
 }
 
+static void seq_disk_cache_write_file_and_enforce_limits(SeqDiskCache *disk_cache,
+                                                        char *path,
+                                                        float nfra,
+                                                        ImBuf *ibuf)
+{
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  seq_disk_cache_write_file(disk_cache, path, nfra, ibuf);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  seq_disk_cache_enforce_limits(disk_cache);
+}
+
+static void seq_disk_cache_write_task(TaskPool *__restrict pool, void *taskdata)
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_user_data(pool);
+  DiskCacheWriteTaskData *data = taskdata;
+  seq_disk_cache_write_file_and_enforce_limits(disk_cache, data->path, data->nfra, data->ibuf);
+}
+
+static void seq_disk_cache_write_task_free(TaskPool *__restrict pool, void *taskdata)
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_user_data(pool);
+  DiskCacheWriteTaskData *data = taskdata;
+  IMB_freeImBuf(data->ibuf);
+  MEM_freeN(data);
+  atomic_sub_and_fetch_int32(&disk_cache->pending_writes, 1);
+}
+
+/* Queue image to be written by background task.
+ * File path is resolved immediately, so key doesn't have to outlive the task. */
+static void seq_disk_cache_write_file_async(SeqDiskCache *disk_cache,
+                                            SeqCacheKey *key,
+                                            ImBuf *ibuf)
+{
+  if (atomic_add_and_fetch_int32(&disk_cache->pending_writes, 1) > DCACHE_MAX_PENDING_WRITES) {
+    /* Queue is full, write in this thread instead of keeping more images in memory. */
+    atomic_sub_and_fetch_int32(&disk_cache->pending_writes, 1);
+    char path[FILE_MAX];
+    seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
+    seq_disk_cache_write_file_and_enforce_limits(disk_cache, path, key->nfra, ibuf);
+    return;
+  }
+
+  DiskCacheWriteTaskData *data = MEM_mallocN(sizeof(DiskCacheWriteTaskData),
+                                             "DiskCacheWriteTaskData");
+  seq_disk_cache_get_file_path(disk_cache, key, data->path, sizeof(data->path));
+  data->nfra = key->nfra;
+  data->ibuf = ibuf;
+  IMB_refImBuf(ibuf);
+
+  BLI_task_pool_push(
+      disk_cache->write_pool, seq_disk_cache_write_task, data, false, seq_disk_cache_write_task_free);
+}
+
 static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
 {
   char path[FILE_MAX];
@@ -662,7 +875,7 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
+  size_t bytes_read = seq_disk_cache_decode_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
 
   /* Sanity check. */
   if (bytes_read != expected_size) {
@@ -1046,6 +1259,8 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   cache->disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
   cache->disk_cache->bmain = bmain;
   BLI_mutex_init(&cache->disk_cache->read_write_mutex);
+  cache->disk_cache->write_pool = BLI_task_pool_create_background_serial(cache->disk_cache,
+                                                                        TASK_PRIORITY_LOW);
   seq_disk_cache_handle_versioning(cache->disk_cache);
   seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
   cache->disk_cache->timestamp = scene->ed->disk_cache_timestamp;
@@ -1110,6 +1325,8 @@ void BKE_sequencer_cache_destruct(Scene *scene)
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
+    seq_disk_cache_flush_writes(cache->disk_cache);
+    BLI_task_pool_free(cache->disk_cache->write_pool);
     BLI_freelistN(&cache->disk_cache->files);
     BLI_mutex_end(&cache->disk_cache->read_write_mutex);
     MEM_freeN(cache->disk_cache);
@@ -1406,10 +1623,7 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
         seq_disk_cache_create(context->bmain, context->scene);
       }
 
-      BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      seq_disk_cache_write_file_async(cache->disk_cache, key, i);
     }
   }
 }
@@ -49,6 +49,7 @@
 #include "BLI_session_uuid.h"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -1992,7 +1993,7 @@ static void seq_proxy_build_frame(const SeqRenderData *context,
     ibuf = IMB_dupImBuf(ibuf_tmp);
     IMB_metadata_copy(ibuf, ibuf_tmp);
     IMB_freeImBuf(ibuf_tmp);
-    IMB_scalefastImBuf(ibuf, (short)rectx, (short)recty);
+    IMB_scaleImBuf_filtered(ibuf, (short)rectx, (short)recty, IMB_SCALE_FILTER_BOX);
   }
   else {
     ibuf = ibuf_tmp;
@@ -2723,7 +2724,10 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
 
     if (image_scale_factor != 1.0) {
       if (context->for_render) {
-        IMB_scaleImBuf(ibuf, ibuf->x * image_scale_factor, ibuf->y * image_scale_factor);
+        IMB_scaleImBuf_filtered(ibuf,
+                                ibuf->x * image_scale_factor,
+                                ibuf->y * image_scale_factor,
+                                IMB_SCALE_FILTER_BILINEAR);
       }
       else {
         IMB_scalefastImBuf(ibuf, ibuf->x * image_scale_factor, ibuf->y * image_scale_factor);
@@ -2797,7 +2801,8 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
 
   if (ibuf->x != context->rectx || ibuf->y != context->recty) {
     if (context->for_render) {
-      IMB_scaleImBuf(ibuf, (short)context->rectx, (short)context->recty);
+      IMB_scaleImBuf_filtered(
+          ibuf, (short)context->rectx, (short)context->recty, IMB_SCALE_FILTER_BILINEAR);
     }
     else {
       IMB_scalefastImBuf(ibuf, (short)context->rectx, (short)context->recty);
@@ -3987,6 +3992,102 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+/* Strips which can be rendered concurrently with other strips of the stack.
+ * Their rendering doesn't touch any other strip or render state, so they are safe to decode and
+ * preprocess in parallel. */
+static bool seq_render_strip_stack_input_is_threadsafe(Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return false;
+  }
+
+  /* Mask modifiers render other strips. */
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+typedef struct RenderStripStackInputsData {
+  const SeqRenderData *context;
+  float cfra;
+  Sequence **seq_arr;
+  int *input_indices;
+  ImBuf **inputs;
+} RenderStripStackInputsData;
+
+static void seq_render_strip_stack_input_cb(void *__restrict userdata,
+                                            const int iter,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RenderStripStackInputsData *data = userdata;
+  const int index = data->input_indices[iter];
+  SeqRenderState state;
+
+  sequencer_state_init(&state);
+  data->inputs[index] = seq_render_strip(data->context, &state, data->seq_arr[index], data->cfra);
+}
+
+/* Render inputs of stack above and including `base_index` in parallel when possible.
+ * Rendered images are stored in `inputs`, other inputs are rendered in order of composition. */
+static void seq_render_strip_stack_inputs(const SeqRenderData *context,
+                                          Sequence **seq_arr,
+                                          int count,
+                                          int base_index,
+                                          bool render_base,
+                                          float cfra,
+                                          ImBuf **inputs)
+{
+  int input_indices[MAXSEQ + 1];
+  int inputs_num = 0;
+
+  for (int i = base_index; i < count; i++) {
+    if (i == base_index ? render_base :
+                          seq_get_early_out_for_blend_mode(seq_arr[i]) == EARLY_DO_EFFECT) {
+      if (!seq_render_strip_stack_input_is_threadsafe(seq_arr[i])) {
+        return;
+      }
+      input_indices[inputs_num++] = i;
+    }
+  }
+
+  if (inputs_num < 2) {
+    return;
+  }
+
+  RenderStripStackInputsData data = {
+      .context = context,
+      .cfra = cfra,
+      .seq_arr = seq_arr,
+      .input_indices = input_indices,
+      .inputs = inputs,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, inputs_num, &data, seq_render_strip_stack_input_cb, &settings);
+}
+
+/* Use input rendered in advance by #seq_render_strip_stack_inputs, or render it now. */
+static ImBuf *seq_render_strip_stack_input_get(const SeqRenderData *context,
+                                               SeqRenderState *state,
+                                               Sequence **seq_arr,
+                                               ImBuf **inputs,
+                                               int index,
+                                               float cfra)
+{
+  if (inputs[index]) {
+    ImBuf *ibuf = inputs[index];
+    inputs[index] = NULL;
+    return ibuf;
+  }
+  return seq_render_strip(context, state, seq_arr[index], cfra);
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *seqbasep,
@@ -3994,8 +4095,10 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      int chanshown)
 {
   Sequence *seq_arr[MAXSEQ + 1];
+  ImBuf *inputs[MAXSEQ + 1] = {NULL};
   int count;
   int i;
+  int early_out = EARLY_NO_INPUT;
   ImBuf *out = NULL;
   clock_t begin;
 
@@ -4005,8 +4108,9 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  /* Find lowest strip which has to be rendered. Strips below it are either covered,
+   * or composite result is already cached. */
   for (i = count - 1; i >= 0; i--) {
-    int early_out;
     Sequence *seq = seq_arr[i];
 
     out = BKE_sequencer_cache_get(context, seq, cfra, SEQ_CACHE_STORE_COMPOSITE, false);
@@ -4015,42 +4119,46 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, cfra);
+      early_out = EARLY_NO_INPUT;
       break;
     }
 
     early_out = seq_get_early_out_for_blend_mode(seq);
 
+    if (ELEM(early_out, EARLY_NO_INPUT, EARLY_USE_INPUT_2) || i == 0) {
+      break;
+    }
+  }
+
+  /* Decode and preprocess inputs of the stack concurrently where possible. */
+  const bool render_base = (out == NULL && early_out != EARLY_USE_INPUT_1);
+  seq_render_strip_stack_inputs(context, seq_arr, count, i, render_base, cfra, inputs);
+
+  if (out == NULL) {
     switch (early_out) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, cfra);
+        out = seq_render_strip_stack_input_get(context, state, seq_arr, inputs, i, cfra);
         break;
       case EARLY_USE_INPUT_1:
-        if (i == 0) {
-          out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-        }
+        out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
         break;
-      case EARLY_DO_EFFECT:
-        if (i == 0) {
-          begin = seq_estimate_render_cost_begin();
+      case EARLY_DO_EFFECT: {
+        begin = seq_estimate_render_cost_begin();
 
-          ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+        ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
+        ImBuf *ibuf2 = seq_render_strip_stack_input_get(context, state, seq_arr, inputs, i, cfra);
 
-          out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
+        out = seq_render_strip_stack_apply_effect(context, seq_arr[i], cfra, ibuf1, ibuf2);
 
-          float cost = seq_estimate_render_cost_end(context->scene, begin);
-          BKE_sequencer_cache_put(
-              context, seq_arr[i], cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost, false);
+        float cost = seq_estimate_render_cost_end(context->scene, begin);
+        BKE_sequencer_cache_put(
+            context, seq_arr[i], cfra, SEQ_CACHE_STORE_COMPOSITE, out, cost, false);
 
-          IMB_freeImBuf(ibuf1);
-          IMB_freeImBuf(ibuf2);
-        }
+        IMB_freeImBuf(ibuf1);
+        IMB_freeImBuf(ibuf2);
         break;
-    }
-    if (out) {
-      break;
+      }
     }
   }
 
@@ -4061,7 +4169,7 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
 
     if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, cfra);
+      ImBuf *ibuf2 = seq_render_strip_stack_input_get(context, state, seq_arr, inputs, i, cfra);
 
       out = seq_render_strip_stack_apply_effect(context, seq, cfra, ibuf1, ibuf2);
 
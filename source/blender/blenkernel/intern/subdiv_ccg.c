@@ -38,6 +38,7 @@
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
 /* -------------------------------------------------------------------- */
@@ -176,28 +177,35 @@ typedef struct CCGEvalGridsData {
   SubdivCCGMaterialFlagsEvaluator *material_flags_evaluator;
 } CCGEvalGridsData;
 
-static void subdiv_ccg_eval_grid_element_limit(CCGEvalGridsData *data,
-                                               const int ptex_face_index,
-                                               const float u,
-                                               const float v,
-                                               unsigned char *element)
+/* Per-thread storage for batched evaluation of a single grid.
+ * Allocated on first use, sized to hold all elements of a grid. */
+typedef struct CCGEvalGridsTLS {
+  OpenSubdiv_PatchCoord *patch_coords;
+  float (*P)[3];
+  float (*dPdu)[3];
+  float (*dPdv)[3];
+} CCGEvalGridsTLS;
+
+static void subdiv_ccg_eval_grids_tls_ensure(CCGEvalGridsTLS *tls, const int grid_area)
 {
-  Subdiv *subdiv = data->subdiv;
-  SubdivCCG *subdiv_ccg = data->subdiv_ccg;
-  if (subdiv->displacement_evaluator != NULL) {
-    BKE_subdiv_eval_final_point(subdiv, ptex_face_index, u, v, (float *)element);
-  }
-  else if (subdiv_ccg->has_normal) {
-    BKE_subdiv_eval_limit_point_and_normal(subdiv,
-                                           ptex_face_index,
-                                           u,
-                                           v,
-                                           (float *)element,
-                                           (float *)(element + subdiv_ccg->normal_offset));
-  }
-  else {
-    BKE_subdiv_eval_limit_point(subdiv, ptex_face_index, u, v, (float *)element);
+  if (tls->patch_coords != NULL) {
+    return;
   }
+  tls->patch_coords = MEM_malloc_arrayN(
+      grid_area, sizeof(OpenSubdiv_PatchCoord), "CCG grid patch coords");
+  tls->P = MEM_malloc_arrayN(grid_area, sizeof(float[3]), "CCG grid P");
+  tls->dPdu = MEM_malloc_arrayN(grid_area, sizeof(float[3]), "CCG grid dPdu");
+  tls->dPdv = MEM_malloc_arrayN(grid_area, sizeof(float[3]), "CCG grid dPdv");
+}
+
+static void subdiv_ccg_eval_grids_tls_free(const void *__restrict UNUSED(userdata),
+                                           void *__restrict tls_v)
+{
+  CCGEvalGridsTLS *tls = tls_v;
+  MEM_SAFE_FREE(tls->patch_coords);
+  MEM_SAFE_FREE(tls->P);
+  MEM_SAFE_FREE(tls->dPdu);
+  MEM_SAFE_FREE(tls->dPdv);
 }
 
 static void subdiv_ccg_eval_grid_element_mask(CCGEvalGridsData *data,
@@ -219,40 +227,75 @@ static void subdiv_ccg_eval_grid_element_mask(CCGEvalGridsData *data,
   }
 }
 
-static void subdiv_ccg_eval_grid_element(CCGEvalGridsData *data,
-                                         const int ptex_face_index,
-                                         const float u,
-                                         const float v,
-                                         unsigned char *element)
+/* Evaluate all elements of a grid at the patch coordinates stored in the TLS.
+ * Limit surface is evaluated for the whole grid in one batch, displacement and mask are then
+ * evaluated per element. */
+static void subdiv_ccg_eval_grid_elements(CCGEvalGridsData *data,
+                                          CCGEvalGridsTLS *tls,
+                                          unsigned char *grid)
 {
-  subdiv_ccg_eval_grid_element_limit(data, ptex_face_index, u, v, element);
-  subdiv_ccg_eval_grid_element_mask(data, ptex_face_index, u, v, element);
+  Subdiv *subdiv = data->subdiv;
+  SubdivCCG *subdiv_ccg = data->subdiv_ccg;
+  const int grid_area = subdiv_ccg->grid_size * subdiv_ccg->grid_size;
+  const int element_size = element_size_bytes_get(subdiv_ccg);
+  const bool has_displacement = (subdiv->displacement_evaluator != NULL);
+  const bool need_derivatives = (has_displacement || subdiv_ccg->has_normal);
+  BKE_subdiv_eval_limit_points_and_derivatives(subdiv,
+                                               tls->patch_coords,
+                                               grid_area,
+                                               tls->P,
+                                               need_derivatives ? tls->dPdu : NULL,
+                                               need_derivatives ? tls->dPdv : NULL);
+  for (int i = 0; i < grid_area; i++) {
+    const OpenSubdiv_PatchCoord *patch_coord = &tls->patch_coords[i];
+    unsigned char *element = &grid[(size_t)i * element_size];
+    float *P = (float *)element;
+    copy_v3_v3(P, tls->P[i]);
+    if (has_displacement) {
+      float D[3];
+      BKE_subdiv_eval_displacement(subdiv,
+                                   patch_coord->ptex_face,
+                                   patch_coord->u,
+                                   patch_coord->v,
+                                   tls->dPdu[i],
+                                   tls->dPdv[i],
+                                   D);
+      add_v3_v3(P, D);
+    }
+    else if (subdiv_ccg->has_normal) {
+      float *N = (float *)(element + subdiv_ccg->normal_offset);
+      cross_v3_v3v3(N, tls->dPdu[i], tls->dPdv[i]);
+      normalize_v3(N);
+    }
+    subdiv_ccg_eval_grid_element_mask(
+        data, patch_coord->ptex_face, patch_coord->u, patch_coord->v, element);
+  }
 }
 
-static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data, const int face_index)
+static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data,
+                                         CCGEvalGridsTLS *tls,
+                                         const int face_index)
 {
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   const int ptex_face_index = data->face_ptex_offset[face_index];
   const int grid_size = subdiv_ccg->grid_size;
   const float grid_size_1_inv = 1.0f / (grid_size - 1);
-  const int element_size = element_size_bytes_get(subdiv_ccg);
   SubdivCCGFace *faces = subdiv_ccg->faces;
   SubdivCCGFace **grid_faces = subdiv_ccg->grid_faces;
   const SubdivCCGFace *face = &faces[face_index];
   for (int corner = 0; corner < face->num_grids; corner++) {
     const int grid_index = face->start_grid_index + corner;
     unsigned char *grid = (unsigned char *)subdiv_ccg->grids[grid_index];
+    OpenSubdiv_PatchCoord *patch_coord = tls->patch_coords;
     for (int y = 0; y < grid_size; y++) {
       const float grid_v = y * grid_size_1_inv;
-      for (int x = 0; x < grid_size; x++) {
+      for (int x = 0; x < grid_size; x++, patch_coord++) {
         const float grid_u = x * grid_size_1_inv;
-        float u, v;
-        BKE_subdiv_rotate_grid_to_quad(corner, grid_u, grid_v, &u, &v);
-        const size_t grid_element_index = (size_t)y * grid_size + x;
-        const size_t grid_element_offset = grid_element_index * element_size;
-        subdiv_ccg_eval_grid_element(data, ptex_face_index, u, v, &grid[grid_element_offset]);
+        patch_coord->ptex_face = ptex_face_index;
+        BKE_subdiv_rotate_grid_to_quad(corner, grid_u, grid_v, &patch_coord->u, &patch_coord->v);
       }
     }
+    subdiv_ccg_eval_grid_elements(data, tls, grid);
     /* Assign grid's face. */
     grid_faces[grid_index] = &faces[face_index];
     /* Assign material flags. */
@@ -261,12 +304,13 @@ static void subdiv_ccg_eval_regular_grid(CCGEvalGridsData *data, const int face_
   }
 }
 
-static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_index)
+static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data,
+                                         CCGEvalGridsTLS *tls,
+                                         const int face_index)
 {
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   const int grid_size = subdiv_ccg->grid_size;
   const float grid_size_1_inv = 1.0f / (grid_size - 1);
-  const int element_size = element_size_bytes_get(subdiv_ccg);
   SubdivCCGFace *faces = subdiv_ccg->faces;
   SubdivCCGFace **grid_faces = subdiv_ccg->grid_faces;
   const SubdivCCGFace *face = &faces[face_index];
@@ -274,15 +318,17 @@ static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_
     const int grid_index = face->start_grid_index + corner;
     const int ptex_face_index = data->face_ptex_offset[face_index] + corner;
     unsigned char *grid = (unsigned char *)subdiv_ccg->grids[grid_index];
+    OpenSubdiv_PatchCoord *patch_coord = tls->patch_coords;
     for (int y = 0; y < grid_size; y++) {
       const float u = 1.0f - (y * grid_size_1_inv);
-      for (int x = 0; x < grid_size; x++) {
+      for (int x = 0; x < grid_size; x++, patch_coord++) {
         const float v = 1.0f - (x * grid_size_1_inv);
-        const size_t grid_element_index = (size_t)y * grid_size + x;
-        const size_t grid_element_offset = grid_element_index * element_size;
-        subdiv_ccg_eval_grid_element(data, ptex_face_index, u, v, &grid[grid_element_offset]);
+        patch_coord->ptex_face = ptex_face_index;
+        patch_coord->u = u;
+        patch_coord->v = v;
       }
     }
+    subdiv_ccg_eval_grid_elements(data, tls, grid);
     /* Assign grid's face. */
     grid_faces[grid_index] = &faces[face_index];
     /* Assign material flags. */
@@ -293,16 +339,18 @@ static void subdiv_ccg_eval_special_grid(CCGEvalGridsData *data, const int face_
 
 static void subdiv_ccg_eval_grids_task(void *__restrict userdata_v,
                                        const int face_index,
-                                       const TaskParallelTLS *__restrict UNUSED(tls))
+                                       const TaskParallelTLS *__restrict tls_v)
 {
   CCGEvalGridsData *data = userdata_v;
+  CCGEvalGridsTLS *tls = tls_v->userdata_chunk;
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   SubdivCCGFace *face = &subdiv_ccg->faces[face_index];
+  subdiv_ccg_eval_grids_tls_ensure(tls, subdiv_ccg->grid_size * subdiv_ccg->grid_size);
   if (face->num_grids == 4) {
-    subdiv_ccg_eval_regular_grid(data, face_index);
+    subdiv_ccg_eval_regular_grid(data, tls, face_index);
   }
   else {
-    subdiv_ccg_eval_special_grid(data, face_index);
+    subdiv_ccg_eval_special_grid(data, tls, face_index);
   }
 }
 
@@ -320,9 +368,13 @@ static bool subdiv_ccg_evaluate_grids(SubdivCCG *subdiv_ccg,
   data.face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
   data.mask_evaluator = mask_evaluator;
   data.material_flags_evaluator = material_flags_evaluator;
+  CCGEvalGridsTLS tls = {NULL};
   /* Threaded grids evaluation. */
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  parallel_range_settings.userdata_chunk = &tls;
+  parallel_range_settings.userdata_chunk_size = sizeof(tls);
+  parallel_range_settings.func_free = subdiv_ccg_eval_grids_tls_free;
   BLI_task_parallel_range(
       0, num_faces, &data, subdiv_ccg_eval_grids_task, &parallel_range_settings);
   /* If displacement is used, need to calculate normals after all final
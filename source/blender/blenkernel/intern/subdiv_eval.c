@@ -35,6 +35,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
 #include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
@@ -273,6 +274,52 @@ void BKE_subdiv_eval_final_point(
   }
 }
 
+/* ========================== Batched point queries ========================== */
+
+void BKE_subdiv_eval_limit_points(Subdiv *subdiv,
+                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_patch_coords,
+                                  float (*r_P)[3])
+{
+  BKE_subdiv_eval_limit_points_and_derivatives(
+      subdiv, patch_coords, num_patch_coords, r_P, NULL, NULL);
+}
+
+void BKE_subdiv_eval_limit_points_and_derivatives(Subdiv *subdiv,
+                                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_patch_coords,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3])
+{
+  if (num_patch_coords == 0) {
+    return;
+  }
+  subdiv->evaluator->evaluatePatchesLimit(subdiv->evaluator,
+                                          patch_coords,
+                                          num_patch_coords,
+                                          (float *)r_P,
+                                          (float *)r_dPdu,
+                                          (float *)r_dPdv);
+  if (r_dPdu == NULL || r_dPdv == NULL) {
+    return;
+  }
+  /* Same workaround for degenerate derivatives as in the single point query. Such points are
+   * very rare, so re-evaluate them one by one. */
+  for (int i = 0; i < num_patch_coords; i++) {
+    if (is_zero_v3(r_dPdu[i]) || is_zero_v3(r_dPdv[i])) {
+      const OpenSubdiv_PatchCoord *patch_coord = &patch_coords[i];
+      subdiv->evaluator->evaluateLimit(subdiv->evaluator,
+                                       patch_coord->ptex_face,
+                                       patch_coord->u * 0.999f + 0.0005f,
+                                       patch_coord->v * 0.999f + 0.0005f,
+                                       r_P[i],
+                                       r_dPdu[i],
+                                       r_dPdv[i]);
+    }
+  }
+}
+
 /* ===================  Patch queries at given resolution =================== */
 
 /* Move buffer forward by a given number of bytes. */
@@ -293,28 +340,85 @@ static void buffer_write_short_value(void **buffer, const short *values_buffer,
   memcpy(*buffer, values_buffer, sizeof(short) * num_values);
 }
 
+void BKE_subdiv_eval_patch_buffers_free(SubdivEvalPatchBuffers *buffers)
+{
+  MEM_SAFE_FREE(buffers->patch_coords);
+  MEM_SAFE_FREE(buffers->P);
+  MEM_SAFE_FREE(buffers->dPdu);
+  MEM_SAFE_FREE(buffers->dPdv);
+  buffers->num_allocated_points = 0;
+}
+
+static void patch_buffers_ensure(SubdivEvalPatchBuffers *buffers,
+                                 const int num_points,
+                                 const bool need_derivatives)
+{
+  if (num_points > buffers->num_allocated_points) {
+    BKE_subdiv_eval_patch_buffers_free(buffers);
+    buffers->patch_coords = MEM_malloc_arrayN(
+        num_points, sizeof(OpenSubdiv_PatchCoord), "patch coords");
+    buffers->P = MEM_malloc_arrayN(num_points, sizeof(float[3]), "patch P");
+    buffers->num_allocated_points = num_points;
+  }
+  if (need_derivatives && buffers->dPdu == NULL) {
+    buffers->dPdu = MEM_malloc_arrayN(
+        buffers->num_allocated_points, sizeof(float[3]), "patch dPdu");
+    buffers->dPdv = MEM_malloc_arrayN(
+        buffers->num_allocated_points, sizeof(float[3]), "patch dPdv");
+  }
+}
+
+/* Evaluate limit points of the whole patch at once into the scratch buffers, along with the
+ * derivatives if requested. */
+static void patch_resolution_eval(Subdiv *subdiv,
+                                  const int ptex_face_index,
+                                  const int resolution,
+                                  SubdivEvalPatchBuffers *buffers,
+                                  const bool need_derivatives)
+{
+  const int num_points = resolution * resolution;
+  patch_buffers_ensure(buffers, num_points, need_derivatives);
+  /* Uniform grid of the given resolution, u in rows, v in columns. */
+  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
+  OpenSubdiv_PatchCoord *patch_coord = buffers->patch_coords;
+  for (int y = 0; y < resolution; y++) {
+    const float v = y * inv_resolution_1;
+    for (int x = 0; x < resolution; x++, patch_coord++) {
+      patch_coord->ptex_face = ptex_face_index;
+      patch_coord->u = x * inv_resolution_1;
+      patch_coord->v = v;
+    }
+  }
+  BKE_subdiv_eval_limit_points_and_derivatives(subdiv,
+                                               buffers->patch_coords,
+                                               num_points,
+                                               buffers->P,
+                                               need_derivatives ? buffers->dPdu : NULL,
+                                               need_derivatives ? buffers->dPdv : NULL);
+}
+
 void BKE_subdiv_eval_limit_patch_resolution_point(Subdiv *subdiv,
                                                   const int ptex_face_index,
                                                   const int resolution,
+                                                  SubdivEvalPatchBuffers *buffers,
                                                   void *buffer,
                                                   const int offset,
                                                   const int stride)
 {
+  patch_resolution_eval(subdiv, ptex_face_index, resolution, buffers, false);
+  const float(*P)[3] = buffers->P;
   buffer_apply_offset(&buffer, offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      BKE_subdiv_eval_limit_point(subdiv, ptex_face_index, u, v, buffer);
-      buffer_apply_offset(&buffer, stride);
-    }
+  const int num_points = resolution * resolution;
+  for (int i = 0; i < num_points; i++) {
+    buffer_write_float_value(&buffer, P[i], 3);
+    buffer_apply_offset(&buffer, stride);
   }
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(Subdiv *subdiv,
                                                                   const int ptex_face_index,
                                                                   const int resolution,
+                                                                  SubdivEvalPatchBuffers *buffers,
                                                                   void *point_buffer,
                                                                   const int point_offset,
                                                                   const int point_stride,
@@ -325,26 +429,28 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(Subdiv *subdiv
                                                                   const int dv_offset,
                                                                   const int dv_stride)
 {
+  patch_resolution_eval(subdiv, ptex_face_index, resolution, buffers, true);
+  const float(*P)[3] = buffers->P;
+  const float(*dPdu)[3] = buffers->dPdu;
+  const float(*dPdv)[3] = buffers->dPdv;
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&du_buffer, du_offset);
   buffer_apply_offset(&dv_buffer, dv_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      BKE_subdiv_eval_limit_point_and_derivatives(
-          subdiv, ptex_face_index, u, v, point_buffer, du_buffer, dv_buffer);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&du_buffer, du_stride);
-      buffer_apply_offset(&dv_buffer, dv_stride);
-    }
+  const int num_points = resolution * resolution;
+  for (int i = 0; i < num_points; i++) {
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_float_value(&du_buffer, dPdu[i], 3);
+    buffer_write_float_value(&dv_buffer, dPdv[i], 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&du_buffer, du_stride);
+    buffer_apply_offset(&dv_buffer, dv_stride);
   }
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(Subdiv *subdiv,
                                                              const int ptex_face_index,
                                                              const int resolution,
+                                                             SubdivEvalPatchBuffers *buffers,
                                                              void *point_buffer,
                                                              const int point_offset,
                                                              const int point_stride,
@@ -352,25 +458,28 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(Subdiv *subdiv,
                                                              const int normal_offset,
                                                              const int normal_stride)
 {
+  patch_resolution_eval(subdiv, ptex_face_index, resolution, buffers, true);
+  const float(*P)[3] = buffers->P;
+  const float(*dPdu)[3] = buffers->dPdu;
+  const float(*dPdv)[3] = buffers->dPdv;
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&normal_buffer, normal_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      float normal[3];
-      BKE_subdiv_eval_limit_point_and_normal(subdiv, ptex_face_index, u, v, point_buffer, normal);
-      buffer_write_float_value(&normal_buffer, normal, 3);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&normal_buffer, normal_stride);
-    }
+  const int num_points = resolution * resolution;
+  for (int i = 0; i < num_points; i++) {
+    float normal[3];
+    cross_v3_v3v3(normal, dPdu[i], dPdv[i]);
+    normalize_v3(normal);
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_float_value(&normal_buffer, normal, 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&normal_buffer, normal_stride);
   }
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(Subdiv *subdiv,
                                                                    const int ptex_face_index,
                                                                    const int resolution,
+                                                                   SubdivEvalPatchBuffers *buffers,
                                                                    void *point_buffer,
                                                                    const int point_offset,
                                                                    const int point_stride,
@@ -378,19 +487,22 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(Subdiv *subdi
                                                                    const int normal_offset,
                                                                    const int normal_stride)
 {
+  patch_resolution_eval(subdiv, ptex_face_index, resolution, buffers, true);
+  const float(*P)[3] = buffers->P;
+  const float(*dPdu)[3] = buffers->dPdu;
+  const float(*dPdv)[3] = buffers->dPdv;
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&normal_buffer, normal_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      short normal[3];
-      BKE_subdiv_eval_limit_point_and_short_normal(
-          subdiv, ptex_face_index, u, v, point_buffer, normal);
-      buffer_write_short_value(&normal_buffer, normal, 3);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&normal_buffer, normal_stride);
-    }
+  const int num_points = resolution * resolution;
+  for (int i = 0; i < num_points; i++) {
+    float normal[3];
+    short short_normal[3];
+    cross_v3_v3v3(normal, dPdu[i], dPdv[i]);
+    normalize_v3(normal);
+    normal_float_to_short_v3(short_normal, normal);
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_short_value(&normal_buffer, short_normal, 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&normal_buffer, normal_stride);
   }
 }
@@ -41,6 +41,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.h"
+
 /* -------------------------------------------------------------------- */
 /** \name Subdivision Context
  * \{ */
@@ -76,6 +78,9 @@ typedef struct SubdivMeshContext {
    * when it's not possible is when displacement is used. */
   bool can_evaluate_normals;
   bool have_displacement;
+  /* Subdivided mesh already has topology and custom data from a previous evaluation of the same
+   * coarse mesh, only positions and normals are to be evaluated. */
+  bool update_positions_only;
 } SubdivMeshContext;
 
 static void subdiv_mesh_ctx_cache_uv_layers(SubdivMeshContext *ctx)
@@ -425,7 +430,13 @@ static void loop_interpolation_end(LoopsForInterpolation *loop_interpolation)
 /** \name TLS
  * \{ */
 
+/* Number of inner vertices which are gathered before their positions are evaluated in a single
+ * batch. */
+#define SUBDIV_MESH_EVAL_BATCH_SIZE 256
+
 typedef struct SubdivMeshTLS {
+  const SubdivMeshContext *ctx;
+
   bool vertex_interpolation_initialized;
   VerticesForInterpolation vertex_interpolation;
   const MPoly *vertex_interpolation_coarse_poly;
@@ -435,11 +446,19 @@ typedef struct SubdivMeshTLS {
   LoopsForInterpolation loop_interpolation;
   const MPoly *loop_interpolation_coarse_poly;
   int loop_interpolation_coarse_corner;
+
+  /* Inner vertices which are waiting for their limit surface evaluation. */
+  int num_pending_vertices;
+  OpenSubdiv_PatchCoord pending_patch_coords[SUBDIV_MESH_EVAL_BATCH_SIZE];
+  int pending_vertex_indices[SUBDIV_MESH_EVAL_BATCH_SIZE];
 } SubdivMeshTLS;
 
+static void subdiv_mesh_flush_pending_vertices(SubdivMeshTLS *tls);
+
 static void subdiv_mesh_tls_free(void *tls_v)
 {
   SubdivMeshTLS *tls = tls_v;
+  subdiv_mesh_flush_pending_vertices(tls);
   if (tls->vertex_interpolation_initialized) {
     vertex_interpolation_end(&tls->vertex_interpolation);
   }
@@ -454,19 +473,65 @@ static void subdiv_mesh_tls_free(void *tls_v)
 /** \name Evaluation helper functions
  * \{ */
 
-static void eval_final_point_and_vertex_normal(Subdiv *subdiv,
-                                               const int ptex_face_index,
-                                               const float u,
-                                               const float v,
-                                               float r_P[3],
-                                               short r_N[3])
+/* Evaluate final positions of all pending inner vertices in one batch. Normals are evaluated
+ * from the limit surface when there is no displacement, otherwise they are calculated once all
+ * final positions are known. */
+static void subdiv_mesh_flush_pending_vertices(SubdivMeshTLS *tls)
 {
-  if (subdiv->displacement_evaluator == NULL) {
-    BKE_subdiv_eval_limit_point_and_short_normal(subdiv, ptex_face_index, u, v, r_P, r_N);
+  const int num_vertices = tls->num_pending_vertices;
+  if (num_vertices == 0) {
+    return;
   }
-  else {
-    BKE_subdiv_eval_final_point(subdiv, ptex_face_index, u, v, r_P);
+  const SubdivMeshContext *ctx = tls->ctx;
+  Subdiv *subdiv = ctx->subdiv;
+  MVert *subdiv_mvert = ctx->subdiv_mesh->mvert;
+  float P[SUBDIV_MESH_EVAL_BATCH_SIZE][3];
+  float dPdu[SUBDIV_MESH_EVAL_BATCH_SIZE][3];
+  float dPdv[SUBDIV_MESH_EVAL_BATCH_SIZE][3];
+  BKE_subdiv_eval_limit_points_and_derivatives(
+      subdiv, tls->pending_patch_coords, num_vertices, P, dPdu, dPdv);
+  for (int i = 0; i < num_vertices; i++) {
+    const OpenSubdiv_PatchCoord *patch_coord = &tls->pending_patch_coords[i];
+    MVert *subdiv_vert = &subdiv_mvert[tls->pending_vertex_indices[i]];
+    copy_v3_v3(subdiv_vert->co, P[i]);
+    if (ctx->have_displacement) {
+      float D[3];
+      BKE_subdiv_eval_displacement(subdiv,
+                                   patch_coord->ptex_face,
+                                   patch_coord->u,
+                                   patch_coord->v,
+                                   dPdu[i],
+                                   dPdv[i],
+                                   D);
+      add_v3_v3(subdiv_vert->co, D);
+    }
+    else {
+      float N[3];
+      cross_v3_v3v3(N, dPdu[i], dPdv[i]);
+      normalize_v3(N);
+      normal_float_to_short_v3(subdiv_vert->no, N);
+    }
+  }
+  tls->num_pending_vertices = 0;
+}
+
+/* Schedule evaluation of final position and normal of the given vertex.
+ * The actual evaluation happens in batches, see subdiv_mesh_flush_pending_vertices(). */
+static void subdiv_mesh_schedule_vertex_evaluation(SubdivMeshTLS *tls,
+                                                   const int ptex_face_index,
+                                                   const float u,
+                                                   const float v,
+                                                   const int subdiv_vertex_index)
+{
+  if (tls->num_pending_vertices == SUBDIV_MESH_EVAL_BATCH_SIZE) {
+    subdiv_mesh_flush_pending_vertices(tls);
   }
+  const int pending_index = tls->num_pending_vertices++;
+  OpenSubdiv_PatchCoord *patch_coord = &tls->pending_patch_coords[pending_index];
+  patch_coord->ptex_face = ptex_face_index;
+  patch_coord->u = u;
+  patch_coord->v = v;
+  tls->pending_vertex_indices[pending_index] = subdiv_vertex_index;
 }
 
 /** \} */
@@ -527,6 +592,30 @@ static bool subdiv_mesh_topology_info(const SubdivForeachContext *foreach_contex
   return true;
 }
 
+static bool subdiv_mesh_topology_info_update_positions(
+    const SubdivForeachContext *foreach_context,
+    const int num_vertices,
+    const int num_edges,
+    const int num_loops,
+    const int num_polygons)
+{
+  SubdivMeshContext *subdiv_context = foreach_context->user_data;
+  Mesh *subdiv_mesh = subdiv_context->subdiv_mesh;
+  if (subdiv_mesh->totvert != num_vertices || subdiv_mesh->totedge != num_edges ||
+      subdiv_mesh->totloop != num_loops || subdiv_mesh->totpoly != num_polygons) {
+    return false;
+  }
+  /* Displacement is accumulated in vertex coordinates, which are expected to start at zero. */
+  if (subdiv_context->have_displacement) {
+    for (int i = 0; i < num_vertices; i++) {
+      zero_v3(subdiv_mesh->mvert[i].co);
+    }
+  }
+  subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
+  subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
+  return true;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -582,7 +671,9 @@ static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext
     mul_v3_fl(D, inv_num_accumulated);
   }
   /* Copy custom data and evaluate position. */
-  subdiv_vertex_data_copy(ctx, coarse_vert, subdiv_vert);
+  if (!ctx->update_positions_only) {
+    subdiv_vertex_data_copy(ctx, coarse_vert, subdiv_vert);
+  }
   BKE_subdiv_eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_vert->co);
   /* Apply displacement. */
   add_v3_v3(subdiv_vert->co, D);
@@ -615,7 +706,9 @@ static void evaluate_vertex_and_apply_displacement_interpolate(
     mul_v3_fl(D, inv_num_accumulated);
   }
   /* Interpolate custom data and evaluate position. */
-  subdiv_vertex_data_interpolate(ctx, subdiv_vert, vertex_interpolation, u, v);
+  if (!ctx->update_positions_only) {
+    subdiv_vertex_data_interpolate(ctx, subdiv_vert, vertex_interpolation, u, v);
+  }
   BKE_subdiv_eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_vert->co);
   /* Apply displacement. */
   add_v3_v3(subdiv_vert->co, D);
@@ -739,7 +832,9 @@ static void subdiv_mesh_vertex_edge(const SubdivForeachContext *foreach_context,
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
-  subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
+  if (!ctx->update_positions_only) {
+    subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
+  }
   evaluate_vertex_and_apply_displacement_interpolate(
       ctx, ptex_face_index, u, v, &tls->vertex_interpolation, subdiv_vert);
 }
@@ -780,18 +875,18 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
 {
   SubdivMeshContext *ctx = foreach_context->user_data;
   SubdivMeshTLS *tls = tls_v;
-  Subdiv *subdiv = ctx->subdiv;
   const Mesh *coarse_mesh = ctx->coarse_mesh;
   const MPoly *coarse_mpoly = coarse_mesh->mpoly;
   const MPoly *coarse_poly = &coarse_mpoly[coarse_poly_index];
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
-  subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
-  subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
-  eval_final_point_and_vertex_normal(
-      subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
-  subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
+  if (!ctx->update_positions_only) {
+    subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
+    subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
+    subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
+  }
+  subdiv_mesh_schedule_vertex_evaluation(tls, ptex_face_index, u, v, subdiv_vertex_index);
 }
 
 /** \} */
@@ -995,6 +1090,11 @@ static void subdiv_mesh_vertex_loose(const SubdivForeachContext *foreach_context
   Mesh *subdiv_mesh = ctx->subdiv_mesh;
   MVert *subdiv_mvert = subdiv_mesh->mvert;
   MVert *subdiv_vertex = &subdiv_mvert[subdiv_vertex_index];
+  if (ctx->update_positions_only) {
+    copy_v3_v3(subdiv_vertex->co, coarse_vertex->co);
+    copy_v3_v3_short(subdiv_vertex->no, coarse_vertex->no);
+    return;
+  }
   subdiv_vertex_data_copy(ctx, coarse_vertex, subdiv_vertex);
 }
 
@@ -1122,7 +1222,9 @@ static void subdiv_mesh_vertex_of_loose_edge(const struct SubdivForeachContext *
   const MEdge *neighbors[2];
   find_edge_neighbors(ctx, coarse_edge, neighbors);
   /* Interpolate custom data. */
-  subdiv_mesh_vertex_of_loose_edge_interpolate(ctx, coarse_edge, u, subdiv_vertex_index);
+  if (!ctx->update_positions_only) {
+    subdiv_mesh_vertex_of_loose_edge_interpolate(ctx, coarse_edge, u, subdiv_vertex_index);
+  }
   /* Interpolate coordinate. */
   MVert *subdiv_vertex = &subdiv_mvert[subdiv_vertex_index];
   if (is_simple) {
@@ -1183,6 +1285,21 @@ static void setup_foreach_callbacks(const SubdivMeshContext *subdiv_context,
   foreach_context->user_data_tls_free = subdiv_mesh_tls_free;
 }
 
+/* Only vertices are traversed, edges, loops and polygons are kept as-is. */
+static void setup_foreach_update_positions_callbacks(SubdivForeachContext *foreach_context)
+{
+  memset(foreach_context, 0, sizeof(*foreach_context));
+  foreach_context->topology_info = subdiv_mesh_topology_info_update_positions;
+  foreach_context->vertex_every_corner = subdiv_mesh_vertex_every_corner;
+  foreach_context->vertex_every_edge = subdiv_mesh_vertex_every_edge;
+  foreach_context->vertex_corner = subdiv_mesh_vertex_corner;
+  foreach_context->vertex_edge = subdiv_mesh_vertex_edge;
+  foreach_context->vertex_inner = subdiv_mesh_vertex_inner;
+  foreach_context->vertex_loose = subdiv_mesh_vertex_loose;
+  foreach_context->vertex_of_loose_edge = subdiv_mesh_vertex_of_loose_edge;
+  foreach_context->user_data_tls_free = subdiv_mesh_tls_free;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1219,6 +1336,7 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   SubdivForeachContext foreach_context;
   setup_foreach_callbacks(&subdiv_context, &foreach_context);
   SubdivMeshTLS tls = {0};
+  tls.ctx = &subdiv_context;
   foreach_context.user_data = &subdiv_context;
   foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
   foreach_context.user_data_tls = &tls;
@@ -1235,4 +1353,43 @@ Mesh *BKE_subdiv_to_mesh(Subdiv *subdiv,
   return result;
 }
 
+bool BKE_subdiv_to_mesh_update_positions(Subdiv *subdiv,
+                                         const SubdivToMeshSettings *settings,
+                                         const Mesh *coarse_mesh,
+                                         Mesh *subdiv_mesh)
+{
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  if (!BKE_subdiv_eval_begin_from_mesh(subdiv, coarse_mesh, NULL)) {
+    if (coarse_mesh->totpoly) {
+      BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+      return false;
+    }
+  }
+  SubdivMeshContext subdiv_context = {0};
+  subdiv_context.settings = settings;
+  subdiv_context.coarse_mesh = coarse_mesh;
+  subdiv_context.subdiv = subdiv;
+  subdiv_context.subdiv_mesh = subdiv_mesh;
+  subdiv_context.have_displacement = (subdiv->displacement_evaluator != NULL);
+  subdiv_context.can_evaluate_normals = !subdiv_context.have_displacement;
+  subdiv_context.update_positions_only = true;
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  SubdivForeachContext foreach_context;
+  setup_foreach_update_positions_callbacks(&foreach_context);
+  SubdivMeshTLS tls = {0};
+  tls.ctx = &subdiv_context;
+  foreach_context.user_data = &subdiv_context;
+  foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
+  foreach_context.user_data_tls = &tls;
+  const bool is_updated = BKE_subdiv_foreach_subdiv_geometry(
+      subdiv, &foreach_context, settings, coarse_mesh);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH);
+  if (is_updated && !subdiv_context.can_evaluate_normals) {
+    subdiv_mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  }
+  subdiv_mesh_context_free(&subdiv_context);
+  return is_updated;
+}
+
 /** \} */
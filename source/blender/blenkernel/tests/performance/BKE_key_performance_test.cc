@@ -0,0 +1,152 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_key.h"
+
+#include "DNA_ID.h"
+#include "DNA_ipo_types.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 10
+
+/* Synthetic face rig: a mesh object with many relative keys, each moving a small region of the
+ * mesh, without any Main database. */
+struct KeyFaceRig {
+  Object *ob;
+  Mesh *me;
+  Key *key;
+  int verts_num;
+};
+
+static float (*key_face_rig_add_shape(KeyFaceRig &rig, const float value))[3]
+{
+  KeyBlock *kb = BKE_keyblock_add(rig.key, nullptr);
+  kb->data = MEM_calloc_arrayN(rig.verts_num, sizeof(float[3]), __func__);
+  kb->totelem = rig.verts_num;
+  kb->curval = value;
+  return static_cast<float(*)[3]>(kb->data);
+}
+
+static KeyFaceRig key_face_rig_create(const int verts_num, const int keys_num, const int region)
+{
+  KeyFaceRig rig;
+  rig.verts_num = verts_num;
+  rig.key = static_cast<Key *>(MEM_callocN(sizeof(Key), __func__));
+  rig.key->type = KEY_RELATIVE;
+  rig.key->elemstr[0] = KEYELEM_FLOAT_LEN_COORD;
+  rig.key->elemstr[1] = IPO_FLOAT;
+  rig.key->elemsize = sizeof(float[KEYELEM_FLOAT_LEN_COORD]);
+  rig.key->uidgen = 1;
+
+  rig.me = static_cast<Mesh *>(MEM_callocN(sizeof(Mesh), __func__));
+  STRNCPY(rig.me->id.name, "MEKeyFaceRig");
+  rig.me->totvert = verts_num;
+  rig.me->key = rig.key;
+  rig.key->from = &rig.me->id;
+
+  rig.ob = static_cast<Object *>(MEM_callocN(sizeof(Object), __func__));
+  rig.ob->type = OB_MESH;
+  rig.ob->data = rig.me;
+  rig.ob->shapenr = 1;
+
+  RNG *rng = BLI_rng_new(0);
+  float(*basis)[3] = key_face_rig_add_shape(rig, 0.0f);
+  for (int i = 0; i < verts_num; i++) {
+    BLI_rng_get_float_unit_v3(rng, basis[i]);
+  }
+  for (int k = 0; k < keys_num; k++) {
+    float(*cos)[3] = key_face_rig_add_shape(rig, BLI_rng_get_float(rng));
+    memcpy(cos, basis, sizeof(float[3]) * verts_num);
+
+    const int region_start = BLI_rng_get_int(rng) % (verts_num - region);
+    for (int i = region_start; i < region_start + region; i++) {
+      float offset[3];
+      BLI_rng_get_float_unit_v3(rng, offset);
+      madd_v3_v3fl(cos[i], offset, 0.1f);
+    }
+  }
+  BLI_rng_free(rng);
+
+  return rig;
+}
+
+static void key_face_rig_free(KeyFaceRig &rig)
+{
+  BKE_key_free_nolib(rig.key);
+  MEM_freeN(rig.key);
+  MEM_freeN(rig.me);
+  MEM_freeN(rig.ob);
+}
+
+static void key_face_rig_test(const char *id, const bool use_evaluated_key)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  KeyFaceRig rig = key_face_rig_create(50000, 150, 2000);
+  if (use_evaluated_key) {
+    /* Evaluated key-blocks index their moved elements on first use. */
+    rig.key->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  }
+
+  float(*cos)[3] = static_cast<float(*)[3]>(
+      MEM_malloc_arrayN(rig.verts_num, sizeof(float[3]), __func__));
+  const size_t cos_size = sizeof(float[3]) * rig.verts_num;
+
+  const double first_time = PIL_check_seconds_timer();
+  BKE_key_evaluate_object_ex(rig.ob, nullptr, reinterpret_cast<float *>(cos), cos_size);
+  printf("\tFirst evaluation: done in %fs\n", PIL_check_seconds_timer() - first_time);
+
+  const double averaged_time = PIL_check_seconds_timer();
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    BKE_key_evaluate_object_ex(rig.ob, nullptr, reinterpret_cast<float *>(cos), cos_size);
+  }
+  printf("\tEvaluation: done in %fs on average over %d runs\n",
+         (PIL_check_seconds_timer() - averaged_time) / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+
+  MEM_freeN(cos);
+  rig.key->id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+  key_face_rig_free(rig);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(key_evaluate, FaceRigNoThread)
+{
+  key_face_rig_test("FaceRigNoThread", false);
+}
+
+TEST(key_evaluate, FaceRigEvaluatedNoThread)
+{
+  key_face_rig_test("FaceRigEvaluatedNoThread", true);
+}
+
+TEST(key_evaluate, FaceRig)
+{
+  BLI_task_scheduler_init();
+  key_face_rig_test("FaceRig", false);
+  BLI_task_scheduler_exit();
+}
+
+TEST(key_evaluate, FaceRigEvaluated)
+{
+  BLI_task_scheduler_init();
+  key_face_rig_test("FaceRigEvaluated", true);
+  BLI_task_scheduler_exit();
+}
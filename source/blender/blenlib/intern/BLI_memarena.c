@@ -210,3 +210,35 @@ void BLI_memarena_clear(MemArena *ma)
   VALGRIND_DESTROY_MEMPOOL(ma);
   VALGRIND_CREATE_MEMPOOL(ma, 0, false);
 }
+
+/**
+ * Move all memory of \a ma_src into \a ma_dst, \a ma_src is left empty but still valid.
+ * Allows threads to allocate from their own arena and hand over the result to a shared one.
+ *
+ * \note Allocations from \a ma_dst continue in its current buffer.
+ */
+void BLI_memarena_merge(MemArena *ma_dst, MemArena *ma_src)
+{
+  if (ma_src->bufs == NULL) {
+    return;
+  }
+
+  if (ma_dst->bufs == NULL) {
+    ma_dst->bufs = ma_src->bufs;
+    ma_dst->curbuf = ma_src->curbuf;
+    ma_dst->cursize = ma_src->cursize;
+  }
+  else {
+    /* Keep the current buffer of the destination first, it's the one used for allocations. */
+    struct MemBuf *mb_src_last = ma_src->bufs;
+    while (mb_src_last->next != NULL) {
+      mb_src_last = mb_src_last->next;
+    }
+    mb_src_last->next = ma_dst->bufs->next;
+    ma_dst->bufs->next = ma_src->bufs;
+  }
+
+  ma_src->bufs = NULL;
+  ma_src->curbuf = NULL;
+  ma_src->cursize = 0;
+}
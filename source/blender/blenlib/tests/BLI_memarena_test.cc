@@ -0,0 +1,51 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_memarena.h"
+
+TEST(memarena, Merge)
+{
+  MemArena *ma_dst = BLI_memarena_new(64, __func__);
+  MemArena *ma_src = BLI_memarena_new(64, __func__);
+
+  int *data_dst = (int *)BLI_memarena_alloc(ma_dst, sizeof(int));
+  *data_dst = 1;
+  /* Several buffers in the source arena. */
+  int *data_src[16];
+  for (int i = 0; i < 16; i++) {
+    data_src[i] = (int *)BLI_memarena_alloc(ma_src, sizeof(int[8]));
+    *data_src[i] = i;
+  }
+
+  BLI_memarena_merge(ma_dst, ma_src);
+  /* Both arenas remain usable. */
+  int *data_dst_next = (int *)BLI_memarena_alloc(ma_dst, sizeof(int));
+  *data_dst_next = 2;
+  int *data_src_next = (int *)BLI_memarena_alloc(ma_src, sizeof(int));
+  *data_src_next = 3;
+  BLI_memarena_free(ma_src);
+
+  EXPECT_EQ(*data_dst, 1);
+  EXPECT_EQ(*data_dst_next, 2);
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(*data_src[i], i);
+  }
+
+  BLI_memarena_free(ma_dst);
+}
+
+TEST(memarena, MergeIntoEmpty)
+{
+  MemArena *ma_dst = BLI_memarena_new(64, __func__);
+  MemArena *ma_src = BLI_memarena_new(64, __func__);
+
+  int *data_src = (int *)BLI_memarena_alloc(ma_src, sizeof(int));
+  *data_src = 1;
+
+  BLI_memarena_merge(ma_dst, ma_src);
+  BLI_memarena_free(ma_src);
+  EXPECT_EQ(*data_src, 1);
+
+  BLI_memarena_free(ma_dst);
+}
@@ -129,6 +129,7 @@
 #include "BKE_idprop.h"
 #include "BKE_idtype.h"
 #include "BKE_image.h"
+#include "BKE_key.h"
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
 #include "BKE_lib_override.h"
@@ -3908,7 +3909,10 @@ static void switch_endian_keyblock(Key *key, KeyBlock *kb)
   elemsize = key->elemsize;
   data = kb->data;
 
-  for (a = 0; a < kb->totelem; a++) {
+  /* Sparse key-blocks only store some elements. */
+  const int totelem = kb->sparse_index ? kb->sparse_totelem : kb->totelem;
+
+  for (a = 0; a < totelem; a++) {
     const char *cp = key->elemstr;
     char *poin = data;
 
@@ -3942,11 +3946,21 @@ static void direct_link_key(BlendDataReader *reader, Key *key)
 
   for (kb = key->block.first; kb; kb = kb->next) {
     BLO_read_data_address(reader, &kb->data);
+    BLO_read_int32_array(reader, kb->sparse_totelem, &kb->sparse_index);
+    kb->moved_index = NULL;
+    kb->moved_totelem = 0;
 
-    if (BLO_read_requires_endian_switch(reader)) {
+    if (kb->data && BLO_read_requires_endian_switch(reader)) {
       switch_endian_keyblock(key, kb);
     }
   }
+
+  /* Expand sparse key-blocks once the reference key is read. */
+  for (kb = key->block.first; kb; kb = kb->next) {
+    if (kb->sparse_index) {
+      BKE_keyblock_sparse_data_expand(key, kb);
+    }
+  }
 }
 
 /** \} */
@@ -165,6 +165,7 @@
 #include "BKE_global.h"  // for G
 #include "BKE_gpencil_modifier.h"
 #include "BKE_idtype.h"
+#include "BKE_key.h"
 #include "BKE_layer.h"
 #include "BKE_lib_id.h"
 #include "BKE_lib_override.h"
@@ -1941,6 +1942,23 @@ static void write_key(BlendWriter *writer, Key *key, const void *id_address)
 
     /* direct data */
     LISTBASE_FOREACH (KeyBlock *, kb, &key->block) {
+      KeyBlock kb_sparse = *kb;
+
+      /* Undo keeps dense data, unchanged key-blocks are shared between undo steps already. */
+      if ((key->flag & KEY_SPARSE_STORAGE) && !BLO_write_is_undo(writer) &&
+          BKE_keyblock_sparse_data_create(key,
+                                          kb,
+                                          &kb_sparse.sparse_index,
+                                          (float(**)[3])&kb_sparse.data,
+                                          &kb_sparse.sparse_totelem)) {
+        BLO_write_struct_at_address(writer, KeyBlock, kb, &kb_sparse);
+        BLO_write_int32_array(writer, kb_sparse.sparse_totelem, kb_sparse.sparse_index);
+        BLO_write_float3_array(writer, kb_sparse.sparse_totelem, kb_sparse.data);
+        MEM_freeN(kb_sparse.sparse_index);
+        MEM_freeN(kb_sparse.data);
+        continue;
+      }
+
       BLO_write_struct(writer, KeyBlock, kb);
       if (kb->data) {
         BLO_write_raw(writer, kb->totelem * key->elemsize, kb->data);
@@ -3955,6 +3973,20 @@ static void write_libraries(WriteData *wd, Main *main)
   mywrite_flush(wd);
 }
 
+/* Versions before this would read sparse key-blocks as dense, past the end of their data. */
+#define KEY_SPARSE_STORAGE_MIN_VERSION 291
+#define KEY_SPARSE_STORAGE_MIN_SUBVERSION 1
+
+static bool write_uses_sparse_keys(Main *mainvar)
+{
+  LISTBASE_FOREACH (Key *, key, &mainvar->shapekeys) {
+    if (key->id.us > 0 && (key->flag & KEY_SPARSE_STORAGE)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /* context is usually defined by WM, two cases where no WM is available:
  * - for forward compatibility, curscreen has to be saved
  * - for undofile, curscene needs to be saved */
@@ -3991,6 +4023,11 @@ static void write_global(WriteData *wd, int fileflags, Main *mainvar)
   fg.subversion = BLENDER_FILE_SUBVERSION;
   fg.minversion = BLENDER_FILE_MIN_VERSION;
   fg.minsubversion = BLENDER_FILE_MIN_SUBVERSION;
+  if (!is_undo && write_uses_sparse_keys(mainvar)) {
+    /* Make older versions warn about the file instead of silently reading garbage. */
+    fg.minversion = KEY_SPARSE_STORAGE_MIN_VERSION;
+    fg.minsubversion = KEY_SPARSE_STORAGE_MIN_SUBVERSION;
+  }
 #ifdef WITH_BUILDINFO
   {
     extern unsigned long build_commit_timestamp;
@@ -20,24 +20,43 @@
  * \ingroup fn
  */
 
+#include <mutex>
+
 #include "FN_multi_function_network.hh"
 
 namespace blender::fn {
 
 class MFNetworkEvaluationStorage;
+class MFNetworkEvaluationBufferPool;
 
 class MFNetworkEvaluator : public MultiFunction {
  private:
   Vector<const MFOutputSocket *> inputs_;
   Vector<const MFInputSocket *> outputs_;
+  /** Function nodes in the order they are evaluated in. This only depends on the network. */
+  Vector<const MFFunctionNode *> schedule_;
+
+  /**
+   * Temporary buffers of previous evaluations, so that they do not have to be allocated again.
+   * There is one pool per evaluation that runs at the same time.
+   */
+  mutable Vector<MFNetworkEvaluationBufferPool *> buffer_pools_;
+  mutable std::mutex buffer_pools_mutex_;
 
  public:
   MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs, Vector<const MFInputSocket *> outputs);
+  ~MFNetworkEvaluator();
 
   void call(IndexMask mask, MFParams params, MFContext context) const override;
 
  private:
   using Storage = MFNetworkEvaluationStorage;
+  using BufferPool = MFNetworkEvaluationBufferPool;
+
+  void compute_schedule();
+
+  BufferPool *pop_buffer_pool() const;
+  void push_buffer_pool(BufferPool *buffer_pool) const;
 
   void copy_inputs_to_storage(MFParams params, Storage &storage) const;
   void copy_outputs_to_storage(
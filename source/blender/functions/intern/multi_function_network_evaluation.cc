@@ -28,13 +28,15 @@
  * - Avoids data copies in many cases.
  * - Every node is executed at most once.
  * - Can compute sub-functions on a single element, when the result is the same for all elements.
- *
- * Possible improvements:
- * - Cache and reuse buffers.
- * - Use "deepest depth first" heuristic to decide which order the inputs of a node should be
- *   computed. This reduces the number of required temporary buffers when they are reused.
+ * - The order in which nodes are executed is computed once, when the evaluator is created. The
+ *   inputs of a node are computed in "deepest depth first" order. This reduces the number of
+ *   temporary buffers that are alive at the same time.
+ * - Temporary buffers are freed after their last use and reused for other values. They are kept
+ *   around for later evaluations of the same network as well.
  */
 
+#include <algorithm>
+
 #include "FN_multi_function_network_evaluation.hh"
 
 #include "BLI_stack.hh"
@@ -43,6 +45,31 @@ namespace blender::fn {
 
 struct Value;
 
+/**
+ * Temporary buffers that are not used by any value currently. Allocating a new buffer for every
+ * intermediate value is expensive for large arrays, because the memory has to be mapped and
+ * touched again. A buffer can be reused for any value that fits into it.
+ *
+ * The pool does not hold more buffers than have been alive at the same time during a single
+ * evaluation, because buffers that are too small are replaced instead of being added to.
+ */
+class MFNetworkEvaluationBufferPool : NonCopyable, NonMovable {
+ private:
+  struct Buffer {
+    void *data;
+    int64_t size;
+    int64_t alignment;
+  };
+
+  Vector<Buffer> buffers_;
+
+ public:
+  ~MFNetworkEvaluationBufferPool();
+
+  void *allocate(int64_t size, int64_t alignment);
+  void deallocate(void *data, int64_t size, int64_t alignment);
+};
+
 /**
  * This keeps track of all the values that flow through the multi-function network. Therefore it
  * maintains a mapping between output sockets and their corresponding values. Every `value`
@@ -53,12 +80,15 @@ struct Value;
 class MFNetworkEvaluationStorage {
  private:
   LinearAllocator<> allocator_;
+  MFNetworkEvaluationBufferPool &buffer_pool_;
   IndexMask mask_;
   Array<Value *> value_per_output_id_;
   int64_t min_array_size_;
 
  public:
-  MFNetworkEvaluationStorage(IndexMask mask, int socket_id_amount);
+  MFNetworkEvaluationStorage(IndexMask mask,
+                             int socket_id_amount,
+                             MFNetworkEvaluationBufferPool &buffer_pool);
   ~MFNetworkEvaluationStorage();
 
   /* Add the values that have been provided by the caller of the multi-function network. */
@@ -133,6 +163,107 @@ MFNetworkEvaluator::MFNetworkEvaluator(Vector<const MFOutputSocket *> inputs,
         break;
     }
   }
+
+  this->compute_schedule();
+}
+
+MFNetworkEvaluator::~MFNetworkEvaluator()
+{
+  for (BufferPool *buffer_pool : buffer_pools_) {
+    delete buffer_pool;
+  }
+}
+
+/**
+ * Traverses the network in the same way as a naive evaluation would, without evaluating any
+ * nodes. This is done twice: the first pass computes the depth of every node, the second pass
+ * uses it to compute the deepest inputs first.
+ */
+void MFNetworkEvaluator::compute_schedule()
+{
+  const MFNetwork &network = outputs_[0]->node().network();
+  /* The depth is the length of the longest path to a dummy node, -1 means not scheduled yet. */
+  Array<int> depth_per_node(network.node_id_amount());
+  Array<int> sort_depth_per_node(network.node_id_amount(), 0);
+  Vector<const MFOutputSocket *> unscheduled_origins;
+
+  for (const bool use_depth : {false, true}) {
+    depth_per_node.fill(-1);
+    schedule_.clear();
+
+    Stack<const MFOutputSocket *, 32> sockets_to_compute;
+    for (const MFInputSocket *socket : outputs_) {
+      sockets_to_compute.push(socket->origin());
+    }
+
+    while (!sockets_to_compute.is_empty()) {
+      const MFNode &node = sockets_to_compute.peek()->node();
+
+      if (node.is_dummy() || depth_per_node[node.id()] >= 0) {
+        sockets_to_compute.pop();
+        continue;
+      }
+
+      BLI_assert(!node.has_unlinked_inputs());
+      const MFFunctionNode &function_node = node.as_function();
+
+      int max_origin_depth = 0;
+      unscheduled_origins.clear();
+      for (const MFInputSocket *input_socket : function_node.inputs()) {
+        const MFOutputSocket *origin = input_socket->origin();
+        const MFNode &origin_node = origin->node();
+        if (origin_node.is_dummy()) {
+          continue;
+        }
+        const int origin_depth = depth_per_node[origin_node.id()];
+        if (origin_depth >= 0) {
+          max_origin_depth = std::max(max_origin_depth, origin_depth);
+        }
+        else {
+          unscheduled_origins.append(origin);
+        }
+      }
+
+      if (unscheduled_origins.is_empty()) {
+        depth_per_node[node.id()] = max_origin_depth + 1;
+        schedule_.append(&function_node);
+        sockets_to_compute.pop();
+        continue;
+      }
+
+      if (use_depth) {
+        /* The socket on top of the stack is computed first. */
+        std::stable_sort(unscheduled_origins.begin(),
+                         unscheduled_origins.end(),
+                         [&](const MFOutputSocket *a, const MFOutputSocket *b) {
+                           return sort_depth_per_node[a->node().id()] <
+                                  sort_depth_per_node[b->node().id()];
+                         });
+      }
+      for (const MFOutputSocket *origin : unscheduled_origins) {
+        sockets_to_compute.push(origin);
+      }
+    }
+
+    sort_depth_per_node = depth_per_node;
+  }
+}
+
+MFNetworkEvaluator::BufferPool *MFNetworkEvaluator::pop_buffer_pool() const
+{
+  {
+    std::lock_guard lock{buffer_pools_mutex_};
+    if (!buffer_pools_.is_empty()) {
+      return buffer_pools_.pop_last();
+    }
+  }
+  return new BufferPool();
+}
+
+void MFNetworkEvaluator::push_buffer_pool(BufferPool *buffer_pool) const
+{
+  std::lock_guard lock{buffer_pools_mutex_};
+  buffer_pools_.append(buffer_pool);
 }
 
 void MFNetworkEvaluator::call(IndexMask mask, MFParams params, MFContext context) const
@@ -142,14 +273,20 @@ void MFNetworkEvaluator::call(IndexMask mask, MFParams params, MFContext context
   }
 
   const MFNetwork &network = outputs_[0]->node().network();
-  Storage storage(mask, network.socket_id_amount());
+  BufferPool *buffer_pool = this->pop_buffer_pool();
 
-  Vector<const MFInputSocket *> outputs_to_initialize_in_the_end;
+  {
+    Storage storage(mask, network.socket_id_amount(), *buffer_pool);
+
+    Vector<const MFInputSocket *> outputs_to_initialize_in_the_end;
 
-  this->copy_inputs_to_storage(params, storage);
-  this->copy_outputs_to_storage(params, storage, outputs_to_initialize_in_the_end);
-  this->evaluate_network_to_compute_outputs(context, storage);
-  this->initialize_remaining_outputs(params, storage, outputs_to_initialize_in_the_end);
+    this->copy_inputs_to_storage(params, storage);
+    this->copy_outputs_to_storage(params, storage, outputs_to_initialize_in_the_end);
+    this->evaluate_network_to_compute_outputs(context, storage);
+    this->initialize_remaining_outputs(params, storage, outputs_to_initialize_in_the_end);
+  }
+
+  this->push_buffer_pool(buffer_pool);
 }
 
 BLI_NOINLINE void MFNetworkEvaluator::copy_inputs_to_storage(MFParams params,
@@ -214,40 +351,13 @@ BLI_NOINLINE void MFNetworkEvaluator::copy_outputs_to_storage(
 BLI_NOINLINE void MFNetworkEvaluator::evaluate_network_to_compute_outputs(
     MFContext &global_context, Storage &storage) const
 {
-  Stack<const MFOutputSocket *, 32> sockets_to_compute;
-  for (const MFInputSocket *socket : outputs_) {
-    sockets_to_compute.push(socket->origin());
-  }
-
-  /* This is the main loop that traverses the MFNetwork. */
-  while (!sockets_to_compute.is_empty()) {
-    const MFOutputSocket &socket = *sockets_to_compute.peek();
-    const MFNode &node = socket.node();
-
-    if (storage.socket_is_computed(socket)) {
-      sockets_to_compute.pop();
-      continue;
-    }
-
-    BLI_assert(node.is_function());
-    BLI_assert(!node.has_unlinked_inputs());
-    const MFFunctionNode &function_node = node.as_function();
-
-    bool all_origins_are_computed = true;
-    for (const MFInputSocket *input_socket : function_node.inputs()) {
-      const MFOutputSocket *origin = input_socket->origin();
-      if (origin != nullptr) {
-        if (!storage.socket_is_computed(*origin)) {
-          sockets_to_compute.push(origin);
-          all_origins_are_computed = false;
-        }
-      }
-    }
-
-    if (all_origins_are_computed) {
-      this->evaluate_function(global_context, function_node, storage);
-      sockets_to_compute.pop();
+  for (const MFFunctionNode *function_node : schedule_) {
+#ifdef DEBUG
+    for (const MFInputSocket *input_socket : function_node->inputs()) {
+      BLI_assert(storage.socket_is_computed(*input_socket->origin()));
     }
+#endif
+    this->evaluate_function(global_context, *function_node, storage);
   }
 }
 
@@ -502,12 +612,65 @@ struct OwnVectorValue : public Value {
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Buffer Pool methods
+ * \{ */
+
+MFNetworkEvaluationBufferPool::~MFNetworkEvaluationBufferPool()
+{
+  for (Buffer &buffer : buffers_) {
+    MEM_freeN(buffer.data);
+  }
+}
+
+void *MFNetworkEvaluationBufferPool::allocate(int64_t size, int64_t alignment)
+{
+  /* Use the smallest buffer that is large enough. */
+  int64_t best_index = -1;
+  int64_t largest_index = -1;
+  for (int64_t i : buffers_.index_range()) {
+    const Buffer &buffer = buffers_[i];
+    if (buffer.size >= size && buffer.alignment >= alignment) {
+      if (best_index == -1 || buffer.size < buffers_[best_index].size) {
+        best_index = i;
+      }
+    }
+    if (largest_index == -1 || buffer.size > buffers_[largest_index].size) {
+      largest_index = i;
+    }
+  }
+
+  if (best_index >= 0) {
+    void *data = buffers_[best_index].data;
+    buffers_.remove_and_reorder(best_index);
+    return data;
+  }
+
+  /* Replace a buffer that does not fit, so that the pool does not keep growing when the array
+   * size of the evaluations increases. */
+  if (largest_index >= 0) {
+    MEM_freeN(buffers_[largest_index].data);
+    buffers_.remove_and_reorder(largest_index);
+  }
+  return MEM_mallocN_aligned(size, alignment, AT);
+}
+
+void MFNetworkEvaluationBufferPool::deallocate(void *data, int64_t size, int64_t alignment)
+{
+  buffers_.append({data, size, alignment});
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Storage methods
  * \{ */
 
-MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask, int socket_id_amount)
-    : mask_(mask),
+MFNetworkEvaluationStorage::MFNetworkEvaluationStorage(IndexMask mask,
+                                                       int socket_id_amount,
+                                                       MFNetworkEvaluationBufferPool &buffer_pool)
+    : buffer_pool_(buffer_pool),
+      mask_(mask),
       value_per_output_id_(socket_id_amount, nullptr),
       min_array_size_(mask.min_array_size())
 {
@@ -528,7 +691,7 @@ MFNetworkEvaluationStorage::~MFNetworkEvaluationStorage()
       }
       else {
         type.destruct_indices(span.data(), mask_);
-        MEM_freeN(span.data());
+        buffer_pool_.deallocate(span.data(), min_array_size_ * type.size(), type.alignment());
       }
     }
     else if (any_value->type == ValueType::OwnVector) {
@@ -638,7 +801,7 @@ void MFNetworkEvaluationStorage::finish_input_socket(const MFInputSocket &socket
         }
         else {
           type.destruct_indices(span.data(), mask_);
-          MEM_freeN(span.data());
+          buffer_pool_.deallocate(span.data(), min_array_size_ * type.size(), type.alignment());
         }
         value_per_output_id_[origin.id()] = nullptr;
       }
@@ -702,7 +865,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_single_output__full(const MFOutputS
   Value *any_value = value_per_output_id_[socket.id()];
   if (any_value == nullptr) {
     const CPPType &type = socket.data_type().single_type();
-    void *buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+    void *buffer = buffer_pool_.allocate(min_array_size_ * type.size(), type.alignment());
     GMutableSpan span(type, buffer, min_array_size_);
 
     auto *value = allocator_.construct<OwnSingleValue>(span, socket.targets().size(), false);
@@ -802,7 +965,7 @@ GMutableSpan MFNetworkEvaluationStorage::get_mutable_single__full(const MFInputS
   }
 
   GVSpan virtual_span = this->get_single_input__full(input);
-  void *new_buffer = MEM_mallocN_aligned(min_array_size_ * type.size(), type.alignment(), AT);
+  void *new_buffer = buffer_pool_.allocate(min_array_size_ * type.size(), type.alignment());
   GMutableSpan new_array_ref(type, new_buffer, min_array_size_);
   virtual_span.materialize_to_uninitialized(mask_, new_array_ref.data());
 
@@ -251,5 +251,59 @@ TEST(multi_function_network, Test2)
   }
 }
 
+TEST(multi_function_network, ReuseBuffers)
+{
+  CustomMF_SI_SO<int, int> add_1_fn("add 1", [](int value) { return value + 1; });
+  CustomMF_SI_SO<int, int> double_fn("double", [](int value) { return value * 2; });
+  CustomMF_SI_SI_SO<int, int, int> add_fn("add", [](int a, int b) { return a + b; });
+
+  MFNetwork network;
+
+  MFOutputSocket &input_socket = network.add_input("Input", MFDataType::ForSingle<int>());
+  MFInputSocket &output_socket = network.add_output("Output", MFDataType::ForSingle<int>());
+
+  /* Two chains with different lengths, that are joined in the end. */
+  MFOutputSocket *chain1 = &input_socket;
+  for (int i = 0; i < 10; i++) {
+    MFNode &node = network.add_function(add_1_fn);
+    network.add_link(*chain1, node.input(0));
+    chain1 = &node.output(0);
+  }
+  MFOutputSocket *chain2 = &input_socket;
+  for (int i = 0; i < 3; i++) {
+    MFNode &node = network.add_function(double_fn);
+    network.add_link(*chain2, node.input(0));
+    chain2 = &node.output(0);
+  }
+  MFNode &add_node = network.add_function(add_fn);
+  network.add_link(*chain2, add_node.input(0));
+  network.add_link(*chain1, add_node.input(1));
+  network.add_link(add_node.output(0), output_socket);
+
+  MFNetworkEvaluator network_fn{{&input_socket}, {&output_socket}};
+
+  /* Evaluate multiple times with different sizes, so that buffers of previous evaluations are
+   * reused even when they are too large or too small. */
+  for (const int size : {5, 1000, 3, 1000, 20}) {
+    Array<int> values(size);
+    for (int i : values.index_range()) {
+      values[i] = i;
+    }
+    Array<int> results(size, -1);
+
+    MFParamsBuilder params(network_fn, size);
+    params.add_readonly_single_input(values.as_span());
+    params.add_uninitialized_single_output(results.as_mutable_span());
+
+    MFContextBuilder context;
+
+    network_fn.call(IndexRange(size), params, context);
+
+    for (int i : values.index_range()) {
+      EXPECT_EQ(results[i], i * 8 + i + 10);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace blender::fn::tests
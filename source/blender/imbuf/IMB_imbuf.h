@@ -462,6 +462,24 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
  */
 void IMB_scaleImBuf_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum eIMBScaleFilter {
+  IMB_SCALE_FILTER_BOX = 0,
+  IMB_SCALE_FILTER_BILINEAR,
+  IMB_SCALE_FILTER_BICUBIC,
+  IMB_SCALE_FILTER_LANCZOS,
+} eIMBScaleFilter;
+
+/**
+ * Separable, multi-threaded resampling of byte and float buffers with given filter kernel.
+ * Return true if \a ibuf is modified.
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filtered(struct ImBuf *ibuf,
+                             unsigned int newx,
+                             unsigned int newy,
+                             eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in writeimage.c
@@ -58,6 +58,13 @@ typedef struct ColorSpace {
     bool is_srgb;
     bool is_scene_linear;
   } info;
+
+  /* Byte to scene linear lookup table, computed only when needed. */
+  struct {
+    bool cached;
+    /* 256 RGB entries, NULL if conversion is not done per channel. */
+    float (*table)[3];
+  } byte_lut;
 } ColorSpace;
 
 typedef struct ColorManagedDisplay {
@@ -604,6 +604,8 @@ static void colormanage_free_config(void)
       OCIO_processorRelease((OCIO_ConstProcessorRcPtr *)colorspace->from_scene_linear);
     }
 
+    MEM_SAFE_FREE(colorspace->byte_lut.table);
+
     /* free color space itself */
     MEM_freeN(colorspace);
 
@@ -958,6 +960,61 @@ static OCIO_ConstProcessorRcPtr *colorspace_to_scene_linear_processor(ColorSpace
   return (OCIO_ConstProcessorRcPtr *)colorspace->to_scene_linear;
 }
 
+/* Tabulate byte to scene linear conversion. Most byte color spaces (sRGB in particular) are
+ * converted per channel, in which case whole conversion of a pixel is three table lookups
+ * instead of going through OCIO. Returns NULL when channels are not converted independently. */
+static float (*colorspace_byte_lut_create(OCIO_ConstProcessorRcPtr *processor))[3]
+{
+  float(*table)[3] = MEM_mallocN(sizeof(float[256][3]), "colorspace byte lut");
+
+  for (int i = 0; i < 256; i++) {
+    const float value = (float)i * (1.0f / 255.0f);
+    float pixel[3] = {value, value, value};
+    OCIO_processorApplyRGB(processor, pixel);
+    copy_v3_v3(table[i], pixel);
+  }
+
+  /* Check that channels don't affect each other, such as with gamut conversion. */
+  for (int i = 0; i < 256; i += 15) {
+    const int index[3] = {i, 255 - i, (i * 7) % 256};
+    float pixel[3];
+    for (int c = 0; c < 3; c++) {
+      pixel[c] = (float)index[c] * (1.0f / 255.0f);
+    }
+    OCIO_processorApplyRGB(processor, pixel);
+
+    for (int c = 0; c < 3; c++) {
+      const float expected = table[index[c]][c];
+      if (fabsf(pixel[c] - expected) > 1e-5f * max_ff(1.0f, fabsf(expected))) {
+        MEM_freeN(table);
+        return NULL;
+      }
+    }
+  }
+
+  return table;
+}
+
+static const float (*colorspace_to_scene_linear_byte_lut(ColorSpace *colorspace))[3]
+{
+  if (!colorspace->byte_lut.cached) {
+    OCIO_ConstProcessorRcPtr *processor = colorspace_to_scene_linear_processor(colorspace);
+
+    BLI_mutex_lock(&processor_lock);
+
+    if (!colorspace->byte_lut.cached) {
+      if (processor) {
+        colorspace->byte_lut.table = colorspace_byte_lut_create(processor);
+      }
+      colorspace->byte_lut.cached = true;
+    }
+
+    BLI_mutex_unlock(&processor_lock);
+  }
+
+  return (const float(*)[3])colorspace->byte_lut.table;
+}
+
 static OCIO_ConstProcessorRcPtr *colorspace_from_scene_linear_processor(ColorSpace *colorspace)
 {
   if (colorspace->from_scene_linear == NULL) {
@@ -1573,24 +1630,46 @@ static void display_buffer_apply_get_linear_buffer(DisplayBufferThread *handle,
     const size_t i_last = ((size_t)width) * height;
     size_t i;
 
-    /* first convert byte buffer to float, keep in image space */
-    for (i = 0, fp = linear_buffer, cp = byte_buffer; i != i_last;
-         i++, fp += channels, cp += channels) {
-      if (channels == 3) {
-        rgb_uchar_to_float(fp, cp);
-      }
-      else if (channels == 4) {
-        rgba_uchar_to_float(fp, cp);
+    const float(*lut)[3] = NULL;
+    if (!is_data && !is_data_display && channels >= 3) {
+      ColorSpace *colorspace = colormanage_colorspace_get_named(from_colorspace);
+      if (colorspace != NULL && !STREQ(from_colorspace, to_colorspace)) {
+        lut = colorspace_to_scene_linear_byte_lut(colorspace);
       }
-      else {
-        BLI_assert(!"Buffers of 3 or 4 channels are only supported here");
+    }
+
+    if (lut) {
+      /* convert byte buffer directly to scene linear space */
+      for (i = 0, fp = linear_buffer, cp = byte_buffer; i != i_last;
+           i++, fp += channels, cp += channels) {
+        fp[0] = lut[cp[0]][0];
+        fp[1] = lut[cp[1]][1];
+        fp[2] = lut[cp[2]][2];
+        if (channels == 4) {
+          fp[3] = (float)cp[3] * (1.0f / 255.0f);
+        }
       }
     }
+    else {
+      /* first convert byte buffer to float, keep in image space */
+      for (i = 0, fp = linear_buffer, cp = byte_buffer; i != i_last;
+           i++, fp += channels, cp += channels) {
+        if (channels == 3) {
+          rgb_uchar_to_float(fp, cp);
+        }
+        else if (channels == 4) {
+          rgba_uchar_to_float(fp, cp);
+        }
+        else {
+          BLI_assert(!"Buffers of 3 or 4 channels are only supported here");
+        }
+      }
 
-    if (!is_data && !is_data_display) {
-      /* convert float buffer to scene linear space */
-      IMB_colormanagement_transform(
-          linear_buffer, width, height, channels, from_colorspace, to_colorspace, false);
+      if (!is_data && !is_data_display) {
+        /* convert float buffer to scene linear space */
+        IMB_colormanagement_transform(
+            linear_buffer, width, height, channels, from_colorspace, to_colorspace, false);
+      }
     }
 
     *is_straight_alpha = true;
@@ -2247,9 +2326,11 @@ void IMB_colormanagement_imbuf_to_byte_texture(unsigned char *out_buffer,
   BLI_assert(ibuf->rect && ibuf->rect_float == NULL);
 
   OCIO_ConstProcessorRcPtr *processor = NULL;
+  const float(*lut)[3] = NULL;
   if (compress_as_srgb && ibuf->rect_colorspace &&
       !IMB_colormanagement_space_is_srgb(ibuf->rect_colorspace)) {
     processor = colorspace_to_scene_linear_processor(ibuf->rect_colorspace);
+    lut = colorspace_to_scene_linear_byte_lut(ibuf->rect_colorspace);
   }
 
   /* TODO(brecht): make this multi-threaded, or at least process in batches. */
@@ -2262,7 +2343,18 @@ void IMB_colormanagement_imbuf_to_byte_texture(unsigned char *out_buffer,
     const unsigned char *in = in_buffer + in_offset * 4;
     unsigned char *out = out_buffer + out_offset * 4;
 
-    if (processor) {
+    if (lut) {
+      /* Same as below, but with scene linear conversion from lookup table. */
+      for (int x = 0; x < width; x++, in += 4, out += 4) {
+        float pixel[4] = {lut[in[0]][0], lut[in[1]][1], lut[in[2]][2], in[3] * (1.0f / 255.0f)};
+        linearrgb_to_srgb_v3_v3(pixel, pixel);
+        if (use_premultiply) {
+          mul_v3_fl(pixel, pixel[3]);
+        }
+        rgba_float_to_uchar(out, pixel);
+      }
+    }
+    else if (processor) {
       /* Convert to scene linear, to sRGB and premultiply. */
       for (int x = 0; x < width; x++, in += 4, out += 4) {
         float pixel[4];
@@ -3913,15 +4005,21 @@ void IMB_colormanagement_processor_apply_byte(
    * but for now it's not so important.
    */
   BLI_assert(channels == 4);
-  float pixel[4];
+
+  /* Process a scanline at a time, so OCIO can apply transform to a whole packed image
+   * instead of being called for every pixel. */
+  float *scanline = MEM_mallocN(sizeof(float[4]) * width, "colormanagement byte scanline");
   for (int y = 0; y < height; y++) {
+    unsigned char *row = buffer + channels * ((size_t)y) * width;
+    for (int x = 0; x < width; x++) {
+      rgba_uchar_to_float(scanline + 4 * x, row + channels * x);
+    }
+    IMB_colormanagement_processor_apply(cm_processor, scanline, width, 1, 4, false);
     for (int x = 0; x < width; x++) {
-      size_t offset = channels * (((size_t)y) * width + x);
-      rgba_uchar_to_float(pixel, buffer + offset);
-      IMB_colormanagement_processor_apply_v4(cm_processor, pixel);
-      rgba_float_to_uchar(buffer + offset, pixel);
+      rgba_float_to_uchar(row + channels * x, scanline + 4 * x);
     }
   }
+  MEM_freeN(scanline);
 }
 
 void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
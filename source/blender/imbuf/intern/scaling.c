@@ -22,8 +22,10 @@
  * \ingroup imbuf
  */
 
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "MEM_guardedalloc.h"
 
@@ -1758,119 +1760,339 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
   return true;
 }
 
-/* ******** threaded scaling ******** */
+/* ******** filtered scaling ******** */
 
-typedef struct ScaleTreadInitData {
-  ImBuf *ibuf;
+/* Weights of source pixels contributing to each pixel of the scaled axis. */
+typedef struct ScaleFilterWeights {
+  /* First contributing source pixel and number of contributing pixels, per destination pixel. */
+  int *start;
+  int *count;
+  /* Normalized weights, `max_count` per destination pixel. */
+  float *weights;
+  int max_count;
+} ScaleFilterWeights;
 
-  unsigned int newx;
-  unsigned int newy;
+static float scale_filter_support(eIMBScaleFilter filter)
+{
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return 0.5f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return 1.0f;
+    case IMB_SCALE_FILTER_BICUBIC:
+      return 2.0f;
+    case IMB_SCALE_FILTER_LANCZOS:
+      return 3.0f;
+  }
+  return 1.0f;
+}
 
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleTreadInitData;
+static float scale_filter_sinc(float x)
+{
+  if (x == 0.0f) {
+    return 1.0f;
+  }
+  x *= (float)M_PI;
+  return sinf(x) / x;
+}
 
-typedef struct ScaleThreadData {
-  ImBuf *ibuf;
+static float scale_filter_eval(eIMBScaleFilter filter, float x)
+{
+  x = fabsf(x);
+
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return (x <= 0.5f) ? 1.0f : 0.0f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return (x < 1.0f) ? 1.0f - x : 0.0f;
+    case IMB_SCALE_FILTER_BICUBIC: {
+      /* Catmull-Rom (cubic convolution with a = -0.5). */
+      const float a = -0.5f;
+      if (x < 1.0f) {
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+      }
+      if (x < 2.0f) {
+        return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
+      }
+      return 0.0f;
+    }
+    case IMB_SCALE_FILTER_LANCZOS:
+      return (x < 3.0f) ? scale_filter_sinc(x) * scale_filter_sinc(x / 3.0f) : 0.0f;
+  }
+  return 0.0f;
+}
 
-  unsigned int newx;
-  unsigned int newy;
+static void scale_filter_weights_init(ScaleFilterWeights *fw,
+                                      int src_size,
+                                      int dst_size,
+                                      eIMBScaleFilter filter)
+{
+  const float scale = (float)src_size / (float)dst_size;
+  /* Widen the kernel when scaling down, so all source pixels contribute. */
+  const float filter_scale = max_ff(scale, 1.0f);
+  const float support = scale_filter_support(filter) * filter_scale;
+
+  fw->max_count = (int)ceilf(support * 2.0f) + 1;
+  fw->start = MEM_mallocN(sizeof(int) * dst_size, "scale filter start");
+  fw->count = MEM_mallocN(sizeof(int) * dst_size, "scale filter count");
+  fw->weights = MEM_callocN(sizeof(float) * dst_size * fw->max_count, "scale filter weights");
+
+  for (int i = 0; i < dst_size; i++) {
+    const float center = ((float)i + 0.5f) * scale;
+    const int start = max_ii((int)floorf(center - support), 0);
+    const int end = min_iii((int)ceilf(center + support), src_size, start + fw->max_count);
+    float *weights = fw->weights + (size_t)i * fw->max_count;
+    float weight_sum = 0.0f;
+
+    for (int j = start; j < end; j++) {
+      const float w = scale_filter_eval(filter, ((float)j + 0.5f - center) / filter_scale);
+      weights[j - start] = w;
+      weight_sum += w;
+    }
 
-  int start_line;
-  int tot_line;
+    fw->start[i] = start;
+    fw->count[i] = end - start;
 
-  unsigned char *byte_buffer;
-  float *float_buffer;
-} ScaleThreadData;
+    if (weight_sum != 0.0f) {
+      const float inv_sum = 1.0f / weight_sum;
+      for (int j = 0; j < end - start; j++) {
+        weights[j] *= inv_sum;
+      }
+    }
+    else {
+      /* Kernel didn't cover any pixel center, use nearest pixel. */
+      fw->start[i] = min_ii((int)center, src_size - 1);
+      fw->count[i] = 1;
+      weights[0] = 1.0f;
+    }
+  }
+}
 
-static void scale_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
+static void scale_filter_weights_free(ScaleFilterWeights *fw)
 {
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ScaleTreadInitData *init_data = (ScaleTreadInitData *)init_data_v;
+  MEM_freeN(fw->start);
+  MEM_freeN(fw->count);
+  MEM_freeN(fw->weights);
+}
 
-  data->ibuf = init_data->ibuf;
+typedef struct ScaleFilterData {
+  ScaleFilterWeights weights_x, weights_y;
+  int src_x, newx, newy;
 
-  data->newx = init_data->newx;
-  data->newy = init_data->newy;
+  const unsigned char *src_byte;
+  const float *src_float;
+  int float_channels;
 
-  data->start_line = start_line;
-  data->tot_line = tot_line;
+  /* Horizontally scaled rows, newx * ibuf->y pixels. */
+  float *tmp_byte;
+  float *tmp_float;
 
-  data->byte_buffer = init_data->byte_buffer;
-  data->float_buffer = init_data->float_buffer;
-}
+  unsigned char *dst_byte;
+  float *dst_float;
+} ScaleFilterData;
 
-static void *do_scale_thread(void *data_v)
+static void scale_filter_row_x(const ScaleFilterWeights *fw,
+                               int newx,
+                               int channels,
+                               const float *src_row,
+                               const unsigned char *src_row_byte,
+                               float *dst_row)
 {
-  ScaleThreadData *data = (ScaleThreadData *)data_v;
-  ImBuf *ibuf = data->ibuf;
-  int i;
-  float factor_x = (float)ibuf->x / data->newx;
-  float factor_y = (float)ibuf->y / data->newy;
-
-  for (i = 0; i < data->tot_line; i++) {
-    int y = data->start_line + i;
-    int x;
-
-    for (x = 0; x < data->newx; x++) {
-      float u = (float)x * factor_x;
-      float v = (float)y * factor_y;
-      int offset = y * data->newx + x;
-
-      if (data->byte_buffer) {
-        unsigned char *pixel = data->byte_buffer + 4 * offset;
-        BLI_bilinear_interpolation_char(
-            (unsigned char *)ibuf->rect, pixel, ibuf->x, ibuf->y, 4, u, v);
+  for (int x = 0; x < newx; x++) {
+    const float *weights = fw->weights + (size_t)x * fw->max_count;
+    const int start = fw->start[x];
+    const int count = fw->count[x];
+    float accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    if (src_row_byte) {
+      const unsigned char *src = src_row_byte + (size_t)start * 4;
+      for (int i = 0; i < count; i++, src += 4) {
+        const float w = weights[i];
+        accum[0] += w * (float)src[0];
+        accum[1] += w * (float)src[1];
+        accum[2] += w * (float)src[2];
+        accum[3] += w * (float)src[3];
       }
-
-      if (data->float_buffer) {
-        float *pixel = data->float_buffer + ibuf->channels * offset;
-        BLI_bilinear_interpolation_fl(
-            ibuf->rect_float, pixel, ibuf->x, ibuf->y, ibuf->channels, u, v);
+    }
+    else {
+      const float *src = src_row + (size_t)start * channels;
+      for (int i = 0; i < count; i++, src += channels) {
+        const float w = weights[i];
+        for (int c = 0; c < channels; c++) {
+          accum[c] += w * src[c];
+        }
       }
     }
+
+    memcpy(dst_row + (size_t)x * channels, accum, sizeof(float) * channels);
   }
+}
 
-  return NULL;
+static void scale_filter_x_cb(void *__restrict userdata,
+                              const int y,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ScaleFilterData *data = userdata;
+  const size_t src_offset = (size_t)y * data->src_x;
+  const size_t dst_offset = (size_t)y * data->newx;
+
+  if (data->src_byte) {
+    scale_filter_row_x(&data->weights_x,
+                       data->newx,
+                       4,
+                       NULL,
+                       data->src_byte + src_offset * 4,
+                       data->tmp_byte + dst_offset * 4);
+  }
+  if (data->src_float) {
+    const int channels = data->float_channels;
+    scale_filter_row_x(&data->weights_x,
+                       data->newx,
+                       channels,
+                       data->src_float + src_offset * channels,
+                       NULL,
+                       data->tmp_float + dst_offset * channels);
+  }
 }
 
-void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
+/* Accumulate whole rows, so the inner loop is over contiguous memory and vectorizes well. */
+static void scale_filter_column_y(const ScaleFilterWeights *fw,
+                                  int y,
+                                  size_t row_len,
+                                  const float *src,
+                                  float *dst_row)
 {
-  ScaleTreadInitData init_data = {NULL};
+  const float *weights = fw->weights + (size_t)y * fw->max_count;
+  const int start = fw->start[y];
+  const int count = fw->count[y];
+
+  memset(dst_row, 0, sizeof(float) * row_len);
+  for (int i = 0; i < count; i++) {
+    const float w = weights[i];
+    const float *src_row = src + (size_t)(start + i) * row_len;
+    for (size_t j = 0; j < row_len; j++) {
+      dst_row[j] += w * src_row[j];
+    }
+  }
+}
 
-  /* prepare initialization data */
-  init_data.ibuf = ibuf;
+typedef struct ScaleFilterTLS {
+  /* Accumulated byte row before it is clamped, allocated on first use. */
+  float *row;
+} ScaleFilterTLS;
 
-  init_data.newx = newx;
-  init_data.newy = newy;
+static void scale_filter_y_cb(void *__restrict userdata,
+                              const int y,
+                              const TaskParallelTLS *__restrict tls)
+{
+  ScaleFilterData *data = userdata;
 
-  if (ibuf->rect) {
-    init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char),
-                                        "threaded scale byte buffer");
+  if (data->src_byte) {
+    ScaleFilterTLS *tls_data = tls->userdata_chunk;
+    const size_t row_len = (size_t)data->newx * 4;
+    if (tls_data->row == NULL) {
+      tls_data->row = MEM_mallocN(sizeof(float) * row_len, "scale filter row");
+    }
+    float *row = tls_data->row;
+    unsigned char *dst = data->dst_byte + (size_t)y * row_len;
+
+    scale_filter_column_y(&data->weights_y, y, row_len, data->tmp_byte, row);
+    for (size_t j = 0; j < row_len; j++) {
+      dst[j] = (unsigned char)clamp_f(row[j] + 0.5f, 0.0f, 255.0f);
+    }
+  }
+  if (data->src_float) {
+    const size_t row_len = (size_t)data->newx * data->float_channels;
+    scale_filter_column_y(
+        &data->weights_y, y, row_len, data->tmp_float, data->dst_float + (size_t)y * row_len);
   }
+}
 
-  if (ibuf->rect_float) {
-    init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float),
-                                         "threaded scale float buffer");
+static void scale_filter_y_free(const void *__restrict UNUSED(userdata),
+                                void *__restrict userdata_chunk)
+{
+  ScaleFilterTLS *tls_data = userdata_chunk;
+  MEM_SAFE_FREE(tls_data->row);
+}
+
+bool IMB_scaleImBuf_filtered(struct ImBuf *ibuf,
+                             unsigned int newx,
+                             unsigned int newy,
+                             eIMBScaleFilter filter)
+{
+  if (ibuf == NULL) {
+    return false;
+  }
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return false;
+  }
+  if (newx == 0 || newy == 0 || (newx == ibuf->x && newy == ibuf->y)) {
+    return false;
   }
 
-  /* actual scaling threads */
-  IMB_processor_apply_threaded(
-      newy, sizeof(ScaleThreadData), &init_data, scale_thread_init, do_scale_thread);
+  ScaleFilterData data = {{NULL}};
+  data.src_x = ibuf->x;
+  data.newx = newx;
+  data.newy = newy;
+  data.src_byte = (unsigned char *)ibuf->rect;
+  data.src_float = ibuf->rect_float;
+  data.float_channels = ibuf->channels;
 
-  /* alter image buffer */
-  ibuf->x = newx;
-  ibuf->y = newy;
+  scale_filter_weights_init(&data.weights_x, ibuf->x, newx, filter);
+  scale_filter_weights_init(&data.weights_y, ibuf->y, newy, filter);
 
-  if (ibuf->rect) {
+  if (data.src_byte) {
+    data.tmp_byte = MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scale filter byte tmp");
+    data.dst_byte = MEM_mallocN(sizeof(uchar[4]) * newx * newy, "scale filter byte");
+  }
+  if (data.src_float) {
+    data.tmp_float = MEM_mallocN(sizeof(float) * data.float_channels * newx * ibuf->y,
+                                 "scale filter float tmp");
+    data.dst_float = MEM_mallocN(sizeof(float) * data.float_channels * newx * newy,
+                                 "scale filter float");
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = ((size_t)newx * MAX2(ibuf->y, newy) > 64 * 64);
+  settings.min_iter_per_thread = 8;
+
+  BLI_task_parallel_range(0, ibuf->y, &data, scale_filter_x_cb, &settings);
+
+  ScaleFilterTLS tls_data = {NULL};
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_free = scale_filter_y_free;
+  BLI_task_parallel_range(0, newy, &data, scale_filter_y_cb, &settings);
+
+  scale_filter_weights_free(&data.weights_x);
+  scale_filter_weights_free(&data.weights_y);
+
+  /* Scale the Z-buffer (if any) before image dimensions change. */
+  scalefast_Z_ImBuf(ibuf, newx, newy);
+
+  if (data.src_byte) {
+    MEM_freeN(data.tmp_byte);
     imb_freerectImBuf(ibuf);
     ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)init_data.byte_buffer;
+    ibuf->rect = (unsigned int *)data.dst_byte;
   }
-
-  if (ibuf->rect_float) {
+  if (data.src_float) {
+    MEM_freeN(data.tmp_float);
     imb_freerectfloatImBuf(ibuf);
     ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = init_data.float_buffer;
+    ibuf->rect_float = data.dst_float;
   }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+
+  return true;
+}
+
+/* ******** threaded scaling ******** */
+
+void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
+{
+  IMB_scaleImBuf_filtered(ibuf, newx, newy, IMB_SCALE_FILTER_BILINEAR);
 }
@@ -69,6 +69,27 @@ typedef struct KeyBlock {
   float slidermin;
   float slidermax;
 
+  /**
+   * File storage only, always NULL in memory: when set, 'data' holds only the elements listed
+   * in this array and all other elements match the reference key. Only written for keys using
+   * #KEY_SPARSE_STORAGE.
+   * See #BKE_keyblock_sparse_data_create.
+   */
+  int *sparse_index;
+  /** Number of items in 'sparse_index' and 'data' when stored sparsely. */
+  int sparse_totelem;
+
+  /**
+   * Runtime only, number of items in 'moved_index', -1 once too many elements were found to
+   * differ for the index to be useful.
+   */
+  int moved_totelem;
+  /**
+   * Runtime only, set on evaluated keys: sorted indices of the elements that differ from the
+   * key-block this one is relative to, so blending can skip the others.
+   * See #key_block_moved_index_ensure.
+   */
+  int *moved_index;
 } KeyBlock;
 
 typedef struct Key {
@@ -131,6 +152,9 @@ enum {
 /* Key->flag */
 enum {
   KEY_DS_EXPAND = 1,
+  /** Save key-blocks sparsely when only some elements differ from the reference key, files are
+   * then marked as requiring at least version 2.91 subversion 1 to read. */
+  KEY_SPARSE_STORAGE = (1 << 1),
 };
 
 /* KeyBlock->type */
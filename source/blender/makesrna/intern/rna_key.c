@@ -1051,6 +1051,13 @@ static void rna_def_key(BlenderRNA *brna)
       "otherwise play through shapes as a sequence using the evaluation time");
   RNA_def_property_update(prop, 0, "rna_Key_update_data");
 
+  prop = RNA_def_property(srna, "use_sparse_storage", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", KEY_SPARSE_STORAGE);
+  RNA_def_property_ui_text(prop,
+                           "Sparse Storage",
+                           "Only save the elements of shape keys that differ from the basis, "
+                           "files can then not be opened by Blender 2.91.0 and older");
+
   prop = RNA_def_property(srna, "eval_time", PROP_FLOAT, PROP_NONE);
   RNA_def_property_float_sdna(prop, NULL, "ctime");
   RNA_def_property_range(prop, MINFRAME, MAXFRAME);
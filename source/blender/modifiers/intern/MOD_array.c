@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -166,13 +167,14 @@ static void svert_from_mvert(SortVertsElem *sv,
  * to vertices within target, or -1 if no double found.
  * The int doubles_map[num_verts_source] array must have been allocated by caller.
  */
-static void dm_mvert_map_doubles(int *doubles_map,
-                                 const MVert *mverts,
-                                 const int target_start,
-                                 const int target_num_verts,
-                                 const int source_start,
-                                 const int source_num_verts,
-                                 const float dist)
+static void dm_mvert_map_doubles_ex(int *doubles_map,
+                                    const MVert *mverts,
+                                    const int target_start,
+                                    const int target_num_verts,
+                                    const int source_start,
+                                    const int source_num_verts,
+                                    const float dist,
+                                    const bool follow_target_mapping)
 {
   const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
   int i_source, i_target, i_target_low_bound, target_end, source_end;
@@ -257,7 +259,7 @@ static void dm_mvert_map_doubles(int *doubles_map,
          * Note that if we later find another target closer than this one, then we check it.
          * But if other potential targets are farther,
          * then there will be no mapping at all for this source. */
-        while (best_target_vertex != -1 &&
+        while (follow_target_mapping && best_target_vertex != -1 &&
                !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
           if (compare_len_v3v3(mverts[sve_source->vertex_num].co,
                                mverts[doubles_map[best_target_vertex]].co,
@@ -280,6 +282,52 @@ static void dm_mvert_map_doubles(int *doubles_map,
   MEM_freeN(sorted_verts_target);
 }
 
+static void dm_mvert_map_doubles(int *doubles_map,
+                                 const MVert *mverts,
+                                 const int target_start,
+                                 const int target_num_verts,
+                                 const int source_start,
+                                 const int source_num_verts,
+                                 const float dist)
+{
+  dm_mvert_map_doubles_ex(doubles_map,
+                          mverts,
+                          target_start,
+                          target_num_verts,
+                          source_start,
+                          source_num_verts,
+                          dist,
+                          true);
+}
+
+/**
+ * Second half of #dm_mvert_map_doubles for mappings which were built without following the
+ * mapping of targets (so that several chunks can be processed in parallel): if a target is
+ * already mapped, only follow that mapping if final target remains close enough from the
+ * source vertex (otherwise no mapping at all).
+ * Must be called in the order the chunks depend on each other.
+ */
+static void dm_mvert_map_doubles_follow_targets(int *doubles_map,
+                                                const MVert *mverts,
+                                                const int source_start,
+                                                const int source_num_verts,
+                                                const float dist)
+{
+  const int source_end = source_start + source_num_verts;
+  for (int i_source = source_start; i_source < source_end; i_source++) {
+    int target = doubles_map[i_source];
+    while (target != -1 && !ELEM(doubles_map[target], -1, target)) {
+      if (compare_len_v3v3(mverts[i_source].co, mverts[doubles_map[target]].co, dist)) {
+        target = doubles_map[target];
+      }
+      else {
+        target = -1;
+      }
+    }
+    doubles_map[i_source] = target;
+  }
+}
+
 static void mesh_merge_transform(Mesh *result,
                                  Mesh *cap_mesh,
                                  const float cap_offset[4][4],
@@ -362,16 +410,120 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+typedef struct ArrayChunksData {
+  const Mesh *mesh;
+  Mesh *result;
+  /* Cumulative offset of every chunk. */
+  const float (*chunk_offsets)[4][4];
+  int chunk_nverts, chunk_nedges, chunk_nloops, chunk_npolys;
+  bool use_recalc_normals;
+  float uv_offset[2];
+  int *full_doubles_map;
+  float merge_dist;
+} ArrayChunksData;
+
+/* Copy geometry of the original mesh to the given chunk and apply its offset. */
+static void array_chunk_copy_task(void *__restrict userdata,
+                                  const int c,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunksData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const float(*current_offset)[4] = data->chunk_offsets[c];
+  const int chunk_nverts = data->chunk_nverts;
+  const int chunk_nedges = data->chunk_nedges;
+  const int chunk_nloops = data->chunk_nloops;
+  const int chunk_npolys = data->chunk_npolys;
+  MVert *mv;
+  MEdge *me;
+  MLoop *ml;
+  MPoly *mp;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  if (chunk_nloops > 0 && is_zero_v2(data->uv_offset) == false) {
+    const float uv_offset[2] = {
+        data->uv_offset[0] * (float)c,
+        data->uv_offset[1] * (float)c,
+    };
+    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
+    for (i = 0; i < totuv; i++) {
+      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
+      dmloopuv += c * chunk_nloops;
+      for (int l_index = chunk_nloops; l_index-- != 0; dmloopuv++) {
+        dmloopuv->uv[0] += uv_offset[0];
+        dmloopuv->uv[1] += uv_offset[1];
+      }
+    }
+  }
+}
+
+/* Find doubles between the given chunk and the previous one. Mapping of the previous chunk is
+ * not followed here, since it might still be in progress in another thread. */
+static void array_chunk_map_doubles_task(void *__restrict userdata,
+                                         const int c,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunksData *data = userdata;
+  const int chunk_nverts = data->chunk_nverts;
+  dm_mvert_map_doubles_ex(data->full_doubles_map,
+                          data->result->mvert,
+                          (c - 1) * chunk_nverts,
+                          chunk_nverts,
+                          c * chunk_nverts,
+                          chunk_nverts,
+                          data->merge_dist,
+                          false);
+}
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
@@ -576,56 +728,47 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
+  /* Cumulative offsets of all chunks, so that chunks can be handled independently. */
+  float(*chunk_offsets)[4][4] = MEM_malloc_arrayN(count, sizeof(*chunk_offsets), __func__);
   unit_m4(current_offset);
+  copy_m4_m4(chunk_offsets[0], current_offset);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
     /* recalculate cumulative offset here */
     mul_m4_m4m4(current_offset, current_offset, offset);
+    copy_m4_m4(chunk_offsets[c], current_offset);
+  }
 
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
-      }
-    }
-
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
-
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
-    }
-
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
-    }
-
-    /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
-      if (!offset_has_scale && (c >= 2)) {
+  ArrayChunksData chunks_data = {
+      .mesh = mesh,
+      .result = result,
+      .chunk_offsets = (const float(*)[4][4])chunk_offsets,
+      .chunk_nverts = chunk_nverts,
+      .chunk_nedges = chunk_nedges,
+      .chunk_nloops = chunk_nloops,
+      .chunk_npolys = chunk_npolys,
+      .use_recalc_normals = use_recalc_normals,
+      .full_doubles_map = full_doubles_map,
+      .merge_dist = amd->merge_dist,
+  };
+  copy_v2_v2(chunks_data.uv_offset, amd->uv_offset);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Avoid threading overhead for tiny chunks. */
+  settings.min_iter_per_thread = max_ii(1, 1024 / max_ii(chunk_nverts + chunk_nloops, 1));
+  BLI_task_parallel_range(1, count, &chunks_data, array_chunk_copy_task, &settings);
+
+  /* Handle merge between chunk n and n-1 */
+  if (use_merge && count > 1) {
+    if (!offset_has_scale) {
+      dm_mvert_map_doubles(full_doubles_map,
+                           result_dm_verts,
+                           0,
+                           chunk_nverts,
+                           chunk_nverts,
+                           chunk_nverts,
+                           amd->merge_dist);
+      for (c = 2; c < count; c++) {
         /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
          * ... that is except if scaling makes the distance grow */
         int k;
@@ -651,38 +794,20 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
           full_doubles_map[this_chunk_index] = target;
         }
       }
-      else {
-        dm_mvert_map_doubles(full_doubles_map,
-                             result_dm_verts,
-                             (c - 1) * chunk_nverts,
-                             chunk_nverts,
-                             c * chunk_nverts,
-                             chunk_nverts,
-                             amd->merge_dist);
-      }
     }
-  }
-
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
+    else {
+      /* Scaling changes distances between chunks, so every pair of chunks needs its own search
+       * for doubles. Searches are independent, following mapped targets is not. */
+      BLI_task_parallel_range(1, count, &chunks_data, array_chunk_map_doubles_task, &settings);
       for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
+        dm_mvert_map_doubles_follow_targets(
+            full_doubles_map, result_dm_verts, c * chunk_nverts, chunk_nverts, amd->merge_dist);
       }
     }
   }
 
+  MEM_freeN(chunk_offsets);
+
   last_chunk_start = (count - 1) * chunk_nverts;
   last_chunk_nverts = chunk_nverts;
 
@@ -26,16 +26,20 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_string.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
 
 #include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 
 #include "BKE_context.h"
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -62,11 +66,40 @@
 
 #include "intern/CCGSubSurf.h"
 
+/* Subdivided mesh from the previous evaluation, together with everything it was created from
+ * except of the coarse vertex positions. When only positions of the input mesh change (which is
+ * the case for animated deformation) the cached mesh is copied and only its vertex positions and
+ * normals are re-evaluated. */
+typedef struct SubsurfTopologyCache {
+  SubdivSettings subdiv_settings;
+  SubdivToMeshSettings mesh_settings;
+  /* Custom data of the coarse mesh, which includes its topology. */
+  CustomData vdata, edata, ldata, pdata;
+  int totvert, totedge, totloop, totpoly;
+  struct Mesh *result;
+} SubsurfTopologyCache;
+
 typedef struct SubsurfRuntimeData {
   /* Cached subdivision surface descriptor, with topology and settings. */
   struct Subdiv *subdiv;
+  SubsurfTopologyCache *topology_cache;
 } SubsurfRuntimeData;
 
+static void subsurf_topology_cache_free(SubsurfRuntimeData *runtime_data)
+{
+  SubsurfTopologyCache *cache = runtime_data->topology_cache;
+  if (cache == NULL) {
+    return;
+  }
+  CustomData_free(&cache->vdata, cache->totvert);
+  CustomData_free(&cache->edata, cache->totedge);
+  CustomData_free(&cache->ldata, cache->totloop);
+  CustomData_free(&cache->pdata, cache->totpoly);
+  BKE_id_free(NULL, cache->result);
+  MEM_freeN(cache);
+  runtime_data->topology_cache = NULL;
+}
+
 static void initData(ModifierData *md)
 {
   SubsurfModifierData *smd = (SubsurfModifierData *)md;
@@ -119,6 +152,7 @@ static void freeRuntimeData(void *runtime_data_v)
   if (runtime_data->subdiv != NULL) {
     BKE_subdiv_free(runtime_data->subdiv);
   }
+  subsurf_topology_cache_free(runtime_data);
   MEM_freeN(runtime_data);
 }
 
@@ -189,6 +223,159 @@ static void subdiv_mesh_settings_init(SubdivToMeshSettings *settings,
                                   !(ctx->flag & MOD_APPLY_TO_BASE_MESH);
 }
 
+/* Topology cache is only used for interactive playback, it doubles memory used by the result. */
+static bool subsurf_use_topology_cache(const ModifierEvalContext *ctx)
+{
+  return (ctx->flag & (MOD_APPLY_RENDER | MOD_APPLY_TO_BASE_MESH)) == 0;
+}
+
+static bool subsurf_custom_data_layer_equals(const CustomDataLayer *layer,
+                                             const CustomDataLayer *cached_layer,
+                                             const int totelem)
+{
+  if (layer->type != cached_layer->type || !STREQ(layer->name, cached_layer->name) ||
+      layer->active != cached_layer->active || layer->active_rnd != cached_layer->active_rnd ||
+      layer->active_clone != cached_layer->active_clone ||
+      layer->active_mask != cached_layer->active_mask) {
+    return false;
+  }
+  switch (layer->type) {
+    case CD_MVERT: {
+      /* Positions and normals are the only data which is allowed to differ. */
+      const MVert *mvert = layer->data;
+      const MVert *cached_mvert = cached_layer->data;
+      for (int i = 0; i < totelem; i++) {
+        if (mvert[i].flag != cached_mvert[i].flag || mvert[i].bweight != cached_mvert[i].bweight) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case CD_MDEFORMVERT: {
+      const MDeformVert *dvert = layer->data;
+      const MDeformVert *cached_dvert = cached_layer->data;
+      for (int i = 0; i < totelem; i++) {
+        if (dvert[i].totweight != cached_dvert[i].totweight ||
+            dvert[i].flag != cached_dvert[i].flag) {
+          return false;
+        }
+        if (dvert[i].totweight != 0 &&
+            memcmp(dvert[i].dw, cached_dvert[i].dw, sizeof(MDeformWeight) * dvert[i].totweight)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      break;
+  }
+  if (CustomData_layertype_is_dynamic(layer->type)) {
+    return false;
+  }
+  return memcmp(layer->data,
+                cached_layer->data,
+                (size_t)CustomData_sizeof(layer->type) * (size_t)totelem) == 0;
+}
+
+/* Layers which are not copied to the subdivided mesh are not stored in the cache and are ignored
+ * here. */
+static bool subsurf_custom_data_equals(const CustomData *data,
+                                       const CustomData *cached_data,
+                                       const int totelem)
+{
+  int cached_layer_index = 0;
+  for (int layer_index = 0; layer_index < data->totlayer; layer_index++) {
+    const CustomDataLayer *layer = &data->layers[layer_index];
+    if (layer->flag & CD_FLAG_NOCOPY) {
+      continue;
+    }
+    if (cached_layer_index == cached_data->totlayer) {
+      return false;
+    }
+    if (!subsurf_custom_data_layer_equals(
+            layer, &cached_data->layers[cached_layer_index++], totelem)) {
+      return false;
+    }
+  }
+  return cached_layer_index == cached_data->totlayer;
+}
+
+static bool subsurf_topology_cache_matches(const SubsurfTopologyCache *cache,
+                                           const Subdiv *subdiv,
+                                           const SubdivToMeshSettings *mesh_settings,
+                                           const Mesh *mesh)
+{
+  if (!BKE_subdiv_settings_equal(&cache->subdiv_settings, &subdiv->settings)) {
+    return false;
+  }
+  if (cache->mesh_settings.resolution != mesh_settings->resolution ||
+      cache->mesh_settings.use_optimal_display != mesh_settings->use_optimal_display) {
+    return false;
+  }
+  if (cache->totvert != mesh->totvert || cache->totedge != mesh->totedge ||
+      cache->totloop != mesh->totloop || cache->totpoly != mesh->totpoly) {
+    return false;
+  }
+  return subsurf_custom_data_equals(&mesh->vdata, &cache->vdata, mesh->totvert) &&
+         subsurf_custom_data_equals(&mesh->edata, &cache->edata, mesh->totedge) &&
+         subsurf_custom_data_equals(&mesh->ldata, &cache->ldata, mesh->totloop) &&
+         subsurf_custom_data_equals(&mesh->pdata, &cache->pdata, mesh->totpoly);
+}
+
+/* Exact copy of the subdivided mesh, with all the custom data layers subdivision created. */
+static Mesh *subsurf_mesh_duplicate(const Mesh *mesh)
+{
+  Mesh *result = BKE_mesh_new_nomain_from_template_ex(
+      mesh, mesh->totvert, mesh->totedge, 0, mesh->totloop, mesh->totpoly, CD_MASK_EVERYTHING);
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, 0, mesh->totvert);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, 0, mesh->totedge);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, 0, mesh->totloop);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, 0, mesh->totpoly);
+  result->runtime.cd_dirty_vert = mesh->runtime.cd_dirty_vert;
+  return result;
+}
+
+static void subsurf_topology_cache_store(SubsurfRuntimeData *runtime_data,
+                                         const Subdiv *subdiv,
+                                         const SubdivToMeshSettings *mesh_settings,
+                                         const Mesh *mesh,
+                                         const Mesh *result)
+{
+  subsurf_topology_cache_free(runtime_data);
+  SubsurfTopologyCache *cache = MEM_callocN(sizeof(*cache), "subsurf topology cache");
+  cache->subdiv_settings = subdiv->settings;
+  cache->mesh_settings = *mesh_settings;
+  cache->totvert = mesh->totvert;
+  cache->totedge = mesh->totedge;
+  cache->totloop = mesh->totloop;
+  cache->totpoly = mesh->totpoly;
+  CustomData_copy(&mesh->vdata, &cache->vdata, CD_MASK_ALL, CD_DUPLICATE, mesh->totvert);
+  CustomData_copy(&mesh->edata, &cache->edata, CD_MASK_ALL, CD_DUPLICATE, mesh->totedge);
+  CustomData_copy(&mesh->ldata, &cache->ldata, CD_MASK_ALL, CD_DUPLICATE, mesh->totloop);
+  CustomData_copy(&mesh->pdata, &cache->pdata, CD_MASK_ALL, CD_DUPLICATE, mesh->totpoly);
+  cache->result = subsurf_mesh_duplicate(result);
+  runtime_data->topology_cache = cache;
+}
+
+/* Returns NULL when the cached topology can not be used for the given mesh. */
+static Mesh *subsurf_topology_cache_evaluate(SubsurfRuntimeData *runtime_data,
+                                             Subdiv *subdiv,
+                                             const SubdivToMeshSettings *mesh_settings,
+                                             const Mesh *mesh)
+{
+  const SubsurfTopologyCache *cache = runtime_data->topology_cache;
+  if (cache == NULL || !subsurf_topology_cache_matches(cache, subdiv, mesh_settings, mesh)) {
+    return NULL;
+  }
+  Mesh *result = subsurf_mesh_duplicate(cache->result);
+  BKE_mesh_copy_settings(result, mesh);
+  if (!BKE_subdiv_to_mesh_update_positions(subdiv, mesh_settings, mesh, result)) {
+    BKE_id_free(NULL, result);
+    return NULL;
+  }
+  return result;
+}
+
 static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
                             const ModifierEvalContext *ctx,
                             Mesh *mesh,
@@ -200,7 +387,21 @@ static Mesh *subdiv_as_mesh(SubsurfModifierData *smd,
   if (mesh_settings.resolution < 3) {
     return result;
   }
+  SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
+  if (!subsurf_use_topology_cache(ctx)) {
+    return BKE_subdiv_to_mesh(subdiv, &mesh_settings, mesh);
+  }
+  result = subsurf_topology_cache_evaluate(runtime_data, subdiv, &mesh_settings, mesh);
+  if (result != NULL) {
+    return result;
+  }
   result = BKE_subdiv_to_mesh(subdiv, &mesh_settings, mesh);
+  if (result != NULL) {
+    subsurf_topology_cache_store(runtime_data, subdiv, &mesh_settings, mesh, result);
+  }
+  else {
+    subsurf_topology_cache_free(runtime_data);
+  }
   return result;
 }
 
@@ -55,32 +55,63 @@ fn::MutableAttributesRef AttributesAllocator::allocate_uninitialized(int size)
   return attributes;
 }
 
+/* Append all blocks of the other allocator after the ones of this allocator. */
+void AttributesAllocator::take_allocations_from(AttributesAllocator &other)
+{
+  BLI_assert(&attributes_info_ == &other.attributes_info_);
+
+  std::lock_guard lock{mutex_};
+  for (std::unique_ptr<AttributesBlock> &block : other.allocated_blocks_) {
+    allocated_blocks_.append(std::move(block));
+  }
+  allocated_attributes_.extend(other.allocated_attributes_);
+  total_allocated_ += other.total_allocated_;
+
+  other.allocated_blocks_.clear();
+  other.allocated_attributes_.clear();
+  other.total_allocated_ = 0;
+}
+
 fn::MutableAttributesRef ParticleAllocator::allocate(int size)
 {
   const fn::AttributesInfo &info = attributes_allocator_.attributes_info();
   fn::MutableAttributesRef attributes = attributes_allocator_.allocate_uninitialized(size);
   for (int i : info.index_range()) {
     const fn::CPPType &type = info.type_of(i);
-    StringRef name = info.name_of(i);
-    if (name == "ID") {
-      int start_id = next_id_.fetch_add(size);
+    type.fill_uninitialized(info.default_of(i), attributes.get(i).data(), size);
+  }
+  return attributes;
+}
+
+void ParticleAllocator::take_allocations_from(ParticleAllocator &other)
+{
+  attributes_allocator_.take_allocations_from(other.attributes_allocator_);
+}
+
+/* Give consecutive ids to all allocated particles, in the order of their blocks. */
+void ParticleAllocator::assign_ids_and_hashes()
+{
+  const fn::AttributesInfo &info = attributes_allocator_.attributes_info();
+  const bool has_ids = info.has_attribute("ID", fn::CPPType::get<int>());
+  const bool has_hashes = info.has_attribute("Hash", fn::CPPType::get<int>());
+
+  for (fn::MutableAttributesRef attributes : attributes_allocator_.get_allocations()) {
+    const int start_id = next_id_;
+    next_id_ += attributes.size();
+    if (has_ids) {
       MutableSpan<int> ids = attributes.get<int>("ID");
-      for (int pindex : IndexRange(size)) {
+      for (int pindex : attributes.index_range()) {
         ids[pindex] = start_id + pindex;
       }
     }
-    else if (name == "Hash") {
+    if (has_hashes) {
       MutableSpan<int> hashes = attributes.get<int>("Hash");
-      RandomNumberGenerator rng(hash_seed_ ^ static_cast<uint32_t>(next_id_));
-      for (int pindex : IndexRange(size)) {
+      RandomNumberGenerator rng(hash_seed_ ^ static_cast<uint32_t>(start_id));
+      for (int pindex : attributes.index_range()) {
         hashes[pindex] = static_cast<int>(rng.get_uint32());
       }
     }
-    else {
-      type.fill_uninitialized(info.default_of(i), attributes.get(i).data(), size);
-    }
   }
-  return attributes;
 }
 
 }  // namespace blender::sim
@@ -21,7 +21,6 @@
 
 #include "FN_attributes_ref.hh"
 
-#include <atomic>
 #include <mutex>
 
 namespace blender::sim {
@@ -63,12 +62,18 @@ class AttributesAllocator : NonCopyable, NonMovable {
   }
 
   fn::MutableAttributesRef allocate_uninitialized(int size);
+  void take_allocations_from(AttributesAllocator &other);
 };
 
+/**
+ * Allocates blocks of new particles. The "ID" and "Hash" attributes are only assigned by
+ * #assign_ids_and_hashes, once the allocations of all emitters have been merged in a fixed
+ * order, so they don't depend on the order in which emitters ran.
+ */
 class ParticleAllocator : NonCopyable, NonMovable {
  private:
   AttributesAllocator attributes_allocator_;
-  std::atomic<int> next_id_;
+  int next_id_;
   uint32_t hash_seed_;
 
  public:
@@ -93,6 +98,8 @@ class ParticleAllocator : NonCopyable, NonMovable {
   }
 
   fn::MutableAttributesRef allocate(int size);
+  void take_allocations_from(ParticleAllocator &other);
+  void assign_ids_and_hashes();
 };
 
 }  // namespace blender::sim
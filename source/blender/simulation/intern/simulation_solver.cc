@@ -21,6 +21,7 @@
 
 #include "BLI_rand.hh"
 #include "BLI_set.hh"
+#include "BLI_task.h"
 
 #include "DEG_depsgraph_query.h"
 
@@ -337,6 +338,100 @@ BLI_NOINLINE static void simulate_particle_chunk(SimulationSolveContext &solve_c
   }
 }
 
+/* Amount of particles that is processed by one task. Chunks are independent of each other, because
+ * forces, events and actions only ever access the particles they are given. */
+static constexpr int particle_chunk_size = 1000;
+
+static int particle_chunks_num(const int64_t particle_amount)
+{
+  return static_cast<int>((particle_amount + particle_chunk_size - 1) / particle_chunk_size);
+}
+
+static IndexRange particle_chunk_range(const int64_t particle_amount, const int chunk_index)
+{
+  const int64_t start = static_cast<int64_t>(chunk_index) * particle_chunk_size;
+  return IndexRange(start, std::min<int64_t>(particle_chunk_size, particle_amount - start));
+}
+
+static void particle_chunks_parallel_range(const int64_t particle_amount,
+                                           void *userdata,
+                                           TaskParallelRangeFunc func)
+{
+  const int chunks_num = particle_chunks_num(particle_amount);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = chunks_num > 1;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, chunks_num, userdata, func, &settings);
+}
+
+struct SimulateParticleChunksData {
+  SimulationSolveContext *solve_context;
+  ParticleSimulationState *state;
+  MutableAttributesRef attributes;
+  MutableSpan<float> remaining_durations;
+  float end_time;
+};
+
+static void simulate_particle_chunks_func(void *__restrict userdata,
+                                          const int chunk_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SimulateParticleChunksData *data = static_cast<const SimulateParticleChunksData *>(
+      userdata);
+  const IndexRange range = particle_chunk_range(data->attributes.size(), chunk_index);
+  simulate_particle_chunk(*data->solve_context,
+                          *data->state,
+                          data->attributes.slice(range),
+                          data->remaining_durations.slice(range.start(), range.size()),
+                          data->end_time);
+}
+
+BLI_NOINLINE static void simulate_particle_chunks(SimulationSolveContext &solve_context,
+                                                  ParticleSimulationState &state,
+                                                  MutableAttributesRef attributes,
+                                                  MutableSpan<float> remaining_durations,
+                                                  float end_time)
+{
+  SimulateParticleChunksData data{
+      &solve_context, &state, attributes, remaining_durations, end_time};
+  particle_chunks_parallel_range(attributes.size(), &data, simulate_particle_chunks_func);
+}
+
+struct ExecuteBirthActionsData {
+  SimulationSolveContext *solve_context;
+  ParticleSimulationState *state;
+  MutableAttributesRef attributes;
+  Span<const ParticleAction *> actions;
+};
+
+static void execute_birth_actions_func(void *__restrict userdata,
+                                       const int chunk_index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ExecuteBirthActionsData *data = static_cast<const ExecuteBirthActionsData *>(userdata);
+  const IndexRange range = particle_chunk_range(data->attributes.size(), chunk_index);
+  MutableAttributesRef attributes = data->attributes.slice(range);
+  for (const ParticleAction *action : data->actions) {
+    ParticleChunkContext chunk_context{*data->state, IndexRange(attributes.size()), attributes};
+    ParticleActionContext action_context{*data->solve_context, chunk_context};
+    action->execute(action_context);
+  }
+}
+
+BLI_NOINLINE static void execute_birth_actions(SimulationSolveContext &solve_context,
+                                               ParticleSimulationState &state,
+                                               MutableAttributesRef attributes)
+{
+  Span<const ParticleAction *> actions = solve_context.influences.particle_birth_actions.lookup_as(
+      state.head.name);
+  if (actions.is_empty()) {
+    return;
+  }
+  ExecuteBirthActionsData data{&solve_context, &state, attributes, actions};
+  particle_chunks_parallel_range(attributes.size(), &data, execute_birth_actions_func);
+}
+
 BLI_NOINLINE static void simulate_existing_particles(SimulationSolveContext &solve_context,
                                                      ParticleSimulationState &state,
                                                      const AttributesInfo &attributes_info)
@@ -346,17 +441,60 @@ BLI_NOINLINE static void simulate_existing_particles(SimulationSolveContext &sol
   MutableAttributesRef attributes = custom_data_attributes;
 
   Array<float> remaining_durations(state.tot_particles, solve_context.solve_interval.duration());
-  simulate_particle_chunk(
+  simulate_particle_chunks(
       solve_context, state, attributes, remaining_durations, solve_context.solve_interval.stop());
 }
 
+using ParticleAllocatorsMap = Map<std::string, std::unique_ptr<ParticleAllocator>>;
+
+struct RunEmittersData {
+  SimulationSolveContext *solve_context;
+  MutableSpan<ParticleAllocatorsMap> emitter_allocators;
+};
+
+static void run_emitters_func(void *__restrict userdata,
+                              const int emitter_index,
+                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const RunEmittersData *data = static_cast<const RunEmittersData *>(userdata);
+  SimulationSolveContext &solve_context = *data->solve_context;
+  const ParticleEmitter *emitter = solve_context.influences.particle_emitters[emitter_index];
+  ParticleAllocators particle_allocators{data->emitter_allocators[emitter_index]};
+  ParticleEmitterContext emitter_context{
+      solve_context, particle_allocators, solve_context.solve_interval};
+  emitter->emit(emitter_context);
+}
+
+/* Emitters only modify their own state and write new particles into allocators of their own, so
+ * they can run in parallel. Their allocations are then merged in emitter order, before ids and
+ * hashes are assigned, so the result is the same as when running the emitters one by one. */
 BLI_NOINLINE static void run_emitters(SimulationSolveContext &solve_context,
-                                      ParticleAllocators &particle_allocators)
+                                      ParticleAllocatorsMap &particle_allocators)
 {
-  for (const ParticleEmitter *emitter : solve_context.influences.particle_emitters) {
-    ParticleEmitterContext emitter_context{
-        solve_context, particle_allocators, solve_context.solve_interval};
-    emitter->emit(emitter_context);
+  const int emitters_num = solve_context.influences.particle_emitters.size();
+
+  Array<ParticleAllocatorsMap> emitter_allocators(emitters_num);
+  for (ParticleAllocatorsMap &allocators : emitter_allocators) {
+    for (auto item : particle_allocators.items()) {
+      /* Ids and hashes are only assigned by the main allocator. */
+      allocators.add_new(item.key,
+                         std::make_unique<ParticleAllocator>(item.value->attributes_info(), 0, 0));
+    }
+  }
+
+  RunEmittersData data{&solve_context, emitter_allocators};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = emitters_num > 1;
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, emitters_num, &data, run_emitters_func, &settings);
+
+  for (auto item : particle_allocators.items()) {
+    ParticleAllocator &allocator = *item.value;
+    for (ParticleAllocatorsMap &allocators : emitter_allocators) {
+      allocator.take_allocations_from(*allocators.lookup(item.key));
+    }
+    allocator.assign_ids_and_hashes();
   }
 }
 
@@ -462,7 +600,7 @@ void solve_simulation_time_step(Simulation &simulation,
       state_map.lookup<ParticleSimulationState>();
 
   Map<std::string, std::unique_ptr<AttributesInfo>> attribute_infos;
-  Map<std::string, std::unique_ptr<ParticleAllocator>> particle_allocators_map;
+  ParticleAllocatorsMap particle_allocators_map;
   for (ParticleSimulationState *state : particle_simulation_states) {
     const AttributesInfoBuilder &builder = *influences.particle_attributes_builder.lookup_as(
         state->head.name);
@@ -484,19 +622,13 @@ void solve_simulation_time_step(Simulation &simulation,
     simulate_existing_particles(solve_context, *state, attributes_info);
   }
 
-  run_emitters(solve_context, particle_allocators);
+  run_emitters(solve_context, particle_allocators_map);
 
   for (ParticleSimulationState *state : particle_simulation_states) {
     ParticleAllocator &allocator = *particle_allocators.try_get_allocator(state->head.name);
 
     for (MutableAttributesRef attributes : allocator.get_allocations()) {
-      Span<const ParticleAction *> actions = influences.particle_birth_actions.lookup_as(
-          state->head.name);
-      for (const ParticleAction *action : actions) {
-        ParticleChunkContext chunk_context{*state, IndexRange(attributes.size()), attributes};
-        ParticleActionContext action_context{solve_context, chunk_context};
-        action->execute(action_context);
-      }
+      execute_birth_actions(solve_context, *state, attributes);
     }
   }
 
@@ -510,7 +642,7 @@ void solve_simulation_time_step(Simulation &simulation,
       for (int i : attributes.index_range()) {
         remaining_durations[i] = end_time - birth_times[i];
       }
-      simulate_particle_chunk(solve_context, *state, attributes, remaining_durations, end_time);
+      simulate_particle_chunks(solve_context, *state, attributes, remaining_durations, end_time);
     }
 
     remove_dead_and_add_new_particles(*state, allocator);